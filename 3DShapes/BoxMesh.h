@@ -4,6 +4,8 @@
 
 #include <GL/glew.h>
 
+#include "MeshData.h"
+
 class BoxMesh
 {
 public:
@@ -11,22 +13,18 @@ public:
 	~BoxMesh();
 
 	void CreateBoxMesh(); // method for loading the shape mesh data into memory
+	void ReleaseBoxMesh(); // deletes the buffers until the next CreateBoxMesh()
 	void DrawBoxMesh() const;
 	
 
 private:
 	struct GLMesh
 	{
-		GLuint vao;         // Handle for the vertex array object
 		GLuint vbos[2];     // Handles for the vertex buffer objects
 		GLuint nVertices;	// Number of vertices for the mesh
 		GLuint nIndices;    // Number of indices for the mesh
 	};
 
 	GLMesh m_BoxMesh;
-
-	void SetBoxMeshMemoryLayout();
-
-	bool m_bMemoryLayoutDone;
 };
 #endif // BOX_MESH_H
@@ -1,19 +1,27 @@
 #include "ConeMesh.h"
+#include "MeshOptimizer.h"
+#include "MeshWelding.h"
+#include "MeshWinding.h"
+#include <iterator>
 #include <vector>
 
-namespace
+ConeMesh::ConeMesh() : m_ConeMesh() {}
+
+ConeMesh::~ConeMesh()
 {
-	const GLuint g_FloatsPerVertex = 3;	// Number of coordinates per vertex
-	const GLuint g_FloatsPerNormal = 3;	// Number of values per vertex color
-	const GLuint g_FloatsPerUV = 2;		// Number of texture coordinate values
+	glDeleteBuffers(2, m_ConeMesh.vbos);
 }
 
-ConeMesh::ConeMesh() : m_bMemoryLayoutDone(false) {}
-
-ConeMesh::~ConeMesh()
+///////////////////////////////////////////////////
+//	ReleaseConeMesh()
+//	Deletes the buffers and the CPU copy of the mesh.
+///////////////////////////////////////////////////
+void ConeMesh::ReleaseConeMesh()
 {
-	glDeleteVertexArrays(1, &m_ConeMesh.vao);
 	glDeleteBuffers(2, m_ConeMesh.vbos);
+	m_ConeMesh = GLMesh();
+	m_MeshData = MeshData();
+	m_parts.clear();
 }
 
 ///////////////////////////////////////////////////
@@ -23,7 +31,8 @@ ConeMesh::~ConeMesh()
 //  store it in a VAO/VBO.  The normals and texture
 //  coordinates are also set.
 //
-//  Correct triangle drawing commands:
+//  The vertices are laid out for these draw commands,
+//  which are turned into one welded triangle list:
 //
 //	glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
 //	glDrawArrays(GL_TRIANGLE_STRIP, 36, 108);	//sides
@@ -181,58 +190,43 @@ void ConeMesh::CreateConeMesh()
 		1.0f, 0.0f, 0.0f,		0.993150651f, 0.0f, 0.116841137f, 	1.0f, 0.5f
 	};
 
-	// store vertex and index count
-	m_ConeMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
-
-	// Create VAO
-	glGenVertexArrays(1, &m_ConeMesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_ConeMesh.vao);
+	// one triangle list with the bottom cap first, so that the capped
+	// cone is a single draw and the sides alone are the index sub-range after it
+	m_MeshData.vertices.assign(std::begin(verts), std::end(verts));
+	m_MeshData.indices.clear();
+	m_parts = {
+		AppendTriangleFan(m_MeshData.indices, 0, 36),		//bottom
+		AppendTriangleStrip(m_MeshData.indices, 36, 108)	//sides
+	};
+	PrintWindingReport("cone", NormalizeWinding(m_MeshData.vertices, m_MeshData.indices));
+	PrintWeldReport("cone", WeldVertices(m_MeshData.vertices, m_MeshData.indices, m_parts));
+	PrintVertexCacheReport("cone", OptimizeMesh(m_MeshData.vertices, m_MeshData.indices, m_parts));
 
-	// Create VBO
-	glGenBuffers(1, m_ConeMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_ConeMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+	// store vertex and index count
+	m_ConeMesh.nVertices = m_MeshData.VertexCount();
+	m_ConeMesh.nIndices = m_MeshData.IndexCount();
 
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetConeMeshMemoryLayout();
-		m_bMemoryLayoutDone = true;
-	}
+	// Create 2 buffers: first one for the vertex data; second one for the indices
+	m_ConeMesh.vbos[0] = CreateBufferData(sizeof(GLfloat) * m_MeshData.vertices.size(), m_MeshData.vertices.data()); // Sends vertex or coordinate data to the GPU
+	m_ConeMesh.vbos[1] = CreateBufferData(sizeof(GLuint) * m_MeshData.indices.size(), m_MeshData.indices.data());
 }
 
 ///////////////////////////////////////////////////
 //	DrawConeMesh()
 //	Transform and draw the Cone mesh to the window.
 ///////////////////////////////////////////////////
-void ConeMesh::DrawConeMesh(bool bDrawBottom) const
+void ConeMesh::DrawConeMesh() const
 {
-	glBindVertexArray(m_ConeMesh.vao);
-
-	if (bDrawBottom == true)
-	{
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
-	}
-	glDrawArrays(GL_TRIANGLE_STRIP, 36, 108);	//sides
-
-	glBindVertexArray(0);
+	MeshData::Layout::Bind(m_ConeMesh.vbos[0], m_ConeMesh.vbos[1]);
+	glDrawElements(GL_TRIANGLES, m_ConeMesh.nIndices, GL_UNSIGNED_INT, (void*)0);	//bottom and sides
 }
 
-
-void ConeMesh::SetConeMeshMemoryLayout()
+///////////////////////////////////////////////////
+//	DrawConeRange()
+//	Draw one named range of the Cone mesh, see ShapeMeshes::DrawSubmesh().
+///////////////////////////////////////////////////
+void ConeMesh::DrawConeRange(const SubmeshRange& submesh) const
 {
-	// The following code defines the layout of the mesh data in memory - each mesh needs
-	// to have the same memory layout so that the data is retrieved properly by the shaders
-
-	// Strides between vertex coordinates is 6 (x, y, z, r, g, b, a). A tightly packed stride is 0.
-	GLint stride = sizeof(float) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV);// The number of floats before each
-
-	// Create Vertex Attribute Pointers
-	glVertexAttribPointer(0, g_FloatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, g_FloatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * g_FloatsPerVertex));
-	glEnableVertexAttribArray(1);
-
-	glVertexAttribPointer(2, g_FloatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (g_FloatsPerVertex + g_FloatsPerNormal)));
-	glEnableVertexAttribArray(2);
-}
\ No newline at end of file
+	MeshData::Layout::Bind(m_ConeMesh.vbos[0], m_ConeMesh.vbos[1]);
+	submesh.Draw();
+}
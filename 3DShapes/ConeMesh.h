@@ -3,6 +3,10 @@
 #pragma once
 
 #include <GL/glew.h>
+#include <vector>
+
+#include "MeshData.h"
+#include "SubmeshRange.h"
 
 class ConeMesh
 {
@@ -13,21 +17,22 @@ public:
 	~ConeMesh();
 
 	void CreateConeMesh();// method for loading the shape mesh data into memory
-	void DrawConeMesh(bool bDrawBottom = true) const;
+	void ReleaseConeMesh(); // deletes the buffers and the CPU copy until the next CreateConeMesh()
+	void DrawConeMesh() const;
+	void DrawConeRange(const SubmeshRange& submesh) const; // draws a named range of the cone
+	const MeshData& GetMeshData() const { return m_MeshData; } // CPU copy of the uploaded mesh data
+	const std::vector<IndexRange>& GetParts() const { return m_parts; } // bottom cap and sides
 
 private:
 	struct GLMesh
 	{
-		GLuint vao;         // Handle for the vertex array object
 		GLuint vbos[2];     // Handles for the vertex buffer objects
 		GLuint nVertices;	// Number of vertices for the mesh
 		GLuint nIndices;    // Number of indices for the mesh
 	};
 
 	GLMesh m_ConeMesh;
-
-	void SetConeMeshMemoryLayout();
-
-	bool m_bMemoryLayoutDone;
+	MeshData m_MeshData; // CPU copy of the uploaded mesh data
+	std::vector<IndexRange> m_parts; // index ranges of the bottom cap and the sides
 };
 #endif // CONE_MESH_H
\ No newline at end of file
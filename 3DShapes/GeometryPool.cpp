@@ -0,0 +1,173 @@
+#include "GeometryPool.h"
+#include <algorithm>
+
+GeometryPool::GeometryPool() : m_vertexCount(0), m_indexCount(0), m_vao(0), m_vbos{ 0, 0 } {}
+
+GeometryPool::~GeometryPool()
+{
+	glDeleteVertexArrays(1, &m_vao);
+	glDeleteBuffers(2, m_vbos);
+}
+
+///////////////////////////////////////////////////
+//	AddMesh()
+//
+//	Append the mesh data to the packed buffers and
+//	record where it lives along with its bounding sphere.
+///////////////////////////////////////////////////
+GLuint GeometryPool::AddMesh(const MeshData& meshData)
+{
+	MeshRange range;
+	range.firstIndex = m_indexCount;
+	range.indexCount = meshData.IndexCount();
+	range.baseVertex = static_cast<GLint>(m_vertexCount);
+	range.vertexCount = meshData.VertexCount();
+
+	// bounding sphere centered on the bounding box of the positions
+	glm::vec3 minCorner(0.0f);
+	glm::vec3 maxCorner(0.0f);
+	for (GLuint i = 0; i < meshData.VertexCount(); ++i)
+	{
+		const GLfloat* vertex = &meshData.vertices[i * MeshData::FloatsPerVertex];
+		glm::vec3 position(vertex[0], vertex[1], vertex[2]);
+		minCorner = (i == 0) ? position : glm::min(minCorner, position);
+		maxCorner = (i == 0) ? position : glm::max(maxCorner, position);
+	}
+
+	glm::vec3 center = (minCorner + maxCorner) * 0.5f;
+	float radius = 0.0f;
+	for (GLuint i = 0; i < meshData.VertexCount(); ++i)
+	{
+		const GLfloat* vertex = &meshData.vertices[i * MeshData::FloatsPerVertex];
+		radius = std::max(radius, glm::length(glm::vec3(vertex[0], vertex[1], vertex[2]) - center));
+	}
+	range.bounds = glm::vec4(center, radius);
+
+	// meshes added one after another are uploaded together
+	if (m_uploadSpans.empty() ||
+		m_uploadSpans.back().firstVertex + m_uploadSpans.back().vertexCount != m_vertexCount ||
+		m_uploadSpans.back().firstIndex + m_uploadSpans.back().indexCount != m_indexCount)
+	{
+		m_uploadSpans.push_back({ m_vertexCount, 0, m_indexCount, 0,
+			m_vertices.size() / MeshData::FloatsPerVertex, m_indices.size() });
+	}
+	m_uploadSpans.back().vertexCount += range.vertexCount;
+	m_uploadSpans.back().indexCount += range.indexCount;
+
+	m_vertices.insert(m_vertices.end(), meshData.vertices.begin(), meshData.vertices.end());
+	m_indices.insert(m_indices.end(), meshData.indices.begin(), meshData.indices.end());
+	m_vertexCount += range.vertexCount;
+	m_indexCount += range.indexCount;
+	m_meshRanges.push_back(range);
+	m_lodChains.emplace_back();
+
+	return static_cast<GLuint>(m_meshRanges.size() - 1);
+}
+
+///////////////////////////////////////////////////
+//	ReserveMesh()
+//
+//	Only the range is recorded, the buffers get room for
+//	it in Upload() but nothing is sent. The caller knows
+//	the shape, so it gives the bounding sphere.
+///////////////////////////////////////////////////
+GLuint GeometryPool::ReserveMesh(GLuint vertexCount, GLuint indexCount, const glm::vec4& bounds)
+{
+	MeshRange range;
+	range.firstIndex = m_indexCount;
+	range.indexCount = indexCount;
+	range.baseVertex = static_cast<GLint>(m_vertexCount);
+	range.vertexCount = vertexCount;
+	range.bounds = bounds;
+
+	m_vertexCount += vertexCount;
+	m_indexCount += indexCount;
+	m_meshRanges.push_back(range);
+	m_lodChains.emplace_back();
+
+	return static_cast<GLuint>(m_meshRanges.size() - 1);
+}
+
+///////////////////////////////////////////////////
+//	AddSubmesh()
+//
+//	Nothing is added to the buffers, the new range points
+//	into those of the mesh with its own bounding sphere.
+//	It has no coarser levels, as the index ranges of the
+//	parts are not kept through simplification.
+///////////////////////////////////////////////////
+GLuint GeometryPool::AddSubmesh(GLuint meshID, const SubmeshRange& submesh)
+{
+	MeshRange range = m_meshRanges[meshID];
+	range.firstIndex += submesh.firstIndex;
+	range.indexCount = submesh.indexCount;
+	range.baseVertex += submesh.baseVertex;
+	range.bounds = submesh.bounds;
+
+	m_meshRanges.push_back(range);
+	m_lodChains.emplace_back();
+
+	return static_cast<GLuint>(m_meshRanges.size() - 1);
+}
+
+///////////////////////////////////////////////////
+//	SetLodChain()
+//
+//	Objects are culled with the bounding sphere of level 0,
+//	so switching levels never changes what is visible.
+///////////////////////////////////////////////////
+void GeometryPool::SetLodChain(GLuint meshID, const std::vector<GLuint>& coarserMeshIDs)
+{
+	m_lodChains[meshID] = coarserMeshIDs;
+}
+
+GLuint GeometryPool::GetLodCount(GLuint meshID) const
+{
+	return static_cast<GLuint>(m_lodChains[meshID].size()) + 1;
+}
+
+GLuint GeometryPool::GetLodMesh(GLuint meshID, GLuint level) const
+{
+	return level == 0 ? meshID : m_lodChains[meshID][level - 1];
+}
+
+///////////////////////////////////////////////////
+//	Upload()
+//
+//	Create the shared VAO/VBO/EBO from the packed data.
+//	The pool keeps a VAO of its own because the culling
+//	pass adds a per-instance attribute to it. Reserved
+//	meshes are left undefined until they are written.
+///////////////////////////////////////////////////
+void GeometryPool::Upload()
+{
+	if (m_vao == 0)
+	{
+		m_vao = MeshData::Layout::CreateVertexArray();
+		m_vbos[0] = CreateBufferData(0, nullptr);
+		m_vbos[1] = CreateBufferData(0, nullptr);
+	}
+
+	const size_t vertexBytes = MeshData::FloatsPerVertex * sizeof(GLfloat);
+	SetBufferData(m_vbos[0], m_vertexCount * vertexBytes, nullptr);
+	SetBufferData(m_vbos[1], m_indexCount * sizeof(GLuint), nullptr);
+	for (const UploadSpan& span : m_uploadSpans)
+	{
+		SetBufferSubData(m_vbos[0], span.firstVertex * vertexBytes, span.vertexCount * vertexBytes,
+			m_vertices.data() + span.sourceVertex * MeshData::FloatsPerVertex);
+		SetBufferSubData(m_vbos[1], span.firstIndex * sizeof(GLuint), span.indexCount * sizeof(GLuint),
+			m_indices.data() + span.sourceIndex);
+	}
+
+	// same memory layout as the individual meshes so the shaders read it identically
+	MeshData::Layout::SetBuffers(m_vao, m_vbos[0], m_vbos[1]);
+}
+
+///////////////////////////////////////////////////
+//	Bind()
+//	Activate the shared VAO for drawing.
+///////////////////////////////////////////////////
+void GeometryPool::Bind() const
+{
+	glBindVertexArray(m_vao);
+}
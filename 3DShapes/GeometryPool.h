@@ -0,0 +1,83 @@
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "MeshData.h"
+#include "SubmeshRange.h"
+
+/***********************************************************
+ *  GeometryPool
+ *
+ *  Packs the vertex and index data of many meshes into one
+ *  shared VAO/VBO/EBO so that they can be drawn together
+ *  with indirect and multi-draw commands.
+ ***********************************************************/
+class GeometryPool
+{
+public:
+	// location of one mesh inside the shared buffers
+	struct MeshRange
+	{
+		GLuint firstIndex;	// First index of the mesh in the shared index buffer
+		GLuint indexCount;	// Number of indices for the mesh
+		GLint baseVertex;	// Offset added to every index of the mesh
+		GLuint vertexCount;	// Number of vertices for the mesh
+		glm::vec4 bounds;	// Object-space bounding sphere (xyz center, w radius)
+	};
+
+	GeometryPool();
+	~GeometryPool();
+
+	GLuint AddMesh(const MeshData& meshData);	// Appends a mesh and returns its ID
+	void Upload();	// Sends the packed data to the GPU
+
+	// room for a mesh that is written on the GPU after Upload(),
+	// e.g. by a compute shader; it has no CPU data to send
+	GLuint ReserveMesh(GLuint vertexCount, GLuint indexCount, const glm::vec4& bounds);
+
+	// a named range of an added mesh as a mesh of its own, sharing
+	// the mesh's data, so that it is drawn like any other mesh
+	GLuint AddSubmesh(GLuint meshID, const SubmeshRange& submesh);
+
+	void Bind() const;
+	GLuint GetVertexArray() const { return m_vao; }
+	GLuint GetVertexBuffer() const { return m_vbos[0]; }
+	GLuint GetIndexBuffer() const { return m_vbos[1]; }
+	GLuint GetMeshCount() const { return static_cast<GLuint>(m_meshRanges.size()); }
+	const MeshRange& GetMeshRange(GLuint meshID) const { return m_meshRanges[meshID]; }
+
+	// coarser versions of a mesh, level 0 is the mesh itself and
+	// each further level is another pooled mesh with fewer triangles
+	void SetLodChain(GLuint meshID, const std::vector<GLuint>& coarserMeshIDs);
+	GLuint GetLodCount(GLuint meshID) const;
+	GLuint GetLodMesh(GLuint meshID, GLuint level) const;
+
+private:
+	// run of added meshes that follow each other in the shared buffers
+	// and are uploaded from m_vertices and m_indices in one piece
+	struct UploadSpan
+	{
+		GLuint firstVertex;		// First vertex of the run in the shared vertex buffer
+		GLuint vertexCount;
+		GLuint firstIndex;		// First index of the run in the shared index buffer
+		GLuint indexCount;
+		size_t sourceVertex;	// First vertex of the run in m_vertices
+		size_t sourceIndex;		// First index of the run in m_indices
+	};
+
+	std::vector<GLfloat> m_vertices;	// Packed interleaved vertex data of the added meshes
+	std::vector<GLuint> m_indices;		// Packed index data of the added meshes
+	std::vector<UploadSpan> m_uploadSpans;	// Where the packed data goes in the shared buffers
+	GLuint m_vertexCount;	// Vertices of all meshes, reserved ones included
+	GLuint m_indexCount;	// Indices of all meshes, reserved ones included
+	std::vector<MeshRange> m_meshRanges;	// Location of each mesh in the shared buffers
+	std::vector<std::vector<GLuint>> m_lodChains;	// Coarser levels of each mesh, empty without LODs
+
+	GLuint m_vao;		// Handle for the shared vertex array object
+	GLuint m_vbos[2];	// Handles for the shared vertex and index buffers
+};
+#endif // GEOMETRY_POOL_H
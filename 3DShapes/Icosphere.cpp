@@ -0,0 +1,304 @@
+#include "Icosphere.h"
+#include "ParametricSurface.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+
+namespace
+{
+	const float g_PoleEpsilon = 1e-6f;			// Distance from the y axis below which a vertex is a pole
+	const GLuint g_BenchmarkMaxLevel = 6;		// Finest icosphere level of the benchmark
+	const GLuint g_UVSphereStacks = 32;			// Stacks of the UV sphere loaded by default
+
+	// the 12 icosahedron vertices (+-1, +-phi, 0) and their cyclic
+	// permutations, and its 20 faces wound counter-clockwise from outside
+	const float g_Phi = 1.6180339887498949f;
+	const glm::vec3 g_IcosahedronVertices[12] = {
+		{ -1.0f, g_Phi, 0.0f }, { 1.0f, g_Phi, 0.0f }, { -1.0f, -g_Phi, 0.0f }, { 1.0f, -g_Phi, 0.0f },
+		{ 0.0f, -1.0f, g_Phi }, { 0.0f, 1.0f, g_Phi }, { 0.0f, -1.0f, -g_Phi }, { 0.0f, 1.0f, -g_Phi },
+		{ g_Phi, 0.0f, -1.0f }, { g_Phi, 0.0f, 1.0f }, { -g_Phi, 0.0f, -1.0f }, { -g_Phi, 0.0f, 1.0f }
+	};
+	const GLuint g_IcosahedronFaces[20][3] = {
+		{ 0, 11, 5 }, { 0, 5, 1 }, { 0, 1, 7 }, { 0, 7, 10 }, { 0, 10, 11 },
+		{ 1, 5, 9 }, { 5, 11, 4 }, { 11, 10, 2 }, { 10, 7, 6 }, { 7, 1, 8 },
+		{ 3, 9, 4 }, { 3, 4, 2 }, { 3, 2, 6 }, { 3, 6, 8 }, { 3, 8, 9 },
+		{ 4, 9, 5 }, { 2, 4, 11 }, { 6, 2, 10 }, { 8, 6, 7 }, { 9, 8, 1 }
+	};
+
+	// splits every triangle into four, reusing the midpoint of an
+	// edge that the neighboring triangle has already split
+	void Subdivide(std::vector<glm::vec3>& directions, std::vector<GLuint>& triangles)
+	{
+		std::unordered_map<uint64_t, GLuint> midpoints;
+		midpoints.reserve(triangles.size() / 2);
+		auto midpoint = [&](GLuint a, GLuint b)
+		{
+			uint64_t key = (static_cast<uint64_t>(std::min(a, b)) << 32) | std::max(a, b);
+			auto entry = midpoints.find(key);
+			if (entry != midpoints.end())
+			{
+				return entry->second;
+			}
+			GLuint index = static_cast<GLuint>(directions.size());
+			directions.push_back(glm::normalize(directions[a] + directions[b]));
+			midpoints.emplace(key, index);
+			return index;
+		};
+
+		std::vector<GLuint> finer;
+		finer.reserve(triangles.size() * 4);
+		for (size_t i = 0; i < triangles.size(); i += 3)
+		{
+			GLuint a = triangles[i];
+			GLuint b = triangles[i + 1];
+			GLuint c = triangles[i + 2];
+			GLuint ab = midpoint(a, b);
+			GLuint bc = midpoint(b, c);
+			GLuint ca = midpoint(c, a);
+			GLuint corners[12] = { a, ab, ca, ab, b, bc, ca, bc, c, ab, bc, ca };
+			finer.insert(finer.end(), corners, corners + 12);
+		}
+		triangles.swap(finer);
+	}
+
+	// point of the triangle closest to the origin, by the region
+	// of the triangle the origin projects into
+	glm::vec3 ClosestPointToOrigin(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c)
+	{
+		glm::vec3 ab = b - a;
+		glm::vec3 ac = c - a;
+		glm::vec3 ap = -a;
+		float d1 = glm::dot(ab, ap);
+		float d2 = glm::dot(ac, ap);
+		if (d1 <= 0.0f && d2 <= 0.0f)
+		{
+			return a;
+		}
+
+		glm::vec3 bp = -b;
+		float d3 = glm::dot(ab, bp);
+		float d4 = glm::dot(ac, bp);
+		if (d3 >= 0.0f && d4 <= d3)
+		{
+			return b;
+		}
+
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		{
+			return a + (d1 / (d1 - d3)) * ab;
+		}
+
+		glm::vec3 cp = -c;
+		float d5 = glm::dot(ab, cp);
+		float d6 = glm::dot(ac, cp);
+		if (d6 >= 0.0f && d5 <= d6)
+		{
+			return c;
+		}
+
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		{
+			return a + (d2 / (d2 - d6)) * ac;
+		}
+
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+		{
+			return b + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (c - b);
+		}
+
+		float denominator = 1.0f / (va + vb + vc);
+		return a + (vb * denominator) * ab + (vc * denominator) * ac;
+	}
+
+	// UV sphere of the given stacks and twice as many slices
+	MeshData MakeUVSphere(GLuint stacks)
+	{
+		MeshData meshData;
+		GenerateParametricSurface(SphereSurface{ 1.0f }, SphereSurface::Grid(stacks, stacks * 2), meshData);
+		return meshData;
+	}
+}
+
+///////////////////////////////////////////////////
+//	GenerateIcosphere()
+//
+//	The texture u is the angle around the y axis, as on the
+//	UV sphere. A triangle whose corners span more than half
+//	a turn crosses the seam, its corners near u = 0 use a
+//	copy at u + 1. A pole has no angle, so each triangle
+//	at a pole gets a copy with the u of its other corners.
+///////////////////////////////////////////////////
+void GenerateIcosphere(float radius, GLuint subdivisions, MeshData& meshData, std::vector<IndexRange>* parts)
+{
+	std::vector<glm::vec3> directions;
+	std::vector<GLuint> triangles;
+	for (const glm::vec3& vertex : g_IcosahedronVertices)
+	{
+		directions.push_back(glm::normalize(vertex));
+	}
+	for (const auto& face : g_IcosahedronFaces)
+	{
+		triangles.insert(triangles.end(), face, face + 3);
+	}
+	for (GLuint level = 0; level < subdivisions; ++level)
+	{
+		Subdivide(directions, triangles);
+	}
+
+	// one vertex per direction, then the seam and pole copies
+	meshData.vertices.clear();
+	meshData.vertices.reserve(directions.size() * MeshData::FloatsPerVertex);
+	std::vector<float> textureU(directions.size());
+	std::vector<bool> bPole(directions.size());
+	auto addVertex = [&](const glm::vec3& direction, float u)
+	{
+		const GLfloat vertex[MeshData::FloatsPerVertex] = {
+			radius * direction.x, radius * direction.y, radius * direction.z,
+			direction.x, direction.y, direction.z,
+			u + 0.5f, direction.y * 0.5f + 0.5f };
+		meshData.vertices.insert(meshData.vertices.end(), vertex, vertex + MeshData::FloatsPerVertex);
+		return meshData.VertexCount() - 1;
+	};
+	for (size_t i = 0; i < directions.size(); ++i)
+	{
+		const glm::vec3& direction = directions[i];
+		float angle = std::atan2(direction.z, direction.x);
+		textureU[i] = (angle < 0.0f ? angle + glm::two_pi<float>() : angle) / glm::two_pi<float>();
+		bPole[i] = std::fabs(direction.x) < g_PoleEpsilon && std::fabs(direction.z) < g_PoleEpsilon;
+		addVertex(direction, textureU[i]);
+	}
+
+	std::unordered_map<GLuint, GLuint> seamCopies;
+	std::vector<GLuint> upper;
+	std::vector<GLuint> lower;
+	for (size_t i = 0; i < triangles.size(); i += 3)
+	{
+		GLuint corners[3] = { triangles[i], triangles[i + 1], triangles[i + 2] };
+		float u[3];
+		float minU = 1.0f;
+		float maxU = 0.0f;
+		for (int k = 0; k < 3; ++k)
+		{
+			u[k] = textureU[corners[k]];
+			if (!bPole[corners[k]])
+			{
+				minU = std::min(minU, u[k]);
+				maxU = std::max(maxU, u[k]);
+			}
+		}
+
+		if (maxU - minU > 0.5f)
+		{
+			for (int k = 0; k < 3; ++k)
+			{
+				if (!bPole[corners[k]] && u[k] < 0.5f)
+				{
+					auto copy = seamCopies.find(corners[k]);
+					if (copy == seamCopies.end())
+					{
+						copy = seamCopies.emplace(corners[k], addVertex(directions[corners[k]], u[k] + 1.0f)).first;
+					}
+					corners[k] = copy->second;
+					u[k] += 1.0f;
+				}
+			}
+		}
+
+		for (int k = 0; k < 3; ++k)
+		{
+			if (corners[k] < directions.size() && bPole[corners[k]])
+			{
+				float poleU = 0.5f * (u[(k + 1) % 3] + u[(k + 2) % 3]);
+				corners[k] = addVertex(directions[corners[k]], poleU);
+			}
+		}
+
+		float centroidY = directions[triangles[i]].y + directions[triangles[i + 1]].y + directions[triangles[i + 2]].y;
+		std::vector<GLuint>& half = centroidY >= 0.0f ? upper : lower;
+		half.insert(half.end(), corners, corners + 3);
+	}
+
+	meshData.indices = upper;
+	meshData.indices.insert(meshData.indices.end(), lower.begin(), lower.end());
+	if (parts)
+	{
+		*parts = {
+			{ 0, static_cast<GLuint>(upper.size()) },
+			{ static_cast<GLuint>(upper.size()), static_cast<GLuint>(lower.size()) }
+		};
+	}
+}
+
+///////////////////////////////////////////////////
+//	MeasureSphereError()
+//
+//	The vertices lie on the sphere, so the error of a flat
+//	triangle is how far its point closest to the center
+//	falls short of the radius.
+///////////////////////////////////////////////////
+SphereErrorReport MeasureSphereError(const MeshData& meshData, float radius)
+{
+	SphereErrorReport report = { 0, 0.0f };
+	auto position = [&](GLuint index)
+	{
+		const GLfloat* vertex = &meshData.vertices[static_cast<size_t>(index) * MeshData::FloatsPerVertex];
+		return glm::vec3(vertex[0], vertex[1], vertex[2]);
+	};
+
+	for (size_t i = 0; i + 2 < meshData.indices.size(); i += 3)
+	{
+		glm::vec3 a = position(meshData.indices[i]);
+		glm::vec3 b = position(meshData.indices[i + 1]);
+		glm::vec3 c = position(meshData.indices[i + 2]);
+		if (glm::length(glm::cross(b - a, c - a)) <= 1e-12f * radius * radius)
+		{
+			continue;
+		}
+
+		report.triangleCount++;
+		float distance = glm::length(ClosestPointToOrigin(a, b, c));
+		report.maxError = std::max(report.maxError, (radius - distance) / radius);
+	}
+	return report;
+}
+
+///////////////////////////////////////////////////
+//	RunIcosphereBenchmark()
+//
+//	For each level the UV sphere with twice as many slices
+//	as stacks is refined until its largest error is no more
+//	than the icosphere's, and the triangle counts compared.
+///////////////////////////////////////////////////
+void RunIcosphereBenchmark()
+{
+	SphereErrorReport loaded = MeasureSphereError(MakeUVSphere(g_UVSphereStacks), 1.0f);
+	std::cout << "INFO: UV sphere " << g_UVSphereStacks << " x " << g_UVSphereStacks * 2 << ": "
+		<< loaded.triangleCount << " triangles, largest error " << loaded.maxError << std::endl;
+
+	GLuint stacks = 2;
+	for (GLuint level = 1; level <= g_BenchmarkMaxLevel; ++level)
+	{
+		MeshData icosphere;
+		GenerateIcosphere(1.0f, level, icosphere);
+		SphereErrorReport ico = MeasureSphereError(icosphere, 1.0f);
+
+		SphereErrorReport uv = MeasureSphereError(MakeUVSphere(stacks), 1.0f);
+		while (uv.maxError > ico.maxError)
+		{
+			uv = MeasureSphereError(MakeUVSphere(++stacks), 1.0f);
+		}
+
+		std::cout << "INFO: icosphere level " << level << ": " << ico.triangleCount << " triangles, "
+			<< icosphere.VertexCount() << " vertices, largest error " << ico.maxError
+			<< "; UV sphere " << stacks << " x " << stacks * 2 << " at that error: " << uv.triangleCount
+			<< " triangles, " << static_cast<float>(uv.triangleCount) / ico.triangleCount << " times as many" << std::endl;
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef ICOSPHERE_H
+#define ICOSPHERE_H
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+
+#include "MeshData.h"
+
+// How far the flat triangles of a sphere mesh fall inside the sphere
+struct SphereErrorReport
+{
+	GLuint triangleCount;	// Triangles with an area, the collapsed pole ones are left out
+	float maxError;			// Largest distance of a triangle point inside the sphere, relative to the radius
+};
+
+///////////////////////////////////////////////////
+//	GenerateIcosphere()
+//
+//	Subdivides an icosahedron, each level splitting every
+//	triangle into four at its edge midpoints pushed out to
+//	the sphere, so the triangles stay nearly equal in size
+//	everywhere instead of crowding at the poles. A midpoint
+//	cache keyed by edge gives each new vertex once. Normals
+//	and texture coords are those of the UV sphere; vertices
+//	on the texture seam and at the poles are split so the
+//	coords do not wrap across a triangle. Level n has
+//	20 * 4^n triangles. The parts are the triangles above
+//	and below the equator, the "upper half" and "lower half"
+//	submeshes of the sphere.
+///////////////////////////////////////////////////
+void GenerateIcosphere(float radius,
+	GLuint subdivisions,
+	MeshData& meshData,
+	std::vector<IndexRange>* parts = nullptr);
+
+// Measures the triangles of a sphere mesh centered at the origin
+SphereErrorReport MeasureSphereError(const MeshData& meshData, float radius);
+
+// Prints the triangles of each icosphere level next to those the
+// UV sphere needs for the same largest error
+void RunIcosphereBenchmark();
+
+#endif // ICOSPHERE_H
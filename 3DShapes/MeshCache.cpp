@@ -0,0 +1,409 @@
+#include "MeshCache.h"
+#include "MeshCodec.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <direct.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	// bump whenever a generator, the welding, the optimizer or the mesh
+	// codec changes the files it produces, so that the old ones are regenerated
+	const uint32_t g_MeshCacheVersion = 3;
+	const char g_MeshCacheMagic[4] = { 'M', 'S', 'H', 'C' };
+	const char* g_MeshCacheExtension = ".mesh";
+	const uint32_t g_ChecksumSeed = 2166136261u;	// FNV-1a offset basis
+	const uint64_t g_SourceHashSeed = 14695981039346656037ull;	// 64 bit FNV-1a offset basis
+
+	// fixed size start of every cache file, followed by the key padded
+	// to 4 bytes, the parts and the encoded mesh padded to 4 bytes
+	struct MeshCacheHeader
+	{
+		char magic[4];
+		uint32_t version;		// g_MeshCacheVersion of the writer
+		uint32_t keyLength;		// Bytes of the key without padding
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t partCount;
+		uint32_t checksum;		// FNV-1a of every 32 bit word after the header
+		uint32_t encodedBytes;	// Bytes of the encoded mesh without padding
+	};
+	static_assert(sizeof(MeshCacheHeader) == 32, "mesh cache header must not be padded");
+
+	uint32_t PaddedLength(uint32_t length)
+	{
+		return (length + 3) & ~3u;
+	}
+
+	uint32_t UpdateChecksum(uint32_t hash, const void* data, size_t bytes)
+	{
+		const unsigned char* word = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i + 4 <= bytes; i += 4)
+		{
+			uint32_t value;
+			std::memcpy(&value, word + i, sizeof(value));
+			hash = (hash ^ value) * 16777619u;
+		}
+		return hash;
+	}
+
+	uint64_t UpdateSourceHash(uint64_t hash, const void* data, size_t bytes)
+	{
+		const unsigned char* word = static_cast<const unsigned char*>(data);
+		for (size_t i = 0; i + 4 <= bytes; i += 4)
+		{
+			uint32_t value;
+			std::memcpy(&value, word + i, sizeof(value));
+			hash = (hash ^ value) * 1099511628211ull;
+		}
+		return hash;
+	}
+
+	// appends the hex digits of the low bits of a value, most significant first
+	void AppendHexDigits(std::string& key, uint64_t bits, int digitCount)
+	{
+		static const char digits[] = "0123456789abcdef";
+
+		for (int shift = (digitCount - 1) * 4; shift >= 0; shift -= 4)
+		{
+			key += digits[(bits >> shift) & 0xF];
+		}
+	}
+}
+
+///////////////////////////////////////////////////
+//	MappedFile()
+///////////////////////////////////////////////////
+MappedFile::MappedFile()
+	: m_pData(nullptr),
+	m_size(0)
+#ifdef _WIN32
+	, m_hFile(INVALID_HANDLE_VALUE),
+	m_hMapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+///////////////////////////////////////////////////
+//	Open()
+//
+//	Maps the whole file read-only. Empty files cannot be
+//	mapped and fail like missing ones.
+///////////////////////////////////////////////////
+bool MappedFile::Open(const std::string& path)
+{
+	Close();
+
+#ifdef _WIN32
+	m_hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (m_hFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(m_hFile, &size) || size.QuadPart == 0)
+	{
+		Close();
+		return false;
+	}
+
+	m_hMapping = CreateFileMappingA(m_hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_hMapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+
+	m_pData = static_cast<const unsigned char*>(MapViewOfFile(m_hMapping, FILE_MAP_READ, 0, 0, 0));
+	if (m_pData == nullptr)
+	{
+		Close();
+		return false;
+	}
+	m_size = static_cast<size_t>(size.QuadPart);
+#else
+	int file = open(path.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return false;
+	}
+
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size == 0)
+	{
+		close(file);
+		return false;
+	}
+
+	// the mapping stays valid after the descriptor is closed
+	void* data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+	m_pData = static_cast<const unsigned char*>(data);
+	m_size = static_cast<size_t>(status.st_size);
+#endif
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	Close()
+///////////////////////////////////////////////////
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (m_pData != nullptr)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (m_hMapping != nullptr)
+	{
+		CloseHandle(m_hMapping);
+		m_hMapping = nullptr;
+	}
+	if (m_hFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(m_hFile);
+		m_hFile = INVALID_HANDLE_VALUE;
+	}
+#else
+	if (m_pData != nullptr)
+	{
+		munmap(const_cast<unsigned char*>(m_pData), m_size);
+	}
+#endif
+	m_pData = nullptr;
+	m_size = 0;
+}
+
+///////////////////////////////////////////////////
+//	MeshCache()
+///////////////////////////////////////////////////
+MeshCache::MeshCache(const std::string& directory)
+	: m_directory(directory)
+{
+}
+
+///////////////////////////////////////////////////
+//	MakeKey()
+//
+//	The parameters are written as the hex digits of their
+//	bits, so that the key is exact and safe as a file name.
+///////////////////////////////////////////////////
+std::string MeshCache::MakeKey(const char* generator, std::initializer_list<float> parameters)
+{
+	std::string key = generator;
+	for (float parameter : parameters)
+	{
+		uint32_t bits;
+		std::memcpy(&bits, &parameter, sizeof(bits));
+
+		key += '_';
+		AppendHexDigits(key, bits, 8);
+	}
+	return key;
+}
+
+///////////////////////////////////////////////////
+//	MakeKey()
+//
+//	For meshes derived from another one: a 64 bit FNV-1a
+//	hash of the source vertex and index buffers and their
+//	exact counts stand in for the source, so any change to
+//	it, or another source of the same size, is a new key.
+///////////////////////////////////////////////////
+std::string MeshCache::MakeKey(const char* generator, const MeshData& source, std::initializer_list<float> parameters)
+{
+	uint64_t hash = UpdateSourceHash(g_SourceHashSeed, source.vertices.data(), source.vertices.size() * sizeof(GLfloat));
+	hash = UpdateSourceHash(hash, source.indices.data(), source.indices.size() * sizeof(GLuint));
+
+	std::string key = generator;
+	key += '_';
+	AppendHexDigits(key, hash, 16);
+	key += '_' + std::to_string(source.VertexCount()) + '_' + std::to_string(source.IndexCount());
+	return key + MakeKey("", parameters);
+}
+
+///////////////////////////////////////////////////
+//	GetPath()
+///////////////////////////////////////////////////
+std::string MeshCache::GetPath(const std::string& key) const
+{
+	return m_directory + "/" + key + g_MeshCacheExtension;
+}
+
+///////////////////////////////////////////////////
+//	Load()
+//
+//	Maps the file of the key and decodes the mesh from it.
+//	Returns false when the file is missing or when its
+//	version, key, sizes or checksum do not match or the
+//	encoded mesh does not decode.
+///////////////////////////////////////////////////
+bool MeshCache::Load(const std::string& key, CachedMesh& mesh) const
+{
+	MappedFile file;
+	if (!file.Open(GetPath(key)))
+	{
+		return false;
+	}
+
+	const unsigned char* data = file.GetData();
+	const size_t size = file.GetSize();
+
+	MeshCacheHeader header;
+	bool bValid = size >= sizeof(header);
+	if (bValid)
+	{
+		std::memcpy(&header, data, sizeof(header));
+		bValid = std::memcmp(header.magic, g_MeshCacheMagic, sizeof(header.magic)) == 0 &&
+			header.version == g_MeshCacheVersion &&
+			header.keyLength == key.size();
+	}
+
+	// 64 bit sizes, so that a damaged header cannot wrap around
+	uint64_t keyBytes = 0, partBytes = 0;
+	if (bValid)
+	{
+		keyBytes = PaddedLength(header.keyLength);
+		partBytes = static_cast<uint64_t>(header.partCount) * 2 * sizeof(GLuint);
+		bValid = sizeof(header) + keyBytes + partBytes + PaddedLength(header.encodedBytes) == size &&
+			std::memcmp(data + sizeof(header), key.data(), key.size()) == 0;
+	}
+	if (bValid)
+	{
+		uint32_t checksum = UpdateChecksum(g_ChecksumSeed, data + sizeof(header), size - sizeof(header));
+		bValid = checksum == header.checksum;
+	}
+	if (bValid)
+	{
+		const unsigned char* encoded = data + sizeof(header) + keyBytes + partBytes;
+		bValid = DecodeMesh(encoded, header.encodedBytes, mesh.meshData) &&
+			mesh.meshData.VertexCount() == header.vertexCount &&
+			mesh.meshData.IndexCount() == header.indexCount;
+	}
+	if (!bValid)
+	{
+		std::cout << "INFO: mesh cache file for " << key << " is stale or corrupt" << std::endl;
+		mesh.meshData = MeshData();
+		return false;
+	}
+
+	const unsigned char* section = data + sizeof(header) + keyBytes;
+	mesh.parts.resize(header.partCount);
+	for (IndexRange& part : mesh.parts)
+	{
+		std::memcpy(&part.firstIndex, section, sizeof(GLuint));
+		std::memcpy(&part.indexCount, section + sizeof(GLuint), sizeof(GLuint));
+		section += 2 * sizeof(GLuint);
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	Store()
+//
+//	Encodes the mesh and writes it to a temporary file that
+//	is renamed over the old one, so an interrupted write
+//	never leaves a half written file under the name of the key.
+//	The exact codec keeps every bit, so later loads see the
+//	same buffers the caller uploads this time.
+///////////////////////////////////////////////////
+bool MeshCache::Store(const std::string& key,
+	const std::vector<GLfloat>& vertices,
+	const std::vector<GLuint>& indices,
+	const std::vector<IndexRange>& parts) const
+{
+#ifdef _WIN32
+	_mkdir(m_directory.c_str());
+#else
+	mkdir(m_directory.c_str(), 0755);
+#endif
+
+	std::vector<char> paddedKey(PaddedLength(static_cast<uint32_t>(key.size())), '\0');
+	std::memcpy(paddedKey.data(), key.data(), key.size());
+
+	std::vector<GLuint> partWords;
+	partWords.reserve(parts.size() * 2);
+	for (const IndexRange& part : parts)
+	{
+		partWords.push_back(part.firstIndex);
+		partWords.push_back(part.indexCount);
+	}
+
+	MeshData meshData;
+	meshData.vertices = vertices;
+	meshData.indices = indices;
+	std::vector<unsigned char> encoded;
+	EncodeMeshExact(meshData, encoded);
+	const size_t encodedBytes = encoded.size();
+	encoded.resize(PaddedLength(static_cast<uint32_t>(encodedBytes)), 0);
+
+	MeshCacheHeader header;
+	std::memcpy(header.magic, g_MeshCacheMagic, sizeof(header.magic));
+	header.version = g_MeshCacheVersion;
+	header.keyLength = static_cast<uint32_t>(key.size());
+	header.vertexCount = static_cast<uint32_t>(vertices.size() / MeshData::FloatsPerVertex);
+	header.indexCount = static_cast<uint32_t>(indices.size());
+	header.partCount = static_cast<uint32_t>(parts.size());
+	header.encodedBytes = static_cast<uint32_t>(encodedBytes);
+
+	uint32_t checksum = g_ChecksumSeed;
+	checksum = UpdateChecksum(checksum, paddedKey.data(), paddedKey.size());
+	checksum = UpdateChecksum(checksum, partWords.data(), partWords.size() * sizeof(GLuint));
+	checksum = UpdateChecksum(checksum, encoded.data(), encoded.size());
+	header.checksum = checksum;
+
+	const std::string path = GetPath(key);
+	const std::string temporaryPath = path + ".tmp";
+	{
+		std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		file.write(paddedKey.data(), paddedKey.size());
+		file.write(reinterpret_cast<const char*>(partWords.data()), partWords.size() * sizeof(GLuint));
+		file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+		if (!file)
+		{
+			file.close();
+			std::remove(temporaryPath.c_str());
+			std::cout << "Could not write mesh cache file " << temporaryPath << std::endl;
+			return false;
+		}
+	}
+
+	std::remove(path.c_str());
+	if (std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+	{
+		std::remove(temporaryPath.c_str());
+		std::cout << "Could not write mesh cache file " << path << std::endl;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,79 @@
+#ifndef MESH_CACHE_H
+#define MESH_CACHE_H
+#pragma once
+
+#include <GL/glew.h>
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+#include "MeshData.h"
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+
+	bool Open(const std::string& path);
+	void Close();
+
+	const unsigned char* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_size; }
+
+private:
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const unsigned char* m_pData;	// First byte of the mapping
+	size_t m_size;					// Bytes of the file
+#ifdef _WIN32
+	void* m_hFile;		// Handle of the open file
+	void* m_hMapping;	// Handle of the file mapping object
+#endif
+};
+
+// A mesh read from the cache, decoded from the mapped file; the
+// buffers can be uploaded and then moved out as the CPU copy
+struct CachedMesh
+{
+	MeshData meshData;				// Buffers decoded from the file
+	std::vector<IndexRange> parts;	// Index ranges of the separately drawn parts
+};
+
+/***********************************************************
+ *  MeshCache
+ *
+ *  Keeps the final vertex and index buffers of generated
+ *  meshes in versioned binary files, one per generator and
+ *  parameter set. The buffers are stored losslessly with
+ *  EncodeMeshExact(), so a loaded mesh is bit for bit the
+ *  one that was generated, and the memory-mapped files are
+ *  decoded straight from the mapping. A file that is
+ *  missing, from another version, truncated or fails its
+ *  checksum is a miss, and the mesh is generated and stored again.
+ ***********************************************************/
+class MeshCache
+{
+public:
+	explicit MeshCache(const std::string& directory);
+
+	// key made of the generator name and its parameters
+	static std::string MakeKey(const char* generator, std::initializer_list<float> parameters);
+	// key of a mesh made from the buffers of a source mesh
+	static std::string MakeKey(const char* generator, const MeshData& source, std::initializer_list<float> parameters);
+
+	bool Load(const std::string& key, CachedMesh& mesh) const;
+	bool Store(const std::string& key,
+		const std::vector<GLfloat>& vertices,
+		const std::vector<GLuint>& indices,
+		const std::vector<IndexRange>& parts) const;
+
+private:
+	std::string m_directory;	// Folder holding the cache files
+
+	std::string GetPath(const std::string& key) const;
+};
+
+#endif // MESH_CACHE_H
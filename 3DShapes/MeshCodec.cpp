@@ -0,0 +1,1092 @@
+#include "MeshCodec.h"
+#include "MeshImporter.h"
+#include "MeshOptimizer.h"
+#include "MeshWelding.h"
+#include "ParametricSurface.h"
+#include "Icosphere.h"
+#include "SolidTables.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_CODEC_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	const char g_MeshCodecMagic[4] = { 'M', 'S', 'H', 'Z' };
+	const uint32_t g_MeshCodecVersion = 2;
+	const uint32_t g_FlagExactVertices = 1;	// The floats are stored with all of their bits
+
+	const GLuint g_Channels = MeshData::FloatsPerVertex;	// One 16 bit channel per vertex float
+	const GLuint g_BlockVertices = 16;		// Vertices whose bytes are stored together
+	const GLuint g_QuantizedPlanes = 2;		// Byte planes of a quantized channel
+	const GLuint g_ExactPlanes = 4;			// Byte planes of an exact channel
+	const float g_QuantizedScale = 32767.0f;
+	const float g_MinExtent = 1e-6f;		// Keeps flat ranges from dividing by zero
+
+	// byte plane modes, 2 bits each in the block header
+	const unsigned g_PlaneZero = 0;			// All 16 bytes are zero, nothing stored
+	const unsigned g_PlaneNibbles = 1;		// All bytes below 16, two per stored byte
+	const unsigned g_PlaneBytes = 2;		// 16 stored bytes
+
+	// the index codes: the high nibble is an edge of the edge FIFO, counted
+	// from the newest, or g_EdgeMiss; a vertex nibble is g_NextVertex, one
+	// more than an entry of the vertex FIFO, or g_ExplicitVertex
+	const GLuint g_EdgeFifoSize = 16;
+	const unsigned g_EdgeMiss = 15;
+	const GLuint g_VertexFifoSize = 16;
+	const unsigned g_NextVertex = 0;
+	const unsigned g_ExplicitVertex = 15;
+
+	// start of every stream, followed by the vertex and the index section
+	struct MeshCodecHeader
+	{
+		char magic[4];
+		uint32_t version;			// g_MeshCodecVersion of the writer
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t vertexBytes;		// Bytes of the vertex section
+		uint32_t indexBytes;		// Bytes of the index section
+		uint32_t flags;				// g_FlagExactVertices or 0
+		uint32_t reserved;
+		float center[g_Channels];	// A channel decodes to value * scale + center, unused when exact
+		float scale[g_Channels];
+	};
+	static_assert(sizeof(MeshCodecHeader) == 96, "mesh codec header must not be padded");
+
+	uint16_t EncodeZigzag(int16_t value)
+	{
+		return static_cast<uint16_t>((static_cast<uint16_t>(value) << 1) ^ static_cast<uint16_t>(value >> 15));
+	}
+
+	int16_t DecodeZigzag(uint16_t value)
+	{
+		return static_cast<int16_t>((value >> 1) ^ (0u - (value & 1u)));
+	}
+
+	uint32_t EncodeZigzag32(int32_t value)
+	{
+		return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+	}
+
+	int32_t DecodeZigzag32(uint32_t value)
+	{
+		return static_cast<int32_t>((value >> 1) ^ (0u - (value & 1u)));
+	}
+
+	void WriteVarint(std::vector<unsigned char>& data, uint32_t value)
+	{
+		while (value >= 0x80)
+		{
+			data.push_back(static_cast<unsigned char>(value | 0x80));
+			value >>= 7;
+		}
+		data.push_back(static_cast<unsigned char>(value));
+	}
+
+	bool ReadVarint(const unsigned char*& data, const unsigned char* end, uint32_t& value)
+	{
+		value = 0;
+		for (int shift = 0; shift < 35 && data < end; shift += 7)
+		{
+			unsigned char byte = *data++;
+			value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+			if ((byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// the range of every channel, so that it fills the 16 bits
+	void MeasureChannels(const MeshData& meshData, float center[g_Channels], float scale[g_Channels])
+	{
+		for (GLuint channel = 0; channel < g_Channels; ++channel)
+		{
+			float minimum = 0.0f;
+			float maximum = 0.0f;
+			for (size_t i = channel; i < meshData.vertices.size(); i += g_Channels)
+			{
+				float value = meshData.vertices[i];
+				minimum = i == channel ? value : std::min(minimum, value);
+				maximum = i == channel ? value : std::max(maximum, value);
+			}
+			center[channel] = 0.5f * (minimum + maximum);
+			scale[channel] = std::max(0.5f * (maximum - minimum), g_MinExtent) / g_QuantizedScale;
+		}
+	}
+
+	int16_t QuantizeChannel(float value, float center, float scale)
+	{
+		float quantized = std::round((value - center) / scale);
+		return static_cast<int16_t>(std::max(-g_QuantizedScale, std::min(g_QuantizedScale, quantized)));
+	}
+
+	// appends the 16 bytes of one plane in the smallest mode that holds them
+	unsigned WritePlane(std::vector<unsigned char>& encoded, const unsigned char bytes[g_BlockVertices])
+	{
+		unsigned char largest = *std::max_element(bytes, bytes + g_BlockVertices);
+		unsigned mode = largest == 0 ? g_PlaneZero : largest < 16 ? g_PlaneNibbles : g_PlaneBytes;
+		if (mode == g_PlaneNibbles)
+		{
+			for (GLuint i = 0; i < g_BlockVertices; i += 2)
+			{
+				encoded.push_back(static_cast<unsigned char>(bytes[i] | (bytes[i + 1] << 4)));
+			}
+		}
+		else if (mode == g_PlaneBytes)
+		{
+			encoded.insert(encoded.end(), bytes, bytes + g_BlockVertices);
+		}
+		return mode;
+	}
+
+	///////////////////////////////////////////////////
+	//	EncodeVertices()
+	//
+	//	Every block starts with 2 bits per byte plane, the low
+	//	and high byte of each channel, then the stored planes
+	//	in channel order. The deltas run on across the blocks;
+	//	the last block is padded with zero deltas.
+	///////////////////////////////////////////////////
+	void EncodeVertices(const MeshData& meshData,
+		const float center[g_Channels],
+		const float scale[g_Channels],
+		std::vector<unsigned char>& encoded)
+	{
+		const GLuint vertexCount = meshData.VertexCount();
+		int16_t previous[g_Channels] = {};
+		for (GLuint first = 0; first < vertexCount; first += g_BlockVertices)
+		{
+			unsigned char planes[g_Channels][2][g_BlockVertices] = {};
+			for (GLuint i = 0; i < g_BlockVertices && first + i < vertexCount; ++i)
+			{
+				const GLfloat* vertex = &meshData.vertices[(first + i) * g_Channels];
+				for (GLuint channel = 0; channel < g_Channels; ++channel)
+				{
+					int16_t value = QuantizeChannel(vertex[channel], center[channel], scale[channel]);
+					uint16_t delta = EncodeZigzag(static_cast<int16_t>(value - previous[channel]));
+					previous[channel] = value;
+					planes[channel][0][i] = static_cast<unsigned char>(delta & 0xFF);
+					planes[channel][1][i] = static_cast<unsigned char>(delta >> 8);
+				}
+			}
+
+			size_t header = encoded.size();
+			encoded.resize(header + 4, 0);
+			uint32_t modes = 0;
+			for (GLuint channel = 0; channel < g_Channels; ++channel)
+			{
+				for (GLuint plane = 0; plane < g_QuantizedPlanes; ++plane)
+				{
+					modes |= WritePlane(encoded, planes[channel][plane]) << ((channel * g_QuantizedPlanes + plane) * 2);
+				}
+			}
+			std::memcpy(&encoded[header], &modes, sizeof(modes));
+		}
+	}
+
+	///////////////////////////////////////////////////
+	//	EncodeExactVertices()
+	//
+	//	The lossless layout: the 32 bits of every float are
+	//	delta coded as an integer against the previous vertex
+	//	and zigzag coded, and a block stores four byte planes
+	//	per channel behind 64 bits of plane modes. Neighboring
+	//	values of a mesh mostly share their sign, exponent and
+	//	high mantissa bits, so the high planes are often zero.
+	///////////////////////////////////////////////////
+	void EncodeExactVertices(const MeshData& meshData, std::vector<unsigned char>& encoded)
+	{
+		const GLuint vertexCount = meshData.VertexCount();
+		uint32_t previous[g_Channels] = {};
+		for (GLuint first = 0; first < vertexCount; first += g_BlockVertices)
+		{
+			unsigned char planes[g_Channels][g_ExactPlanes][g_BlockVertices] = {};
+			for (GLuint i = 0; i < g_BlockVertices && first + i < vertexCount; ++i)
+			{
+				const GLfloat* vertex = &meshData.vertices[(first + i) * g_Channels];
+				for (GLuint channel = 0; channel < g_Channels; ++channel)
+				{
+					uint32_t bits;
+					std::memcpy(&bits, &vertex[channel], sizeof(bits));
+					uint32_t delta = EncodeZigzag32(static_cast<int32_t>(bits - previous[channel]));
+					previous[channel] = bits;
+					for (GLuint plane = 0; plane < g_ExactPlanes; ++plane)
+					{
+						planes[channel][plane][i] = static_cast<unsigned char>(delta >> (plane * 8));
+					}
+				}
+			}
+
+			size_t header = encoded.size();
+			encoded.resize(header + sizeof(uint64_t), 0);
+			uint64_t modes = 0;
+			for (GLuint channel = 0; channel < g_Channels; ++channel)
+			{
+				for (GLuint plane = 0; plane < g_ExactPlanes; ++plane)
+				{
+					modes |= static_cast<uint64_t>(WritePlane(encoded, planes[channel][plane])) << ((channel * g_ExactPlanes + plane) * 2);
+				}
+			}
+			std::memcpy(&encoded[header], &modes, sizeof(modes));
+		}
+	}
+
+	// the 16 bytes of one plane, false when the section ends early
+	bool ReadPlane(const unsigned char*& data, const unsigned char* end, unsigned mode, unsigned char bytes[g_BlockVertices])
+	{
+		if (mode == g_PlaneZero)
+		{
+			std::memset(bytes, 0, g_BlockVertices);
+			return true;
+		}
+		if (mode == g_PlaneNibbles)
+		{
+			if (end - data < static_cast<ptrdiff_t>(g_BlockVertices / 2))
+			{
+				return false;
+			}
+			for (GLuint i = 0; i < g_BlockVertices; i += 2)
+			{
+				bytes[i] = data[i / 2] & 0x0F;
+				bytes[i + 1] = data[i / 2] >> 4;
+			}
+			data += g_BlockVertices / 2;
+			return true;
+		}
+		if (mode != g_PlaneBytes || end - data < static_cast<ptrdiff_t>(g_BlockVertices))
+		{
+			return false;
+		}
+		std::memcpy(bytes, data, g_BlockVertices);
+		data += g_BlockVertices;
+		return true;
+	}
+
+	// the block size of the stored planes, to check a block before it is decoded
+	size_t GetBlockBytes(uint64_t modes, GLuint planeCount)
+	{
+		size_t bytes = 0;
+		for (GLuint plane = 0; plane < g_Channels * planeCount; ++plane)
+		{
+			unsigned mode = (modes >> (plane * 2)) & 3;
+			bytes += mode == g_PlaneNibbles ? g_BlockVertices / 2 : mode == g_PlaneBytes ? g_BlockVertices : 0;
+		}
+		return bytes;
+	}
+
+	bool DecodeVerticesScalar(const unsigned char* data,
+		const unsigned char* end,
+		const MeshCodecHeader& header,
+		GLfloat* vertices)
+	{
+		int16_t previous[g_Channels] = {};
+		for (GLuint first = 0; first < header.vertexCount; first += g_BlockVertices)
+		{
+			uint32_t modes;
+			if (end - data < 4)
+			{
+				return false;
+			}
+			std::memcpy(&modes, data, sizeof(modes));
+			data += sizeof(modes);
+
+			for (GLuint channel = 0; channel < g_Channels; ++channel)
+			{
+				unsigned char low[g_BlockVertices];
+				unsigned char high[g_BlockVertices];
+				if (!ReadPlane(data, end, (modes >> (channel * 4)) & 3, low) ||
+					!ReadPlane(data, end, (modes >> (channel * 4 + 2)) & 3, high))
+				{
+					return false;
+				}
+
+				for (GLuint i = 0; i < g_BlockVertices && first + i < header.vertexCount; ++i)
+				{
+					previous[channel] = static_cast<int16_t>(previous[channel] + DecodeZigzag(static_cast<uint16_t>(low[i] | (high[i] << 8))));
+					vertices[(first + i) * g_Channels + channel] = previous[channel] * header.scale[channel] + header.center[channel];
+				}
+			}
+		}
+		return data == end;
+	}
+
+	bool DecodeExactVerticesScalar(const unsigned char* data,
+		const unsigned char* end,
+		const MeshCodecHeader& header,
+		GLfloat* vertices)
+	{
+		uint32_t previous[g_Channels] = {};
+		for (GLuint first = 0; first < header.vertexCount; first += g_BlockVertices)
+		{
+			uint64_t modes;
+			if (end - data < 8)
+			{
+				return false;
+			}
+			std::memcpy(&modes, data, sizeof(modes));
+			data += sizeof(modes);
+
+			for (GLuint channel = 0; channel < g_Channels; ++channel)
+			{
+				unsigned char planes[g_ExactPlanes][g_BlockVertices];
+				for (GLuint plane = 0; plane < g_ExactPlanes; ++plane)
+				{
+					if (!ReadPlane(data, end, (modes >> ((channel * g_ExactPlanes + plane) * 2)) & 3, planes[plane]))
+					{
+						return false;
+					}
+				}
+
+				for (GLuint i = 0; i < g_BlockVertices && first + i < header.vertexCount; ++i)
+				{
+					uint32_t delta = planes[0][i] | (planes[1][i] << 8) | (planes[2][i] << 16) | (static_cast<uint32_t>(planes[3][i]) << 24);
+					previous[channel] += static_cast<uint32_t>(DecodeZigzag32(delta));
+					std::memcpy(&vertices[(first + i) * g_Channels + channel], &previous[channel], sizeof(GLfloat));
+				}
+			}
+		}
+		return data == end;
+	}
+
+#ifdef MESH_CODEC_SSE2
+	__m128i LoadPlane(const unsigned char*& data, unsigned mode)
+	{
+		if (mode == g_PlaneZero)
+		{
+			return _mm_setzero_si128();
+		}
+		if (mode == g_PlaneNibbles)
+		{
+			__m128i packed = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data));
+			data += g_BlockVertices / 2;
+			__m128i mask = _mm_set1_epi8(0x0F);
+			return _mm_unpacklo_epi8(_mm_and_si128(packed, mask), _mm_and_si128(_mm_srli_epi16(packed, 4), mask));
+		}
+		__m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+		data += g_BlockVertices;
+		return bytes;
+	}
+
+	// zigzag decodes eight deltas and adds them up onto the last value before them
+	__m128i AccumulateDeltas(__m128i deltas, __m128i& previous)
+	{
+		__m128i values = _mm_xor_si128(_mm_srli_epi16(deltas, 1),
+			_mm_sub_epi16(_mm_setzero_si128(), _mm_and_si128(deltas, _mm_set1_epi16(1))));
+		values = _mm_add_epi16(values, _mm_slli_si128(values, 2));
+		values = _mm_add_epi16(values, _mm_slli_si128(values, 4));
+		values = _mm_add_epi16(values, _mm_slli_si128(values, 8));
+		values = _mm_add_epi16(values, previous);
+		previous = _mm_shuffle_epi32(_mm_shufflehi_epi16(values, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+		return values;
+	}
+
+	// turns eight channel rows of eight vertices into eight vertex rows
+	void Transpose8x8(__m128i rows[8])
+	{
+		__m128i a0 = _mm_unpacklo_epi16(rows[0], rows[1]);
+		__m128i a1 = _mm_unpackhi_epi16(rows[0], rows[1]);
+		__m128i a2 = _mm_unpacklo_epi16(rows[2], rows[3]);
+		__m128i a3 = _mm_unpackhi_epi16(rows[2], rows[3]);
+		__m128i a4 = _mm_unpacklo_epi16(rows[4], rows[5]);
+		__m128i a5 = _mm_unpackhi_epi16(rows[4], rows[5]);
+		__m128i a6 = _mm_unpacklo_epi16(rows[6], rows[7]);
+		__m128i a7 = _mm_unpackhi_epi16(rows[6], rows[7]);
+
+		__m128i b0 = _mm_unpacklo_epi32(a0, a2);
+		__m128i b1 = _mm_unpackhi_epi32(a0, a2);
+		__m128i b2 = _mm_unpacklo_epi32(a1, a3);
+		__m128i b3 = _mm_unpackhi_epi32(a1, a3);
+		__m128i b4 = _mm_unpacklo_epi32(a4, a6);
+		__m128i b5 = _mm_unpackhi_epi32(a4, a6);
+		__m128i b6 = _mm_unpacklo_epi32(a5, a7);
+		__m128i b7 = _mm_unpackhi_epi32(a5, a7);
+
+		rows[0] = _mm_unpacklo_epi64(b0, b4);
+		rows[1] = _mm_unpackhi_epi64(b0, b4);
+		rows[2] = _mm_unpacklo_epi64(b1, b5);
+		rows[3] = _mm_unpackhi_epi64(b1, b5);
+		rows[4] = _mm_unpacklo_epi64(b2, b6);
+		rows[5] = _mm_unpackhi_epi64(b2, b6);
+		rows[6] = _mm_unpacklo_epi64(b3, b7);
+		rows[7] = _mm_unpackhi_epi64(b3, b7);
+	}
+
+	///////////////////////////////////////////////////
+	//	DecodeVerticesSSE2()
+	//
+	//	A block decodes as 16 byte vectors: each plane is
+	//	loaded or unpacked from nibbles, the two planes of a
+	//	channel interleave into sixteen 16 bit deltas that are
+	//	summed up in a log step prefix sum, and the channels of
+	//	eight vertices are transposed so that each vertex
+	//	converts to its eight floats with two multiply-adds.
+	///////////////////////////////////////////////////
+	bool DecodeVerticesSSE2(const unsigned char* data,
+		const unsigned char* end,
+		const MeshCodecHeader& header,
+		GLfloat* vertices)
+	{
+		const __m128 scaleLow = _mm_loadu_ps(header.scale);
+		const __m128 scaleHigh = _mm_loadu_ps(header.scale + 4);
+		const __m128 centerLow = _mm_loadu_ps(header.center);
+		const __m128 centerHigh = _mm_loadu_ps(header.center + 4);
+
+		__m128i previous[g_Channels];
+		for (__m128i& value : previous)
+		{
+			value = _mm_setzero_si128();
+		}
+
+		for (GLuint first = 0; first < header.vertexCount; first += g_BlockVertices)
+		{
+			uint32_t modes;
+			if (end - data < 4)
+			{
+				return false;
+			}
+			std::memcpy(&modes, data, sizeof(modes));
+			data += sizeof(modes);
+
+			// the loads read exactly the stored planes, so a whole block must be there
+			if (static_cast<size_t>(end - data) < GetBlockBytes(modes, g_QuantizedPlanes))
+			{
+				return false;
+			}
+
+			__m128i rows[2][g_Channels];
+			for (GLuint channel = 0; channel < g_Channels; ++channel)
+			{
+				__m128i low = LoadPlane(data, (modes >> (channel * 4)) & 3);
+				__m128i high = LoadPlane(data, (modes >> (channel * 4 + 2)) & 3);
+				rows[0][channel] = AccumulateDeltas(_mm_unpacklo_epi8(low, high), previous[channel]);
+				rows[1][channel] = AccumulateDeltas(_mm_unpackhi_epi8(low, high), previous[channel]);
+			}
+
+			for (GLuint half = 0; half < 2; ++half)
+			{
+				Transpose8x8(rows[half]);
+				for (GLuint i = 0; i < 8; ++i)
+				{
+					GLuint vertex = first + half * 8 + i;
+					if (vertex >= header.vertexCount)
+					{
+						break;
+					}
+					__m128i values = rows[half][i];
+					__m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(values, values), 16);
+					__m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(values, values), 16);
+					GLfloat* output = vertices + static_cast<size_t>(vertex) * g_Channels;
+					_mm_storeu_ps(output, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(low), scaleLow), centerLow));
+					_mm_storeu_ps(output + 4, _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(high), scaleHigh), centerHigh));
+				}
+			}
+		}
+		return data == end;
+	}
+
+	// zigzag decodes four 32 bit deltas and adds them up onto the last value before them
+	__m128i AccumulateDeltas32(__m128i deltas, __m128i& previous)
+	{
+		__m128i values = _mm_xor_si128(_mm_srli_epi32(deltas, 1),
+			_mm_sub_epi32(_mm_setzero_si128(), _mm_and_si128(deltas, _mm_set1_epi32(1))));
+		values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+		values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+		values = _mm_add_epi32(values, previous);
+		previous = _mm_shuffle_epi32(values, _MM_SHUFFLE(3, 3, 3, 3));
+		return values;
+	}
+
+	// turns four channel rows of four vertices into four vertex rows
+	void Transpose4x4(__m128i rows[4])
+	{
+		__m128i a0 = _mm_unpacklo_epi32(rows[0], rows[1]);
+		__m128i a1 = _mm_unpacklo_epi32(rows[2], rows[3]);
+		__m128i a2 = _mm_unpackhi_epi32(rows[0], rows[1]);
+		__m128i a3 = _mm_unpackhi_epi32(rows[2], rows[3]);
+
+		rows[0] = _mm_unpacklo_epi64(a0, a1);
+		rows[1] = _mm_unpackhi_epi64(a0, a1);
+		rows[2] = _mm_unpacklo_epi64(a2, a3);
+		rows[3] = _mm_unpackhi_epi64(a2, a3);
+	}
+
+	///////////////////////////////////////////////////
+	//	DecodeExactVerticesSSE2()
+	//
+	//	The four planes of a channel interleave into sixteen
+	//	32 bit deltas, four vectors that are summed up like the
+	//	quantized ones, and each group of four vertices is
+	//	transposed twice, channels 0-3 and 4-7, into its floats.
+	///////////////////////////////////////////////////
+	bool DecodeExactVerticesSSE2(const unsigned char* data,
+		const unsigned char* end,
+		const MeshCodecHeader& header,
+		GLfloat* vertices)
+	{
+		__m128i previous[g_Channels];
+		for (__m128i& value : previous)
+		{
+			value = _mm_setzero_si128();
+		}
+
+		for (GLuint first = 0; first < header.vertexCount; first += g_BlockVertices)
+		{
+			uint64_t modes;
+			if (end - data < 8)
+			{
+				return false;
+			}
+			std::memcpy(&modes, data, sizeof(modes));
+			data += sizeof(modes);
+
+			if (static_cast<size_t>(end - data) < GetBlockBytes(modes, g_ExactPlanes))
+			{
+				return false;
+			}
+
+			__m128i rows[4][g_Channels];
+			for (GLuint channel = 0; channel < g_Channels; ++channel)
+			{
+				__m128i planes[g_ExactPlanes];
+				for (GLuint plane = 0; plane < g_ExactPlanes; ++plane)
+				{
+					planes[plane] = LoadPlane(data, (modes >> ((channel * g_ExactPlanes + plane) * 2)) & 3);
+				}
+				__m128i lowFirst = _mm_unpacklo_epi8(planes[0], planes[1]);
+				__m128i highFirst = _mm_unpacklo_epi8(planes[2], planes[3]);
+				__m128i lowLast = _mm_unpackhi_epi8(planes[0], planes[1]);
+				__m128i highLast = _mm_unpackhi_epi8(planes[2], planes[3]);
+				rows[0][channel] = AccumulateDeltas32(_mm_unpacklo_epi16(lowFirst, highFirst), previous[channel]);
+				rows[1][channel] = AccumulateDeltas32(_mm_unpackhi_epi16(lowFirst, highFirst), previous[channel]);
+				rows[2][channel] = AccumulateDeltas32(_mm_unpacklo_epi16(lowLast, highLast), previous[channel]);
+				rows[3][channel] = AccumulateDeltas32(_mm_unpackhi_epi16(lowLast, highLast), previous[channel]);
+			}
+
+			for (GLuint quarter = 0; quarter < 4; ++quarter)
+			{
+				Transpose4x4(rows[quarter]);
+				Transpose4x4(rows[quarter] + 4);
+				for (GLuint i = 0; i < 4; ++i)
+				{
+					GLuint vertex = first + quarter * 4 + i;
+					if (vertex >= header.vertexCount)
+					{
+						break;
+					}
+					GLfloat* output = vertices + static_cast<size_t>(vertex) * g_Channels;
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output), rows[quarter][i]);
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(output + 4), rows[quarter][4 + i]);
+				}
+			}
+		}
+		return data == end;
+	}
+#endif
+
+	// the edge and vertex FIFOs that the encoder and the decoder keep in step
+	struct IndexCodecState
+	{
+		GLuint edges[g_EdgeFifoSize][2];
+		GLuint edgeHead;
+		GLuint vertices[g_VertexFifoSize];
+		GLuint vertexHead;
+		GLuint next;		// Vertex expected next, one past the highest new one so far
+		GLuint last;		// Last explicit vertex, the base of the next one
+
+		IndexCodecState() : edges(), edgeHead(0), vertices(), vertexHead(0), next(0), last(0) {}
+
+		const GLuint* GetEdge(GLuint age) const
+		{
+			return edges[(edgeHead + g_EdgeFifoSize - 1 - age) % g_EdgeFifoSize];
+		}
+
+		GLuint GetVertex(GLuint age) const
+		{
+			return vertices[(vertexHead + g_VertexFifoSize - 1 - age) % g_VertexFifoSize];
+		}
+
+		void PushEdge(GLuint a, GLuint b)
+		{
+			edges[edgeHead][0] = a;
+			edges[edgeHead][1] = b;
+			edgeHead = (edgeHead + 1) % g_EdgeFifoSize;
+		}
+
+		void PushVertex(GLuint vertex)
+		{
+			vertices[vertexHead] = vertex;
+			vertexHead = (vertexHead + 1) % g_VertexFifoSize;
+		}
+
+		// neighbors see each edge of the triangle the other way around
+		void PushTriangle(GLuint a, GLuint b, GLuint c, bool bFirstEdge)
+		{
+			if (bFirstEdge)
+			{
+				PushEdge(b, a);
+			}
+			PushEdge(c, b);
+			PushEdge(a, c);
+		}
+	};
+
+	unsigned EncodeIndex(IndexCodecState& state, GLuint vertex, std::vector<unsigned char>& data)
+	{
+		if (vertex == state.next)
+		{
+			state.next++;
+			state.PushVertex(vertex);
+			return g_NextVertex;
+		}
+		for (GLuint age = 0; age + 1 < g_ExplicitVertex && age < g_VertexFifoSize; ++age)
+		{
+			if (state.GetVertex(age) == vertex)
+			{
+				return age + 1;
+			}
+		}
+
+		WriteVarint(data, EncodeZigzag32(static_cast<int32_t>(vertex - state.last)));
+		state.last = vertex;
+		state.PushVertex(vertex);
+		return g_ExplicitVertex;
+	}
+
+	bool DecodeIndex(IndexCodecState& state, unsigned code, const unsigned char*& data, const unsigned char* end, GLuint& vertex)
+	{
+		if (code == g_NextVertex)
+		{
+			vertex = state.next++;
+			state.PushVertex(vertex);
+			return true;
+		}
+		if (code != g_ExplicitVertex)
+		{
+			vertex = state.GetVertex(code - 1);
+			return true;
+		}
+
+		uint32_t delta;
+		if (!ReadVarint(data, end, delta))
+		{
+			return false;
+		}
+		vertex = state.last + static_cast<GLuint>(DecodeZigzag32(delta));
+		state.last = vertex;
+		state.PushVertex(vertex);
+		return true;
+	}
+
+	///////////////////////////////////////////////////
+	//	EncodeIndices()
+	//
+	//	A triangle that shares an edge with one of the last
+	//	triangles is one code byte: the age of the edge and the
+	//	third vertex, most often the next new vertex. Other
+	//	triangles take a second byte for their first two
+	//	vertices. Vertices that fit no nibble follow as
+	//	varints in a data stream after the codes.
+	///////////////////////////////////////////////////
+	void EncodeIndices(const std::vector<GLuint>& indices, std::vector<unsigned char>& encoded)
+	{
+		IndexCodecState state;
+		std::vector<unsigned char> codes;
+		std::vector<unsigned char> data;
+		codes.reserve(indices.size() / 3 + 16);
+
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			const GLuint corners[3] = { indices[i], indices[i + 1], indices[i + 2] };
+
+			// the newest edge that one of the rotations of the triangle starts with
+			GLuint edgeAge = g_EdgeMiss;
+			GLuint rotation = 0;
+			for (GLuint age = 0; age < g_EdgeMiss && edgeAge == g_EdgeMiss; ++age)
+			{
+				const GLuint* edge = state.GetEdge(age);
+				for (GLuint r = 0; r < 3; ++r)
+				{
+					if (edge[0] == corners[r] && edge[1] == corners[(r + 1) % 3])
+					{
+						edgeAge = age;
+						rotation = r;
+						break;
+					}
+				}
+			}
+
+			GLuint a = corners[rotation];
+			GLuint b = corners[(rotation + 1) % 3];
+			GLuint c = corners[(rotation + 2) % 3];
+			if (edgeAge != g_EdgeMiss)
+			{
+				codes.push_back(static_cast<unsigned char>((edgeAge << 4) | EncodeIndex(state, c, data)));
+				state.PushTriangle(a, b, c, false);
+				continue;
+			}
+
+			size_t code = codes.size();
+			codes.resize(code + 2);
+			unsigned codeA = EncodeIndex(state, a, data);
+			unsigned codeB = EncodeIndex(state, b, data);
+			unsigned codeC = EncodeIndex(state, c, data);
+			codes[code] = static_cast<unsigned char>((g_EdgeMiss << 4) | codeC);
+			codes[code + 1] = static_cast<unsigned char>((codeA << 4) | codeB);
+			state.PushTriangle(a, b, c, true);
+		}
+
+		uint32_t codeBytes = static_cast<uint32_t>(codes.size());
+		const unsigned char* size = reinterpret_cast<const unsigned char*>(&codeBytes);
+		encoded.insert(encoded.end(), size, size + sizeof(codeBytes));
+		encoded.insert(encoded.end(), codes.begin(), codes.end());
+		encoded.insert(encoded.end(), data.begin(), data.end());
+	}
+
+	bool DecodeIndices(const unsigned char* section, const unsigned char* end, GLuint vertexCount, GLuint* indices, GLuint indexCount)
+	{
+		uint32_t codeBytes;
+		if (end - section < 4)
+		{
+			return false;
+		}
+		std::memcpy(&codeBytes, section, sizeof(codeBytes));
+		const unsigned char* code = section + sizeof(codeBytes);
+		if (static_cast<size_t>(end - code) < codeBytes)
+		{
+			return false;
+		}
+		const unsigned char* codeEnd = code + codeBytes;
+		const unsigned char* data = codeEnd;
+
+		IndexCodecState state;
+		for (GLuint i = 0; i + 2 < indexCount; i += 3)
+		{
+			if (code == codeEnd)
+			{
+				return false;
+			}
+			unsigned triangleCode = *code++;
+			unsigned edgeAge = triangleCode >> 4;
+
+			GLuint a, b, c;
+			if (edgeAge != g_EdgeMiss)
+			{
+				const GLuint* edge = state.GetEdge(edgeAge);
+				a = edge[0];
+				b = edge[1];
+				if (!DecodeIndex(state, triangleCode & 0x0F, data, end, c))
+				{
+					return false;
+				}
+			}
+			else
+			{
+				if (code == codeEnd)
+				{
+					return false;
+				}
+				unsigned vertexCodes = *code++;
+				if (!DecodeIndex(state, vertexCodes >> 4, data, end, a) ||
+					!DecodeIndex(state, vertexCodes & 0x0F, data, end, b) ||
+					!DecodeIndex(state, triangleCode & 0x0F, data, end, c))
+				{
+					return false;
+				}
+			}
+
+			if (a >= vertexCount || b >= vertexCount || c >= vertexCount)
+			{
+				return false;
+			}
+			indices[i] = a;
+			indices[i + 1] = b;
+			indices[i + 2] = c;
+			state.PushTriangle(a, b, c, edgeAge == g_EdgeMiss);
+		}
+		return code == codeEnd && data == end;
+	}
+
+	bool DecodeMesh(const unsigned char* data, size_t size, MeshData& meshData, bool bVectorized)
+	{
+		MeshCodecHeader header;
+		if (size < sizeof(header))
+		{
+			return false;
+		}
+		std::memcpy(&header, data, sizeof(header));
+		if (std::memcmp(header.magic, g_MeshCodecMagic, sizeof(header.magic)) != 0 ||
+			header.version != g_MeshCodecVersion ||
+			(header.flags & ~g_FlagExactVertices) != 0 ||
+			header.indexCount % 3 != 0 ||
+			static_cast<uint64_t>(sizeof(header)) + header.vertexBytes + header.indexBytes != size)
+		{
+			return false;
+		}
+
+		const unsigned char* vertexSection = data + sizeof(header);
+		const unsigned char* indexSection = vertexSection + header.vertexBytes;
+		meshData.vertices.resize(static_cast<size_t>(header.vertexCount) * g_Channels);
+		meshData.indices.resize(header.indexCount);
+
+		const bool bExact = (header.flags & g_FlagExactVertices) != 0;
+		bool bDecoded = false;
+#ifdef MESH_CODEC_SSE2
+		if (bVectorized)
+		{
+			bDecoded = bExact ?
+				DecodeExactVerticesSSE2(vertexSection, indexSection, header, meshData.vertices.data()) :
+				DecodeVerticesSSE2(vertexSection, indexSection, header, meshData.vertices.data());
+		}
+		else
+#endif
+		{
+			(void)bVectorized;
+			bDecoded = bExact ?
+				DecodeExactVerticesScalar(vertexSection, indexSection, header, meshData.vertices.data()) :
+				DecodeVerticesScalar(vertexSection, indexSection, header, meshData.vertices.data());
+		}
+		return bDecoded &&
+			DecodeIndices(indexSection, data + size, header.vertexCount, meshData.indices.data(), header.indexCount);
+	}
+
+	void EncodeMesh(const MeshData& meshData, std::vector<unsigned char>& encoded, MeshCodecReport* report, bool bExact)
+	{
+		MeshCodecHeader header = {};
+		std::memcpy(header.magic, g_MeshCodecMagic, sizeof(header.magic));
+		header.version = g_MeshCodecVersion;
+		header.vertexCount = meshData.VertexCount();
+		header.indexCount = meshData.IndexCount() / 3 * 3;
+		header.flags = bExact ? g_FlagExactVertices : 0;
+
+		encoded.resize(sizeof(header));
+		if (bExact)
+		{
+			EncodeExactVertices(meshData, encoded);
+		}
+		else
+		{
+			MeasureChannels(meshData, header.center, header.scale);
+			EncodeVertices(meshData, header.center, header.scale, encoded);
+		}
+		header.vertexBytes = static_cast<uint32_t>(encoded.size() - sizeof(header));
+		EncodeIndices(meshData.indices, encoded);
+		header.indexBytes = static_cast<uint32_t>(encoded.size() - sizeof(header) - header.vertexBytes);
+		std::memcpy(encoded.data(), &header, sizeof(header));
+
+		if (report == nullptr)
+		{
+			return;
+		}
+
+		*report = {};
+		report->vertexCount = header.vertexCount;
+		report->indexCount = header.indexCount;
+		report->rawBytes = meshData.vertices.size() * sizeof(GLfloat) + meshData.indices.size() * sizeof(GLuint);
+		report->vertexBytes = header.vertexBytes;
+		report->indexBytes = header.indexBytes;
+		report->encodedBytes = encoded.size();
+		if (bExact)
+		{
+			return;
+		}
+
+		// the error of every value after it is decoded the same way
+		for (size_t i = 0; i < meshData.vertices.size(); ++i)
+		{
+			GLuint channel = i % g_Channels;
+			float value = meshData.vertices[i];
+			float decoded = QuantizeChannel(value, header.center[channel], header.scale[channel]) * header.scale[channel] + header.center[channel];
+			float error = std::abs(decoded - value);
+			float& maxError = channel < 3 ? report->maxPositionError : channel < 6 ? report->maxNormalError : report->maxUVError;
+			maxError = std::max(maxError, error);
+		}
+	}
+
+	// a welded and optimized mesh, as the shapes are loaded
+	MeshData PrepareMesh(MeshData meshData, std::vector<IndexRange> parts = {})
+	{
+		if (parts.empty())
+		{
+			parts.push_back({ 0, meshData.IndexCount() });
+		}
+		WeldVertices(meshData.vertices, meshData.indices, parts);
+		OptimizeMesh(meshData.vertices, meshData.indices, parts);
+		return meshData;
+	}
+
+	// decoded bytes per second in GB/s of the fastest of enough runs to take a while
+	double MeasureDecode(const std::vector<unsigned char>& encoded, size_t rawBytes, bool bVectorized)
+	{
+		double fastest = 0.0;
+		MeshData meshData;
+		auto start = std::chrono::steady_clock::now();
+		for (int run = 0; run < 3 || std::chrono::steady_clock::now() - start < std::chrono::milliseconds(200); ++run)
+		{
+			auto runStart = std::chrono::steady_clock::now();
+			DecodeMesh(encoded.data(), encoded.size(), meshData, bVectorized);
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - runStart;
+			if (elapsed.count() > 0.0)
+			{
+				fastest = std::max(fastest, rawBytes / elapsed.count() / 1e9);
+			}
+		}
+		return fastest;
+	}
+
+	// the raw buffers written to a file and read back into vectors, at best from the file cache
+	double MeasureRawRead(const MeshData& meshData, size_t rawBytes)
+	{
+		const char* path = "mesh_codec_benchmark.raw";
+		{
+			std::ofstream file(path, std::ios::binary | std::ios::trunc);
+			file.write(reinterpret_cast<const char*>(meshData.vertices.data()), meshData.vertices.size() * sizeof(GLfloat));
+			file.write(reinterpret_cast<const char*>(meshData.indices.data()), meshData.indices.size() * sizeof(GLuint));
+		}
+
+		double fastest = 0.0;
+		MeshData copy;
+		for (int run = 0; run < 5; ++run)
+		{
+			auto runStart = std::chrono::steady_clock::now();
+			std::ifstream file(path, std::ios::binary);
+			copy.vertices.resize(meshData.vertices.size());
+			copy.indices.resize(meshData.indices.size());
+			file.read(reinterpret_cast<char*>(copy.vertices.data()), copy.vertices.size() * sizeof(GLfloat));
+			file.read(reinterpret_cast<char*>(copy.indices.data()), copy.indices.size() * sizeof(GLuint));
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - runStart;
+			if (elapsed.count() > 0.0)
+			{
+				fastest = std::max(fastest, rawBytes / elapsed.count() / 1e9);
+			}
+		}
+		std::remove(path);
+		return fastest;
+	}
+
+	void BenchmarkCodec(const char* meshName, const MeshData& meshData)
+	{
+		for (bool bExact : { false, true })
+		{
+			std::string name = std::string(meshName) + (bExact ? " exact" : "");
+			std::vector<unsigned char> encoded;
+			MeshCodecReport report;
+			EncodeMesh(meshData, encoded, &report, bExact);
+			PrintMeshCodecReport(name.c_str(), report);
+
+			MeshData decoded;
+			if (!DecodeMesh(encoded.data(), encoded.size(), decoded) ||
+				(bExact && decoded.vertices != meshData.vertices))
+			{
+				std::cerr << "Failed to decode the " << name << " mesh" << std::endl;
+				continue;
+			}
+
+			std::cout << "INFO: codec " << name << " decode "
+#ifdef MESH_CODEC_SSE2
+				<< MeasureDecode(encoded, report.rawBytes, true) << " GB/s SSE2, "
+#endif
+				<< MeasureDecode(encoded, report.rawBytes, false) << " GB/s scalar";
+			if (!bExact)
+			{
+				std::cout << "; raw file read " << MeasureRawRead(meshData, report.rawBytes) << " GB/s";
+			}
+			std::cout << std::endl;
+		}
+	}
+}
+
+///////////////////////////////////////////////////
+//	EncodeMesh()
+///////////////////////////////////////////////////
+void EncodeMesh(const MeshData& meshData, std::vector<unsigned char>& encoded, MeshCodecReport* report)
+{
+	EncodeMesh(meshData, encoded, report, false);
+}
+
+///////////////////////////////////////////////////
+//	EncodeMeshExact()
+///////////////////////////////////////////////////
+void EncodeMeshExact(const MeshData& meshData, std::vector<unsigned char>& encoded, MeshCodecReport* report)
+{
+	EncodeMesh(meshData, encoded, report, true);
+}
+
+///////////////////////////////////////////////////
+//	DecodeMesh()
+///////////////////////////////////////////////////
+bool DecodeMesh(const unsigned char* data, size_t size, MeshData& meshData)
+{
+	return DecodeMesh(data, size, meshData, true);
+}
+
+///////////////////////////////////////////////////
+//	PrintMeshCodecReport()
+///////////////////////////////////////////////////
+void PrintMeshCodecReport(const char* meshName, const MeshCodecReport& report)
+{
+	GLuint triangleCount = std::max(report.indexCount / 3, 1u);
+	std::cout << "INFO: codec " << meshName << ": " << report.vertexCount << " vertices, "
+		<< report.indexCount / 3 << " triangles, " << report.rawBytes << " -> " << report.encodedBytes
+		<< " bytes (" << static_cast<double>(report.rawBytes) / std::max<size_t>(report.encodedBytes, 1) << " : 1), "
+		<< static_cast<double>(report.vertexBytes) / std::max(report.vertexCount, 1u) << " bytes per vertex, "
+		<< report.indexBytes * 8.0 / triangleCount << " bits per triangle, largest errors position "
+		<< report.maxPositionError << ", normal " << report.maxNormalError << ", uv " << report.maxUVError << std::endl;
+}
+
+///////////////////////////////////////////////////
+//	RunMeshCodecBenchmark()
+//
+//	The primitives are welded and optimized as they are
+//	when loaded, which orders their vertices by first use.
+//	The raw read is timed from the file cache, the best
+//	case for the uncompressed buffers; a cold read from a
+//	disk is slower still.
+///////////////////////////////////////////////////
+void RunMeshCodecBenchmark(const char* path)
+{
+	MeshData sphere;
+	GenerateParametricSurface(SphereSurface{ 1.0f }, SphereSurface::Grid(32, 64), sphere);
+	BenchmarkCodec("sphere 32 x 64", PrepareMesh(sphere));
+
+	MeshData torus;
+	GenerateParametricSurface(TorusSurface{ 1.0f, 0.2f }, TorusSurface::Grid(64, 32), torus);
+	BenchmarkCodec("torus 64 x 32", PrepareMesh(torus));
+
+	MeshData cylinder;
+	std::vector<IndexRange> cylinderParts;
+	GenerateCylinderSurface(CylinderSurface{ 1.0f, 1.0f }, 64, 8, cylinder, &cylinderParts);
+	BenchmarkCodec("cylinder 64 x 8", PrepareMesh(cylinder, cylinderParts));
+
+	MeshData icosphere;
+	std::vector<IndexRange> icosphereParts;
+	GenerateIcosphere(1.0f, 5, icosphere, &icosphereParts);
+	BenchmarkCodec("icosphere level 5", PrepareMesh(icosphere, icosphereParts));
+
+	BenchmarkCodec("dodecahedron", PrepareMesh(GetDodecahedronGeometry().ToMeshData()));
+
+	MeshData largeSphere;
+	GenerateParametricSurface(SphereSurface{ 1.0f }, SphereSurface::Grid(512, 1024), largeSphere);
+	BenchmarkCodec("sphere 512 x 1024", PrepareMesh(largeSphere));
+
+	if (path != nullptr)
+	{
+		MeshData imported;
+		if (ImportMesh(path, imported))
+		{
+			BenchmarkCodec(path, PrepareMesh(imported));
+		}
+	}
+}
@@ -0,0 +1,59 @@
+#ifndef MESH_CODEC_H
+#define MESH_CODEC_H
+#pragma once
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <vector>
+
+#include "MeshData.h"
+
+// Size and error of an encoded mesh
+struct MeshCodecReport
+{
+	GLuint vertexCount;
+	GLuint indexCount;
+	size_t rawBytes;			// Float vertices and 32 bit indices
+	size_t vertexBytes;			// Encoded vertex section
+	size_t indexBytes;			// Encoded index section
+	size_t encodedBytes;		// Whole stream with its header
+	float maxPositionError;		// Largest position error in object units
+	float maxNormalError;		// Largest normal component error
+	float maxUVError;			// Largest texture coordinate error
+};
+
+///////////////////////////////////////////////////
+//	EncodeMesh()
+//
+//	Packs a triangle mesh in the interleaved layout of
+//	MeshData into a compact byte stream for files. Each of
+//	the eight vertex floats is quantized to 16 bits in its
+//	own range, delta coded against the previous vertex and
+//	zigzag coded, and the bytes of 16 vertices are stored
+//	per channel as zero, 4 bit or 8 bit runs. The indices
+//	are coded against a FIFO of recent edges and vertices,
+//	mostly one byte per triangle. Triangles keep their order
+//	and winding but may start at another corner, so the
+//	parts of a mesh stay valid.
+///////////////////////////////////////////////////
+void EncodeMesh(const MeshData& meshData, std::vector<unsigned char>& encoded, MeshCodecReport* report = nullptr);
+
+// The lossless form of EncodeMesh() for caches: the 32 bits of each
+// vertex float are delta coded as integers in the same byte planes,
+// so the mesh decodes bit for bit as it was stored
+void EncodeMeshExact(const MeshData& meshData, std::vector<unsigned char>& encoded, MeshCodecReport* report = nullptr);
+
+// Decodes a stream written by EncodeMesh() or EncodeMeshExact(), with
+// SSE2 where it is available; false when the stream is truncated or damaged
+bool DecodeMesh(const unsigned char* data, size_t size, MeshData& meshData);
+
+// Writes a one line summary of the report
+void PrintMeshCodecReport(const char* meshName, const MeshCodecReport& report);
+
+// Encodes the built-in primitives, and the mesh file when one is
+// given, quantized and exact, and prints the compression ratio, the
+// decode speed of the SSE2 and scalar decoders and the speed of
+// reading the raw buffers
+void RunMeshCodecBenchmark(const char* path = nullptr);
+
+#endif // MESH_CODEC_H
@@ -0,0 +1,45 @@
+#ifndef MESH_DATA_H
+#define MESH_DATA_H
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+
+#include "VertexLayout.h"
+
+// CPU-side copy of a triangle mesh using the same interleaved layout
+// that every mesh uploads: position (3), normal (3), texture coords (2)
+struct MeshData
+{
+	static const GLuint FloatsPerVertex = 8;	// Number of floats in one interleaved vertex
+
+	// the float vertex format shared by the meshes
+	typedef VertexLayout<
+		Attr<0, 3, GL_FLOAT>,	// Position
+		Attr<1, 3, GL_FLOAT>,	// Normal
+		Attr<2, 2, GL_FLOAT>	// Texture coords
+	> Layout;
+
+	std::vector<GLfloat> vertices;	// Interleaved vertex data
+	std::vector<GLuint> indices;	// Triangle list indices into the vertex data
+
+	GLuint VertexCount() const { return static_cast<GLuint>(vertices.size() / FloatsPerVertex); }
+	GLuint IndexCount() const { return static_cast<GLuint>(indices.size()); }
+};
+
+// A run of triangle list indices drawn with one glDrawElements call
+struct IndexRange
+{
+	GLuint firstIndex;	// First index of the run in the index buffer
+	GLuint indexCount;	// Number of indices of the run
+
+	// byte offset of the run for glDrawElements
+	const void* Offset() const { return reinterpret_cast<const void*>(sizeof(GLuint) * firstIndex); }
+
+	// draws the run from the bound element buffer
+	void Draw() const { glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, Offset()); }
+};
+
+static_assert(MeshData::Layout::Stride() == MeshData::FloatsPerVertex * sizeof(GLfloat), "MeshData layout must match FloatsPerVertex");
+
+#endif // MESH_DATA_H
@@ -0,0 +1,2061 @@
+#include "MeshImporter.h"
+
+#include "MeshCache.h"
+#include "MeshNormals.h"
+#include "MeshWelding.h"
+#include "ParametricSurface.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	const size_t g_ChunkBytes = 1 << 20;		// Bytes of text a worker parses at a time
+	const size_t g_ChunkVertices = 1 << 16;		// Binary vertices a worker converts at a time
+	const int g_MaxJsonDepth = 64;				// Deepest JSON nesting that is parsed
+	const int g_MaxNodeDepth = 64;				// Deepest glTF node hierarchy that is walked
+	const GLuint g_BenchmarkColumns = 1024;		// Quads along u of the benchmark sphere
+	const GLuint g_BenchmarkRows = 512;			// Quads along v of the benchmark sphere
+	const char* g_BenchmarkPath = "import_benchmark.obj";	// Temporary file of the benchmark sphere
+
+	const double g_PowersOfTen[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	typedef std::pair<const char*, const char*> TextRange;
+
+	unsigned GetHardwareThreads()
+	{
+		unsigned threads = std::thread::hardware_concurrency();
+		return threads > 0 ? threads : 1;
+	}
+
+	// runs the body once per chunk, each worker takes the next free chunk
+	// so that chunks which parse slower do not hold up the others
+	void ParallelForChunks(size_t chunkCount, unsigned threadCount, const std::function<void(size_t chunk)>& body)
+	{
+		if (threadCount == 0)
+		{
+			threadCount = GetHardwareThreads();
+		}
+		threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, chunkCount));
+
+		std::atomic<size_t> nextChunk(0);
+		auto work = [&]()
+		{
+			for (size_t chunk = nextChunk++; chunk < chunkCount; chunk = nextChunk++)
+			{
+				body(chunk);
+			}
+		};
+
+		std::vector<std::thread> workers;
+		for (unsigned t = 1; t < threadCount; ++t)
+		{
+			workers.emplace_back(work);
+		}
+		work();
+		for (std::thread& worker : workers)
+		{
+			worker.join();
+		}
+	}
+
+	bool IsSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
+
+	void SkipSpaces(const char*& p, const char* end)
+	{
+		while (p < end && IsSpace(*p))
+		{
+			++p;
+		}
+	}
+
+	// start of the line after the one p is in
+	const char* NextLine(const char* p, const char* end)
+	{
+		const char* newline = static_cast<const char*>(std::memchr(p, '\n', end - p));
+		return newline ? newline + 1 : end;
+	}
+
+	// splits the text into ranges of about g_ChunkBytes that end after a newline
+	void SplitLines(const char* begin, const char* end, std::vector<TextRange>& chunks)
+	{
+		chunks.clear();
+		while (begin < end)
+		{
+			const char* chunkEnd = begin + std::min(g_ChunkBytes, static_cast<size_t>(end - begin));
+			if (chunkEnd < end)
+			{
+				chunkEnd = NextLine(chunkEnd, end);
+			}
+			chunks.push_back({ begin, chunkEnd });
+			begin = chunkEnd;
+		}
+	}
+
+	// start of the text after count lines
+	const char* SkipLines(const char* p, const char* end, size_t count)
+	{
+		for (size_t line = 0; line < count && p < end; ++line)
+		{
+			p = NextLine(p, end);
+		}
+		return p;
+	}
+
+	///////////////////////////////////////////////////
+	//	ParseDouble()
+	//
+	//	Parses a decimal number such as -1.25e-3 after any
+	//	spaces. Up to 19 significant digits are gathered in
+	//	an integer and scaled by an exact power of ten, which
+	//	is well within float precision. The decimal point is
+	//	always '.', whatever the locale says.
+	///////////////////////////////////////////////////
+	bool ParseDouble(const char*& p, const char* end, double& value)
+	{
+		SkipSpaces(p, end);
+		const char* start = p;
+		bool bNegative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			bNegative = *p == '-';
+			++p;
+		}
+
+		std::uint64_t mantissa = 0;
+		int significantDigits = 0;
+		int exponent = 0;
+		bool bDigits = false;
+		for (; p < end && static_cast<unsigned>(*p - '0') < 10; ++p)
+		{
+			bDigits = true;
+			if (significantDigits < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+				significantDigits += mantissa != 0;
+			}
+			else
+			{
+				exponent++;
+			}
+		}
+		if (p < end && *p == '.')
+		{
+			for (++p; p < end && static_cast<unsigned>(*p - '0') < 10; ++p)
+			{
+				bDigits = true;
+				if (significantDigits < 19)
+				{
+					mantissa = mantissa * 10 + static_cast<unsigned>(*p - '0');
+					significantDigits += mantissa != 0;
+					exponent--;
+				}
+			}
+		}
+		if (!bDigits)
+		{
+			p = start;
+			return false;
+		}
+
+		if (p < end && (*p == 'e' || *p == 'E'))
+		{
+			const char* exponentStart = p++;
+			bool bNegativeExponent = false;
+			if (p < end && (*p == '-' || *p == '+'))
+			{
+				bNegativeExponent = *p == '-';
+				++p;
+			}
+			if (p < end && static_cast<unsigned>(*p - '0') < 10)
+			{
+				int written = 0;
+				for (; p < end && static_cast<unsigned>(*p - '0') < 10; ++p)
+				{
+					written = std::min(written * 10 + (*p - '0'), 100000);
+				}
+				exponent += bNegativeExponent ? -written : written;
+			}
+			else
+			{
+				p = exponentStart;
+			}
+		}
+
+		value = static_cast<double>(mantissa);
+		if (exponent >= 0 && exponent <= 22)
+		{
+			value *= g_PowersOfTen[exponent];
+		}
+		else if (exponent < 0 && exponent >= -22)
+		{
+			value /= g_PowersOfTen[-exponent];
+		}
+		else if (mantissa != 0)
+		{
+			value *= std::pow(10.0, exponent);
+		}
+		if (bNegative)
+		{
+			value = -value;
+		}
+		return true;
+	}
+
+	bool ParseFloat(const char*& p, const char* end, float& value)
+	{
+		double number = 0.0;
+		if (!ParseDouble(p, end, number))
+		{
+			return false;
+		}
+		value = static_cast<float>(number);
+		return true;
+	}
+
+	// parses a whole number after any spaces
+	bool ParseInteger(const char*& p, const char* end, long long& value)
+	{
+		SkipSpaces(p, end);
+		const char* start = p;
+		bool bNegative = false;
+		if (p < end && (*p == '-' || *p == '+'))
+		{
+			bNegative = *p == '-';
+			++p;
+		}
+		if (p >= end || static_cast<unsigned>(*p - '0') >= 10)
+		{
+			p = start;
+			return false;
+		}
+		long long number = 0;
+		for (; p < end && static_cast<unsigned>(*p - '0') < 10; ++p)
+		{
+			number = std::min(number * 10 + (*p - '0'), 0x7FFFFFFFFFFFLL);
+		}
+		value = bNegative ? -number : number;
+		return true;
+	}
+
+	// the next word of a line after any spaces
+	std::string ParseWord(const char*& p, const char* end)
+	{
+		SkipSpaces(p, end);
+		const char* start = p;
+		while (p < end && !IsSpace(*p) && *p != '\n')
+		{
+			++p;
+		}
+		return std::string(start, p);
+	}
+
+	void WriteVertex(GLfloat* vertex, const glm::vec3& position, const glm::vec3& normal, const glm::vec2& uv)
+	{
+		vertex[0] = position.x;
+		vertex[1] = position.y;
+		vertex[2] = position.z;
+		vertex[3] = normal.x;
+		vertex[4] = normal.y;
+		vertex[5] = normal.z;
+		vertex[6] = uv.x;
+		vertex[7] = uv.y;
+	}
+
+	std::string GetExtension(const std::string& path)
+	{
+		size_t dot = path.find_last_of('.');
+		size_t slash = path.find_last_of("/\\");
+		if (dot == std::string::npos || (slash != std::string::npos && dot < slash))
+		{
+			return std::string();
+		}
+		std::string extension = path.substr(dot + 1);
+		for (char& c : extension)
+		{
+			if (c >= 'A' && c <= 'Z')
+			{
+				c = static_cast<char>(c - 'A' + 'a');
+			}
+		}
+		return extension;
+	}
+
+	/***********************************************************
+	 *  OBJ
+	 ***********************************************************/
+
+	// face corner of an OBJ file; bit i of localMask marks index[i] as
+	// relative to the first element of its kind in the chunk, otherwise a
+	// positive index[i] is 1-based into the whole file and 0 is missing
+	struct ObjCorner
+	{
+		std::int32_t index[3];	// Position, texture coord and normal
+		unsigned char localMask;
+	};
+
+	// everything one worker read from its range of lines
+	struct ObjChunk
+	{
+		std::vector<float> positions;	// 3 per position
+		std::vector<float> uvs;			// 2 per texture coord
+		std::vector<float> normals;		// 3 per normal
+		std::vector<ObjCorner> corners;	// 3 per triangle
+		size_t bases[3];				// Elements of each kind in the chunks before
+		size_t cornerBase;				// Corners in the chunks before
+		bool bValid;
+	};
+
+	// reads "v/vt/vn", "v//vn", "v/vt" or "v"; negative indices count back
+	// from the last element of the kind read so far
+	bool ParseObjCorner(const char*& p, const char* end, const size_t localCounts[3], ObjCorner& corner)
+	{
+		corner = ObjCorner{ { 0, 0, 0 }, 0 };
+		for (int kind = 0; kind < 3; ++kind)
+		{
+			if (kind > 0)
+			{
+				if (p >= end || *p != '/')
+				{
+					break;
+				}
+				++p;
+				if (p < end && *p == '/')
+				{
+					continue;
+				}
+			}
+
+			long long value = 0;
+			if (!ParseInteger(p, end, value))
+			{
+				if (kind == 0)
+				{
+					return false;
+				}
+				continue;
+			}
+			if (value < 0)
+			{
+				value += static_cast<long long>(localCounts[kind]);
+				corner.localMask |= 1 << kind;
+			}
+			else if (value == 0)
+			{
+				return false;
+			}
+			corner.index[kind] = static_cast<std::int32_t>(value);
+		}
+		return true;
+	}
+
+	void ParseObjChunk(const char* p, const char* end, ObjChunk& chunk)
+	{
+		chunk.bValid = true;
+		std::vector<ObjCorner> face;
+		while (p < end && chunk.bValid)
+		{
+			const char* lineEnd = static_cast<const char*>(std::memchr(p, '\n', end - p));
+			lineEnd = lineEnd ? lineEnd : end;
+			SkipSpaces(p, lineEnd);
+
+			if (lineEnd - p >= 2 && p[0] == 'v' && IsSpace(p[1]))
+			{
+				p += 1;
+				for (int i = 0; i < 3 && chunk.bValid; ++i)
+				{
+					float value = 0.0f;
+					chunk.bValid = ParseFloat(p, lineEnd, value);
+					chunk.positions.push_back(value);
+				}
+			}
+			else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 't' && IsSpace(p[2]))
+			{
+				p += 2;
+				float u = 0.0f;
+				float v = 0.0f;
+				chunk.bValid = ParseFloat(p, lineEnd, u);
+				ParseFloat(p, lineEnd, v);
+				chunk.uvs.push_back(u);
+				chunk.uvs.push_back(v);
+			}
+			else if (lineEnd - p >= 3 && p[0] == 'v' && p[1] == 'n' && IsSpace(p[2]))
+			{
+				p += 2;
+				for (int i = 0; i < 3 && chunk.bValid; ++i)
+				{
+					float value = 0.0f;
+					chunk.bValid = ParseFloat(p, lineEnd, value);
+					chunk.normals.push_back(value);
+				}
+			}
+			else if (lineEnd - p >= 2 && p[0] == 'f' && IsSpace(p[1]))
+			{
+				const size_t localCounts[3] = { chunk.positions.size() / 3, chunk.uvs.size() / 2, chunk.normals.size() / 3 };
+				face.clear();
+				p += 1;
+				SkipSpaces(p, lineEnd);
+				while (p < lineEnd && chunk.bValid)
+				{
+					ObjCorner corner;
+					chunk.bValid = ParseObjCorner(p, lineEnd, localCounts, corner);
+					face.push_back(corner);
+					SkipSpaces(p, lineEnd);
+				}
+				for (size_t k = 1; k + 1 < face.size(); ++k)
+				{
+					chunk.corners.push_back(face[0]);
+					chunk.corners.push_back(face[k]);
+					chunk.corners.push_back(face[k + 1]);
+				}
+			}
+			p = lineEnd + 1;
+		}
+	}
+
+	// the chunks are read in parallel, then their positions, texture
+	// coords and normals are joined, and in a second parallel pass
+	// every chunk writes one vertex per corner at its own offset;
+	// corners without a normal get the smooth normal of their
+	// position, so that they can still be welded
+	bool ImportObj(const char* text, size_t size, MeshData& meshData, unsigned threadCount, std::string& error)
+	{
+		std::vector<TextRange> ranges;
+		SplitLines(text, text + size, ranges);
+		std::vector<ObjChunk> chunks(ranges.size());
+		ParallelForChunks(ranges.size(), threadCount, [&](size_t chunk)
+		{
+			ParseObjChunk(ranges[chunk].first, ranges[chunk].second, chunks[chunk]);
+		});
+
+		size_t totals[3] = { 0, 0, 0 };
+		size_t cornerCount = 0;
+		for (size_t c = 0; c < chunks.size(); ++c)
+		{
+			ObjChunk& chunk = chunks[c];
+			if (!chunk.bValid)
+			{
+				error = "malformed line";
+				return false;
+			}
+			chunk.bases[0] = totals[0];
+			chunk.bases[1] = totals[1];
+			chunk.bases[2] = totals[2];
+			chunk.cornerBase = cornerCount;
+			totals[0] += chunk.positions.size() / 3;
+			totals[1] += chunk.uvs.size() / 2;
+			totals[2] += chunk.normals.size() / 3;
+			cornerCount += chunk.corners.size();
+		}
+		if (cornerCount > 0xFFFFFFFFu)
+		{
+			error = "too many triangles";
+			return false;
+		}
+
+		std::vector<float> attributes[3];
+		const size_t widths[3] = { 3, 2, 3 };
+		for (int kind = 0; kind < 3; ++kind)
+		{
+			attributes[kind].resize(totals[kind] * widths[kind]);
+		}
+		ParallelForChunks(chunks.size(), threadCount, [&](size_t c)
+		{
+			ObjChunk& chunk = chunks[c];
+			const std::vector<float>* sources[3] = { &chunk.positions, &chunk.uvs, &chunk.normals };
+			for (int kind = 0; kind < 3; ++kind)
+			{
+				std::copy(sources[kind]->begin(), sources[kind]->end(), attributes[kind].begin() + chunk.bases[kind] * widths[kind]);
+			}
+			std::vector<float>().swap(chunk.positions);
+			std::vector<float>().swap(chunk.uvs);
+			std::vector<float>().swap(chunk.normals);
+		});
+
+		meshData.vertices.resize(cornerCount * MeshData::FloatsPerVertex);
+		meshData.indices.resize(cornerCount);
+		std::vector<GLuint> cornerPositions(cornerCount);
+		std::atomic<bool> bInvalidIndex(false);
+		std::atomic<bool> bMissingNormals(false);
+		ParallelForChunks(chunks.size(), threadCount, [&](size_t c)
+		{
+			const ObjChunk& chunk = chunks[c];
+			GLfloat* vertex = meshData.vertices.data() + chunk.cornerBase * MeshData::FloatsPerVertex;
+			for (size_t i = 0; i + 2 < chunk.corners.size(); i += 3)
+			{
+				glm::vec3 positions[3];
+				glm::vec3 normals[3];
+				glm::vec2 uvs[3];
+				for (int k = 0; k < 3; ++k)
+				{
+					const ObjCorner& corner = chunk.corners[i + k];
+					long long resolved[3];
+					for (int kind = 0; kind < 3; ++kind)
+					{
+						long long index = corner.index[kind];
+						resolved[kind] = (corner.localMask & (1 << kind)) ? static_cast<long long>(chunk.bases[kind]) + index :
+							(index > 0 ? index - 1 : -1);
+						if (resolved[kind] >= static_cast<long long>(totals[kind]) || (kind == 0 && resolved[kind] < 0))
+						{
+							bInvalidIndex = true;
+							resolved[kind] = -1;
+						}
+					}
+
+					const float* position = resolved[0] >= 0 ? &attributes[0][resolved[0] * 3] : nullptr;
+					positions[k] = position ? glm::vec3(position[0], position[1], position[2]) : glm::vec3(0.0f);
+					cornerPositions[chunk.cornerBase + i + k] = resolved[0] >= 0 ? static_cast<GLuint>(resolved[0]) : 0;
+					uvs[k] = resolved[1] >= 0 ? glm::vec2(attributes[1][resolved[1] * 2], attributes[1][resolved[1] * 2 + 1]) : glm::vec2(0.0f);
+					if (resolved[2] >= 0)
+					{
+						const float* normal = &attributes[2][resolved[2] * 3];
+						normals[k] = glm::vec3(normal[0], normal[1], normal[2]);
+					}
+					else
+					{
+						normals[k] = glm::vec3(0.0f);
+						bMissingNormals = true;
+					}
+				}
+
+				for (int k = 0; k < 3; ++k)
+				{
+					WriteVertex(vertex, positions[k], normals[k], uvs[k]);
+					vertex += MeshData::FloatsPerVertex;
+					meshData.indices[chunk.cornerBase + i + k] = static_cast<GLuint>(chunk.cornerBase + i + k);
+				}
+			}
+		});
+
+		if (bInvalidIndex)
+		{
+			error = "face index out of range";
+			return false;
+		}
+		if (!bMissingNormals)
+		{
+			return true;
+		}
+
+		// the corners without a normal sum the area-weighted face normals around their position
+		NormalOptions options = NormalOptions::Smooth(threadCount);
+		options.positionGroups = cornerPositions.data();
+		options.groupCount = static_cast<GLuint>(totals[0]);
+		options.bOnlyMissing = true;
+		GenerateVertexNormals(meshData, options);
+		return true;
+	}
+
+	/***********************************************************
+	 *  PLY
+	 ***********************************************************/
+
+	enum class PlyFormat
+	{
+		Ascii,
+		BinaryLittleEndian,
+		BinaryBigEndian
+	};
+
+	enum class PlyType
+	{
+		Int8, UInt8, Int16, UInt16, Int32, UInt32, Float32, Float64, Invalid
+	};
+
+	struct PlyProperty
+	{
+		std::string name;
+		PlyType type;		// Type of the value, or of the list items
+		PlyType countType;	// Type of the item count of a list
+		bool bList;
+	};
+
+	struct PlyElement
+	{
+		std::string name;
+		size_t count;
+		std::vector<PlyProperty> properties;
+	};
+
+	PlyType GetPlyType(const std::string& name)
+	{
+		if (name == "char" || name == "int8") return PlyType::Int8;
+		if (name == "uchar" || name == "uint8") return PlyType::UInt8;
+		if (name == "short" || name == "int16") return PlyType::Int16;
+		if (name == "ushort" || name == "uint16") return PlyType::UInt16;
+		if (name == "int" || name == "int32") return PlyType::Int32;
+		if (name == "uint" || name == "uint32") return PlyType::UInt32;
+		if (name == "float" || name == "float32") return PlyType::Float32;
+		if (name == "double" || name == "float64") return PlyType::Float64;
+		return PlyType::Invalid;
+	}
+
+	size_t GetPlyTypeSize(PlyType type)
+	{
+		switch (type)
+		{
+		case PlyType::Int8:
+		case PlyType::UInt8:
+			return 1;
+		case PlyType::Int16:
+		case PlyType::UInt16:
+			return 2;
+		case PlyType::Int32:
+		case PlyType::UInt32:
+		case PlyType::Float32:
+			return 4;
+		case PlyType::Float64:
+			return 8;
+		default:
+			return 0;
+		}
+	}
+
+	bool IsLittleEndian()
+	{
+		const std::uint16_t one = 1;
+		unsigned char first;
+		std::memcpy(&first, &one, 1);
+		return first == 1;
+	}
+
+	// value of a binary property, bytes swapped for the other byte order
+	double ReadPlyValue(const unsigned char* data, PlyType type, bool bSwap)
+	{
+		unsigned char bytes[8];
+		size_t size = GetPlyTypeSize(type);
+		for (size_t i = 0; i < size; ++i)
+		{
+			bytes[i] = data[bSwap ? size - 1 - i : i];
+		}
+
+		switch (type)
+		{
+		case PlyType::Int8: { std::int8_t v; std::memcpy(&v, bytes, 1); return v; }
+		case PlyType::UInt8: return bytes[0];
+		case PlyType::Int16: { std::int16_t v; std::memcpy(&v, bytes, 2); return v; }
+		case PlyType::UInt16: { std::uint16_t v; std::memcpy(&v, bytes, 2); return v; }
+		case PlyType::Int32: { std::int32_t v; std::memcpy(&v, bytes, 4); return v; }
+		case PlyType::UInt32: { std::uint32_t v; std::memcpy(&v, bytes, 4); return v; }
+		case PlyType::Float32: { float v; std::memcpy(&v, bytes, 4); return v; }
+		case PlyType::Float64: { double v; std::memcpy(&v, bytes, 8); return v; }
+		default: return 0.0;
+		}
+	}
+
+	// slot of a vertex property in the interleaved layout, -1 when unused
+	int GetPlyVertexSlot(const std::string& name)
+	{
+		static const char* names[][4] = {
+			{ "x" }, { "y" }, { "z" }, { "nx" }, { "ny" }, { "nz" },
+			{ "u", "s", "texture_u", "texture_s" },
+			{ "v", "t", "texture_v", "texture_t" }
+		};
+		for (int slot = 0; slot < 8; ++slot)
+		{
+			for (const char* alias : names[slot])
+			{
+				if (alias && name == alias)
+				{
+					return slot;
+				}
+			}
+		}
+		return -1;
+	}
+
+	bool IsPlyFaceList(const PlyProperty& property)
+	{
+		return property.bList && (property.name == "vertex_indices" || property.name == "vertex_index");
+	}
+
+	// reads the header lines up to end_header
+	bool ParsePlyHeader(const char*& p, const char* end, PlyFormat& format, std::vector<PlyElement>& elements, std::string& error)
+	{
+		if (end - p < 4 || std::strncmp(p, "ply", 3) != 0)
+		{
+			error = "not a PLY file";
+			return false;
+		}
+		p = NextLine(p, end);
+
+		bool bFormat = false;
+		while (p < end)
+		{
+			const char* lineEnd = NextLine(p, end);
+			std::string keyword = ParseWord(p, lineEnd);
+			if (keyword == "format")
+			{
+				std::string name = ParseWord(p, lineEnd);
+				bFormat = true;
+				if (name == "ascii") format = PlyFormat::Ascii;
+				else if (name == "binary_little_endian") format = PlyFormat::BinaryLittleEndian;
+				else if (name == "binary_big_endian") format = PlyFormat::BinaryBigEndian;
+				else bFormat = false;
+			}
+			else if (keyword == "element")
+			{
+				PlyElement element;
+				element.name = ParseWord(p, lineEnd);
+				long long count = 0;
+				if (!ParseInteger(p, lineEnd, count) || count < 0)
+				{
+					error = "bad element count";
+					return false;
+				}
+				element.count = static_cast<size_t>(count);
+				elements.push_back(element);
+			}
+			else if (keyword == "property")
+			{
+				if (elements.empty())
+				{
+					error = "property outside an element";
+					return false;
+				}
+				PlyProperty property;
+				std::string type = ParseWord(p, lineEnd);
+				property.bList = type == "list";
+				property.countType = PlyType::Invalid;
+				if (property.bList)
+				{
+					property.countType = GetPlyType(ParseWord(p, lineEnd));
+					type = ParseWord(p, lineEnd);
+				}
+				property.type = GetPlyType(type);
+				property.name = ParseWord(p, lineEnd);
+				if (property.type == PlyType::Invalid || (property.bList && property.countType == PlyType::Invalid))
+				{
+					error = "unknown property type";
+					return false;
+				}
+				elements.back().properties.push_back(property);
+			}
+			else if (keyword == "end_header")
+			{
+				p = lineEnd;
+				if (!bFormat)
+				{
+					error = "unknown PLY format";
+				}
+				return bFormat;
+			}
+			p = lineEnd;
+		}
+		error = "no end_header";
+		return false;
+	}
+
+	// walks over one binary row of any element and copies the vertex
+	// list of a face into faceList when given; returns null past the end
+	const unsigned char* ReadPlyBinaryRow(const unsigned char* p,
+		const unsigned char* end,
+		const PlyElement& element,
+		bool bSwap,
+		std::vector<GLuint>* faceList)
+	{
+		for (const PlyProperty& property : element.properties)
+		{
+			if (!property.bList)
+			{
+				p += GetPlyTypeSize(property.type);
+				if (p > end)
+				{
+					return nullptr;
+				}
+				continue;
+			}
+
+			size_t countSize = GetPlyTypeSize(property.countType);
+			if (p + countSize > end)
+			{
+				return nullptr;
+			}
+			size_t count = static_cast<size_t>(ReadPlyValue(p, property.countType, bSwap));
+			p += countSize;
+
+			size_t itemSize = GetPlyTypeSize(property.type);
+			if (static_cast<size_t>(end - p) < count * itemSize)
+			{
+				return nullptr;
+			}
+			if (faceList && IsPlyFaceList(property))
+			{
+				faceList->clear();
+				for (size_t i = 0; i < count; ++i)
+				{
+					faceList->push_back(static_cast<GLuint>(ReadPlyValue(p + i * itemSize, property.type, bSwap)));
+				}
+			}
+			p += count * itemSize;
+		}
+		return p;
+	}
+
+	// fan triangulates a face into the indices, false on a bad index
+	bool AppendPlyFace(const std::vector<GLuint>& face, GLuint vertexCount, std::vector<GLuint>& indices)
+	{
+		for (GLuint index : face)
+		{
+			if (index >= vertexCount)
+			{
+				return false;
+			}
+		}
+		for (size_t k = 1; k + 1 < face.size(); ++k)
+		{
+			indices.push_back(face[0]);
+			indices.push_back(face[k]);
+			indices.push_back(face[k + 1]);
+		}
+		return true;
+	}
+
+	// parses the ascii rows of the vertex element in parallel; the
+	// lines are split into chunks whose first vertex is known from
+	// the line counts of the chunks before
+	bool ParsePlyAsciiVertices(const char* begin, const char* end, const PlyElement& element, MeshData& meshData, unsigned threadCount)
+	{
+		std::vector<TextRange> ranges;
+		SplitLines(begin, end, ranges);
+		std::vector<size_t> firstVertices(ranges.size() + 1, 0);
+		ParallelForChunks(ranges.size(), threadCount, [&](size_t chunk)
+		{
+			size_t lines = 0;
+			for (const char* p = ranges[chunk].first; p < ranges[chunk].second; p = NextLine(p, ranges[chunk].second))
+			{
+				lines++;
+			}
+			firstVertices[chunk + 1] = lines;
+		});
+		for (size_t chunk = 0; chunk < ranges.size(); ++chunk)
+		{
+			firstVertices[chunk + 1] += firstVertices[chunk];
+		}
+
+		std::vector<int> slots;
+		for (const PlyProperty& property : element.properties)
+		{
+			slots.push_back(property.bList ? -1 : GetPlyVertexSlot(property.name));
+		}
+
+		std::atomic<bool> bValid(true);
+		ParallelForChunks(ranges.size(), threadCount, [&](size_t chunk)
+		{
+			size_t vertex = firstVertices[chunk];
+			for (const char* p = ranges[chunk].first; p < ranges[chunk].second && vertex < element.count; ++vertex)
+			{
+				const char* lineEnd = NextLine(p, ranges[chunk].second);
+				GLfloat* output = &meshData.vertices[vertex * MeshData::FloatsPerVertex];
+				for (size_t i = 0; i < element.properties.size(); ++i)
+				{
+					double value = 0.0;
+					if (!ParseDouble(p, lineEnd, value))
+					{
+						bValid = false;
+						break;
+					}
+					if (element.properties[i].bList)
+					{
+						for (long long item = 0; item < static_cast<long long>(value); ++item)
+						{
+							double skipped = 0.0;
+							ParseDouble(p, lineEnd, skipped);
+						}
+					}
+					else if (slots[i] >= 0)
+					{
+						output[slots[i]] = static_cast<GLfloat>(value);
+					}
+				}
+				p = lineEnd;
+			}
+		});
+		return bValid;
+	}
+
+	// parses the ascii rows of the face element into per chunk
+	// index lists in parallel and joins them
+	bool ParsePlyAsciiFaces(const char* begin, const char* end, const PlyElement& element, MeshData& meshData, unsigned threadCount)
+	{
+		std::vector<TextRange> ranges;
+		SplitLines(begin, end, ranges);
+		std::vector<std::vector<GLuint>> chunkIndices(ranges.size());
+		const GLuint vertexCount = meshData.VertexCount();
+
+		std::atomic<bool> bValid(true);
+		ParallelForChunks(ranges.size(), threadCount, [&](size_t chunk)
+		{
+			std::vector<GLuint> face;
+			for (const char* p = ranges[chunk].first; p < ranges[chunk].second; )
+			{
+				const char* lineEnd = NextLine(p, ranges[chunk].second);
+				for (const PlyProperty& property : element.properties)
+				{
+					double value = 0.0;
+					if (!ParseDouble(p, lineEnd, value))
+					{
+						bValid = false;
+						break;
+					}
+					if (!property.bList)
+					{
+						continue;
+					}
+					face.clear();
+					for (long long item = 0; item < static_cast<long long>(value); ++item)
+					{
+						double index = 0.0;
+						ParseDouble(p, lineEnd, index);
+						face.push_back(index >= 0.0 ? static_cast<GLuint>(index) : vertexCount);
+					}
+					if (IsPlyFaceList(property) && !AppendPlyFace(face, vertexCount, chunkIndices[chunk]))
+					{
+						bValid = false;
+					}
+				}
+				p = lineEnd;
+			}
+		});
+
+		for (const std::vector<GLuint>& indices : chunkIndices)
+		{
+			meshData.indices.insert(meshData.indices.end(), indices.begin(), indices.end());
+		}
+		return bValid;
+	}
+
+	bool ImportPly(const char* text, size_t size, MeshData& meshData, unsigned threadCount, std::string& error)
+	{
+		const char* p = text;
+		const char* end = text + size;
+		PlyFormat format = PlyFormat::Ascii;
+		std::vector<PlyElement> elements;
+		if (!ParsePlyHeader(p, end, format, elements, error))
+		{
+			return false;
+		}
+
+		const bool bSwap = (format == PlyFormat::BinaryBigEndian) == IsLittleEndian();
+		const unsigned char* data = reinterpret_cast<const unsigned char*>(p);
+		const unsigned char* dataEnd = reinterpret_cast<const unsigned char*>(end);
+
+		bool bNormals = false;
+		bool bVertices = false;
+		for (const PlyElement& element : elements)
+		{
+			if (element.name == "vertex" && !bVertices)
+			{
+				bVertices = true;
+				if (element.count > 0xFFFFFFFFu)
+				{
+					error = "too many vertices";
+					return false;
+				}
+				meshData.vertices.assign(element.count * MeshData::FloatsPerVertex, 0.0f);
+				for (const PlyProperty& property : element.properties)
+				{
+					bNormals |= property.name == "nx";
+				}
+
+				if (format == PlyFormat::Ascii)
+				{
+					const char* sectionEnd = SkipLines(p, end, element.count);
+					if (!ParsePlyAsciiVertices(p, sectionEnd, element, meshData, threadCount))
+					{
+						error = "malformed vertex";
+						return false;
+					}
+					p = sectionEnd;
+					continue;
+				}
+
+				// fixed size rows are converted in parallel straight from the mapping
+				size_t stride = 0;
+				std::vector<std::pair<size_t, int>> offsets;
+				for (const PlyProperty& property : element.properties)
+				{
+					if (property.bList)
+					{
+						error = "list property in the vertex element";
+						return false;
+					}
+					offsets.push_back({ stride, GetPlyVertexSlot(property.name) });
+					stride += GetPlyTypeSize(property.type);
+				}
+				if (static_cast<size_t>(dataEnd - data) < stride * element.count)
+				{
+					error = "file ends inside the vertices";
+					return false;
+				}
+				ParallelForChunks((element.count + g_ChunkVertices - 1) / g_ChunkVertices, threadCount, [&](size_t chunk)
+				{
+					size_t last = std::min(element.count, (chunk + 1) * g_ChunkVertices);
+					for (size_t vertex = chunk * g_ChunkVertices; vertex < last; ++vertex)
+					{
+						const unsigned char* row = data + vertex * stride;
+						GLfloat* output = &meshData.vertices[vertex * MeshData::FloatsPerVertex];
+						for (size_t i = 0; i < offsets.size(); ++i)
+						{
+							if (offsets[i].second >= 0)
+							{
+								output[offsets[i].second] = static_cast<GLfloat>(ReadPlyValue(row + offsets[i].first, element.properties[i].type, bSwap));
+							}
+						}
+					}
+				});
+				data += stride * element.count;
+				continue;
+			}
+
+			if (element.name == "face" && bVertices)
+			{
+				if (format == PlyFormat::Ascii)
+				{
+					const char* sectionEnd = SkipLines(p, end, element.count);
+					if (!ParsePlyAsciiFaces(p, sectionEnd, element, meshData, threadCount))
+					{
+						error = "malformed face";
+						return false;
+					}
+					p = sectionEnd;
+					continue;
+				}
+
+				// the rows differ in size, so the faces are read in order
+				std::vector<GLuint> face;
+				for (size_t row = 0; row < element.count; ++row)
+				{
+					face.clear();
+					data = ReadPlyBinaryRow(data, dataEnd, element, bSwap, &face);
+					if (!data || !AppendPlyFace(face, meshData.VertexCount(), meshData.indices))
+					{
+						error = data ? "face index out of range" : "file ends inside the faces";
+						return false;
+					}
+				}
+				break;
+			}
+
+			// other elements are skipped
+			if (format == PlyFormat::Ascii)
+			{
+				p = SkipLines(p, end, element.count);
+				continue;
+			}
+			for (size_t row = 0; row < element.count && data; ++row)
+			{
+				data = ReadPlyBinaryRow(data, dataEnd, element, bSwap, nullptr);
+			}
+			if (!data)
+			{
+				error = "file ends inside an element";
+				return false;
+			}
+		}
+
+		if (!bVertices)
+		{
+			error = "no vertex element";
+			return false;
+		}
+		if (!bNormals)
+		{
+			GenerateVertexNormals(meshData, NormalOptions::Smooth(threadCount));
+		}
+		return true;
+	}
+
+	/***********************************************************
+	 *  glTF
+	 ***********************************************************/
+
+	// parsed JSON value, objects keep their members in file order
+	struct JsonValue
+	{
+		enum class Type { Null, Bool, Number, String, Array, Object };
+
+		Type type;
+		double number;
+		std::string text;
+		std::vector<JsonValue> items;	// Array items, or object member values
+		std::vector<std::string> keys;	// Object member names
+
+		JsonValue() : type(Type::Null), number(0.0) {}
+
+		const JsonValue* Find(const char* key) const
+		{
+			for (size_t i = 0; i < keys.size(); ++i)
+			{
+				if (keys[i] == key)
+				{
+					return &items[i];
+				}
+			}
+			return nullptr;
+		}
+
+		double GetNumber(const char* key, double fallback) const
+		{
+			const JsonValue* value = Find(key);
+			return value && value->type == Type::Number ? value->number : fallback;
+		}
+
+		const JsonValue* GetItem(const char* key, double index) const
+		{
+			const JsonValue* array = Find(key);
+			if (!array || array->type != Type::Array || index < 0.0 || index >= array->items.size())
+			{
+				return nullptr;
+			}
+			return &array->items[static_cast<size_t>(index)];
+		}
+	};
+
+	void SkipJsonSpaces(const char*& p, const char* end)
+	{
+		while (p < end && (IsSpace(*p) || *p == '\n'))
+		{
+			++p;
+		}
+	}
+
+	void AppendUtf8(std::string& text, unsigned codePoint)
+	{
+		if (codePoint < 0x80)
+		{
+			text += static_cast<char>(codePoint);
+		}
+		else if (codePoint < 0x800)
+		{
+			text += static_cast<char>(0xC0 | (codePoint >> 6));
+			text += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+		else if (codePoint < 0x10000)
+		{
+			text += static_cast<char>(0xE0 | (codePoint >> 12));
+			text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			text += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+		else
+		{
+			text += static_cast<char>(0xF0 | (codePoint >> 18));
+			text += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+			text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+			text += static_cast<char>(0x80 | (codePoint & 0x3F));
+		}
+	}
+
+	bool ParseJsonHex(const char*& p, const char* end, unsigned& value)
+	{
+		value = 0;
+		for (int i = 0; i < 4; ++i, ++p)
+		{
+			if (p >= end)
+			{
+				return false;
+			}
+			char c = *p;
+			unsigned digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : 16;
+			if (digit > 15)
+			{
+				return false;
+			}
+			value = value * 16 + digit;
+		}
+		return true;
+	}
+
+	bool ParseJsonString(const char*& p, const char* end, std::string& text)
+	{
+		if (p >= end || *p != '"')
+		{
+			return false;
+		}
+		for (++p; p < end && *p != '"'; ++p)
+		{
+			if (*p != '\\')
+			{
+				text += *p;
+				continue;
+			}
+			if (++p >= end)
+			{
+				return false;
+			}
+			switch (*p)
+			{
+			case 'b': text += '\b'; break;
+			case 'f': text += '\f'; break;
+			case 'n': text += '\n'; break;
+			case 'r': text += '\r'; break;
+			case 't': text += '\t'; break;
+			case 'u':
+			{
+				unsigned codePoint = 0;
+				++p;
+				if (!ParseJsonHex(p, end, codePoint))
+				{
+					return false;
+				}
+				unsigned low = 0;
+				if (codePoint >= 0xD800 && codePoint < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u')
+				{
+					const char* next = p + 2;
+					if (ParseJsonHex(next, end, low) && low >= 0xDC00 && low < 0xE000)
+					{
+						codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+						p = next;
+					}
+				}
+				AppendUtf8(text, codePoint);
+				--p;
+				break;
+			}
+			default: text += *p; break;
+			}
+		}
+		if (p >= end)
+		{
+			return false;
+		}
+		++p;
+		return true;
+	}
+
+	bool ParseJsonValue(const char*& p, const char* end, JsonValue& value, int depth)
+	{
+		SkipJsonSpaces(p, end);
+		if (p >= end || depth > g_MaxJsonDepth)
+		{
+			return false;
+		}
+
+		if (*p == '{' || *p == '[')
+		{
+			const bool bObject = *p == '{';
+			const char close = bObject ? '}' : ']';
+			value.type = bObject ? JsonValue::Type::Object : JsonValue::Type::Array;
+			++p;
+			SkipJsonSpaces(p, end);
+			if (p < end && *p == close)
+			{
+				++p;
+				return true;
+			}
+			while (p < end)
+			{
+				if (bObject)
+				{
+					std::string key;
+					SkipJsonSpaces(p, end);
+					if (!ParseJsonString(p, end, key))
+					{
+						return false;
+					}
+					SkipJsonSpaces(p, end);
+					if (p >= end || *p != ':')
+					{
+						return false;
+					}
+					++p;
+					value.keys.push_back(key);
+				}
+				value.items.push_back(JsonValue());
+				if (!ParseJsonValue(p, end, value.items.back(), depth + 1))
+				{
+					return false;
+				}
+				SkipJsonSpaces(p, end);
+				if (p < end && *p == ',')
+				{
+					++p;
+					continue;
+				}
+				if (p < end && *p == close)
+				{
+					++p;
+					return true;
+				}
+				return false;
+			}
+			return false;
+		}
+		if (*p == '"')
+		{
+			value.type = JsonValue::Type::String;
+			return ParseJsonString(p, end, value.text);
+		}
+		if (end - p >= 4 && std::strncmp(p, "true", 4) == 0)
+		{
+			value.type = JsonValue::Type::Bool;
+			value.number = 1.0;
+			p += 4;
+			return true;
+		}
+		if (end - p >= 5 && std::strncmp(p, "false", 5) == 0)
+		{
+			value.type = JsonValue::Type::Bool;
+			p += 5;
+			return true;
+		}
+		if (end - p >= 4 && std::strncmp(p, "null", 4) == 0)
+		{
+			p += 4;
+			return true;
+		}
+		value.type = JsonValue::Type::Number;
+		return ParseDouble(p, end, value.number);
+	}
+
+	bool DecodeBase64(const char* p, const char* end, std::vector<unsigned char>& bytes)
+	{
+		unsigned bits = 0;
+		int bitCount = 0;
+		for (; p < end && *p != '='; ++p)
+		{
+			char c = *p;
+			int digit = (c >= 'A' && c <= 'Z') ? c - 'A' : (c >= 'a' && c <= 'z') ? c - 'a' + 26 :
+				(c >= '0' && c <= '9') ? c - '0' + 52 : c == '+' ? 62 : c == '/' ? 63 : -1;
+			if (digit < 0)
+			{
+				return false;
+			}
+			bits = (bits << 6) | static_cast<unsigned>(digit);
+			bitCount += 6;
+			if (bitCount >= 8)
+			{
+				bitCount -= 8;
+				bytes.push_back(static_cast<unsigned char>((bits >> bitCount) & 0xFF));
+			}
+		}
+		return true;
+	}
+
+	// a buffer of the glTF file, owned by the mapping or the decoded copy
+	struct GltfBuffer
+	{
+		const unsigned char* data;
+		size_t size;
+	};
+
+	// typed view of an accessor inside its buffer
+	struct GltfAccessor
+	{
+		const unsigned char* data;	// First element
+		size_t count;
+		size_t stride;				// Bytes from one element to the next
+		int componentType;
+		int componentCount;
+		bool bNormalized;
+	};
+
+	size_t GetComponentSize(int componentType)
+	{
+		switch (componentType)
+		{
+		case 5120: case 5121: return 1;
+		case 5122: case 5123: return 2;
+		case 5125: case 5126: return 4;
+		default: return 0;
+		}
+	}
+
+	int GetComponentCount(const std::string& type)
+	{
+		if (type == "SCALAR") return 1;
+		if (type == "VEC2") return 2;
+		if (type == "VEC3") return 3;
+		if (type == "VEC4") return 4;
+		return 0;
+	}
+
+	double ReadComponent(const unsigned char* p, int componentType, bool bNormalized)
+	{
+		switch (componentType)
+		{
+		case 5120: { std::int8_t v; std::memcpy(&v, p, 1); return bNormalized ? std::max(v / 127.0, -1.0) : v; }
+		case 5121: return bNormalized ? p[0] / 255.0 : p[0];
+		case 5122: { std::int16_t v; std::memcpy(&v, p, 2); return bNormalized ? std::max(v / 32767.0, -1.0) : v; }
+		case 5123: { std::uint16_t v; std::memcpy(&v, p, 2); return bNormalized ? v / 65535.0 : v; }
+		case 5125: { std::uint32_t v; std::memcpy(&v, p, 4); return v; }
+		case 5126: { float v; std::memcpy(&v, p, 4); return v; }
+		default: return 0.0;
+		}
+	}
+
+	// looks up an accessor and checks that every element lies in its buffer
+	bool GetGltfAccessor(const JsonValue& root, const std::vector<GltfBuffer>& buffers, double index, GltfAccessor& accessor)
+	{
+		const JsonValue* json = root.GetItem("accessors", index);
+		if (!json || json->Find("sparse"))
+		{
+			return false;
+		}
+		const JsonValue* type = json->Find("type");
+		accessor.componentType = static_cast<int>(json->GetNumber("componentType", 0));
+		accessor.componentCount = type ? GetComponentCount(type->text) : 0;
+		accessor.count = static_cast<size_t>(json->GetNumber("count", 0));
+		const JsonValue* normalized = json->Find("normalized");
+		accessor.bNormalized = normalized && normalized->number != 0.0;
+
+		const JsonValue* view = root.GetItem("bufferViews", json->GetNumber("bufferView", -1));
+		size_t elementSize = GetComponentSize(accessor.componentType) * accessor.componentCount;
+		if (!view || elementSize == 0)
+		{
+			return false;
+		}
+		double bufferIndex = view->GetNumber("buffer", -1);
+		if (bufferIndex < 0 || bufferIndex >= buffers.size())
+		{
+			return false;
+		}
+		const GltfBuffer& buffer = buffers[static_cast<size_t>(bufferIndex)];
+		size_t viewOffset = static_cast<size_t>(view->GetNumber("byteOffset", 0));
+		size_t viewLength = static_cast<size_t>(view->GetNumber("byteLength", 0));
+		size_t accessorOffset = static_cast<size_t>(json->GetNumber("byteOffset", 0));
+		accessor.stride = static_cast<size_t>(view->GetNumber("byteStride", 0));
+		accessor.stride = accessor.stride > 0 ? accessor.stride : elementSize;
+
+		if (viewOffset > buffer.size || viewLength > buffer.size - viewOffset)
+		{
+			return false;
+		}
+		if (accessor.count > 0 && (accessorOffset > viewLength ||
+			(accessor.count - 1) * accessor.stride + elementSize > viewLength - accessorOffset))
+		{
+			return false;
+		}
+		accessor.data = buffer.data + viewOffset + accessorOffset;
+		return true;
+	}
+
+	glm::vec4 ReadAccessor(const GltfAccessor& accessor, size_t element)
+	{
+		glm::vec4 value(0.0f);
+		const unsigned char* p = accessor.data + element * accessor.stride;
+		size_t componentSize = GetComponentSize(accessor.componentType);
+		for (int c = 0; c < accessor.componentCount; ++c)
+		{
+			value[c] = static_cast<float>(ReadComponent(p + c * componentSize, accessor.componentType, accessor.bNormalized));
+		}
+		return value;
+	}
+
+	glm::mat4 GetNodeMatrix(const JsonValue& node)
+	{
+		const JsonValue* matrix = node.Find("matrix");
+		if (matrix && matrix->items.size() == 16)
+		{
+			glm::mat4 result;
+			for (int i = 0; i < 16; ++i)
+			{
+				result[i / 4][i % 4] = static_cast<float>(matrix->items[i].number);
+			}
+			return result;
+		}
+
+		glm::vec3 translation(0.0f);
+		glm::vec4 rotation(0.0f, 0.0f, 0.0f, 1.0f);
+		glm::vec3 scale(1.0f);
+		const JsonValue* t = node.Find("translation");
+		const JsonValue* r = node.Find("rotation");
+		const JsonValue* s = node.Find("scale");
+		if (t && t->items.size() == 3)
+		{
+			translation = glm::vec3(t->items[0].number, t->items[1].number, t->items[2].number);
+		}
+		if (r && r->items.size() == 4)
+		{
+			rotation = glm::vec4(r->items[0].number, r->items[1].number, r->items[2].number, r->items[3].number);
+		}
+		if (s && s->items.size() == 3)
+		{
+			scale = glm::vec3(s->items[0].number, s->items[1].number, s->items[2].number);
+		}
+
+		// rotation matrix of the unit quaternion (x, y, z, w)
+		const float x = rotation.x;
+		const float y = rotation.y;
+		const float z = rotation.z;
+		const float w = rotation.w;
+		glm::mat4 result(1.0f);
+		result[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + z * w), 2.0f * (x * z - y * w), 0.0f);
+		result[1] = glm::vec4(2.0f * (x * y - z * w), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + x * w), 0.0f);
+		result[2] = glm::vec4(2.0f * (x * z + y * w), 2.0f * (y * z - x * w), 1.0f - 2.0f * (x * x + y * y), 0.0f);
+		result[0] *= scale.x;
+		result[1] *= scale.y;
+		result[2] *= scale.z;
+		result[3] = glm::vec4(translation, 1.0f);
+		return result;
+	}
+
+	// one mesh placed by a node
+	struct GltfInstance
+	{
+		const JsonValue* mesh;
+		glm::mat4 transform;
+	};
+
+	void CollectGltfNodes(const JsonValue& root, double nodeIndex, const glm::mat4& parent, int depth, std::vector<GltfInstance>& instances)
+	{
+		const JsonValue* node = root.GetItem("nodes", nodeIndex);
+		if (!node || depth > g_MaxNodeDepth)
+		{
+			return;
+		}
+		glm::mat4 transform = parent * GetNodeMatrix(*node);
+		const JsonValue* mesh = root.GetItem("meshes", node->GetNumber("mesh", -1));
+		if (mesh)
+		{
+			instances.push_back({ mesh, transform });
+		}
+		const JsonValue* children = node->Find("children");
+		if (children)
+		{
+			for (const JsonValue& child : children->items)
+			{
+				CollectGltfNodes(root, child.number, transform, depth + 1, instances);
+			}
+		}
+	}
+
+	// one triangle primitive with the place of its data in the mesh
+	struct GltfPrimitive
+	{
+		const JsonValue* json;
+		glm::mat4 transform;
+		GLuint firstVertex;
+		GLuint vertexCount;
+		size_t firstIndex;
+		size_t indexCount;
+		bool bNormals;
+	};
+
+	bool ImportGltf(const std::string& path, const MappedFile& file, MeshData& meshData, size_t& fileBytes, unsigned threadCount, std::string& error)
+	{
+		const unsigned char* bytes = file.GetData();
+		const size_t size = file.GetSize();
+
+		// a .glb holds the JSON and the first buffer as chunks of one file
+		const char* jsonBegin = reinterpret_cast<const char*>(bytes);
+		const char* jsonEnd = jsonBegin + size;
+		GltfBuffer binaryChunk = { nullptr, 0 };
+		if (size >= 12 && std::memcmp(bytes, "glTF", 4) == 0)
+		{
+			size_t offset = 12;
+			jsonBegin = jsonEnd = nullptr;
+			while (offset + 8 <= size)
+			{
+				std::uint32_t chunkLength;
+				std::uint32_t chunkType;
+				std::memcpy(&chunkLength, bytes + offset, 4);
+				std::memcpy(&chunkType, bytes + offset + 4, 4);
+				offset += 8;
+				if (chunkLength > size - offset)
+				{
+					break;
+				}
+				if (chunkType == 0x4E4F534A && !jsonBegin)
+				{
+					jsonBegin = reinterpret_cast<const char*>(bytes + offset);
+					jsonEnd = jsonBegin + chunkLength;
+				}
+				else if (chunkType == 0x004E4942 && !binaryChunk.data)
+				{
+					binaryChunk = { bytes + offset, chunkLength };
+				}
+				offset += (chunkLength + 3) & ~static_cast<size_t>(3);
+			}
+			if (!jsonBegin)
+			{
+				error = "no JSON chunk";
+				return false;
+			}
+		}
+
+		JsonValue root;
+		const char* p = jsonBegin;
+		if (!ParseJsonValue(p, jsonEnd, root, 0) || root.type != JsonValue::Type::Object)
+		{
+			error = "malformed JSON";
+			return false;
+		}
+
+		// buffers come from the binary chunk, data URIs or files next to this one
+		std::vector<GltfBuffer> buffers;
+		std::vector<std::unique_ptr<MappedFile>> bufferFiles;
+		std::vector<std::unique_ptr<std::vector<unsigned char>>> decodedBuffers;
+		std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+		const JsonValue* bufferList = root.Find("buffers");
+		for (size_t i = 0; bufferList && i < bufferList->items.size(); ++i)
+		{
+			const JsonValue* uri = bufferList->items[i].Find("uri");
+			if (!uri)
+			{
+				buffers.push_back(binaryChunk);
+				continue;
+			}
+			if (uri->text.compare(0, 5, "data:") == 0)
+			{
+				size_t comma = uri->text.find(',');
+				decodedBuffers.emplace_back(new std::vector<unsigned char>());
+				if (comma == std::string::npos ||
+					!DecodeBase64(uri->text.data() + comma + 1, uri->text.data() + uri->text.size(), *decodedBuffers.back()))
+				{
+					error = "bad data URI";
+					return false;
+				}
+				buffers.push_back({ decodedBuffers.back()->data(), decodedBuffers.back()->size() });
+				continue;
+			}
+			bufferFiles.emplace_back(new MappedFile());
+			if (!bufferFiles.back()->Open(directory + uri->text))
+			{
+				error = "cannot open buffer " + uri->text;
+				return false;
+			}
+			fileBytes += bufferFiles.back()->GetSize();
+			buffers.push_back({ bufferFiles.back()->GetData(), bufferFiles.back()->GetSize() });
+		}
+
+		// the meshes placed by the nodes of the scene, or each mesh once
+		std::vector<GltfInstance> instances;
+		const JsonValue* scene = root.GetItem("scenes", root.GetNumber("scene", 0));
+		if (scene && scene->Find("nodes"))
+		{
+			for (const JsonValue& node : scene->Find("nodes")->items)
+			{
+				CollectGltfNodes(root, node.number, glm::mat4(1.0f), 0, instances);
+			}
+		}
+		else if (root.Find("meshes"))
+		{
+			for (const JsonValue& mesh : root.Find("meshes")->items)
+			{
+				instances.push_back({ &mesh, glm::mat4(1.0f) });
+			}
+		}
+
+		std::vector<GltfPrimitive> primitives;
+		size_t vertexCount = 0;
+		size_t indexCount = 0;
+		for (const GltfInstance& instance : instances)
+		{
+			const JsonValue* primitiveList = instance.mesh->Find("primitives");
+			for (size_t i = 0; primitiveList && i < primitiveList->items.size(); ++i)
+			{
+				const JsonValue& json = primitiveList->items[i];
+				const JsonValue* attributes = json.Find("attributes");
+				GltfAccessor positions;
+				if (json.GetNumber("mode", 4) != 4 || !attributes ||
+					!GetGltfAccessor(root, buffers, attributes->GetNumber("POSITION", -1), positions))
+				{
+					continue;
+				}
+				GltfAccessor indices;
+				bool bIndexed = json.Find("indices") != nullptr;
+				if (bIndexed && !GetGltfAccessor(root, buffers, json.GetNumber("indices", -1), indices))
+				{
+					continue;
+				}
+
+				GltfPrimitive primitive = { &json, instance.transform, static_cast<GLuint>(vertexCount),
+					static_cast<GLuint>(positions.count), indexCount, (bIndexed ? indices.count : positions.count) / 3 * 3, false };
+				primitives.push_back(primitive);
+				vertexCount += primitive.vertexCount;
+				indexCount += primitive.indexCount;
+			}
+		}
+		if (primitives.empty())
+		{
+			error = "no triangle primitives";
+			return false;
+		}
+		if (vertexCount > 0xFFFFFFFFu)
+		{
+			error = "too many vertices";
+			return false;
+		}
+
+		// the primitives are converted in parallel, each into its own range
+		meshData.vertices.resize(vertexCount * MeshData::FloatsPerVertex);
+		meshData.indices.resize(indexCount);
+		std::atomic<bool> bInvalidIndex(false);
+		ParallelForChunks(primitives.size(), threadCount, [&](size_t i)
+		{
+			GltfPrimitive& primitive = primitives[i];
+			const JsonValue* attributes = primitive.json->Find("attributes");
+			GltfAccessor positions;
+			GltfAccessor normals;
+			GltfAccessor uvs;
+			GetGltfAccessor(root, buffers, attributes->GetNumber("POSITION", -1), positions);
+			primitive.bNormals = GetGltfAccessor(root, buffers, attributes->GetNumber("NORMAL", -1), normals) && normals.count == positions.count;
+			bool bUVs = GetGltfAccessor(root, buffers, attributes->GetNumber("TEXCOORD_0", -1), uvs) && uvs.count == positions.count;
+
+			glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(primitive.transform)));
+			GLfloat* vertex = &meshData.vertices[static_cast<size_t>(primitive.firstVertex) * MeshData::FloatsPerVertex];
+			for (size_t v = 0; v < positions.count; ++v)
+			{
+				glm::vec3 position = glm::vec3(primitive.transform * glm::vec4(glm::vec3(ReadAccessor(positions, v)), 1.0f));
+				glm::vec3 normal(0.0f, 1.0f, 0.0f);
+				if (primitive.bNormals)
+				{
+					normal = normalMatrix * glm::vec3(ReadAccessor(normals, v));
+					float length = glm::length(normal);
+					normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+				}
+				glm::vec4 uv = bUVs ? ReadAccessor(uvs, v) : glm::vec4(0.0f);
+				WriteVertex(vertex, position, normal, glm::vec2(uv.x, uv.y));
+				vertex += MeshData::FloatsPerVertex;
+			}
+
+			// a mirroring transform turns the triangles inside out
+			const bool bMirrored = glm::determinant(glm::mat3(primitive.transform)) < 0.0f;
+			GltfAccessor indices;
+			const bool bIndexed = GetGltfAccessor(root, buffers, primitive.json->GetNumber("indices", -1), indices);
+			GLuint* output = &meshData.indices[primitive.firstIndex];
+			for (size_t k = 0; k < primitive.indexCount; ++k)
+			{
+				size_t source = bMirrored ? k - k % 3 + (2 - k % 3) : k;
+				size_t index = bIndexed ? static_cast<size_t>(ReadComponent(indices.data + source * indices.stride, indices.componentType, false)) : source;
+				if (index >= primitive.vertexCount)
+				{
+					bInvalidIndex = true;
+					index = 0;
+				}
+				output[k] = primitive.firstVertex + static_cast<GLuint>(index);
+			}
+
+			// one thread each, the primitives already run in parallel
+			if (!primitive.bNormals)
+			{
+				GenerateVertexNormals(meshData.vertices.data(), primitive.firstVertex, primitive.vertexCount,
+					&meshData.indices[primitive.firstIndex], primitive.indexCount, NormalOptions::Smooth(1));
+			}
+		});
+
+		if (bInvalidIndex)
+		{
+			error = "index out of range";
+			return false;
+		}
+		return true;
+	}
+
+	/***********************************************************
+	 *  Benchmark
+	 ***********************************************************/
+
+	// peak resident memory of the process in bytes, 0 when unknown
+	size_t GetPeakResidentBytes()
+	{
+#ifdef _WIN32
+		PROCESS_MEMORY_COUNTERS counters;
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		{
+			return counters.PeakWorkingSetSize;
+		}
+		return 0;
+#else
+		std::ifstream status("/proc/self/status");
+		std::string line;
+		while (std::getline(status, line))
+		{
+			if (line.compare(0, 6, "VmHWM:") == 0)
+			{
+				const char* p = line.c_str() + 6;
+				long long kilobytes = 0;
+				ParseInteger(p, line.c_str() + line.size(), kilobytes);
+				return static_cast<size_t>(kilobytes) * 1024;
+			}
+		}
+		struct rusage usage;
+		if (getrusage(RUSAGE_SELF, &usage) == 0)
+		{
+#ifdef __APPLE__
+			return static_cast<size_t>(usage.ru_maxrss);
+#else
+			return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+		}
+		return 0;
+#endif
+	}
+
+	// lets the next peak start from the current use, where the system
+	// allows it; elsewhere the peaks only grow over the benchmark
+	void ResetPeakResident()
+	{
+#ifdef __linux__
+		std::ofstream clearRefs("/proc/self/clear_refs");
+		clearRefs << "5";
+#endif
+	}
+
+	// the straightforward OBJ reader the importer is measured against,
+	// one getline and one istringstream per line
+	bool ImportObjWithStreams(const std::string& path, MeshData& meshData)
+	{
+		std::ifstream file(path);
+		if (!file)
+		{
+			return false;
+		}
+
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+		std::string line;
+		while (std::getline(file, line))
+		{
+			std::istringstream stream(line);
+			std::string keyword;
+			stream >> keyword;
+			if (keyword == "v")
+			{
+				glm::vec3 position;
+				stream >> position.x >> position.y >> position.z;
+				positions.push_back(position);
+			}
+			else if (keyword == "vt")
+			{
+				glm::vec2 uv;
+				stream >> uv.x >> uv.y;
+				uvs.push_back(uv);
+			}
+			else if (keyword == "vn")
+			{
+				glm::vec3 normal;
+				stream >> normal.x >> normal.y >> normal.z;
+				normals.push_back(normal);
+			}
+			else if (keyword == "f")
+			{
+				std::vector<std::array<long long, 3>> face;
+				std::string corner;
+				while (stream >> corner)
+				{
+					std::array<long long, 3> index = { { 0, 0, 0 } };
+					std::istringstream cornerStream(corner);
+					std::string part;
+					for (int kind = 0; kind < 3 && std::getline(cornerStream, part, '/'); ++kind)
+					{
+						index[kind] = part.empty() ? 0 : std::stoll(part);
+					}
+					face.push_back(index);
+				}
+				for (size_t k = 1; k + 1 < face.size(); ++k)
+				{
+					for (size_t corner : { size_t(0), k, k + 1 })
+					{
+						const std::array<long long, 3>& index = face[corner];
+						long long p = index[0] < 0 ? positions.size() + index[0] : index[0] - 1;
+						long long t = index[1] < 0 ? uvs.size() + index[1] : index[1] - 1;
+						long long n = index[2] < 0 ? normals.size() + index[2] : index[2] - 1;
+						if (p < 0 || p >= static_cast<long long>(positions.size()))
+						{
+							return false;
+						}
+						glm::vec2 uv = t >= 0 && t < static_cast<long long>(uvs.size()) ? uvs[t] : glm::vec2(0.0f);
+						glm::vec3 normal = n >= 0 && n < static_cast<long long>(normals.size()) ? normals[n] : glm::vec3(0.0f, 1.0f, 0.0f);
+						meshData.indices.push_back(meshData.VertexCount());
+						meshData.vertices.resize(meshData.vertices.size() + MeshData::FloatsPerVertex);
+						WriteVertex(&meshData.vertices[meshData.vertices.size() - MeshData::FloatsPerVertex], positions[p], normal, uv);
+					}
+				}
+			}
+		}
+		return true;
+	}
+
+	// writes a welded sphere with positions, texture coords and normals
+	bool WriteBenchmarkObj(const char* path)
+	{
+		MeshData sphere;
+		GenerateParametricSurface(SphereSurface{ 1.0f }, SphereSurface::Grid(g_BenchmarkRows, g_BenchmarkColumns), sphere);
+		WeldVertices(sphere);
+
+		FILE* file = std::fopen(path, "wb");
+		if (!file)
+		{
+			return false;
+		}
+		const GLfloat* v = sphere.vertices.data();
+		for (GLuint i = 0; i < sphere.VertexCount(); ++i, v += MeshData::FloatsPerVertex)
+		{
+			std::fprintf(file, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n", v[0], v[1], v[2], v[6], v[7], v[3], v[4], v[5]);
+		}
+		for (size_t i = 0; i + 2 < sphere.indices.size(); i += 3)
+		{
+			GLuint a = sphere.indices[i] + 1;
+			GLuint b = sphere.indices[i + 1] + 1;
+			GLuint c = sphere.indices[i + 2] + 1;
+			std::fprintf(file, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+		}
+		return std::fclose(file) == 0;
+	}
+
+	void PrintBenchmarkLine(const char* parserName, size_t fileBytes, double milliseconds, size_t peakBytes, const MeshData& meshData)
+	{
+		const double megabytes = fileBytes / (1024.0 * 1024.0);
+		std::cout << "INFO:   " << parserName << ": " << milliseconds << " ms, " << megabytes * 1000.0 / milliseconds
+			<< " MB/s, peak RSS " << peakBytes / (1024.0 * 1024.0) << " MB, " << meshData.VertexCount() << " vertices, "
+			<< meshData.IndexCount() / 3 << " triangles" << std::endl;
+	}
+}
+
+///////////////////////////////////////////////////
+//	ImportMesh()
+///////////////////////////////////////////////////
+bool ImportMesh(const std::string& path, MeshData& meshData, ImportReport* report, unsigned threadCount)
+{
+	auto start = std::chrono::steady_clock::now();
+	meshData.vertices.clear();
+	meshData.indices.clear();
+
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		std::cerr << "Failed to import mesh " << path << ": cannot open the file" << std::endl;
+		return false;
+	}
+
+	std::string error;
+	size_t fileBytes = file.GetSize();
+	const char* text = reinterpret_cast<const char*>(file.GetData());
+	const std::string extension = GetExtension(path);
+	bool bImported = false;
+	if (extension == "obj")
+	{
+		bImported = ImportObj(text, file.GetSize(), meshData, threadCount, error);
+	}
+	else if (extension == "ply")
+	{
+		bImported = ImportPly(text, file.GetSize(), meshData, threadCount, error);
+	}
+	else if (extension == "gltf" || extension == "glb")
+	{
+		bImported = ImportGltf(path, file, meshData, fileBytes, threadCount, error);
+	}
+	else
+	{
+		error = "unknown file type";
+	}
+
+	if (!bImported)
+	{
+		std::cerr << "Failed to import mesh " << path << ": " << error << std::endl;
+		meshData.vertices.clear();
+		meshData.indices.clear();
+		return false;
+	}
+
+	if (report)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		report->fileBytes = fileBytes;
+		report->vertexCount = meshData.VertexCount();
+		report->triangleCount = meshData.IndexCount() / 3;
+		report->milliseconds = elapsed.count();
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	PrintImportReport()
+///////////////////////////////////////////////////
+void PrintImportReport(const char* meshName, const ImportReport& report)
+{
+	const double megabytes = report.fileBytes / (1024.0 * 1024.0);
+	std::cout << "INFO: imported " << meshName << ": " << megabytes << " MB in " << report.milliseconds << " ms ("
+		<< (report.milliseconds > 0.0 ? megabytes * 1000.0 / report.milliseconds : 0.0) << " MB/s), "
+		<< report.vertexCount << " vertices, " << report.triangleCount << " triangles" << std::endl;
+}
+
+///////////////////////////////////////////////////
+//	RunMeshImportBenchmark()
+//
+//	The peak resident memory is reset before each parser
+//	on Linux; elsewhere the second figure can only be read
+//	as the larger of the two.
+///////////////////////////////////////////////////
+void RunMeshImportBenchmark(const char* path)
+{
+	const bool bGenerated = path == nullptr;
+	if (bGenerated)
+	{
+		path = g_BenchmarkPath;
+		if (!WriteBenchmarkObj(path))
+		{
+			std::cerr << "Failed to write " << path << std::endl;
+			return;
+		}
+	}
+
+	{
+		MeshData meshData;
+		ImportReport report = {};
+		ResetPeakResident();
+		if (ImportMesh(path, meshData, &report))
+		{
+			std::cout << "INFO: import benchmark " << path << ", " << report.fileBytes / (1024.0 * 1024.0) << " MB" << std::endl;
+			PrintBenchmarkLine("mapped parallel importer", report.fileBytes, report.milliseconds, GetPeakResidentBytes(), meshData);
+		}
+	}
+
+	if (GetExtension(path) == "obj")
+	{
+		MeshData meshData;
+		ResetPeakResident();
+		auto start = std::chrono::steady_clock::now();
+		bool bImported = ImportObjWithStreams(path, meshData);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		size_t fileBytes = static_cast<size_t>(file.tellg());
+		if (bImported)
+		{
+			PrintBenchmarkLine("ifstream parser", fileBytes, elapsed.count(), GetPeakResidentBytes(), meshData);
+		}
+	}
+
+	if (bGenerated)
+	{
+		std::remove(path);
+	}
+}
@@ -0,0 +1,47 @@
+#ifndef MESH_IMPORTER_H
+#define MESH_IMPORTER_H
+#pragma once
+
+#include <GL/glew.h>
+#include <string>
+
+#include "MeshData.h"
+
+// Size and speed of one import
+struct ImportReport
+{
+	size_t fileBytes;		// Bytes of the mapped file, with the external glTF buffers
+	GLuint vertexCount;		// Vertices written
+	GLuint triangleCount;	// Triangles written
+	double milliseconds;	// Time from opening the file to the finished mesh
+};
+
+///////////////////////////////////////////////////
+//	ImportMesh()
+//
+//	Reads a Wavefront OBJ, PLY (ascii or binary) or glTF 2.0
+//	(.gltf or .glb) file into the interleaved layout of
+//	MeshData, with polygons triangulated as fans. The file
+//	is memory-mapped and split into chunks at line
+//	boundaries that worker threads parse in parallel, a
+//	threadCount of 0 uses every hardware thread. Numbers
+//	are parsed by hand, so the result does not depend on
+//	the C locale. OBJ corners get a vertex each, to be
+//	welded afterwards, PLY and glTF keep their shared
+//	vertices. Missing normals are smoothed over the faces
+//	around each position and missing texture coords are
+//	zero. Returns false and leaves the mesh empty when the
+//	file cannot be read.
+///////////////////////////////////////////////////
+bool ImportMesh(const std::string& path, MeshData& meshData, ImportReport* report = nullptr, unsigned threadCount = 0);
+
+// Writes a one line summary of the report
+void PrintImportReport(const char* meshName, const ImportReport& report);
+
+// Times the importer against a line by line ifstream parser on an OBJ
+// file and prints the throughput in MB/s and the peak resident memory
+// of both; without a path a sphere of about a million triangles is
+// written to a temporary OBJ file first
+void RunMeshImportBenchmark(const char* path = nullptr);
+
+#endif // MESH_IMPORTER_H
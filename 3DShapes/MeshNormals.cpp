@@ -0,0 +1,491 @@
+#include "MeshNormals.h"
+#include "ParametricSurface.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MESH_NORMALS_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	const GLuint g_TrianglesPerGroup = 4;		// Triangles of one SSE2 step
+	const GLuint g_BenchmarkColumns = 2048;		// Quads along u of the benchmark sphere
+	const GLuint g_BenchmarkRows = 1024;		// Quads along v of the benchmark sphere
+	const float g_BenchmarkCreaseAngle = 60.0f;	// Degrees
+	const int g_BenchmarkRuns = 3;				// Runs per kernel, the fastest is kept
+
+	unsigned GetHardwareThreads()
+	{
+		unsigned threads = std::thread::hardware_concurrency();
+		return threads > 0 ? threads : 1;
+	}
+
+	const GLfloat* GetVertex(const GLfloat* vertices, GLuint vertex)
+	{
+		return vertices + static_cast<size_t>(vertex) * MeshData::FloatsPerVertex;
+	}
+
+	glm::vec3 GetPosition(const GLfloat* vertices, GLuint vertex)
+	{
+		const GLfloat* v = GetVertex(vertices, vertex);
+		return glm::vec3(v[0], v[1], v[2]);
+	}
+
+	glm::vec4 GetFaceNormal(const GLfloat* vertices, const GLuint* triangle)
+	{
+		glm::vec3 p0 = GetPosition(vertices, triangle[0]);
+		glm::vec3 normal = glm::cross(GetPosition(vertices, triangle[1]) - p0, GetPosition(vertices, triangle[2]) - p0);
+		float length = glm::length(normal);
+		return glm::vec4(normal, length > 0.0f ? 1.0f / length : 0.0f);
+	}
+
+	// tangent and bitangent of a triangle, weighted by its area in the texture
+	void GetFaceTangent(const GLfloat* vertices, const GLuint* triangle, glm::vec4& tangent, glm::vec4& bitangent)
+	{
+		const GLfloat* v0 = GetVertex(vertices, triangle[0]);
+		const GLfloat* v1 = GetVertex(vertices, triangle[1]);
+		const GLfloat* v2 = GetVertex(vertices, triangle[2]);
+		glm::vec3 e1 = glm::vec3(v1[0], v1[1], v1[2]) - glm::vec3(v0[0], v0[1], v0[2]);
+		glm::vec3 e2 = glm::vec3(v2[0], v2[1], v2[2]) - glm::vec3(v0[0], v0[1], v0[2]);
+		float du1 = v1[6] - v0[6];
+		float dv1 = v1[7] - v0[7];
+		float du2 = v2[6] - v0[6];
+		float dv2 = v2[7] - v0[7];
+		float determinant = du1 * dv2 - du2 * dv1;
+		float sign = determinant > 0.0f ? 1.0f : determinant < 0.0f ? -1.0f : 0.0f;
+		tangent = glm::vec4((e1 * dv2 - e2 * dv1) * sign, 0.0f);
+		bitangent = glm::vec4((e2 * du1 - e1 * du2) * sign, 0.0f);
+	}
+
+#ifdef MESH_NORMALS_SSE2
+	// the first four floats of the corner of four triangles, turned into x, y, z and w rows
+	void LoadCorners(const GLfloat* vertices, const GLuint* triangles, GLuint corner, GLuint offset, __m128 rows[4])
+	{
+		for (GLuint t = 0; t < g_TrianglesPerGroup; ++t)
+		{
+			rows[t] = _mm_loadu_ps(GetVertex(vertices, triangles[t * 3 + corner]) + offset);
+		}
+		_MM_TRANSPOSE4_PS(rows[0], rows[1], rows[2], rows[3]);
+	}
+
+	void Cross(__m128 ax, __m128 ay, __m128 az, __m128 bx, __m128 by, __m128 bz, __m128& x, __m128& y, __m128& z)
+	{
+		x = _mm_sub_ps(_mm_mul_ps(ay, bz), _mm_mul_ps(az, by));
+		y = _mm_sub_ps(_mm_mul_ps(az, bx), _mm_mul_ps(ax, bz));
+		z = _mm_sub_ps(_mm_mul_ps(ax, by), _mm_mul_ps(ay, bx));
+	}
+
+	// four rows of x, y, z and w back into one vector per triangle
+	void StoreRows(__m128 x, __m128 y, __m128 z, __m128 w, glm::vec4* output)
+	{
+		_MM_TRANSPOSE4_PS(x, y, z, w);
+		_mm_storeu_ps(&output[0].x, x);
+		_mm_storeu_ps(&output[1].x, y);
+		_mm_storeu_ps(&output[2].x, z);
+		_mm_storeu_ps(&output[3].x, w);
+	}
+
+	///////////////////////////////////////////////////
+	//	GetFaceNormals4()
+	//
+	//	The positions of four triangles are loaded a vertex
+	//	at a time and transposed into x, y and z rows, so the
+	//	edges, the cross product and its length are worked
+	//	out for all four at once.
+	///////////////////////////////////////////////////
+	void GetFaceNormals4(const GLfloat* vertices, const GLuint* triangles, glm::vec4* output)
+	{
+		__m128 p0[4], p1[4], p2[4];
+		LoadCorners(vertices, triangles, 0, 0, p0);
+		LoadCorners(vertices, triangles, 1, 0, p1);
+		LoadCorners(vertices, triangles, 2, 0, p2);
+
+		__m128 x, y, z;
+		Cross(_mm_sub_ps(p1[0], p0[0]), _mm_sub_ps(p1[1], p0[1]), _mm_sub_ps(p1[2], p0[2]),
+			_mm_sub_ps(p2[0], p0[0]), _mm_sub_ps(p2[1], p0[1]), _mm_sub_ps(p2[2], p0[2]), x, y, z);
+
+		__m128 lengthSquared = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z));
+		__m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), _mm_sqrt_ps(lengthSquared));
+		inverse = _mm_and_ps(inverse, _mm_cmpgt_ps(lengthSquared, _mm_setzero_ps()));
+		StoreRows(x, y, z, inverse, output);
+	}
+
+	// the tangents and bitangents of four triangles, from the positions and the texture coords
+	void GetFaceTangents4(const GLfloat* vertices, const GLuint* triangles, glm::vec4* tangents, glm::vec4* bitangents)
+	{
+		__m128 p0[4], p1[4], p2[4], t0[4], t1[4], t2[4];
+		LoadCorners(vertices, triangles, 0, 0, p0);
+		LoadCorners(vertices, triangles, 1, 0, p1);
+		LoadCorners(vertices, triangles, 2, 0, p2);
+		LoadCorners(vertices, triangles, 0, 4, t0);
+		LoadCorners(vertices, triangles, 1, 4, t1);
+		LoadCorners(vertices, triangles, 2, 4, t2);
+
+		__m128 e1x = _mm_sub_ps(p1[0], p0[0]), e1y = _mm_sub_ps(p1[1], p0[1]), e1z = _mm_sub_ps(p1[2], p0[2]);
+		__m128 e2x = _mm_sub_ps(p2[0], p0[0]), e2y = _mm_sub_ps(p2[1], p0[1]), e2z = _mm_sub_ps(p2[2], p0[2]);
+		__m128 du1 = _mm_sub_ps(t1[2], t0[2]), dv1 = _mm_sub_ps(t1[3], t0[3]);
+		__m128 du2 = _mm_sub_ps(t2[2], t0[2]), dv2 = _mm_sub_ps(t2[3], t0[3]);
+
+		// 1 or -1 with the sign of the determinant, 0 when the coords have no area
+		__m128 determinant = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(du2, dv1));
+		__m128 sign = _mm_or_ps(_mm_set1_ps(1.0f), _mm_and_ps(determinant, _mm_set1_ps(-0.0f)));
+		sign = _mm_and_ps(sign, _mm_cmpneq_ps(determinant, _mm_setzero_ps()));
+		dv1 = _mm_mul_ps(dv1, sign);
+		dv2 = _mm_mul_ps(dv2, sign);
+		du1 = _mm_mul_ps(du1, sign);
+		du2 = _mm_mul_ps(du2, sign);
+
+		__m128 zero = _mm_setzero_ps();
+		StoreRows(_mm_sub_ps(_mm_mul_ps(e1x, dv2), _mm_mul_ps(e2x, dv1)),
+			_mm_sub_ps(_mm_mul_ps(e1y, dv2), _mm_mul_ps(e2y, dv1)),
+			_mm_sub_ps(_mm_mul_ps(e1z, dv2), _mm_mul_ps(e2z, dv1)), zero, tangents);
+		StoreRows(_mm_sub_ps(_mm_mul_ps(e2x, du1), _mm_mul_ps(e1x, du2)),
+			_mm_sub_ps(_mm_mul_ps(e2y, du1), _mm_mul_ps(e1y, du2)),
+			_mm_sub_ps(_mm_mul_ps(e2z, du1), _mm_mul_ps(e1z, du2)), zero, bitangents);
+	}
+#endif
+
+	void ComputeFaceNormals(const GLfloat* vertices,
+		const GLuint* indices,
+		GLuint triangleCount,
+		glm::vec4* faceNormals,
+		bool bVectorized,
+		unsigned threadCount)
+	{
+		GLuint groupCount = (triangleCount + g_TrianglesPerGroup - 1) / g_TrianglesPerGroup;
+		ParallelForRows(groupCount, triangleCount, threadCount, [&](GLuint firstGroup, GLuint endGroup)
+		{
+			GLuint triangle = firstGroup * g_TrianglesPerGroup;
+			GLuint end = std::min(endGroup * g_TrianglesPerGroup, triangleCount);
+#ifdef MESH_NORMALS_SSE2
+			for (; bVectorized && triangle + g_TrianglesPerGroup <= end; triangle += g_TrianglesPerGroup)
+			{
+				GetFaceNormals4(vertices, indices + static_cast<size_t>(triangle) * 3, faceNormals + triangle);
+			}
+#endif
+			(void)bVectorized;
+			for (; triangle < end; ++triangle)
+			{
+				faceNormals[triangle] = GetFaceNormal(vertices, indices + static_cast<size_t>(triangle) * 3);
+			}
+		});
+	}
+
+	void ComputeFaceTangents(const GLfloat* vertices,
+		const GLuint* indices,
+		GLuint triangleCount,
+		glm::vec4* tangents,
+		glm::vec4* bitangents,
+		bool bVectorized,
+		unsigned threadCount)
+	{
+		GLuint groupCount = (triangleCount + g_TrianglesPerGroup - 1) / g_TrianglesPerGroup;
+		ParallelForRows(groupCount, triangleCount, threadCount, [&](GLuint firstGroup, GLuint endGroup)
+		{
+			GLuint triangle = firstGroup * g_TrianglesPerGroup;
+			GLuint end = std::min(endGroup * g_TrianglesPerGroup, triangleCount);
+#ifdef MESH_NORMALS_SSE2
+			for (; bVectorized && triangle + g_TrianglesPerGroup <= end; triangle += g_TrianglesPerGroup)
+			{
+				GetFaceTangents4(vertices, indices + static_cast<size_t>(triangle) * 3, tangents + triangle, bitangents + triangle);
+			}
+#endif
+			(void)bVectorized;
+			for (; triangle < end; ++triangle)
+			{
+				GetFaceTangent(vertices, indices + static_cast<size_t>(triangle) * 3, tangents[triangle], bitangents[triangle]);
+			}
+		});
+	}
+
+	///////////////////////////////////////////////////
+	//	BuildCornerLists()
+	//
+	//	The corners of the index list sorted by the key of
+	//	their vertex, its group or the vertex itself, with a
+	//	counting sort so that each key can then gather its
+	//	faces on its own, in parallel and without locks.
+	///////////////////////////////////////////////////
+	void BuildCornerLists(const GLuint* indices,
+		size_t indexCount,
+		GLuint baseVertex,
+		const GLuint* groups,
+		GLuint keyCount,
+		std::vector<GLuint>& offsets,
+		std::vector<GLuint>& corners)
+	{
+		offsets.assign(static_cast<size_t>(keyCount) + 1, 0);
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			GLuint vertex = indices[i] - baseVertex;
+			offsets[(groups != nullptr ? groups[vertex] : vertex) + 1]++;
+		}
+		for (GLuint key = 0; key < keyCount; ++key)
+		{
+			offsets[key + 1] += offsets[key];
+		}
+
+		corners.resize(indexCount);
+		std::vector<GLuint> next(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			GLuint vertex = indices[i] - baseVertex;
+			corners[next[groups != nullptr ? groups[vertex] : vertex]++] = static_cast<GLuint>(i);
+		}
+	}
+
+	// sum of the face vectors of a run of corners
+	glm::vec3 SumFaces(const glm::vec4* faces, const GLuint* corner, const GLuint* end, bool bVectorized)
+	{
+#ifdef MESH_NORMALS_SSE2
+		if (bVectorized)
+		{
+			__m128 sum = _mm_setzero_ps();
+			for (; corner != end; ++corner)
+			{
+				sum = _mm_add_ps(sum, _mm_loadu_ps(&faces[*corner / 3].x));
+			}
+			float values[4];
+			_mm_storeu_ps(values, sum);
+			return glm::vec3(values[0], values[1], values[2]);
+		}
+#endif
+		(void)bVectorized;
+		glm::vec3 sum(0.0f);
+		for (; corner != end; ++corner)
+		{
+			sum += glm::vec3(faces[*corner / 3]);
+		}
+		return sum;
+	}
+
+	void WriteNormal(GLfloat* vertex, const glm::vec3& sum)
+	{
+		float length = glm::length(sum);
+		glm::vec3 normal = length > 0.0f ? sum / length : glm::vec3(0.0f, 1.0f, 0.0f);
+		vertex[3] = normal.x;
+		vertex[4] = normal.y;
+		vertex[5] = normal.z;
+	}
+
+	void GenerateVertexNormals(GLfloat* vertices,
+		GLuint baseVertex,
+		GLuint vertexCount,
+		const GLuint* indices,
+		size_t indexCount,
+		const NormalOptions& options,
+		bool bVectorized)
+	{
+		GLuint triangleCount = static_cast<GLuint>(indexCount / 3);
+		std::vector<glm::vec4> faces(triangleCount);
+		ComputeFaceNormals(vertices, indices, triangleCount, faces.data(), bVectorized, options.threadCount);
+
+		const GLuint* groups = options.positionGroups;
+		GLuint keyCount = groups != nullptr ? options.groupCount : vertexCount;
+		std::vector<GLuint> offsets;
+		std::vector<GLuint> corners;
+		BuildCornerLists(indices, triangleCount * 3, baseVertex, groups, keyCount, offsets, corners);
+
+		const bool bCrease = options.creaseAngle < 180.0f;
+		const float minCosine = std::cos(glm::radians(options.creaseAngle));
+		GLfloat* first = vertices + static_cast<size_t>(baseVertex) * MeshData::FloatsPerVertex;
+		ParallelForRows(vertexCount, triangleCount, options.threadCount, [&](GLuint firstVertex, GLuint endVertex)
+		{
+			for (GLuint v = firstVertex; v < endVertex; ++v)
+			{
+				GLfloat* vertex = first + static_cast<size_t>(v) * MeshData::FloatsPerVertex;
+				if (options.bOnlyMissing && (vertex[3] != 0.0f || vertex[4] != 0.0f || vertex[5] != 0.0f))
+				{
+					continue;
+				}
+
+				GLuint key = groups != nullptr ? groups[v] : v;
+				const GLuint* begin = corners.data() + offsets[key];
+				const GLuint* end = corners.data() + offsets[key + 1];
+				if (!bCrease)
+				{
+					WriteNormal(vertex, SumFaces(faces.data(), begin, end, bVectorized));
+					continue;
+				}
+
+				// the own triangles of the vertex give the direction the others are measured from
+				glm::vec3 own(0.0f);
+				for (const GLuint* corner = begin; corner != end; ++corner)
+				{
+					if (indices[*corner] - baseVertex == v)
+					{
+						own += glm::vec3(faces[*corner / 3]);
+					}
+				}
+				float ownLength = glm::length(own);
+				glm::vec3 direction = ownLength > 0.0f ? own / ownLength : own;
+
+				glm::vec3 sum(0.0f);
+				for (const GLuint* corner = begin; corner != end; ++corner)
+				{
+					const glm::vec4& face = faces[*corner / 3];
+					if (glm::dot(glm::vec3(face), direction) * face.w >= minCosine)
+					{
+						sum += glm::vec3(face);
+					}
+				}
+				WriteNormal(vertex, sum);
+			}
+		});
+	}
+
+	void GenerateTangents(const MeshData& meshData, std::vector<glm::vec4>& tangents, bool bVectorized, unsigned threadCount)
+	{
+		const GLfloat* vertices = meshData.vertices.data();
+		const GLuint* indices = meshData.indices.data();
+		const GLuint vertexCount = meshData.VertexCount();
+		const GLuint triangleCount = meshData.IndexCount() / 3;
+		std::vector<glm::vec4> faceTangents(triangleCount);
+		std::vector<glm::vec4> faceBitangents(triangleCount);
+		ComputeFaceTangents(vertices, indices, triangleCount, faceTangents.data(), faceBitangents.data(), bVectorized, threadCount);
+
+		std::vector<GLuint> offsets;
+		std::vector<GLuint> corners;
+		BuildCornerLists(indices, triangleCount * 3, 0, nullptr, vertexCount, offsets, corners);
+
+		tangents.resize(vertexCount);
+		ParallelForRows(vertexCount, triangleCount, threadCount, [&](GLuint firstVertex, GLuint endVertex)
+		{
+			for (GLuint v = firstVertex; v < endVertex; ++v)
+			{
+				const GLuint* begin = corners.data() + offsets[v];
+				const GLuint* end = corners.data() + offsets[v + 1];
+				glm::vec3 tangent = SumFaces(faceTangents.data(), begin, end, bVectorized);
+				glm::vec3 bitangent = SumFaces(faceBitangents.data(), begin, end, bVectorized);
+
+				// Gram-Schmidt against the normal, any perpendicular when the coords give none
+				const GLfloat* vertex = GetVertex(vertices, v);
+				glm::vec3 normal(vertex[3], vertex[4], vertex[5]);
+				tangent -= normal * glm::dot(normal, tangent);
+				float length = glm::length(tangent);
+				if (length <= 1e-12f)
+				{
+					glm::vec3 axis = std::abs(normal.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+					tangent = glm::cross(axis, normal);
+					length = glm::length(tangent);
+				}
+				tangent = length > 0.0f ? tangent / length : glm::vec3(1.0f, 0.0f, 0.0f);
+				float handedness = glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+				tangents[v] = glm::vec4(tangent, handedness);
+			}
+		});
+	}
+
+	// millions of triangles per second of the fastest of a few runs
+	template <typename Kernel>
+	double TimeKernel(GLuint triangleCount, Kernel kernel)
+	{
+		double best = 0.0;
+		for (int run = 0; run < g_BenchmarkRuns; ++run)
+		{
+			auto start = std::chrono::steady_clock::now();
+			kernel();
+			std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+			if (elapsed.count() > 0.0)
+			{
+				best = std::max(best, triangleCount / elapsed.count() / 1e6);
+			}
+		}
+		return best;
+	}
+
+	template <typename Kernel>
+	void BenchmarkKernel(const char* kernelName, GLuint triangleCount, Kernel kernel)
+	{
+		unsigned hardwareThreads = GetHardwareThreads();
+		std::cout << "INFO:   " << kernelName << ": "
+			<< TimeKernel(triangleCount, [&]() { kernel(false, 1u); }) << " scalar, "
+#ifdef MESH_NORMALS_SSE2
+			<< TimeKernel(triangleCount, [&]() { kernel(true, 1u); }) << " SSE2, "
+#endif
+			<< TimeKernel(triangleCount, [&]() { kernel(true, hardwareThreads); }) << " on "
+			<< hardwareThreads << " threads, million triangles per second" << std::endl;
+	}
+}
+
+///////////////////////////////////////////////////
+//	ComputeFaceNormals()
+///////////////////////////////////////////////////
+void ComputeFaceNormals(const MeshData& meshData, std::vector<glm::vec4>& faceNormals, unsigned threadCount)
+{
+	faceNormals.resize(meshData.IndexCount() / 3);
+	ComputeFaceNormals(meshData.vertices.data(), meshData.indices.data(), meshData.IndexCount() / 3,
+		faceNormals.data(), true, threadCount);
+}
+
+///////////////////////////////////////////////////
+//	GenerateVertexNormals()
+///////////////////////////////////////////////////
+void GenerateVertexNormals(GLfloat* vertices,
+	GLuint baseVertex,
+	GLuint vertexCount,
+	const GLuint* indices,
+	size_t indexCount,
+	const NormalOptions& options)
+{
+	GenerateVertexNormals(vertices, baseVertex, vertexCount, indices, indexCount, options, true);
+}
+
+void GenerateVertexNormals(MeshData& meshData, const NormalOptions& options)
+{
+	GenerateVertexNormals(meshData.vertices.data(), 0, meshData.VertexCount(),
+		meshData.indices.data(), meshData.indices.size(), options, true);
+}
+
+///////////////////////////////////////////////////
+//	GenerateTangents()
+///////////////////////////////////////////////////
+void GenerateTangents(const MeshData& meshData, std::vector<glm::vec4>& tangents, unsigned threadCount)
+{
+	GenerateTangents(meshData, tangents, true, threadCount);
+}
+
+///////////////////////////////////////////////////
+//	RunMeshNormalsBenchmark()
+///////////////////////////////////////////////////
+void RunMeshNormalsBenchmark()
+{
+	MeshData meshData;
+	GenerateParametricSurface(SphereSurface{ 1.0f }, SphereSurface::Grid(g_BenchmarkRows, g_BenchmarkColumns), meshData);
+	const GLuint triangleCount = meshData.IndexCount() / 3;
+	std::cout << "INFO: normals of a sphere: " << meshData.VertexCount() << " vertices, "
+		<< triangleCount << " triangles" << std::endl;
+
+	std::vector<glm::vec4> output(triangleCount);
+	BenchmarkKernel("face normals", triangleCount, [&](bool bVectorized, unsigned threads)
+	{
+		ComputeFaceNormals(meshData.vertices.data(), meshData.indices.data(), triangleCount, output.data(), bVectorized, threads);
+	});
+
+	NormalOptions options = NormalOptions::Smooth();
+	BenchmarkKernel("smooth vertex normals", triangleCount, [&](bool bVectorized, unsigned threads)
+	{
+		options.threadCount = threads;
+		GenerateVertexNormals(meshData.vertices.data(), 0, meshData.VertexCount(),
+			meshData.indices.data(), meshData.indices.size(), options, bVectorized);
+	});
+
+	options.creaseAngle = g_BenchmarkCreaseAngle;
+	BenchmarkKernel("creased vertex normals", triangleCount, [&](bool bVectorized, unsigned threads)
+	{
+		options.threadCount = threads;
+		GenerateVertexNormals(meshData.vertices.data(), 0, meshData.VertexCount(),
+			meshData.indices.data(), meshData.indices.size(), options, bVectorized);
+	});
+
+	BenchmarkKernel("tangents", triangleCount, [&](bool bVectorized, unsigned threads)
+	{
+		GenerateTangents(meshData, output, bVectorized, threads);
+	});
+}
@@ -0,0 +1,77 @@
+#ifndef MESH_NORMALS_H
+#define MESH_NORMALS_H
+#pragma once
+
+#include <GL/glew.h>
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "MeshData.h"
+
+// How GenerateVertexNormals() smooths the face normals
+struct NormalOptions
+{
+	float creaseAngle;				// Degrees; faces further from the own faces of a vertex are left out, 180 keeps all
+	const GLuint* positionGroups;	// Group of each vertex, the vertices of a group share their faces; null for none
+	GLuint groupCount;				// Groups that positionGroups numbers
+	bool bOnlyMissing;				// Vertices whose normal is not zero are kept
+	unsigned threadCount;			// 0 uses every hardware thread
+
+	// every face around a vertex, as the importers have always done
+	static NormalOptions Smooth(unsigned threadCount = 0)
+	{
+		return { 180.0f, nullptr, 0, false, threadCount };
+	}
+};
+
+///////////////////////////////////////////////////
+//	ComputeFaceNormals()
+//
+//	The normal of every triangle of a list, four triangles
+//	at a time with SSE2 where it is available. The xyz of
+//	each is the cross product of its edges, twice its area
+//	long, and w is the inverse of that length, zero for
+//	triangles without an area.
+///////////////////////////////////////////////////
+void ComputeFaceNormals(const MeshData& meshData, std::vector<glm::vec4>& faceNormals, unsigned threadCount = 0);
+
+///////////////////////////////////////////////////
+//	GenerateVertexNormals()
+//
+//	Writes the normal of each vertex in [baseVertex,
+//	baseVertex + vertexCount) from the area-weighted face
+//	normals of the triangles around it; the indices of the
+//	list are those of the whole mesh. The vertices of a
+//	position group, such as the split corners of an
+//	imported face list, sum the faces of the whole group.
+//	With a crease angle below 180 a vertex only takes the
+//	faces within that angle of the average normal of its
+//	own triangles, so hard edges stay hard. Vertices that
+//	no triangle uses get +y.
+///////////////////////////////////////////////////
+void GenerateVertexNormals(GLfloat* vertices,
+	GLuint baseVertex,
+	GLuint vertexCount,
+	const GLuint* indices,
+	size_t indexCount,
+	const NormalOptions& options);
+void GenerateVertexNormals(MeshData& meshData, const NormalOptions& options);
+
+///////////////////////////////////////////////////
+//	GenerateTangents()
+//
+//	The tangent of each vertex for normal mapping, along
+//	+u of the texture coords: the per-triangle tangents
+//	and bitangents are summed around the vertex, the
+//	tangent is made perpendicular to the vertex normal and
+//	w is the handedness of the bitangent, 1 or -1.
+///////////////////////////////////////////////////
+void GenerateTangents(const MeshData& meshData, std::vector<glm::vec4>& tangents, unsigned threadCount = 0);
+
+// Times the face normals, the smooth and creased vertex normals and
+// the tangents of a large sphere, scalar and SSE2 on one thread and
+// SSE2 on every thread, and prints the triangles per second
+void RunMeshNormalsBenchmark();
+
+#endif // MESH_NORMALS_H
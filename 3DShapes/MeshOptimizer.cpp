@@ -0,0 +1,387 @@
+#include "MeshOptimizer.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <iostream>
+
+namespace
+{
+	const GLuint g_VertexCacheSize = 16;		// Entries of the simulated FIFO post-transform cache
+	const float g_OverdrawThreshold = 1.05f;	// Overdraw clusters may raise the ACMR by this factor
+
+	// FIFO cache simulation, a vertex is cached while fewer than
+	// g_VertexCacheSize vertices were transformed after it
+	class CacheSimulator
+	{
+	public:
+		explicit CacheSimulator(GLuint vertexCount) :
+			m_timestamps(vertexCount, 0), m_time(g_VertexCacheSize + 1) {}
+
+		// true when the vertex had to be transformed
+		bool Access(GLuint vertex)
+		{
+			if (m_time - m_timestamps[vertex] > g_VertexCacheSize)
+			{
+				m_timestamps[vertex] = m_time++;
+				return true;
+			}
+			return false;
+		}
+
+		// empties the cache without touching the timestamps
+		void Flush() { m_time += g_VertexCacheSize + 1; }
+
+	private:
+		std::vector<GLuint> m_timestamps;	// Insertion time of each vertex
+		GLuint m_time;						// Insertion time of the next transformed vertex
+	};
+
+	GLuint CountCacheMisses(const std::vector<GLuint>& indices, GLuint vertexCount)
+	{
+		CacheSimulator cache(vertexCount);
+		GLuint misses = 0;
+		for (GLuint index : indices)
+		{
+			misses += cache.Access(index) ? 1 : 0;
+		}
+		return misses;
+	}
+
+	GLuint GetVertexCount(const std::vector<GLfloat>& vertices)
+	{
+		return static_cast<GLuint>(vertices.size() / MeshData::FloatsPerVertex);
+	}
+
+	glm::vec3 GetPosition(const std::vector<GLfloat>& vertices, GLuint vertex)
+	{
+		const GLfloat* v = &vertices[vertex * MeshData::FloatsPerVertex];
+		return glm::vec3(v[0], v[1], v[2]);
+	}
+
+	// ACMR and ATVR of an index buffer
+	void MeasureCache(const std::vector<GLuint>& indices, GLuint vertexCount, float& acmr, float& atvr)
+	{
+		std::vector<bool> bUsed(vertexCount, false);
+		GLuint usedCount = 0;
+		for (GLuint index : indices)
+		{
+			if (!bUsed[index])
+			{
+				bUsed[index] = true;
+				usedCount++;
+			}
+		}
+
+		GLuint misses = CountCacheMisses(indices, vertexCount);
+		GLuint triangleCount = static_cast<GLuint>(indices.size() / 3);
+		acmr = triangleCount > 0 ? static_cast<float>(misses) / triangleCount : 0.0f;
+		atvr = usedCount > 0 ? static_cast<float>(misses) / usedCount : 0.0f;
+	}
+
+	// cluster of consecutive triangles and its overdraw sort key
+	struct Cluster
+	{
+		GLuint firstTriangle;
+		GLuint triangleCount;
+		float sortKey;
+	};
+}
+
+///////////////////////////////////////////////////
+//	OptimizeVertexCache()
+//
+//	Tipsify (Sander, Nehab and Barczak, 2007) fans around one
+//	vertex at a time, emitting all of its remaining triangles.
+//	The next fanning vertex is the neighbor that stays cached
+//	longest while its triangles are emitted; at a dead end the
+//	last emitted vertices and then the input order are tried.
+///////////////////////////////////////////////////
+void OptimizeVertexCache(std::vector<GLuint>& indices, GLuint vertexCount, const IndexRange& range)
+{
+	const GLuint triangleCount = range.indexCount / 3;
+	if (triangleCount < 2)
+	{
+		return;
+	}
+	const GLuint* input = &indices[range.firstIndex];
+
+	// live triangles of each vertex and the triangles around it
+	std::vector<GLuint> liveCount(vertexCount, 0);
+	for (GLuint i = 0; i < triangleCount * 3; ++i)
+	{
+		liveCount[input[i]]++;
+	}
+	std::vector<GLuint> adjacencyOffset(vertexCount + 1, 0);
+	for (GLuint v = 0; v < vertexCount; ++v)
+	{
+		adjacencyOffset[v + 1] = adjacencyOffset[v] + liveCount[v];
+	}
+	std::vector<GLuint> adjacency(triangleCount * 3);
+	std::vector<GLuint> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+	for (GLuint t = 0; t < triangleCount; ++t)
+	{
+		for (GLuint k = 0; k < 3; ++k)
+		{
+			adjacency[fill[input[t * 3 + k]]++] = t;
+		}
+	}
+
+	std::vector<GLuint> output;
+	output.reserve(triangleCount * 3);
+	std::vector<GLuint> timestamps(vertexCount, 0);
+	std::vector<bool> bEmitted(triangleCount, false);
+	std::vector<GLuint> deadEnd;		// Emitted vertices, most recent last
+	std::vector<GLuint> candidates;		// Vertices of the triangles of the current fan
+	GLuint time = g_VertexCacheSize + 1;
+	GLuint cursor = 0;
+
+	int fanning = static_cast<int>(input[0]);
+	while (fanning >= 0)
+	{
+		candidates.clear();
+		for (GLuint a = adjacencyOffset[fanning]; a < adjacencyOffset[fanning + 1]; ++a)
+		{
+			GLuint t = adjacency[a];
+			if (bEmitted[t])
+			{
+				continue;
+			}
+			for (GLuint k = 0; k < 3; ++k)
+			{
+				GLuint v = input[t * 3 + k];
+				output.push_back(v);
+				deadEnd.push_back(v);
+				candidates.push_back(v);
+				liveCount[v]--;
+				if (time - timestamps[v] > g_VertexCacheSize)
+				{
+					timestamps[v] = time++;
+				}
+			}
+			bEmitted[t] = true;
+		}
+
+		// the neighbor still in the cache after its own triangles, oldest first
+		fanning = -1;
+		int bestPriority = -1;
+		for (GLuint v : candidates)
+		{
+			if (liveCount[v] == 0)
+			{
+				continue;
+			}
+			int priority = 0;
+			if (time - timestamps[v] + 2 * liveCount[v] <= g_VertexCacheSize)
+			{
+				priority = static_cast<int>(time - timestamps[v]);
+			}
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				fanning = static_cast<int>(v);
+			}
+		}
+
+		// dead end, go back to a recent vertex or on in the input
+		while (fanning < 0 && !deadEnd.empty())
+		{
+			GLuint v = deadEnd.back();
+			deadEnd.pop_back();
+			if (liveCount[v] > 0)
+			{
+				fanning = static_cast<int>(v);
+			}
+		}
+		while (fanning < 0 && cursor < triangleCount * 3)
+		{
+			GLuint v = input[cursor++];
+			if (liveCount[v] > 0)
+			{
+				fanning = static_cast<int>(v);
+			}
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices.begin() + range.firstIndex);
+}
+
+///////////////////////////////////////////////////
+//	OptimizeOverdraw()
+//
+//	Follows the second half of Tipsify. A cluster starts where
+//	a triangle misses the cache with all three vertices, and
+//	long clusters are split again once their running ACMR is
+//	within g_OverdrawThreshold of the whole cluster, so that
+//	sorting them costs little cache efficiency. The clusters
+//	are sorted by how far their center lies out from the mesh
+//	center along their normal.
+///////////////////////////////////////////////////
+void OptimizeOverdraw(const std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, const IndexRange& range)
+{
+	const GLuint triangleCount = range.indexCount / 3;
+	if (triangleCount < 2)
+	{
+		return;
+	}
+	const GLuint vertexCount = GetVertexCount(vertices);
+	GLuint* input = &indices[range.firstIndex];
+
+	// hard boundaries where the order restarts
+	std::vector<GLuint> hardStarts;
+	CacheSimulator cache(vertexCount);
+	for (GLuint t = 0; t < triangleCount; ++t)
+	{
+		GLuint misses = 0;
+		for (GLuint k = 0; k < 3; ++k)
+		{
+			misses += cache.Access(input[t * 3 + k]) ? 1 : 0;
+		}
+		if (t == 0 || misses == 3)
+		{
+			hardStarts.push_back(t);
+		}
+	}
+	hardStarts.push_back(triangleCount);
+
+	// soft boundaries inside the hard clusters
+	std::vector<Cluster> clusters;
+	for (size_t h = 0; h + 1 < hardStarts.size(); ++h)
+	{
+		GLuint start = hardStarts[h];
+		GLuint end = hardStarts[h + 1];
+
+		cache.Flush();
+		GLuint clusterMisses = 0;
+		for (GLuint i = start * 3; i < end * 3; ++i)
+		{
+			clusterMisses += cache.Access(input[i]) ? 1 : 0;
+		}
+		float clusterACMR = static_cast<float>(clusterMisses) / (end - start);
+
+		cache.Flush();
+		GLuint clusterStart = start;
+		GLuint misses = 0;
+		for (GLuint t = start; t < end; ++t)
+		{
+			for (GLuint k = 0; k < 3; ++k)
+			{
+				misses += cache.Access(input[t * 3 + k]) ? 1 : 0;
+			}
+			float acmr = static_cast<float>(misses) / (t - clusterStart + 1);
+			if (t + 1 == end || acmr <= clusterACMR * g_OverdrawThreshold)
+			{
+				clusters.push_back({ clusterStart, t + 1 - clusterStart, 0.0f });
+				clusterStart = t + 1;
+				misses = 0;
+				cache.Flush();
+			}
+		}
+	}
+
+	// area weighted center and normal of each cluster and of the range
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+	std::vector<glm::vec3> centers(clusters.size());
+	std::vector<glm::vec3> normals(clusters.size());
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		glm::vec3 center(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+		for (GLuint t = clusters[c].firstTriangle; t < clusters[c].firstTriangle + clusters[c].triangleCount; ++t)
+		{
+			glm::vec3 p0 = GetPosition(vertices, input[t * 3]);
+			glm::vec3 p1 = GetPosition(vertices, input[t * 3 + 1]);
+			glm::vec3 p2 = GetPosition(vertices, input[t * 3 + 2]);
+			glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+			float faceArea = glm::length(faceNormal);
+
+			center += (p0 + p1 + p2) * (faceArea / 3.0f);
+			normal += faceNormal;
+			area += faceArea;
+		}
+		meshCenter += center;
+		meshArea += area;
+		centers[c] = area > 0.0f ? center / area : center;
+		normals[c] = glm::dot(normal, normal) > 0.0f ? glm::normalize(normal) : normal;
+	}
+	if (meshArea > 0.0f)
+	{
+		meshCenter /= meshArea;
+	}
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		clusters[c].sortKey = glm::dot(centers[c] - meshCenter, normals[c]);
+	}
+
+	std::stable_sort(clusters.begin(), clusters.end(),
+		[](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<GLuint> output;
+	output.reserve(triangleCount * 3);
+	for (const Cluster& cluster : clusters)
+	{
+		output.insert(output.end(), input + cluster.firstTriangle * 3,
+			input + (cluster.firstTriangle + cluster.triangleCount) * 3);
+	}
+	std::copy(output.begin(), output.end(), input);
+}
+
+///////////////////////////////////////////////////
+//	OptimizeVertexFetch()
+///////////////////////////////////////////////////
+void OptimizeVertexFetch(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices)
+{
+	const GLuint vertexCount = GetVertexCount(vertices);
+	std::vector<GLuint> remap(vertexCount, vertexCount);
+	std::vector<GLfloat> ordered;
+	ordered.reserve(vertices.size());
+
+	for (GLuint& index : indices)
+	{
+		if (remap[index] == vertexCount)
+		{
+			remap[index] = GetVertexCount(ordered);
+			const GLfloat* vertex = &vertices[index * MeshData::FloatsPerVertex];
+			ordered.insert(ordered.end(), vertex, vertex + MeshData::FloatsPerVertex);
+		}
+		index = remap[index];
+	}
+	vertices.swap(ordered);
+}
+
+///////////////////////////////////////////////////
+//	OptimizeMesh()
+///////////////////////////////////////////////////
+VertexCacheReport OptimizeMesh(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, const std::vector<IndexRange>& ranges)
+{
+	VertexCacheReport report = {};
+	report.triangleCount = static_cast<GLuint>(indices.size() / 3);
+	MeasureCache(indices, GetVertexCount(vertices), report.acmrBefore, report.atvrBefore);
+
+	for (const IndexRange& range : ranges)
+	{
+		OptimizeVertexCache(indices, GetVertexCount(vertices), range);
+		OptimizeOverdraw(vertices, indices, range);
+	}
+	OptimizeVertexFetch(vertices, indices);
+
+	MeasureCache(indices, GetVertexCount(vertices), report.acmrAfter, report.atvrAfter);
+	return report;
+}
+
+VertexCacheReport OptimizeMesh(MeshData& meshData)
+{
+	std::vector<IndexRange> ranges = { { 0, meshData.IndexCount() } };
+	return OptimizeMesh(meshData.vertices, meshData.indices, ranges);
+}
+
+///////////////////////////////////////////////////
+//	PrintVertexCacheReport()
+///////////////////////////////////////////////////
+void PrintVertexCacheReport(const char* meshName, const VertexCacheReport& report)
+{
+	std::cout << "INFO: vertex cache " << meshName << ": " << report.triangleCount << " triangles, "
+		<< "ACMR " << report.acmrBefore << " -> " << report.acmrAfter
+		<< ", ATVR " << report.atvrBefore << " -> " << report.atvrAfter << std::endl;
+}
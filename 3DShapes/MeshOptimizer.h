@@ -0,0 +1,47 @@
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+
+#include "MeshData.h"
+
+// Vertex cache efficiency of an index buffer before and after optimizing it,
+// measured on a simulated FIFO post-transform cache
+struct VertexCacheReport
+{
+	GLuint triangleCount;	// Triangles of the index buffer
+	float acmrBefore;		// Average cache miss ratio, transformed vertices per triangle
+	float acmrAfter;
+	float atvrBefore;		// Average transformed to vertex ratio, 1 is the best possible
+	float atvrAfter;
+};
+
+// Reorders the triangles of a range with Tipsify so that
+// consecutive triangles share the vertices still in the cache
+void OptimizeVertexCache(std::vector<GLuint>& indices, GLuint vertexCount, const IndexRange& range);
+
+// Splits a cache optimized range into clusters and sorts them
+// so that the ones facing away from the mesh center come first,
+// which lets the depth test reject more of the later fragments
+void OptimizeOverdraw(const std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, const IndexRange& range);
+
+// Reorders the vertices in the order the indices first use them
+void OptimizeVertexFetch(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices);
+
+///////////////////////////////////////////////////
+//	OptimizeMesh()
+//
+//	Runs the three passes on an indexed triangle mesh in the
+//	interleaved layout of MeshData. Triangles never move
+//	between ranges and keep their winding, so the parts of
+//	a mesh can still be drawn on their own.
+///////////////////////////////////////////////////
+VertexCacheReport OptimizeMesh(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, const std::vector<IndexRange>& ranges);
+VertexCacheReport OptimizeMesh(MeshData& meshData);
+
+// Writes a one line summary of the report
+void PrintVertexCacheReport(const char* meshName, const VertexCacheReport& report);
+
+#endif // MESH_OPTIMIZER_H
@@ -0,0 +1,847 @@
+#include "MeshSimplifier.h"
+
+#include "MeshOptimizer.h"
+#include "MeshWelding.h"
+#include "ParametricSurface.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <thread>
+#include <unordered_map>
+
+namespace
+{
+	const double g_BoundaryWeight = 10.0;		// Weight of the planes that hold borders and seams in place
+	const double g_MinFlipCosine = 0.2;			// Triangles whose normal turns further count as flipped
+	const GLuint g_NoCollapse = 0xFFFFFFFF;		// Position without an allowed collapse
+	const GLuint g_BenchmarkColumns = 1024;		// Quads along u of the benchmark meshes
+	const GLuint g_BenchmarkRows = 512;			// Quads along v of the benchmark meshes
+	const float g_BenchmarkRatios[] = { 0.25f, 0.05f, 0.01f };	// Fractions of the triangles kept by the benchmark levels
+
+	unsigned GetHardwareThreads()
+	{
+		unsigned threads = std::thread::hardware_concurrency();
+		return threads > 0 ? threads : 1;
+	}
+
+	// how a position may move, from the edges around it
+	enum class VertexKind : unsigned char
+	{
+		Manifold,	// Inside a smooth part of the surface, moves onto any neighbor
+		Border,		// On an open edge, moves along it
+		Seam,		// On an attribute seam, moves along it
+		Locked		// Corner, junction or non-manifold vertex, never moves
+	};
+
+	// sum of squared distances to a set of weighted planes as the
+	// quadratic form p'Ap + 2b'p + c, with the triangle area it covers
+	struct Quadric
+	{
+		double a00, a01, a02, a11, a12, a22;
+		double b0, b1, b2;
+		double c;
+		double area;
+	};
+
+	// plane dot(normal, p) + distance = 0 with a unit normal
+	void AddPlane(Quadric& q, const glm::dvec3& normal, double distance, double weight)
+	{
+		q.a00 += weight * normal.x * normal.x;
+		q.a01 += weight * normal.x * normal.y;
+		q.a02 += weight * normal.x * normal.z;
+		q.a11 += weight * normal.y * normal.y;
+		q.a12 += weight * normal.y * normal.z;
+		q.a22 += weight * normal.z * normal.z;
+		q.b0 += weight * normal.x * distance;
+		q.b1 += weight * normal.y * distance;
+		q.b2 += weight * normal.z * distance;
+		q.c += weight * distance * distance;
+	}
+
+	void AddQuadric(Quadric& q, const Quadric& other)
+	{
+		q.a00 += other.a00;
+		q.a01 += other.a01;
+		q.a02 += other.a02;
+		q.a11 += other.a11;
+		q.a12 += other.a12;
+		q.a22 += other.a22;
+		q.b0 += other.b0;
+		q.b1 += other.b1;
+		q.b2 += other.b2;
+		q.c += other.c;
+		q.area += other.area;
+	}
+
+	double EvaluateQuadric(const Quadric& q, const glm::dvec3& p)
+	{
+		return q.a00 * p.x * p.x + q.a11 * p.y * p.y + q.a22 * p.z * p.z +
+			2.0 * (q.a01 * p.x * p.y + q.a02 * p.x * p.z + q.a12 * p.y * p.z) +
+			2.0 * (q.b0 * p.x + q.b1 * p.y + q.b2 * p.z) + q.c;
+	}
+
+	// squared distance, averaged over the area, of moving the first
+	// position onto the second with the planes of both
+	double CollapseError(const Quadric& from, const Quadric& to, const glm::dvec3& p)
+	{
+		double area = from.area + to.area;
+		double error = EvaluateQuadric(from, p) + EvaluateQuadric(to, p);
+		return area > 0.0 ? std::max(error, 0.0) / area : std::max(error, 0.0);
+	}
+
+	// one triangle edge of a position, as seen from one triangle around it
+	struct EdgeRecord
+	{
+		GLuint neighbor;		// Position at the other end
+		GLuint wedge;			// Vertex of the triangle at this end
+		GLuint neighborWedge;	// Vertex of the triangle at the other end
+	};
+
+	// an edge of a position with the triangles that share it
+	struct EdgeInfo
+	{
+		GLuint neighbor;		// Position at the other end
+		GLuint triangleCount;	// Triangles sharing the edge
+		bool bSeam;				// The triangles use different vertices at either end
+	};
+
+	// one move of a position onto a neighbor
+	struct CollapseCandidate
+	{
+		GLuint target;		// Position moved onto
+		double error;		// Squared error of the move
+		bool bBorder;		// The move runs along a border
+	};
+
+	// working copy of the mesh; the vertices of MeshData are kept as
+	// wedges, grouped by their position so that the collapses move all
+	// the wedges of a position at once
+	struct SimplifyState
+	{
+		std::vector<glm::dvec3> positions;		// Unique positions
+		std::vector<GLuint> wedgePositions;		// Position of each vertex
+		std::vector<GLuint> wedgeOffsets;		// Wedges of position p are positionWedges[wedgeOffsets[p], wedgeOffsets[p + 1])
+		std::vector<GLuint> positionWedges;
+		std::vector<Quadric> quadrics;			// Error quadric of each position
+		std::vector<GLuint> indices;			// Current triangle list over the wedges
+		std::vector<GLuint> triangleOffsets;	// Triangles around position p are positionTriangles[triangleOffsets[p], triangleOffsets[p + 1])
+		std::vector<GLuint> positionTriangles;
+
+		GLuint PositionCount() const { return static_cast<GLuint>(positions.size()); }
+		GLuint TriangleCount() const { return static_cast<GLuint>(indices.size() / 3); }
+		GLuint Position(GLuint triangle, GLuint corner) const { return wedgePositions[indices[triangle * 3 + corner]]; }
+	};
+
+	// bit pattern of a position, with -0 and 0 made equal
+	struct PositionKey
+	{
+		std::array<std::uint32_t, 3> bits;
+
+		explicit PositionKey(const GLfloat* position)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				GLfloat value = position[i] + 0.0f;
+				std::memcpy(&bits[i], &value, sizeof(GLfloat));
+			}
+		}
+
+		bool operator==(const PositionKey& other) const { return bits == other.bits; }
+	};
+
+	struct PositionKeyHash
+	{
+		size_t operator()(const PositionKey& key) const
+		{
+			// FNV-1a over the three values
+			std::uint32_t hash = 2166136261u;
+			for (std::uint32_t value : key.bits)
+			{
+				hash = (hash ^ value) * 16777619u;
+			}
+			return hash;
+		}
+	};
+
+	// merges the vertices that share a position and drops the
+	// triangles that have two corners at one position
+	void InitializeState(const MeshData& source, SimplifyState& state)
+	{
+		const GLuint wedgeCount = source.VertexCount();
+		std::unordered_map<PositionKey, GLuint, PositionKeyHash> positionIDs;
+		positionIDs.reserve(wedgeCount);
+
+		state.wedgePositions.resize(wedgeCount);
+		for (GLuint wedge = 0; wedge < wedgeCount; ++wedge)
+		{
+			const GLfloat* vertex = &source.vertices[static_cast<size_t>(wedge) * MeshData::FloatsPerVertex];
+			auto inserted = positionIDs.emplace(PositionKey(vertex), state.PositionCount());
+			if (inserted.second)
+			{
+				state.positions.push_back(glm::dvec3(vertex[0], vertex[1], vertex[2]));
+			}
+			state.wedgePositions[wedge] = inserted.first->second;
+		}
+
+		const GLuint positionCount = state.PositionCount();
+		state.wedgeOffsets.assign(positionCount + 1, 0);
+		for (GLuint position : state.wedgePositions)
+		{
+			state.wedgeOffsets[position + 1]++;
+		}
+		std::partial_sum(state.wedgeOffsets.begin(), state.wedgeOffsets.end(), state.wedgeOffsets.begin());
+		std::vector<GLuint> cursor(state.wedgeOffsets.begin(), state.wedgeOffsets.end() - 1);
+		state.positionWedges.resize(wedgeCount);
+		for (GLuint wedge = 0; wedge < wedgeCount; ++wedge)
+		{
+			state.positionWedges[cursor[state.wedgePositions[wedge]]++] = wedge;
+		}
+
+		state.indices.clear();
+		state.indices.reserve(source.indices.size());
+		for (size_t i = 0; i + 2 < source.indices.size(); i += 3)
+		{
+			GLuint p0 = state.wedgePositions[source.indices[i]];
+			GLuint p1 = state.wedgePositions[source.indices[i + 1]];
+			GLuint p2 = state.wedgePositions[source.indices[i + 2]];
+			if (p0 != p1 && p1 != p2 && p0 != p2)
+			{
+				state.indices.insert(state.indices.end(), source.indices.begin() + i, source.indices.begin() + i + 3);
+			}
+		}
+	}
+
+	// lists the triangles around every position
+	void BuildAdjacency(SimplifyState& state)
+	{
+		const GLuint positionCount = state.PositionCount();
+		state.triangleOffsets.assign(positionCount + 1, 0);
+		for (GLuint index : state.indices)
+		{
+			state.triangleOffsets[state.wedgePositions[index] + 1]++;
+		}
+		std::partial_sum(state.triangleOffsets.begin(), state.triangleOffsets.end(), state.triangleOffsets.begin());
+
+		std::vector<GLuint> cursor(state.triangleOffsets.begin(), state.triangleOffsets.end() - 1);
+		state.positionTriangles.resize(state.indices.size());
+		for (GLuint i = 0; i < state.indices.size(); ++i)
+		{
+			state.positionTriangles[cursor[state.wedgePositions[state.indices[i]]]++] = i / 3;
+		}
+	}
+
+	glm::dvec3 GetTriangleNormal(const SimplifyState& state, GLuint triangle)
+	{
+		const glm::dvec3& p0 = state.positions[state.Position(triangle, 0)];
+		return glm::cross(state.positions[state.Position(triangle, 1)] - p0, state.positions[state.Position(triangle, 2)] - p0);
+	}
+
+	// the edges of a position with the number of triangles on each
+	// and whether the triangles disagree about the vertices at its ends
+	void GatherEdges(const SimplifyState& state, GLuint position, std::vector<EdgeRecord>& records, std::vector<EdgeInfo>& edges)
+	{
+		records.clear();
+		for (GLuint k = state.triangleOffsets[position]; k < state.triangleOffsets[position + 1]; ++k)
+		{
+			const GLuint* triangle = &state.indices[state.positionTriangles[k] * 3];
+			for (GLuint corner = 0; corner < 3; ++corner)
+			{
+				if (state.wedgePositions[triangle[corner]] == position)
+				{
+					GLuint next = triangle[(corner + 1) % 3];
+					GLuint previous = triangle[(corner + 2) % 3];
+					records.push_back({ state.wedgePositions[next], triangle[corner], next });
+					records.push_back({ state.wedgePositions[previous], triangle[corner], previous });
+					break;
+				}
+			}
+		}
+		std::sort(records.begin(), records.end(), [](const EdgeRecord& a, const EdgeRecord& b)
+		{
+			return a.neighbor < b.neighbor;
+		});
+
+		edges.clear();
+		for (size_t i = 0; i < records.size(); )
+		{
+			EdgeInfo edge = { records[i].neighbor, 0, false };
+			size_t first = i;
+			for (; i < records.size() && records[i].neighbor == edge.neighbor; ++i)
+			{
+				edge.triangleCount++;
+				edge.bSeam |= records[i].wedge != records[first].wedge || records[i].neighborWedge != records[first].neighborWedge;
+			}
+			edges.push_back(edge);
+		}
+	}
+
+	VertexKind ClassifyVertex(const std::vector<EdgeInfo>& edges)
+	{
+		GLuint borderCount = 0;
+		GLuint seamCount = 0;
+		for (const EdgeInfo& edge : edges)
+		{
+			if (edge.triangleCount > 2)
+			{
+				return VertexKind::Locked;
+			}
+			if (edge.triangleCount == 1)
+			{
+				borderCount++;
+			}
+			else if (edge.bSeam)
+			{
+				seamCount++;
+			}
+		}
+
+		if (borderCount == 0 && seamCount == 0)
+		{
+			return VertexKind::Manifold;
+		}
+		if (borderCount == 2 && seamCount == 0)
+		{
+			return VertexKind::Border;
+		}
+		if (seamCount == 2 && borderCount == 0)
+		{
+			return VertexKind::Seam;
+		}
+		return VertexKind::Locked;
+	}
+
+	// area-weighted planes of the triangles, and planes through the
+	// border and seam edges at right angles to the surface
+	void BuildQuadrics(SimplifyState& state)
+	{
+		state.quadrics.assign(state.PositionCount(), Quadric{});
+		for (GLuint triangle = 0; triangle < state.TriangleCount(); ++triangle)
+		{
+			glm::dvec3 normal = GetTriangleNormal(state, triangle);
+			double length = glm::length(normal);
+			if (length == 0.0)
+			{
+				continue;
+			}
+			normal /= length;
+			double distance = -glm::dot(normal, state.positions[state.Position(triangle, 0)]);
+			for (GLuint corner = 0; corner < 3; ++corner)
+			{
+				Quadric& q = state.quadrics[state.Position(triangle, corner)];
+				AddPlane(q, normal, distance, 0.5 * length);
+				q.area += 0.5 * length;
+			}
+		}
+
+		std::vector<EdgeRecord> records;
+		std::vector<EdgeInfo> edges;
+		for (GLuint position = 0; position < state.PositionCount(); ++position)
+		{
+			GatherEdges(state, position, records, edges);
+			for (const EdgeInfo& edge : edges)
+			{
+				if (edge.neighbor < position || (edge.triangleCount != 1 && !edge.bSeam))
+				{
+					continue;
+				}
+
+				// the normal of a triangle on the edge gives the side of the plane
+				GLuint triangle = g_NoCollapse;
+				for (GLuint k = state.triangleOffsets[position]; k < state.triangleOffsets[position + 1] && triangle == g_NoCollapse; ++k)
+				{
+					GLuint t = state.positionTriangles[k];
+					for (GLuint corner = 0; corner < 3; ++corner)
+					{
+						if (state.Position(t, corner) == edge.neighbor)
+						{
+							triangle = t;
+						}
+					}
+				}
+
+				glm::dvec3 direction = state.positions[edge.neighbor] - state.positions[position];
+				glm::dvec3 normal = glm::cross(direction, GetTriangleNormal(state, triangle));
+				double length = glm::length(normal);
+				if (length == 0.0)
+				{
+					continue;
+				}
+				normal /= length;
+				double distance = -glm::dot(normal, state.positions[position]);
+				double weight = g_BoundaryWeight * glm::dot(direction, direction);
+				AddPlane(state.quadrics[position], normal, distance, weight);
+				AddPlane(state.quadrics[edge.neighbor], normal, distance, weight);
+			}
+		}
+	}
+
+	// the allowed moves of a position, cheapest first
+	void FindCollapses(const SimplifyState& state,
+		GLuint position,
+		std::vector<EdgeRecord>& records,
+		std::vector<EdgeInfo>& edges,
+		std::vector<CollapseCandidate>& candidates)
+	{
+		candidates.clear();
+		GatherEdges(state, position, records, edges);
+		VertexKind kind = ClassifyVertex(edges);
+		if (kind == VertexKind::Locked)
+		{
+			return;
+		}
+
+		for (const EdgeInfo& edge : edges)
+		{
+			bool bBorder = edge.triangleCount == 1;
+			if ((kind == VertexKind::Border && !bBorder) || (kind == VertexKind::Seam && !edge.bSeam))
+			{
+				continue;
+			}
+			double error = CollapseError(state.quadrics[position], state.quadrics[edge.neighbor], state.positions[edge.neighbor]);
+			candidates.push_back({ edge.neighbor, error, bBorder });
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const CollapseCandidate& a, const CollapseCandidate& b)
+		{
+			return a.error < b.error;
+		});
+	}
+
+	// positions that share a triangle with the given one
+	void GatherRing(const SimplifyState& state, GLuint position, std::vector<GLuint>& ring)
+	{
+		ring.clear();
+		for (GLuint k = state.triangleOffsets[position]; k < state.triangleOffsets[position + 1]; ++k)
+		{
+			GLuint triangle = state.positionTriangles[k];
+			for (GLuint corner = 0; corner < 3; ++corner)
+			{
+				GLuint neighbor = state.Position(triangle, corner);
+				if (neighbor != position)
+				{
+					ring.push_back(neighbor);
+				}
+			}
+		}
+		std::sort(ring.begin(), ring.end());
+		ring.erase(std::unique(ring.begin(), ring.end()), ring.end());
+	}
+
+	// checks that moving the position onto the target keeps the surface
+	// manifold and unflipped, and finds the target vertex that each vertex
+	// of the position becomes; returns the triangles the move removes
+	bool CanCollapse(const SimplifyState& state,
+		GLuint position,
+		const CollapseCandidate& candidate,
+		std::vector<GLuint>& ring,
+		std::vector<GLuint>& targetRing,
+		std::vector<std::pair<GLuint, GLuint>>& wedgeMap,
+		GLuint& removedTriangles)
+	{
+		const GLuint target = candidate.target;
+
+		// the two rings may only share the corners of the triangles on the edge
+		GatherRing(state, position, ring);
+		GatherRing(state, target, targetRing);
+		size_t shared = 0;
+		for (size_t i = 0, j = 0; i < ring.size() && j < targetRing.size(); )
+		{
+			if (ring[i] < targetRing[j])
+			{
+				++i;
+			}
+			else if (targetRing[j] < ring[i])
+			{
+				++j;
+			}
+			else
+			{
+				shared++;
+				++i;
+				++j;
+			}
+		}
+		if (shared > (candidate.bBorder ? 1u : 2u))
+		{
+			return false;
+		}
+
+		// the triangles that stay must not turn over
+		removedTriangles = 0;
+		for (GLuint k = state.triangleOffsets[position]; k < state.triangleOffsets[position + 1]; ++k)
+		{
+			GLuint triangle = state.positionTriangles[k];
+			glm::dvec3 corners[3];
+			bool bRemoved = false;
+			for (GLuint corner = 0; corner < 3; ++corner)
+			{
+				GLuint p = state.Position(triangle, corner);
+				bRemoved |= p == target;
+				corners[corner] = state.positions[p == position ? target : p];
+			}
+			if (bRemoved)
+			{
+				removedTriangles++;
+				continue;
+			}
+
+			glm::dvec3 before = GetTriangleNormal(state, triangle);
+			glm::dvec3 after = glm::cross(corners[1] - corners[0], corners[2] - corners[0]);
+			double scale = glm::length(before) * glm::length(after);
+			if (scale == 0.0 || glm::dot(before, after) < g_MinFlipCosine * scale)
+			{
+				return false;
+			}
+		}
+
+		// each vertex of the position becomes the target vertex it shares
+		// an edge with, so both sides of a seam keep their own attributes
+		wedgeMap.clear();
+		for (GLuint w = state.wedgeOffsets[position]; w < state.wedgeOffsets[position + 1]; ++w)
+		{
+			GLuint wedge = state.positionWedges[w];
+			GLuint mapped = g_NoCollapse;
+			bool bUsed = false;
+			for (GLuint k = state.triangleOffsets[position]; k < state.triangleOffsets[position + 1] && mapped == g_NoCollapse; ++k)
+			{
+				const GLuint* triangle = &state.indices[state.positionTriangles[k] * 3];
+				if (triangle[0] != wedge && triangle[1] != wedge && triangle[2] != wedge)
+				{
+					continue;
+				}
+				bUsed = true;
+				for (GLuint corner = 0; corner < 3; ++corner)
+				{
+					if (state.wedgePositions[triangle[corner]] == target)
+					{
+						mapped = triangle[corner];
+					}
+				}
+			}
+
+			if (mapped == g_NoCollapse)
+			{
+				if (bUsed)
+				{
+					return false;
+				}
+				mapped = state.positionWedges[state.wedgeOffsets[target]];
+			}
+			wedgeMap.push_back({ wedge, mapped });
+		}
+		return true;
+	}
+
+	// distance of a point from the sphere or torus of the benchmark
+	struct SphereDistance
+	{
+		float radius;
+
+		double operator()(const glm::dvec3& p) const { return std::abs(glm::length(p) - radius); }
+	};
+
+	struct TorusDistance
+	{
+		float mainRadius;
+		float tubeRadius;
+
+		double operator()(const glm::dvec3& p) const
+		{
+			double ring = std::sqrt(p.x * p.x + p.y * p.y) - mainRadius;
+			return std::abs(std::sqrt(ring * ring + p.z * p.z) - tubeRadius);
+		}
+	};
+
+	// largest and root mean square distance of the triangle centers
+	// and edge midpoints from the exact surface, the vertices lie on it
+	template <typename Distance>
+	void MeasureSurfaceError(const MeshData& meshData, const Distance& distance, double& maxError, double& rmsError)
+	{
+		maxError = 0.0;
+		double sum = 0.0;
+		size_t count = 0;
+		for (size_t i = 0; i + 2 < meshData.indices.size(); i += 3)
+		{
+			glm::dvec3 corners[3];
+			for (int corner = 0; corner < 3; ++corner)
+			{
+				const GLfloat* v = &meshData.vertices[static_cast<size_t>(meshData.indices[i + corner]) * MeshData::FloatsPerVertex];
+				corners[corner] = glm::dvec3(v[0], v[1], v[2]);
+			}
+
+			glm::dvec3 samples[4] = {
+				(corners[0] + corners[1] + corners[2]) / 3.0,
+				0.5 * (corners[0] + corners[1]),
+				0.5 * (corners[1] + corners[2]),
+				0.5 * (corners[2] + corners[0])
+			};
+			for (const glm::dvec3& sample : samples)
+			{
+				double d = distance(sample);
+				maxError = std::max(maxError, d);
+				sum += d * d;
+				count++;
+			}
+		}
+		rmsError = count > 0 ? std::sqrt(sum / count) : 0.0;
+	}
+
+	template <typename Surface, typename Distance>
+	void BenchmarkSimplifier(const char* surfaceName, const Surface& surface, const SurfaceGrid& grid, const Distance& distance)
+	{
+		MeshData meshData;
+		GenerateParametricSurface(surface, grid, meshData);
+		WeldVertices(meshData);
+		const GLuint triangleCount = meshData.IndexCount() / 3;
+		std::cout << "INFO: simplifying " << surfaceName << ": " << meshData.VertexCount() << " vertices, "
+			<< triangleCount << " triangles" << std::endl;
+
+		std::vector<SimplifyTarget> targets;
+		double sequential = 0.0;
+		for (float ratio : g_BenchmarkRatios)
+		{
+			SimplifyTarget target = { static_cast<GLuint>(triangleCount * ratio), std::numeric_limits<float>::max() };
+			targets.push_back(target);
+
+			MeshData level;
+			auto start = std::chrono::steady_clock::now();
+			SimplifyReport report = SimplifyMesh(meshData, target, level);
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			sequential += elapsed.count();
+
+			double maxError = 0.0;
+			double rmsError = 0.0;
+			MeasureSurfaceError(level, distance, maxError, rmsError);
+			std::cout << "INFO:   " << report.triangleCountAfter << " triangles in " << report.passCount << " passes: "
+				<< elapsed.count() << " ms, " << elapsed.count() * 1e6 / triangleCount << " ms per million triangles, "
+				<< "surface error max " << maxError << " rms " << rmsError << ", quadric error " << report.error << std::endl;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		BuildSimplifiedLods(meshData, targets);
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		std::cout << "INFO:   " << targets.size() << " levels on worker threads: " << elapsed.count()
+			<< " ms, one after another " << sequential << " ms" << std::endl;
+	}
+}
+
+///////////////////////////////////////////////////
+//	SimplifyMesh()
+//
+//	Runs passes until the target is reached. Each pass
+//	finds the cheapest allowed move of every position in
+//	parallel and then performs them in order of error. A
+//	move also freezes the ring around the moved position
+//	for the rest of the pass, so the adjacency the checks
+//	read is never stale and no position moves twice.
+///////////////////////////////////////////////////
+SimplifyReport SimplifyMesh(const MeshData& source, const SimplifyTarget& target, MeshData& result, unsigned threadCount)
+{
+	SimplifyReport report = {};
+	report.triangleCountBefore = source.IndexCount() / 3;
+
+	SimplifyState state;
+	InitializeState(source, state);
+	BuildAdjacency(state);
+	BuildQuadrics(state);
+
+	const GLuint positionCount = state.PositionCount();
+	const double maxError = static_cast<double>(target.maxError) * target.maxError;
+	std::vector<CollapseCandidate> bestCollapses(positionCount);
+	std::vector<GLuint> order;
+	std::vector<unsigned char> bFrozen(positionCount);
+	std::vector<GLuint> wedgeRemap(state.wedgePositions.size());
+
+	std::vector<EdgeRecord> records;
+	std::vector<EdgeInfo> edges;
+	std::vector<CollapseCandidate> candidates;
+	std::vector<GLuint> ring;
+	std::vector<GLuint> targetRing;
+	std::vector<std::pair<GLuint, GLuint>> wedgeMap;
+
+	double largestError = 0.0;
+	while (state.TriangleCount() > target.triangleCount)
+	{
+		if (report.passCount > 0)
+		{
+			BuildAdjacency(state);
+		}
+
+		ParallelForRows(positionCount, positionCount, threadCount, [&](GLuint firstPosition, GLuint endPosition)
+		{
+			std::vector<EdgeRecord> localRecords;
+			std::vector<EdgeInfo> localEdges;
+			std::vector<CollapseCandidate> localCandidates;
+			for (GLuint position = firstPosition; position < endPosition; ++position)
+			{
+				FindCollapses(state, position, localRecords, localEdges, localCandidates);
+				bestCollapses[position] = localCandidates.empty() ?
+					CollapseCandidate{ g_NoCollapse, 0.0, false } : localCandidates.front();
+			}
+		});
+
+		order.clear();
+		for (GLuint position = 0; position < positionCount; ++position)
+		{
+			if (bestCollapses[position].target != g_NoCollapse && bestCollapses[position].error <= maxError)
+			{
+				order.push_back(position);
+			}
+		}
+		std::sort(order.begin(), order.end(), [&](GLuint a, GLuint b)
+		{
+			return bestCollapses[a].error < bestCollapses[b].error;
+		});
+
+		std::fill(bFrozen.begin(), bFrozen.end(), 0);
+		std::iota(wedgeRemap.begin(), wedgeRemap.end(), 0);
+		const GLuint removeGoal = state.TriangleCount() - target.triangleCount;
+		GLuint removed = 0;
+		GLuint collapseCount = 0;
+		for (GLuint position : order)
+		{
+			if (removed >= removeGoal)
+			{
+				break;
+			}
+			if (bFrozen[position])
+			{
+				continue;
+			}
+
+			// the cheapest move first, the others when it is rejected
+			candidates.assign(1, bestCollapses[position]);
+			bool bCollapsed = false;
+			for (size_t c = 0; c < candidates.size() && !bCollapsed; ++c)
+			{
+				const CollapseCandidate& candidate = candidates[c];
+				GLuint removedTriangles = 0;
+				if (candidate.error <= maxError && !bFrozen[candidate.target] &&
+					CanCollapse(state, position, candidate, ring, targetRing, wedgeMap, removedTriangles))
+				{
+					for (const auto& mapping : wedgeMap)
+					{
+						wedgeRemap[mapping.first] = mapping.second;
+					}
+					AddQuadric(state.quadrics[candidate.target], state.quadrics[position]);
+
+					bFrozen[position] = 1;
+					bFrozen[candidate.target] = 1;
+					for (GLuint neighbor : ring)
+					{
+						bFrozen[neighbor] = 1;
+					}
+
+					removed += removedTriangles;
+					largestError = std::max(largestError, candidate.error);
+					collapseCount++;
+					bCollapsed = true;
+				}
+				else if (c == 0)
+				{
+					FindCollapses(state, position, records, edges, candidates);
+				}
+			}
+		}
+
+		if (collapseCount == 0)
+		{
+			break;
+		}
+
+		// remap the moved vertices and drop the triangles that collapsed
+		size_t kept = 0;
+		for (size_t i = 0; i + 2 < state.indices.size(); i += 3)
+		{
+			GLuint w0 = wedgeRemap[state.indices[i]];
+			GLuint w1 = wedgeRemap[state.indices[i + 1]];
+			GLuint w2 = wedgeRemap[state.indices[i + 2]];
+			GLuint p0 = state.wedgePositions[w0];
+			GLuint p1 = state.wedgePositions[w1];
+			GLuint p2 = state.wedgePositions[w2];
+			if (p0 != p1 && p1 != p2 && p0 != p2)
+			{
+				state.indices[kept++] = w0;
+				state.indices[kept++] = w1;
+				state.indices[kept++] = w2;
+			}
+		}
+		state.indices.resize(kept);
+		report.passCount++;
+	}
+
+	result.vertices = source.vertices;
+	result.indices.swap(state.indices);
+	OptimizeVertexFetch(result.vertices, result.indices);
+
+	report.triangleCountAfter = result.IndexCount() / 3;
+	report.error = static_cast<float>(std::sqrt(largestError));
+	return report;
+}
+
+///////////////////////////////////////////////////
+//	BuildSimplifiedLods()
+//
+//	Every level starts from the source mesh, so the levels
+//	do not wait on each other. The hardware threads left
+//	over are shared out to the passes of the levels.
+///////////////////////////////////////////////////
+std::vector<MeshData> BuildSimplifiedLods(const MeshData& source,
+	const std::vector<SimplifyTarget>& targets,
+	std::vector<SimplifyReport>* reports)
+{
+	std::vector<MeshData> levels(targets.size());
+	std::vector<SimplifyReport> levelReports(targets.size());
+	if (targets.empty())
+	{
+		return levels;
+	}
+
+	const unsigned threadsPerLevel = std::max(GetHardwareThreads() / static_cast<unsigned>(targets.size()), 1u);
+	std::vector<std::thread> workers;
+	workers.reserve(targets.size());
+	for (size_t level = 0; level < targets.size(); ++level)
+	{
+		workers.emplace_back([&, level]()
+		{
+			levelReports[level] = SimplifyMesh(source, targets[level], levels[level], threadsPerLevel);
+			OptimizeMesh(levels[level]);
+		});
+	}
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+
+	if (reports)
+	{
+		reports->swap(levelReports);
+	}
+	return levels;
+}
+
+///////////////////////////////////////////////////
+//	PrintSimplifyReport()
+///////////////////////////////////////////////////
+void PrintSimplifyReport(const char* meshName, GLuint level, const SimplifyReport& report)
+{
+	std::cout << "INFO: " << meshName << " simplified LOD " << level << ": "
+		<< report.triangleCountBefore << " -> " << report.triangleCountAfter << " triangles in "
+		<< report.passCount << " passes, error " << report.error << std::endl;
+}
+
+///////////////////////////////////////////////////
+//	RunMeshSimplifierBenchmark()
+///////////////////////////////////////////////////
+void RunMeshSimplifierBenchmark()
+{
+	BenchmarkSimplifier("sphere", SphereSurface{ 1.0f }, SphereSurface::Grid(g_BenchmarkRows, g_BenchmarkColumns), SphereDistance{ 1.0f });
+	BenchmarkSimplifier("torus", TorusSurface{ 1.0f, 0.2f }, TorusSurface::Grid(g_BenchmarkColumns, g_BenchmarkRows), TorusDistance{ 1.0f, 0.2f });
+}
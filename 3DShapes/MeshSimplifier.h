@@ -0,0 +1,58 @@
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+
+#include "MeshData.h"
+
+// Where the simplification of one level stops, whichever
+// of the two limits is reached first
+struct SimplifyTarget
+{
+	GLuint triangleCount;	// Triangles left at most
+	float maxError;			// Largest geometric error of a collapse, in mesh units
+};
+
+// Result of simplifying a mesh to one target
+struct SimplifyReport
+{
+	GLuint triangleCountBefore;	// Triangles of the source mesh
+	GLuint triangleCountAfter;	// Triangles left after the collapses
+	GLuint passCount;			// Collapse passes that were run
+	float error;				// Largest error of a performed collapse, in mesh units
+};
+
+///////////////////////////////////////////////////
+//	SimplifyMesh()
+//
+//	Reduces an indexed triangle mesh in the interleaved
+//	layout of MeshData by edge collapse ordered by the
+//	quadric error metric. Each collapse moves a vertex onto
+//	one of its neighbors, so the kept vertices keep their
+//	normals and texture coords. Vertices on a border only
+//	move along the border and vertices on a seam, where the
+//	normals or texture coords of the two sides differ, only
+//	move along the seam with every side remapped. Collapses
+//	that would flip a triangle or pinch the surface are
+//	skipped. The result holds only the used vertices.
+///////////////////////////////////////////////////
+SimplifyReport SimplifyMesh(const MeshData& source, const SimplifyTarget& target, MeshData& result, unsigned threadCount = 0);
+
+// Simplifies the source to every target on worker threads, one
+// level per thread, and optimizes each level for the vertex cache;
+// the reports are filled in when given
+std::vector<MeshData> BuildSimplifiedLods(const MeshData& source,
+	const std::vector<SimplifyTarget>& targets,
+	std::vector<SimplifyReport>* reports = nullptr);
+
+// Writes a one line summary of the report
+void PrintSimplifyReport(const char* meshName, GLuint level, const SimplifyReport& report);
+
+// Times the simplifier on a sphere and a torus of about a million
+// triangles and prints the time per million triangles and the
+// distance of the simplified meshes from the exact surfaces
+void RunMeshSimplifierBenchmark();
+
+#endif // MESH_SIMPLIFIER_H
@@ -0,0 +1,196 @@
+#include "MeshWelding.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <unordered_map>
+
+namespace
+{
+	const float g_WeldGridSize = 1e-5f;	// Attribute values closer than this are merged
+	const float g_AreaEpsilon = 1e-12f;	// Smaller cross products count as degenerate
+
+	// quantized attributes of one vertex
+	typedef std::array<std::int32_t, MeshData::FloatsPerVertex> WeldKey;
+
+	struct WeldKeyHash
+	{
+		size_t operator()(const WeldKey& key) const
+		{
+			// FNV-1a over the quantized values
+			std::uint32_t hash = 2166136261u;
+			for (std::int32_t value : key)
+			{
+				hash = (hash ^ static_cast<std::uint32_t>(value)) * 16777619u;
+			}
+			return hash;
+		}
+	};
+
+	WeldKey GetWeldKey(const GLfloat* vertex)
+	{
+		WeldKey key;
+		for (GLuint i = 0; i < MeshData::FloatsPerVertex; ++i)
+		{
+			key[i] = static_cast<std::int32_t>(std::lround(vertex[i] / g_WeldGridSize));
+		}
+		return key;
+	}
+
+	glm::vec3 GetPosition(const std::vector<GLfloat>& vertices, GLuint vertex)
+	{
+		const GLfloat* v = &vertices[vertex * MeshData::FloatsPerVertex];
+		return glm::vec3(v[0], v[1], v[2]);
+	}
+
+	bool IsDegenerate(const std::vector<GLfloat>& vertices, GLuint i0, GLuint i1, GLuint i2)
+	{
+		if (i0 == i1 || i1 == i2 || i0 == i2)
+		{
+			return true;
+		}
+
+		glm::vec3 p0 = GetPosition(vertices, i0);
+		glm::vec3 faceNormal = glm::cross(GetPosition(vertices, i1) - p0, GetPosition(vertices, i2) - p0);
+		return glm::dot(faceNormal, faceNormal) < g_AreaEpsilon;
+	}
+}
+
+///////////////////////////////////////////////////
+//	AppendTriangleList()
+///////////////////////////////////////////////////
+IndexRange AppendTriangleList(std::vector<GLuint>& indices, GLuint first, GLuint count)
+{
+	IndexRange range = { static_cast<GLuint>(indices.size()), 0 };
+	for (GLuint i = 0; i + 2 < count; i += 3)
+	{
+		indices.push_back(first + i);
+		indices.push_back(first + i + 1);
+		indices.push_back(first + i + 2);
+	}
+	range.indexCount = static_cast<GLuint>(indices.size()) - range.firstIndex;
+	return range;
+}
+
+///////////////////////////////////////////////////
+//	AppendTriangleStrip()
+//	Every odd triangle of a strip swaps its first two
+//	vertices so that the whole strip winds the same way.
+///////////////////////////////////////////////////
+IndexRange AppendTriangleStrip(std::vector<GLuint>& indices, GLuint first, GLuint count)
+{
+	IndexRange range = { static_cast<GLuint>(indices.size()), 0 };
+	for (GLuint i = 0; i + 2 < count; ++i)
+	{
+		bool bOdd = (i % 2) != 0;
+		indices.push_back(first + (bOdd ? i + 1 : i));
+		indices.push_back(first + (bOdd ? i : i + 1));
+		indices.push_back(first + i + 2);
+	}
+	range.indexCount = static_cast<GLuint>(indices.size()) - range.firstIndex;
+	return range;
+}
+
+///////////////////////////////////////////////////
+//	AppendTriangleFan()
+///////////////////////////////////////////////////
+IndexRange AppendTriangleFan(std::vector<GLuint>& indices, GLuint first, GLuint count)
+{
+	IndexRange range = { static_cast<GLuint>(indices.size()), 0 };
+	for (GLuint i = 1; i + 1 < count; ++i)
+	{
+		indices.push_back(first);
+		indices.push_back(first + i);
+		indices.push_back(first + i + 1);
+	}
+	range.indexCount = static_cast<GLuint>(indices.size()) - range.firstIndex;
+	return range;
+}
+
+///////////////////////////////////////////////////
+//	WeldVertices()
+//
+//	The unique vertices are kept in the order of their first
+//	use by the triangles, so the welded mesh reads its vertex
+//	buffer roughly front to back. Vertices that no triangle
+//	uses are dropped with the duplicates.
+///////////////////////////////////////////////////
+WeldReport WeldVertices(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, std::vector<IndexRange>& ranges)
+{
+	const GLuint vertexCount = static_cast<GLuint>(vertices.size() / MeshData::FloatsPerVertex);
+
+	WeldReport report = {};
+	report.vertexCountBefore = vertexCount;
+
+	std::unordered_map<WeldKey, GLuint, WeldKeyHash> uniqueVertices;
+	uniqueVertices.reserve(vertexCount);
+	std::vector<GLuint> remap(vertexCount, vertexCount);
+	std::vector<GLfloat> welded;
+	welded.reserve(vertices.size());
+
+	// map each used vertex to the first vertex with the same key
+	for (GLuint& index : indices)
+	{
+		if (remap[index] == vertexCount)
+		{
+			const GLfloat* vertex = &vertices[index * MeshData::FloatsPerVertex];
+			GLuint weldedCount = static_cast<GLuint>(welded.size() / MeshData::FloatsPerVertex);
+			auto entry = uniqueVertices.emplace(GetWeldKey(vertex), weldedCount);
+			if (entry.second)
+			{
+				welded.insert(welded.end(), vertex, vertex + MeshData::FloatsPerVertex);
+			}
+			remap[index] = entry.first->second;
+		}
+		index = remap[index];
+	}
+	vertices.swap(welded);
+
+	// drop the triangles that collapsed, part by part
+	std::vector<GLuint> compacted;
+	compacted.reserve(indices.size());
+	for (IndexRange& range : ranges)
+	{
+		GLuint firstIndex = static_cast<GLuint>(compacted.size());
+		GLuint end = std::min(range.firstIndex + range.indexCount, static_cast<GLuint>(indices.size()));
+		for (GLuint i = range.firstIndex; i + 2 < end; i += 3)
+		{
+			if (IsDegenerate(vertices, indices[i], indices[i + 1], indices[i + 2]))
+			{
+				report.degenerateCount++;
+				continue;
+			}
+			compacted.insert(compacted.end(), &indices[i], &indices[i] + 3);
+		}
+		range.firstIndex = firstIndex;
+		range.indexCount = static_cast<GLuint>(compacted.size()) - firstIndex;
+	}
+	indices.swap(compacted);
+
+	report.vertexCountAfter = static_cast<GLuint>(vertices.size() / MeshData::FloatsPerVertex);
+	report.indexCount = static_cast<GLuint>(indices.size());
+	return report;
+}
+
+WeldReport WeldVertices(MeshData& meshData)
+{
+	std::vector<IndexRange> ranges = { { 0, meshData.IndexCount() } };
+	return WeldVertices(meshData.vertices, meshData.indices, ranges);
+}
+
+///////////////////////////////////////////////////
+//	PrintWeldReport()
+///////////////////////////////////////////////////
+void PrintWeldReport(const char* meshName, const WeldReport& report)
+{
+	std::cout << "INFO: welding " << meshName << ": " << report.vertexCountBefore << " -> "
+		<< report.vertexCountAfter << " vertices, " << report.indexCount << " indices";
+	if (report.degenerateCount > 0)
+	{
+		std::cout << ", " << report.degenerateCount << " degenerate triangles dropped";
+	}
+	std::cout << std::endl;
+}
@@ -0,0 +1,44 @@
+#ifndef MESH_WELDING_H
+#define MESH_WELDING_H
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+
+#include "MeshData.h"
+
+// Result of welding the duplicate vertices of a mesh
+struct WeldReport
+{
+	GLuint vertexCountBefore;	// Vertices of the unwelded mesh
+	GLuint vertexCountAfter;	// Unique vertices left after welding
+	GLuint indexCount;			// Triangle list indices emitted
+	GLuint degenerateCount;		// Triangles with no area that were dropped
+};
+
+// Append the triangles of a draw command over the vertices
+// [first, first + count) to a triangle list, keeping the
+// winding the GL gives to each primitive type; the
+// returned range holds the appended indices
+IndexRange AppendTriangleList(std::vector<GLuint>& indices, GLuint first, GLuint count);
+IndexRange AppendTriangleStrip(std::vector<GLuint>& indices, GLuint first, GLuint count);
+IndexRange AppendTriangleFan(std::vector<GLuint>& indices, GLuint first, GLuint count);
+
+///////////////////////////////////////////////////
+//	WeldVertices()
+//
+//	Merges the vertices whose position, normal and texture
+//	coords match after quantizing them to a fine grid, and
+//	remaps the triangle list indices to the unique ones.
+//	The vertices use the interleaved layout of MeshData.
+//	Each range is a part of the mesh that is drawn on its
+//	own, they are updated after the degenerate triangles
+//	have been dropped. The triangle order is kept.
+///////////////////////////////////////////////////
+WeldReport WeldVertices(std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, std::vector<IndexRange>& ranges);
+WeldReport WeldVertices(MeshData& meshData);
+
+// Writes a one line summary of the report
+void PrintWeldReport(const char* meshName, const WeldReport& report);
+
+#endif // MESH_WELDING_H
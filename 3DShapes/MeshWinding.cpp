@@ -0,0 +1,132 @@
+#include "MeshWinding.h"
+#include "MeshData.h"
+
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace
+{
+	const float g_AreaEpsilon = 1e-8f;	// Smaller cross products count as degenerate
+	const float g_DirectionEpsilon = 1e-6f;	// Smaller offsets from the center are ambiguous
+
+	glm::vec3 GetPosition(const std::vector<GLfloat>& vertices, GLuint vertex)
+	{
+		const GLfloat* v = &vertices[vertex * MeshData::FloatsPerVertex];
+		return glm::vec3(v[0], v[1], v[2]);
+	}
+
+	glm::vec3 GetNormal(const std::vector<GLfloat>& vertices, GLuint vertex)
+	{
+		const GLfloat* v = &vertices[vertex * MeshData::FloatsPerVertex + 3];
+		return glm::vec3(v[0], v[1], v[2]);
+	}
+}
+
+///////////////////////////////////////////////////
+//	NormalizeWinding()
+//
+//	The outward direction of a triangle is taken from the
+//	center of the mesh to the center of the triangle, which
+//	holds for the convex and star-shaped solids built here.
+//	When the triangle passes through the center, or for
+//	WindingReference::Normals always, the stored vertex
+//	normals decide instead.
+///////////////////////////////////////////////////
+WindingReport NormalizeWinding(const std::vector<GLfloat>& vertices, std::vector<GLuint>& indices, WindingReference reference)
+{
+	WindingReport report = {};
+	report.triangleCount = static_cast<GLuint>(indices.size() / 3);
+	if (report.triangleCount == 0)
+	{
+		return report;
+	}
+
+	// center of the referenced vertices
+	glm::vec3 center(0.0f);
+	for (GLuint index : indices)
+	{
+		center += GetPosition(vertices, index);
+	}
+	center /= static_cast<float>(indices.size());
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		glm::vec3 p0 = GetPosition(vertices, indices[i]);
+		glm::vec3 p1 = GetPosition(vertices, indices[i + 1]);
+		glm::vec3 p2 = GetPosition(vertices, indices[i + 2]);
+
+		glm::vec3 faceNormal = glm::cross(p1 - p0, p2 - p0);
+		if (glm::dot(faceNormal, faceNormal) < g_AreaEpsilon)
+		{
+			report.degenerateCount++;
+			continue;
+		}
+
+		glm::vec3 storedNormal = GetNormal(vertices, indices[i]) + GetNormal(vertices, indices[i + 1]) + GetNormal(vertices, indices[i + 2]);
+		glm::vec3 outward = (p0 + p1 + p2) / 3.0f - center;
+		if (reference == WindingReference::Normals || glm::dot(outward, outward) < g_DirectionEpsilon)
+		{
+			outward = storedNormal;
+		}
+
+		if (glm::dot(faceNormal, outward) < 0.0f)
+		{
+			std::swap(indices[i + 1], indices[i + 2]);
+			faceNormal = -faceNormal;
+			report.flippedCount++;
+		}
+
+		if (glm::dot(faceNormal, storedNormal) < 0.0f)
+		{
+			report.normalMismatchCount++;
+		}
+	}
+
+	return report;
+}
+
+WindingReport NormalizeWinding(std::vector<GLfloat>& vertices, WindingReference reference)
+{
+	const GLuint vertexCount = static_cast<GLuint>(vertices.size() / MeshData::FloatsPerVertex);
+
+	std::vector<GLuint> indices(vertexCount - vertexCount % 3);
+	for (GLuint i = 0; i < indices.size(); ++i)
+	{
+		indices[i] = i;
+	}
+
+	WindingReport report = NormalizeWinding(vertices, indices, reference);
+	if (report.flippedCount == 0)
+	{
+		return report;
+	}
+
+	// write the vertices back in the corrected order
+	std::vector<GLfloat> ordered(vertices.size());
+	for (GLuint i = 0; i < indices.size(); ++i)
+	{
+		std::copy_n(&vertices[indices[i] * MeshData::FloatsPerVertex], MeshData::FloatsPerVertex,
+			&ordered[i * MeshData::FloatsPerVertex]);
+	}
+	std::copy(vertices.begin() + indices.size() * MeshData::FloatsPerVertex, vertices.end(),
+		ordered.begin() + indices.size() * MeshData::FloatsPerVertex);
+	vertices.swap(ordered);
+
+	return report;
+}
+
+///////////////////////////////////////////////////
+//	PrintWindingReport()
+///////////////////////////////////////////////////
+void PrintWindingReport(const char* meshName, const WindingReport& report)
+{
+	std::cout << "INFO: winding " << meshName << ": " << report.triangleCount << " triangles, "
+		<< report.flippedCount << " flipped, " << report.degenerateCount << " degenerate";
+	if (report.normalMismatchCount > 0)
+	{
+		std::cout << ", " << report.normalMismatchCount << " with inward normals";
+	}
+	std::cout << std::endl;
+}
@@ -0,0 +1,41 @@
+#ifndef MESH_WINDING_H
+#define MESH_WINDING_H
+#pragma once
+
+#include <GL/glew.h>
+#include <vector>
+
+// Result of validating the triangle winding of a closed mesh
+struct WindingReport
+{
+	GLuint triangleCount;		// Number of triangles checked
+	GLuint flippedCount;		// Triangles that were wound clockwise and got reversed
+	GLuint degenerateCount;		// Triangles with no area, left as they are
+	GLuint normalMismatchCount;	// Triangles whose stored normals point inward
+};
+
+// Where NormalizeWinding() takes the outside of a triangle from
+enum class WindingReference
+{
+	Center,		// Away from the center of the mesh, for convex and star-shaped solids
+	Normals		// Along the stored vertex normals, for closed meshes such as the torus
+};
+
+///////////////////////////////////////////////////
+//	NormalizeWinding()
+//
+//	Makes every triangle of a closed mesh counter-clockwise
+//	when seen from outside, so that back faces can be culled.
+//	The vertices use the interleaved layout of MeshData.
+//	The indexed version reorders the indices, the other one
+//	reorders the vertices of a plain triangle list.
+///////////////////////////////////////////////////
+WindingReport NormalizeWinding(const std::vector<GLfloat>& vertices,
+	std::vector<GLuint>& indices,
+	WindingReference reference = WindingReference::Center);
+WindingReport NormalizeWinding(std::vector<GLfloat>& vertices, WindingReference reference = WindingReference::Center);
+
+// Writes a one line summary of the report
+void PrintWindingReport(const char* meshName, const WindingReport& report);
+
+#endif // MESH_WINDING_H
@@ -0,0 +1,227 @@
+#include "Meshlet.h"
+#include "MeshData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	const GLuint g_NoMeshlet = std::numeric_limits<GLuint>::max();
+	const float g_MinConeCosine = 0.1f;	// Wider normal cones are never culled
+	const float g_UniformScaleTolerance = 0.01f;	// Allowed difference between the axis scales for cone culling
+
+	glm::vec3 GetPosition(const std::vector<GLfloat>& vertices, GLuint vertex)
+	{
+		const GLfloat* v = &vertices[vertex * MeshData::FloatsPerVertex];
+		return glm::vec3(v[0], v[1], v[2]);
+	}
+}
+
+///////////////////////////////////////////////////
+//	BuildMeshlets()
+//
+//	Meshlets are grown greedily from a seed triangle. The next
+//	triangle is the neighbor that adds the fewest new vertices,
+//	ties going to the one closest to the meshlet center, which
+//	keeps the clusters compact and their normal cones narrow.
+///////////////////////////////////////////////////
+std::vector<Meshlet> BuildMeshlets(const std::vector<GLfloat>& vertices, std::vector<GLuint>& indices)
+{
+	const GLuint triangleCount = static_cast<GLuint>(indices.size() / 3);
+	const GLuint vertexCount = static_cast<GLuint>(vertices.size() / MeshData::FloatsPerVertex);
+
+	// triangles that use each vertex
+	std::vector<std::vector<GLuint>> vertexTriangles(vertexCount);
+	for (GLuint t = 0; t < triangleCount; ++t)
+	{
+		for (GLuint k = 0; k < 3; ++k)
+		{
+			vertexTriangles[indices[t * 3 + k]].push_back(t);
+		}
+	}
+
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<GLuint> vertexMeshlet(vertexCount, g_NoMeshlet);	// last meshlet that used each vertex
+	std::vector<GLuint> orderedIndices;
+	orderedIndices.reserve(indices.size());
+	std::vector<Meshlet> meshlets;
+
+	GLuint seed = 0;
+	while (true)
+	{
+		while (seed < triangleCount && emitted[seed])
+		{
+			++seed;
+		}
+		if (seed == triangleCount)
+		{
+			break;
+		}
+
+		const GLuint meshletID = static_cast<GLuint>(meshlets.size());
+		std::vector<GLuint> meshletVertices;
+		std::vector<GLuint> meshletTriangles;
+		std::vector<GLuint> candidates;
+		glm::vec3 positionSum(0.0f);
+
+		auto addTriangle = [&](GLuint t)
+		{
+			emitted[t] = true;
+			meshletTriangles.push_back(t);
+			for (GLuint k = 0; k < 3; ++k)
+			{
+				GLuint v = indices[t * 3 + k];
+				if (vertexMeshlet[v] != meshletID)
+				{
+					vertexMeshlet[v] = meshletID;
+					meshletVertices.push_back(v);
+					positionSum += GetPosition(vertices, v);
+				}
+				for (GLuint neighbor : vertexTriangles[v])
+				{
+					if (!emitted[neighbor])
+					{
+						candidates.push_back(neighbor);
+					}
+				}
+			}
+		};
+
+		addTriangle(seed);
+		while (meshletTriangles.size() < Meshlet::MaxTriangles)
+		{
+			candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+				[&](GLuint t) { return emitted[t]; }), candidates.end());
+
+			glm::vec3 center = positionSum / static_cast<float>(meshletVertices.size());
+			GLuint best = g_NoMeshlet;
+			GLuint bestNewVertices = 4;
+			float bestDistance = std::numeric_limits<float>::max();
+			for (GLuint t : candidates)
+			{
+				GLuint newVertices = 0;
+				glm::vec3 triangleCenter(0.0f);
+				for (GLuint k = 0; k < 3; ++k)
+				{
+					GLuint v = indices[t * 3 + k];
+					newVertices += (vertexMeshlet[v] != meshletID) ? 1 : 0;
+					triangleCenter += GetPosition(vertices, v) / 3.0f;
+				}
+				if (meshletVertices.size() + newVertices > Meshlet::MaxVertices)
+				{
+					continue;
+				}
+
+				glm::vec3 offset = triangleCenter - center;
+				float distance = glm::dot(offset, offset);
+				if (newVertices < bestNewVertices || (newVertices == bestNewVertices && distance < bestDistance))
+				{
+					best = t;
+					bestNewVertices = newVertices;
+					bestDistance = distance;
+				}
+			}
+			if (best == g_NoMeshlet)
+			{
+				break;
+			}
+			addTriangle(best);
+		}
+
+		Meshlet meshlet = {};
+		meshlet.firstIndex = static_cast<GLuint>(orderedIndices.size());
+		meshlet.indexCount = static_cast<GLuint>(meshletTriangles.size() * 3);
+
+		// bounding sphere around the center of the bounding box
+		glm::vec3 minimum = GetPosition(vertices, meshletVertices[0]);
+		glm::vec3 maximum = minimum;
+		for (GLuint v : meshletVertices)
+		{
+			minimum = glm::min(minimum, GetPosition(vertices, v));
+			maximum = glm::max(maximum, GetPosition(vertices, v));
+		}
+		glm::vec3 center = (minimum + maximum) * 0.5f;
+		float radius = 0.0f;
+		for (GLuint v : meshletVertices)
+		{
+			radius = std::max(radius, glm::length(GetPosition(vertices, v) - center));
+		}
+		meshlet.bounds = glm::vec4(center, radius);
+
+		// normal cone around the average face normal
+		std::vector<glm::vec3> faceNormals;
+		glm::vec3 axis(0.0f);
+		for (GLuint t : meshletTriangles)
+		{
+			glm::vec3 p0 = GetPosition(vertices, indices[t * 3]);
+			glm::vec3 p1 = GetPosition(vertices, indices[t * 3 + 1]);
+			glm::vec3 p2 = GetPosition(vertices, indices[t * 3 + 2]);
+			glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+			float length = glm::length(normal);
+			if (length > 0.0f)
+			{
+				faceNormals.push_back(normal / length);
+				axis += normal / length;
+			}
+			orderedIndices.insert(orderedIndices.end(), &indices[t * 3], &indices[t * 3] + 3);
+		}
+
+		meshlet.cone = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		if (glm::length(axis) > 0.0f)
+		{
+			axis = glm::normalize(axis);
+			float minCosine = 1.0f;
+			for (const glm::vec3& normal : faceNormals)
+			{
+				minCosine = std::min(minCosine, glm::dot(normal, axis));
+			}
+
+			// the cutoff is the sine of the cone angle
+			if (minCosine > g_MinConeCosine)
+			{
+				meshlet.cone = glm::vec4(axis, std::sqrt(1.0f - minCosine * minCosine));
+			}
+		}
+
+		meshlets.push_back(meshlet);
+	}
+
+	indices.swap(orderedIndices);
+	return meshlets;
+}
+
+///////////////////////////////////////////////////
+//	IsMeshletVisible()
+///////////////////////////////////////////////////
+bool IsMeshletVisible(const Meshlet& meshlet,
+	const glm::mat4& model,
+	const Frustum& frustum,
+	const glm::vec3& cameraPosition,
+	bool bCullBackFaces)
+{
+	float scaleX = glm::length(glm::vec3(model[0]));
+	float scaleY = glm::length(glm::vec3(model[1]));
+	float scaleZ = glm::length(glm::vec3(model[2]));
+	float maxScale = std::max(scaleX, std::max(scaleY, scaleZ));
+	float minScale = std::min(scaleX, std::min(scaleY, scaleZ));
+
+	glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(meshlet.bounds), 1.0f));
+	float radius = meshlet.bounds.w * maxScale;
+	if (!frustum.IntersectsSphere(center, radius))
+	{
+		return false;
+	}
+
+	// every triangle faces away from the camera
+	if (bCullBackFaces && meshlet.cone.w < 1.0f && maxScale - minScale <= g_UniformScaleTolerance * maxScale)
+	{
+		glm::vec3 axis = glm::normalize(glm::vec3(model * glm::vec4(glm::vec3(meshlet.cone), 0.0f)));
+		glm::vec3 toCenter = center - cameraPosition;
+		if (glm::dot(toCenter, axis) >= meshlet.cone.w * glm::length(toCenter) + radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
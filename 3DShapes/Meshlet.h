@@ -0,0 +1,45 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "Frustum.h"
+
+// A cluster of neighboring triangles that is culled as one unit
+struct Meshlet
+{
+	static const GLuint MaxVertices = 64;	// Unique vertices per meshlet
+	static const GLuint MaxTriangles = 124;	// Triangles per meshlet
+
+	GLuint firstIndex;	// First index of the meshlet in the meshlet index buffer
+	GLuint indexCount;	// Number of indices for the meshlet
+	glm::vec4 bounds;	// Object-space bounding sphere (xyz center, w radius)
+	glm::vec4 cone;		// Normal cone (xyz axis, w cutoff), a cutoff of 1 never culls
+};
+
+///////////////////////////////////////////////////
+//	BuildMeshlets()
+//
+//	Splits an indexed triangle mesh into meshlets and
+//	returns them. The indices are reordered so that the
+//	triangles of each meshlet form one contiguous range.
+///////////////////////////////////////////////////
+std::vector<Meshlet> BuildMeshlets(const std::vector<GLfloat>& vertices, std::vector<GLuint>& indices);
+
+///////////////////////////////////////////////////
+//	IsMeshletVisible()
+//
+//	Tests a meshlet of an object against the view frustum
+//	and, when bCullBackFaces is set, its normal cone against
+//	the camera position. The cone test needs a uniform scale.
+///////////////////////////////////////////////////
+bool IsMeshletVisible(const Meshlet& meshlet,
+	const glm::mat4& model,
+	const Frustum& frustum,
+	const glm::vec3& cameraPosition,
+	bool bCullBackFaces);
+
+#endif // MESHLET_H
@@ -0,0 +1,363 @@
+#include "PagedMesh.h"
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <utility>
+
+namespace
+{
+	// bump whenever the layout of the file or of its chunks changes
+	const uint32_t g_PagedMeshVersion = 1;
+	const char g_PagedMeshMagic[4] = { 'P', 'M', 'S', 'H' };
+
+	// fixed size start of every paged mesh file, followed by
+	// the chunk records and the chunk data
+	struct PagedMeshHeader
+	{
+		char magic[4];
+		uint32_t version;		// g_PagedMeshVersion of the writer
+		uint32_t chunkCount;
+		uint32_t floatsPerVertex;	// MeshData::FloatsPerVertex of the writer
+		float boundsMin[3];		// Bounds of the whole mesh
+		float boundsMax[3];
+	};
+	static_assert(sizeof(PagedMeshHeader) == 40, "paged mesh header must not be padded");
+
+	// a chunk as stored in the table of the file
+	struct PagedChunkRecord
+	{
+		float boundsMin[3];
+		float boundsMax[3];
+		float sphere[4];
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint64_t offset;
+	};
+	static_assert(sizeof(PagedChunkRecord) == 56, "paged mesh chunk record must not be padded");
+
+	// splits the triangles into ranges of at most chunkTriangles whose
+	// centroids lie together, halving each range along the longest
+	// axis of its centroid bounds
+	void SplitTriangles(const std::vector<glm::vec3>& centroids,
+		std::vector<GLuint>& triangles,
+		GLuint chunkTriangles,
+		std::vector<IndexRange>& chunks)
+	{
+		std::vector<IndexRange> stack = { { 0, static_cast<GLuint>(triangles.size()) } };
+		while (!stack.empty())
+		{
+			IndexRange range = stack.back();
+			stack.pop_back();
+			if (range.indexCount <= chunkTriangles)
+			{
+				chunks.push_back(range);
+				continue;
+			}
+
+			glm::vec3 minimum(std::numeric_limits<float>::max());
+			glm::vec3 maximum(-std::numeric_limits<float>::max());
+			for (GLuint i = range.firstIndex; i < range.firstIndex + range.indexCount; ++i)
+			{
+				minimum = glm::min(minimum, centroids[triangles[i]]);
+				maximum = glm::max(maximum, centroids[triangles[i]]);
+			}
+			glm::vec3 extent = maximum - minimum;
+			int axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+			GLuint half = range.indexCount / 2;
+			auto first = triangles.begin() + range.firstIndex;
+			std::nth_element(first, first + half, first + range.indexCount, [&](GLuint a, GLuint b)
+			{
+				return centroids[a][axis] < centroids[b][axis];
+			});
+
+			// the chunks come out in the order of the file
+			stack.push_back({ range.firstIndex + half, range.indexCount - half });
+			stack.push_back({ range.firstIndex, half });
+		}
+	}
+
+	// copies the triangles of one range and the vertices they use;
+	// remap holds the chunk vertex of each source vertex, or the
+	// source vertex count when it is not in the chunk yet
+	void ExtractChunk(const MeshData& meshData,
+		const std::vector<GLuint>& triangles,
+		const IndexRange& range,
+		std::vector<GLuint>& remap,
+		MeshData& chunk)
+	{
+		const GLuint unused = meshData.VertexCount();
+		chunk.vertices.clear();
+		chunk.indices.clear();
+		for (GLuint i = range.firstIndex; i < range.firstIndex + range.indexCount; ++i)
+		{
+			for (GLuint k = 0; k < 3; ++k)
+			{
+				GLuint vertex = meshData.indices[triangles[i] * 3 + k];
+				if (remap[vertex] == unused)
+				{
+					remap[vertex] = chunk.VertexCount();
+					const GLfloat* source = &meshData.vertices[static_cast<size_t>(vertex) * MeshData::FloatsPerVertex];
+					chunk.vertices.insert(chunk.vertices.end(), source, source + MeshData::FloatsPerVertex);
+				}
+				chunk.indices.push_back(remap[vertex]);
+			}
+		}
+
+		// only the touched entries are reset for the next chunk
+		for (GLuint i = range.firstIndex; i < range.firstIndex + range.indexCount; ++i)
+		{
+			for (GLuint k = 0; k < 3; ++k)
+			{
+				remap[meshData.indices[triangles[i] * 3 + k]] = unused;
+			}
+		}
+	}
+
+	PagedChunkRecord MakeChunkRecord(const MeshData& chunk, uint64_t offset)
+	{
+		glm::vec3 minimum(std::numeric_limits<float>::max());
+		glm::vec3 maximum(-std::numeric_limits<float>::max());
+		for (size_t i = 0; i < chunk.vertices.size(); i += MeshData::FloatsPerVertex)
+		{
+			glm::vec3 position(chunk.vertices[i], chunk.vertices[i + 1], chunk.vertices[i + 2]);
+			minimum = glm::min(minimum, position);
+			maximum = glm::max(maximum, position);
+		}
+		glm::vec3 center = (minimum + maximum) * 0.5f;
+		float radius = 0.0f;
+		for (size_t i = 0; i < chunk.vertices.size(); i += MeshData::FloatsPerVertex)
+		{
+			glm::vec3 position(chunk.vertices[i], chunk.vertices[i + 1], chunk.vertices[i + 2]);
+			radius = std::max(radius, glm::length(position - center));
+		}
+
+		PagedChunkRecord record;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			record.boundsMin[axis] = minimum[axis];
+			record.boundsMax[axis] = maximum[axis];
+			record.sphere[axis] = center[axis];
+		}
+		record.sphere[3] = radius;
+		record.vertexCount = chunk.VertexCount();
+		record.indexCount = chunk.IndexCount();
+		record.offset = offset;
+		return record;
+	}
+}
+
+///////////////////////////////////////////////////
+//	WritePagedMesh()
+//
+//	The mesh is written to a temporary file that is renamed
+//	over the old one, like the files of the mesh cache.
+///////////////////////////////////////////////////
+bool WritePagedMesh(const MeshData& meshData, const std::string& path, GLuint chunkTriangles, PagedMeshReport* report)
+{
+	auto start = std::chrono::steady_clock::now();
+	const GLuint triangleCount = meshData.IndexCount() / 3;
+	if (triangleCount == 0 || chunkTriangles == 0)
+	{
+		std::cerr << "Failed to write paged mesh " << path << ": no triangles" << std::endl;
+		return false;
+	}
+
+	std::vector<glm::vec3> centroids(triangleCount);
+	std::vector<GLuint> triangles(triangleCount);
+	for (GLuint t = 0; t < triangleCount; ++t)
+	{
+		glm::vec3 sum(0.0f);
+		for (GLuint k = 0; k < 3; ++k)
+		{
+			const GLfloat* vertex = &meshData.vertices[static_cast<size_t>(meshData.indices[t * 3 + k]) * MeshData::FloatsPerVertex];
+			sum += glm::vec3(vertex[0], vertex[1], vertex[2]);
+		}
+		centroids[t] = sum / 3.0f;
+		triangles[t] = t;
+	}
+	std::vector<IndexRange> ranges;
+	SplitTriangles(centroids, triangles, chunkTriangles, ranges);
+	std::vector<glm::vec3>().swap(centroids);
+
+	PagedMeshHeader header;
+	std::memcpy(header.magic, g_PagedMeshMagic, sizeof(header.magic));
+	header.version = g_PagedMeshVersion;
+	header.chunkCount = static_cast<uint32_t>(ranges.size());
+	header.floatsPerVertex = MeshData::FloatsPerVertex;
+
+	const std::string temporaryPath = path + ".tmp";
+	std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+	std::vector<PagedChunkRecord> records;
+	records.reserve(ranges.size());
+	uint64_t offset = sizeof(header) + ranges.size() * sizeof(PagedChunkRecord);
+	file.seekp(static_cast<std::streamoff>(offset));
+
+	// the chunks are written one at a time, so only one is held besides the source
+	glm::vec3 minimum(std::numeric_limits<float>::max());
+	glm::vec3 maximum(-std::numeric_limits<float>::max());
+	GLuint maxChunkTriangles = 0;
+	std::vector<GLuint> remap(meshData.VertexCount(), meshData.VertexCount());
+	MeshData chunk;
+	for (const IndexRange& range : ranges)
+	{
+		ExtractChunk(meshData, triangles, range, remap, chunk);
+		OptimizeMesh(chunk);
+
+		records.push_back(MakeChunkRecord(chunk, offset));
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			minimum[axis] = std::min(minimum[axis], records.back().boundsMin[axis]);
+			maximum[axis] = std::max(maximum[axis], records.back().boundsMax[axis]);
+		}
+		maxChunkTriangles = std::max(maxChunkTriangles, chunk.IndexCount() / 3);
+
+		file.write(reinterpret_cast<const char*>(chunk.vertices.data()), chunk.vertices.size() * sizeof(GLfloat));
+		file.write(reinterpret_cast<const char*>(chunk.indices.data()), chunk.indices.size() * sizeof(GLuint));
+		offset += chunk.vertices.size() * sizeof(GLfloat) + chunk.indices.size() * sizeof(GLuint);
+	}
+
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		header.boundsMin[axis] = minimum[axis];
+		header.boundsMax[axis] = maximum[axis];
+	}
+	file.seekp(0);
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(PagedChunkRecord));
+	file.close();
+	if (!file)
+	{
+		std::remove(temporaryPath.c_str());
+		std::cerr << "Failed to write paged mesh " << path << std::endl;
+		return false;
+	}
+
+	std::remove(path.c_str());
+	if (std::rename(temporaryPath.c_str(), path.c_str()) != 0)
+	{
+		std::remove(temporaryPath.c_str());
+		std::cerr << "Failed to write paged mesh " << path << std::endl;
+		return false;
+	}
+
+	if (report)
+	{
+		std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+		report->chunkCount = header.chunkCount;
+		report->triangleCount = triangleCount;
+		report->maxChunkTriangles = maxChunkTriangles;
+		report->fileBytes = offset;
+		report->milliseconds = elapsed.count();
+	}
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	PrintPagedMeshReport()
+///////////////////////////////////////////////////
+void PrintPagedMeshReport(const char* meshName, const PagedMeshReport& report)
+{
+	std::cout << "INFO: paged " << meshName << ": " << report.triangleCount << " triangles in " << report.chunkCount
+		<< " chunks of at most " << report.maxChunkTriangles << ", " << report.fileBytes / (1024.0 * 1024.0)
+		<< " MB in " << report.milliseconds << " ms" << std::endl;
+}
+
+///////////////////////////////////////////////////
+//	PagedMeshFile::Open()
+///////////////////////////////////////////////////
+bool PagedMeshFile::Open(const std::string& path)
+{
+	m_chunks.clear();
+	m_file.close();
+	m_file.clear();
+	m_file.open(path, std::ios::binary);
+	if (!m_file)
+	{
+		std::cerr << "Failed to open paged mesh " << path << std::endl;
+		return false;
+	}
+
+	m_file.seekg(0, std::ios::end);
+	const uint64_t fileSize = static_cast<uint64_t>(m_file.tellg());
+	m_file.seekg(0);
+
+	PagedMeshHeader header;
+	bool bValid = fileSize >= sizeof(header) && m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+		std::memcmp(header.magic, g_PagedMeshMagic, sizeof(header.magic)) == 0 &&
+		header.version == g_PagedMeshVersion &&
+		header.floatsPerVertex == MeshData::FloatsPerVertex &&
+		header.chunkCount <= (fileSize - sizeof(header)) / sizeof(PagedChunkRecord);
+
+	std::vector<PagedChunkRecord> records;
+	if (bValid)
+	{
+		records.resize(header.chunkCount);
+		bValid = static_cast<bool>(m_file.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(PagedChunkRecord)));
+	}
+	for (size_t i = 0; bValid && i < records.size(); ++i)
+	{
+		const PagedChunkRecord& record = records[i];
+		PagedChunk chunk;
+		chunk.boundsMin = glm::vec3(record.boundsMin[0], record.boundsMin[1], record.boundsMin[2]);
+		chunk.boundsMax = glm::vec3(record.boundsMax[0], record.boundsMax[1], record.boundsMax[2]);
+		chunk.sphere = glm::vec4(record.sphere[0], record.sphere[1], record.sphere[2], record.sphere[3]);
+		chunk.offset = record.offset;
+		chunk.vertexCount = record.vertexCount;
+		chunk.indexCount = record.indexCount;
+		bValid = chunk.offset <= fileSize && chunk.GetByteSize() <= fileSize - chunk.offset;
+		m_chunks.push_back(chunk);
+	}
+
+	if (!bValid)
+	{
+		std::cerr << "Failed to open paged mesh " << path << ": not a paged mesh of this version" << std::endl;
+		m_chunks.clear();
+		m_file.close();
+		return false;
+	}
+	m_boundsMin = glm::vec3(header.boundsMin[0], header.boundsMin[1], header.boundsMin[2]);
+	m_boundsMax = glm::vec3(header.boundsMax[0], header.boundsMax[1], header.boundsMax[2]);
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	PagedMeshFile::ReadChunk()
+//
+//	Indices that point past the vertices of the chunk fail
+//	the read, so a damaged file cannot make a draw read
+//	outside of its vertex buffer.
+///////////////////////////////////////////////////
+bool PagedMeshFile::ReadChunk(GLuint chunk, MeshData& meshData)
+{
+	if (chunk >= m_chunks.size())
+	{
+		return false;
+	}
+
+	const PagedChunk& entry = m_chunks[chunk];
+	meshData.vertices.resize(static_cast<size_t>(entry.vertexCount) * MeshData::FloatsPerVertex);
+	meshData.indices.resize(entry.indexCount);
+	m_file.clear();
+	m_file.seekg(static_cast<std::streamoff>(entry.offset));
+	m_file.read(reinterpret_cast<char*>(meshData.vertices.data()), meshData.vertices.size() * sizeof(GLfloat));
+	m_file.read(reinterpret_cast<char*>(meshData.indices.data()), meshData.indices.size() * sizeof(GLuint));
+
+	bool bValid = static_cast<bool>(m_file);
+	for (size_t i = 0; bValid && i < meshData.indices.size(); ++i)
+	{
+		bValid = meshData.indices[i] < entry.vertexCount;
+	}
+	if (!bValid)
+	{
+		meshData.vertices.clear();
+		meshData.indices.clear();
+	}
+	return bValid;
+}
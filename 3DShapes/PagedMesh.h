@@ -0,0 +1,92 @@
+#ifndef PAGED_MESH_H
+#define PAGED_MESH_H
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "MeshData.h"
+
+// Bounds and place in the file of one chunk of a paged mesh
+struct PagedChunk
+{
+	glm::vec3 boundsMin;	// Corners of the axis aligned bounding box
+	glm::vec3 boundsMax;
+	glm::vec4 sphere;		// Bounding sphere, xyz center and w radius
+	uint64_t offset;		// Byte of the vertices in the file, the indices follow
+	GLuint vertexCount;
+	GLuint indexCount;
+
+	// bytes of the vertices and indices, in the file and on the GPU
+	size_t GetByteSize() const
+	{
+		return static_cast<size_t>(vertexCount) * MeshData::FloatsPerVertex * sizeof(GLfloat) +
+			static_cast<size_t>(indexCount) * sizeof(GLuint);
+	}
+};
+
+// Result of writing a paged mesh
+struct PagedMeshReport
+{
+	GLuint chunkCount;
+	GLuint triangleCount;		// Triangles of every chunk together
+	GLuint maxChunkTriangles;	// Triangles of the largest chunk
+	uint64_t fileBytes;
+	double milliseconds;
+};
+
+///////////////////////////////////////////////////
+//	WritePagedMesh()
+//
+//	Splits an indexed triangle mesh into chunks of at most
+//	chunkTriangles triangles by halving the triangle
+//	centroids along their longest axis, so that each chunk
+//	covers a compact part of the surface. Every chunk keeps
+//	only the vertices it uses, is optimized for the vertex
+//	cache and gets its bounds. The chunk table is written
+//	at the start of the file, so a reader needs only the
+//	table in memory and can load any chunk on its own.
+///////////////////////////////////////////////////
+bool WritePagedMesh(const MeshData& meshData,
+	const std::string& path,
+	GLuint chunkTriangles,
+	PagedMeshReport* report = nullptr);
+
+// Writes a one line summary of the report
+void PrintPagedMeshReport(const char* meshName, const PagedMeshReport& report);
+
+/***********************************************************
+ *  PagedMeshFile
+ *
+ *  Reads the chunk table of a paged mesh on opening and
+ *  single chunks on request. The file stays open, and the
+ *  chunks are read with plain seeks so that meshes larger
+ *  than the address space can be streamed. A file that is
+ *  from another version or whose chunks reach past its end
+ *  is not opened.
+ ***********************************************************/
+class PagedMeshFile
+{
+public:
+	bool Open(const std::string& path);
+
+	const std::vector<PagedChunk>& GetChunks() const { return m_chunks; }
+	const glm::vec3& GetBoundsMin() const { return m_boundsMin; }
+	const glm::vec3& GetBoundsMax() const { return m_boundsMax; }
+
+	// reads the vertices and indices of one chunk; calls must not
+	// overlap, as they share the read position of the file
+	bool ReadChunk(GLuint chunk, MeshData& meshData);
+
+private:
+	std::ifstream m_file;
+	std::vector<PagedChunk> m_chunks;
+	glm::vec3 m_boundsMin;	// Bounds of the whole mesh
+	glm::vec3 m_boundsMax;
+};
+
+#endif // PAGED_MESH_H
@@ -0,0 +1,214 @@
+#include "ParametricSurface.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+namespace
+{
+	const GLuint g_AngleResyncSteps = 256;		// Recurrence steps between exact sin/cos values
+	const GLuint g_MinVerticesPerThread = 32768;	// Smaller grids are not worth another thread
+	const GLuint g_BenchmarkColumns = 2048;		// Quads along u of the benchmark meshes
+	const GLuint g_BenchmarkRows = 1024;		// Quads along v of the benchmark meshes
+	const int g_BenchmarkRuns = 3;				// Runs per thread count, the fastest is kept
+
+	unsigned GetHardwareThreads()
+	{
+		unsigned threads = std::thread::hardware_concurrency();
+		return threads > 0 ? threads : 1;
+	}
+
+	// fastest of a few runs of the generator, in milliseconds
+	template <typename Surface>
+	double TimeSurface(const Surface& surface, const SurfaceGrid& grid, unsigned threadCount, MeshData& meshData)
+	{
+		double best = 0.0;
+		for (int run = 0; run < g_BenchmarkRuns; ++run)
+		{
+			auto start = std::chrono::steady_clock::now();
+			GenerateParametricSurface(surface, grid, meshData, threadCount);
+			std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+			best = (run == 0) ? elapsed.count() : std::min(best, elapsed.count());
+		}
+		return best;
+	}
+
+	template <typename Surface>
+	void BenchmarkSurface(const char* surfaceName, const Surface& surface, const SurfaceGrid& grid)
+	{
+		MeshData meshData;
+		std::cout << "INFO: parametric " << surfaceName << ": " << grid.VertexCount() << " vertices, "
+			<< grid.IndexCount() / 3 << " triangles" << std::endl;
+
+		double singleThread = 0.0;
+		unsigned hardwareThreads = GetHardwareThreads();
+		for (unsigned threads = 1; ; threads = std::min(threads * 2, hardwareThreads))
+		{
+			double milliseconds = TimeSurface(surface, grid, threads, meshData);
+			if (threads == 1)
+			{
+				singleThread = milliseconds;
+			}
+			std::cout << "INFO:   " << threads << " threads: " << milliseconds << " ms, speedup "
+				<< singleThread / milliseconds << std::endl;
+
+			if (threads == hardwareThreads)
+			{
+				break;
+			}
+		}
+	}
+}
+
+///////////////////////////////////////////////////
+//	BuildAngleTable()
+//
+//	sin(a + d) = sin(a)cos(d) + cos(a)sin(d) and
+//	cos(a + d) = cos(a)cos(d) - sin(a)sin(d) give each angle
+//	from the previous one. The sums run in double and are
+//	reset to exact values every g_AngleResyncSteps, so the
+//	error stays far below the float precision of the table.
+///////////////////////////////////////////////////
+void BuildAngleTable(float start, float end, GLuint steps, std::vector<float>& sines, std::vector<float>& cosines)
+{
+	sines.resize(steps + 1);
+	cosines.resize(steps + 1);
+
+	const double step = (static_cast<double>(end) - start) / std::max(steps, 1u);
+	const double sinStep = std::sin(step);
+	const double cosStep = std::cos(step);
+
+	double s = 0.0;
+	double c = 1.0;
+	for (GLuint i = 0; i <= steps; ++i)
+	{
+		if (i % g_AngleResyncSteps == 0)
+		{
+			double angle = start + step * i;
+			s = std::sin(angle);
+			c = std::cos(angle);
+		}
+		sines[i] = static_cast<float>(s);
+		cosines[i] = static_cast<float>(c);
+
+		double next = s * cosStep + c * sinStep;
+		c = c * cosStep - s * sinStep;
+		s = next;
+	}
+}
+
+///////////////////////////////////////////////////
+//	ParallelForRows()
+///////////////////////////////////////////////////
+void ParallelForRows(GLuint rowCount,
+	GLuint vertexCount,
+	unsigned threadCount,
+	const std::function<void(GLuint firstRow, GLuint endRow)>& body)
+{
+	if (threadCount == 0)
+	{
+		threadCount = GetHardwareThreads();
+	}
+	threadCount = std::min(threadCount, std::max(vertexCount / g_MinVerticesPerThread, 1u));
+	threadCount = std::min(threadCount, std::max(rowCount, 1u));
+
+	if (threadCount <= 1)
+	{
+		body(0, rowCount);
+		return;
+	}
+
+	// the calling thread takes the first block
+	std::vector<std::thread> workers;
+	workers.reserve(threadCount - 1);
+	for (unsigned t = 1; t < threadCount; ++t)
+	{
+		GLuint firstRow = static_cast<GLuint>(static_cast<size_t>(rowCount) * t / threadCount);
+		GLuint endRow = static_cast<GLuint>(static_cast<size_t>(rowCount) * (t + 1) / threadCount);
+		workers.emplace_back(body, firstRow, endRow);
+	}
+	body(0, static_cast<GLuint>(rowCount / threadCount));
+
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+///////////////////////////////////////////////////
+//	BuildSurfaceIndices()
+///////////////////////////////////////////////////
+void BuildSurfaceIndices(const SurfaceGrid& grid, std::vector<GLuint>& indices, unsigned threadCount)
+{
+	const GLuint rowVertices = grid.columns + 1;
+	indices.resize(grid.IndexCount());
+	GLuint* output = indices.data();
+
+	ParallelForRows(grid.rows, grid.VertexCount(), threadCount, [&](GLuint firstRow, GLuint endRow)
+	{
+		GLuint* index = output + static_cast<size_t>(firstRow) * grid.columns * 6;
+		for (GLuint row = firstRow; row < endRow; ++row)
+		{
+			for (GLuint column = 0; column < grid.columns; ++column)
+			{
+				GLuint current = row * rowVertices + column;	// Vertex at (u, v)
+				GLuint next = current + rowVertices;			// Vertex one row further along v
+
+				index[0] = current;
+				index[1] = current + 1;
+				index[2] = next;
+				index[3] = current + 1;
+				index[4] = next + 1;
+				index[5] = next;
+				index += 6;
+			}
+		}
+	});
+}
+
+///////////////////////////////////////////////////
+//	GenerateCylinderSurface()
+///////////////////////////////////////////////////
+void GenerateCylinderSurface(const CylinderSurface& cylinder,
+	GLuint slices,
+	GLuint stacks,
+	MeshData& meshData,
+	std::vector<IndexRange>* parts,
+	unsigned threadCount)
+{
+	MeshData grids[3];
+	GenerateParametricSurface(CapSurface{ cylinder.radius, 0.0f, -1.0f }, CapSurface::Grid(slices), grids[0], threadCount);
+	GenerateParametricSurface(CapSurface{ cylinder.radius, cylinder.height, 1.0f }, CapSurface::Grid(slices), grids[1], threadCount);
+	GenerateParametricSurface(cylinder, CylinderSurface::Grid(slices, stacks), grids[2], threadCount);
+
+	meshData.vertices.clear();
+	meshData.indices.clear();
+	if (parts)
+	{
+		parts->clear();
+	}
+	for (const MeshData& grid : grids)
+	{
+		GLuint baseVertex = meshData.VertexCount();
+		if (parts)
+		{
+			parts->push_back({ meshData.IndexCount(), grid.IndexCount() });
+		}
+		meshData.vertices.insert(meshData.vertices.end(), grid.vertices.begin(), grid.vertices.end());
+		for (GLuint index : grid.indices)
+		{
+			meshData.indices.push_back(baseVertex + index);
+		}
+	}
+}
+
+///////////////////////////////////////////////////
+//	RunParametricSurfaceBenchmark()
+///////////////////////////////////////////////////
+void RunParametricSurfaceBenchmark()
+{
+	BenchmarkSurface("sphere", SphereSurface{ 1.0f }, SphereSurface::Grid(g_BenchmarkRows, g_BenchmarkColumns));
+	BenchmarkSurface("torus", TorusSurface{ 1.0f, 0.2f }, TorusSurface::Grid(g_BenchmarkColumns, g_BenchmarkRows));
+}
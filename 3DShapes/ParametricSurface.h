@@ -0,0 +1,213 @@
+#ifndef PARAMETRIC_SURFACE_H
+#define PARAMETRIC_SURFACE_H
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <functional>
+#include <vector>
+
+#include "MeshData.h"
+
+// Grid coordinates and angles of one vertex of a parametric surface
+struct SurfaceSample
+{
+	float u, v;			// Grid coordinates in [0, 1]
+	float sinU, cosU;	// Sine and cosine of the angle along u
+	float sinV, cosV;	// Sine and cosine of the angle along v
+};
+
+// Resolution and angle ranges of a parametric surface grid
+struct SurfaceGrid
+{
+	GLuint columns;		// Quads along u
+	GLuint rows;		// Quads along v
+	float uAngleStart;	// Angle at u = 0
+	float uAngleEnd;	// Angle at u = 1
+	float vAngleStart;	// Angle at v = 0
+	float vAngleEnd;	// Angle at v = 1
+
+	GLuint VertexCount() const { return (columns + 1) * (rows + 1); }
+	GLuint IndexCount() const { return columns * rows * 6; }
+};
+
+// Sines and cosines of steps + 1 evenly spaced angles from start to end,
+// built with the angle-addition recurrence instead of one sin/cos each
+void BuildAngleTable(float start, float end, GLuint steps, std::vector<float>& sines, std::vector<float>& cosines);
+
+// Runs the body over [0, rowCount) split into one contiguous block of
+// rows per thread; a threadCount of 0 uses every hardware thread, and
+// small grids of fewer than vertexCount vertices per thread stay on one
+void ParallelForRows(GLuint rowCount,
+	GLuint vertexCount,
+	unsigned threadCount,
+	const std::function<void(GLuint firstRow, GLuint endRow)>& body);
+
+// Triangle list indices of the grid, two triangles per quad wound
+// counter-clockwise around the cross product of d/du and d/dv
+void BuildSurfaceIndices(const SurfaceGrid& grid, std::vector<GLuint>& indices, unsigned threadCount = 0);
+
+///////////////////////////////////////////////////
+//	GenerateParametricSurface()
+//
+//	Evaluates a surface over a (columns + 1) x (rows + 1)
+//	vertex grid, the first and last column and row are kept
+//	apart so that the texture coords do not wrap. The surface
+//	is called as
+//
+//	surface(sample, position, normal, uv)
+//
+//	with uv preset to (u, v). The angles come from tables, so
+//	no vertex calls sin or cos, and the rows are written in
+//	parallel straight into the interleaved MeshData buffer.
+///////////////////////////////////////////////////
+template <typename Surface>
+void GenerateParametricSurface(const Surface& surface, const SurfaceGrid& grid, MeshData& meshData, unsigned threadCount = 0)
+{
+	std::vector<float> sinU, cosU, sinV, cosV;
+	BuildAngleTable(grid.uAngleStart, grid.uAngleEnd, grid.columns, sinU, cosU);
+	BuildAngleTable(grid.vAngleStart, grid.vAngleEnd, grid.rows, sinV, cosV);
+
+	const GLuint rowVertices = grid.columns + 1;
+	meshData.vertices.resize(static_cast<size_t>(grid.VertexCount()) * MeshData::FloatsPerVertex);
+	GLfloat* output = meshData.vertices.data();
+
+	ParallelForRows(grid.rows + 1, grid.VertexCount(), threadCount, [&](GLuint firstRow, GLuint endRow)
+	{
+		SurfaceSample sample;
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 uv;
+		for (GLuint row = firstRow; row < endRow; ++row)
+		{
+			sample.v = static_cast<float>(row) / grid.rows;
+			sample.sinV = sinV[row];
+			sample.cosV = cosV[row];
+
+			GLfloat* vertex = output + static_cast<size_t>(row) * rowVertices * MeshData::FloatsPerVertex;
+			for (GLuint column = 0; column < rowVertices; ++column)
+			{
+				sample.u = static_cast<float>(column) / grid.columns;
+				sample.sinU = sinU[column];
+				sample.cosU = cosU[column];
+
+				uv = glm::vec2(sample.u, sample.v);
+				surface(sample, position, normal, uv);
+
+				vertex[0] = position.x;
+				vertex[1] = position.y;
+				vertex[2] = position.z;
+				vertex[3] = normal.x;
+				vertex[4] = normal.y;
+				vertex[5] = normal.z;
+				vertex[6] = uv.x;
+				vertex[7] = uv.y;
+				vertex += MeshData::FloatsPerVertex;
+			}
+		}
+	});
+
+	BuildSurfaceIndices(grid, meshData.indices, threadCount);
+}
+
+// Sphere around the y axis, u runs around it and v from the top pole
+// to the bottom one; u is offset by half a turn and v follows the height,
+// which is the texture mapping the sphere had before
+struct SphereSurface
+{
+	float radius;
+
+	static SurfaceGrid Grid(GLuint stacks, GLuint slices)
+	{
+		return { slices, stacks, 0.0f, glm::two_pi<float>(), 0.0f, glm::pi<float>() };
+	}
+
+	void operator()(const SurfaceSample& s, glm::vec3& position, glm::vec3& normal, glm::vec2& uv) const
+	{
+		normal = glm::vec3(s.cosU * s.sinV, s.cosV, s.sinU * s.sinV);
+		position = radius * normal;
+		uv = glm::vec2(s.u + 0.5f, s.cosV * 0.5f + 0.5f);
+	}
+};
+
+// Torus in the xy plane, u runs around the main ring and v around the tube
+struct TorusSurface
+{
+	float mainRadius;
+	float tubeRadius;
+
+	static SurfaceGrid Grid(GLuint mainSegments, GLuint tubeSegments)
+	{
+		return { mainSegments, tubeSegments, 0.0f, glm::two_pi<float>(), 0.0f, glm::two_pi<float>() };
+	}
+
+	void operator()(const SurfaceSample& s, glm::vec3& position, glm::vec3& normal, glm::vec2&) const
+	{
+		normal = glm::vec3(s.cosV * s.cosU, s.cosV * s.sinU, s.sinV);
+		position = glm::vec3(mainRadius * s.cosU, mainRadius * s.sinU, 0.0f) + tubeRadius * normal;
+	}
+};
+
+// Side of a cylinder around the y axis from y = 0 up to the height, u runs
+// around it and v down from the top rim so that the quads face outward
+struct CylinderSurface
+{
+	float radius;
+	float height;
+
+	static SurfaceGrid Grid(GLuint slices, GLuint stacks)
+	{
+		return { slices, stacks, 0.0f, glm::two_pi<float>(), 0.0f, 0.0f };
+	}
+
+	void operator()(const SurfaceSample& s, glm::vec3& position, glm::vec3& normal, glm::vec2& uv) const
+	{
+		normal = glm::vec3(s.cosU, 0.0f, s.sinU);
+		position = glm::vec3(radius * s.cosU, height * (1.0f - s.v), radius * s.sinU);
+		uv = glm::vec2(s.u, 1.0f - s.v);
+	}
+};
+
+// Flat cap of a cylinder at the given height, v runs out from the center;
+// the bottom cap (facing -1) is mirrored in z so that it faces down, and
+// the texture is mapped as on the caps of the cylinder table
+struct CapSurface
+{
+	float radius;
+	float height;
+	float facing;	// 1 for the top cap, -1 for the bottom one
+
+	static SurfaceGrid Grid(GLuint slices)
+	{
+		return { slices, 1, 0.0f, glm::two_pi<float>(), 0.0f, 0.0f };
+	}
+
+	void operator()(const SurfaceSample& s, glm::vec3& position, glm::vec3& normal, glm::vec2& uv) const
+	{
+		normal = glm::vec3(0.0f, facing, 0.0f);
+		position = glm::vec3(radius * s.v * s.cosU, height, facing * radius * s.v * s.sinU);
+		uv = glm::vec2(0.5f + 0.5f * facing * s.v * s.sinU, 0.5f + 0.5f * s.v * s.cosU);
+	}
+};
+
+///////////////////////////////////////////////////
+//	GenerateCylinderSurface()
+//
+//	A capped cylinder as three grids in one mesh, the
+//	bottom cap, the top cap and the side, in the part order
+//	of the cylinder table. The caps are one ring of quads
+//	whose inner triangles collapse at the center.
+///////////////////////////////////////////////////
+void GenerateCylinderSurface(const CylinderSurface& cylinder,
+	GLuint slices,
+	GLuint stacks,
+	MeshData& meshData,
+	std::vector<IndexRange>* parts = nullptr,
+	unsigned threadCount = 0);
+
+// Times the sphere and torus generators at a few million vertices
+// for 1, 2, 4 ... hardware threads and prints the speedups
+void RunParametricSurfaceBenchmark();
+
+#endif // PARAMETRIC_SURFACE_H
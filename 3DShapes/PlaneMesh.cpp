@@ -1,18 +1,24 @@
 #include "PlaneMesh.h"
+#include "MeshOptimizer.h"
+#include "MeshWelding.h"
+#include <iterator>
 
-namespace
+PlaneMesh::PlaneMesh() : m_PlaneMesh() {}
+
+PlaneMesh::~PlaneMesh()
 {
-	const GLuint g_FloatsPerVertex = 3;	// Number of coordinates per vertex
-	const GLuint g_FloatsPerNormal = 3;	// Number of values per vertex color
-	const GLuint g_FloatsPerUV = 2;		// Number of texture coordinate values
+	glDeleteBuffers(2, m_PlaneMesh.vbos);
 }
 
-PlaneMesh::PlaneMesh() : m_bMemoryLayoutDone(false) {}
-
-PlaneMesh::~PlaneMesh()
+///////////////////////////////////////////////////
+//	ReleasePlaneMesh()
+//	Deletes the buffers and the CPU copy of the mesh.
+///////////////////////////////////////////////////
+void PlaneMesh::ReleasePlaneMesh()
 {
-	glDeleteVertexArrays(1, &m_PlaneMesh.vao);
 	glDeleteBuffers(2, m_PlaneMesh.vbos);
+	m_PlaneMesh = GLMesh();
+	m_MeshData = MeshData();
 }
 
 ///////////////////////////////////////////////////
@@ -38,27 +44,19 @@ void PlaneMesh::CreatePlaneMesh()
 		0,3,2
 	};
 
-	// store vertex and index count
-	m_PlaneMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
-	m_PlaneMesh.nIndices = sizeof(indices) / sizeof(indices[0]);
+	// keep a CPU copy for the shared geometry pool
+	m_MeshData.vertices.assign(std::begin(verts), std::end(verts));
+	m_MeshData.indices.assign(std::begin(indices), std::end(indices));
+	PrintWeldReport("plane", WeldVertices(m_MeshData));
+	PrintVertexCacheReport("plane", OptimizeMesh(m_MeshData));
 
-	// Generate the VAO for the mesh
-	glGenVertexArrays(1, &m_PlaneMesh.vao);
-	glBindVertexArray(m_PlaneMesh.vao);	// activate the VAO
+	// store vertex and index count
+	m_PlaneMesh.nVertices = m_MeshData.VertexCount();
+	m_PlaneMesh.nIndices = m_MeshData.IndexCount();
 
 	// Create VBOs for the mesh
-	glGenBuffers(2, m_PlaneMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_PlaneMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends data to the GPU
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_PlaneMesh.vbos[1]); // Activates the buffer
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
-
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetPlaneMeshMemoryLayout();
-		m_bMemoryLayoutDone = true;
-	}
+	m_PlaneMesh.vbos[0] = CreateBufferData(sizeof(GLfloat) * m_MeshData.vertices.size(), m_MeshData.vertices.data()); // Sends data to the GPU
+	m_PlaneMesh.vbos[1] = CreateBufferData(sizeof(GLuint) * m_MeshData.indices.size(), m_MeshData.indices.data());
 }
 
 ///////////////////////////////////////////////////
@@ -69,26 +67,6 @@ void PlaneMesh::CreatePlaneMesh()
 ///////////////////////////////////////////////////
 void PlaneMesh::DrawPlaneMesh() const
 {
-	glBindVertexArray(m_PlaneMesh.vao);
+	MeshData::Layout::Bind(m_PlaneMesh.vbos[0], m_PlaneMesh.vbos[1]);
 	glDrawElements(GL_TRIANGLES, m_PlaneMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
-	glBindVertexArray(0);
-}
-
-void PlaneMesh::SetPlaneMeshMemoryLayout()
-{
-	// The following code defines the layout of the mesh data in memory - each mesh needs
-	// to have the same memory layout so that the data is retrieved properly by the shaders
-
-	// Strides between vertex coordinates is 6 (x, y, z, r, g, b, a). A tightly packed stride is 0.
-	GLint stride = sizeof(float) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV);// The number of floats before each
-
-	// Create Vertex Attribute Pointers
-	glVertexAttribPointer(0, g_FloatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-	glEnableVertexAttribArray(0);
-
-	glVertexAttribPointer(1, g_FloatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * g_FloatsPerVertex));
-	glEnableVertexAttribArray(1);
-
-	glVertexAttribPointer(2, g_FloatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (g_FloatsPerVertex + g_FloatsPerNormal)));
-	glEnableVertexAttribArray(2);
 }
\ No newline at end of file
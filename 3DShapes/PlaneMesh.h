@@ -4,6 +4,8 @@
 
 #include <GL/glew.h>
 
+#include "MeshData.h"
+
 class PlaneMesh
 {
 public:
@@ -13,22 +15,20 @@ public:
 		~PlaneMesh();
 
 		void CreatePlaneMesh();// method for loading the shape mesh data into memory
+		void ReleasePlaneMesh(); // deletes the buffers and the CPU copy until the next CreatePlaneMesh()
 		void DrawPlaneMesh() const; // method for drawing the shape mesh to the window
+		const MeshData& GetMeshData() const { return m_MeshData; } // CPU copy of the uploaded mesh data
 	
 private:
 			struct GLMesh
 			{
-				GLuint vao;         // Handle for the vertex array object
 				GLuint vbos[2];     // Handles for the vertex buffer objects
 				GLuint nVertices;	// Number of vertices for the mesh
 				GLuint nIndices;    // Number of indices for the mesh
 			};
 
 			GLMesh m_PlaneMesh;
-
-			void SetPlaneMeshMemoryLayout();
-
-			bool m_bMemoryLayoutDone;
+			MeshData m_MeshData; // CPU copy of the uploaded mesh data
 
 };
 #endif // PLANE_MESH_H
@@ -9,21 +9,112 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "ShapeMeshes.h"
+#include "MeshWinding.h"
+#include "Icosphere.h"
+#include "ParametricSurface.h"
+#include "SolidTables.h"
 
 // GLM Math Header inclusions
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/constants.hpp>
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <utility>
 #include <vector>
 namespace
 {
-	// Initialize & precompute pi
-	constexpr float pi = glm::pi<float>();
-	const double M_PI_2 = 1.571428571428571;
-	const GLuint g_FloatsPerVertex = 3;	// Number of coordinates per vertex
-	const GLuint g_FloatsPerNormal = 3;	// Number of values per vertex color
-	const GLuint g_FloatsPerUV = 2;		// Number of texture coordinate values
+	const GLuint g_HeavyMeshIndexCount = 3000;	// Indices from which a mesh gets an occlusion query
+	const GLuint g_MaxLodLevels = 4;			// Levels of detail of a parametric mesh, including the full one
+	const GLuint g_MinLodSegments = 4;			// Grid segments along u or v below which no level is made
+	const float g_SimplifiedLodRatio = 0.25f;	// Triangles each simplified level keeps of the one before
+	const float g_SimplifiedLodMaxError = 0.05f;	// Largest collapse error of a simplified level, in mesh units
+	const GLuint g_MinLodTriangles = 16;		// Triangle count below which no simplified level is made
+	const GLuint g_MeshIdleFrames = 120;		// Frames a mesh goes unused before it may be released
+	const int g_UVSphereStacks = 32;			// Stacks of the UV sphere, it has twice as many slices
+
+	// coarser copies of a parametric surface for the geometry pool,
+	// each level halves both grid resolutions of the one before
+	template <typename Surface>
+	std::vector<MeshData> BuildSurfaceLods(const char* meshName,
+		const Surface& surface,
+		SurfaceGrid grid,
+		bool bNormalizeWinding,
+		WindingReference reference = WindingReference::Center)
+	{
+		std::vector<MeshData> levels;
+		while (levels.size() + 1 < g_MaxLodLevels &&
+			grid.columns / 2 >= g_MinLodSegments && grid.rows / 2 >= g_MinLodSegments)
+		{
+			grid.columns /= 2;
+			grid.rows /= 2;
+
+			MeshData level;
+			GenerateParametricSurface(surface, grid, level);
+			if (bNormalizeWinding)
+			{
+				NormalizeWinding(level.vertices, level.indices, reference);
+			}
+			WeldVertices(level);
+			OptimizeMesh(level);
+
+			std::cout << "INFO: " << meshName << " LOD " << levels.size() + 1 << ": "
+				<< level.IndexCount() / 3 << " triangles" << std::endl;
+			levels.push_back(std::move(level));
+		}
+		return levels;
+	}
+
+	// the bottom, top and sides of the cylinders and the runs of them
+	std::vector<SubmeshRange> BuildCylinderSubmeshes(const MeshData& meshData, const std::vector<IndexRange>& parts)
+	{
+		return {
+			BuildSubmeshRange("bottom", meshData, parts, 0),
+			BuildSubmeshRange("top", meshData, parts, 1),
+			BuildSubmeshRange("sides", meshData, parts, 2),
+			BuildSubmeshRange("caps", meshData, parts, 0, 2),
+			BuildSubmeshRange("top and sides", meshData, parts, 1, 2)
+		};
+	}
+
+	// the two halves of the sphere and the torus
+	std::vector<SubmeshRange> BuildHalfSubmeshes(const MeshData& meshData,
+		const std::vector<IndexRange>& parts,
+		const char* firstName,
+		const char* secondName)
+	{
+		return {
+			BuildSubmeshRange(firstName, meshData, parts, 0),
+			BuildSubmeshRange(secondName, meshData, parts, 1)
+		};
+	}
+
+	// name of the mesh of a shape in the reports
+	const char* GetShapeMeshName(ShapeType shapeType)
+	{
+		switch (shapeType)
+		{
+		case ShapeType::Box: return "box";
+		case ShapeType::Cone: return "cone";
+		case ShapeType::Cylinder: return "cylinder";
+		case ShapeType::Plane: return "plane";
+		case ShapeType::Prism: return "prism";
+		case ShapeType::Tetrahedron: return "tetrahedron";
+		case ShapeType::Pyramid4: return "pyramid4";
+		case ShapeType::Sphere: return "sphere";
+		case ShapeType::TaperedCylinder: return "tapered cylinder";
+		case ShapeType::Torus: return "torus";
+		case ShapeType::Octahedron: return "octahedron";
+		case ShapeType::Decahedron: return "decahedron";
+		case ShapeType::Dodecahedron: return "dodecahedron";
+		case ShapeType::Icosahedron: return "icosahedron";
+		case ShapeType::Imported: return "imported mesh";
+		}
+		return "mesh";
+	}
 }
 
 /*
@@ -63,9 +154,14 @@ ShapeMeshes::ShapeMeshes(std::shared_ptr<BoxMesh> pBoxMesh,
 	: m_pBoxMesh(std::move(pBoxMesh)),
 	m_pConeMesh(std::move(pConeMesh)),
 	m_pPlaneMesh(std::move(pPlaneMesh)),
-	m_pTetrahedronMesh(std::move(pTetrahedronMesh))
+	m_pTetrahedronMesh(std::move(pTetrahedronMesh)),
+	m_pGeometryPool(std::make_shared<GeometryPool>()),
+	m_meshCache("MeshCache"),
+	m_residentMeshBytes(0),
+	m_meshMemoryBudget(0),
+	m_meshFrame(0),
+	m_icosphereSubdivisions(0)
 {
-	m_bMemoryLayoutDone = false;
 }
 
 ///////////////////////////////////////////////////
@@ -75,6 +171,11 @@ ShapeMeshes::ShapeMeshes(std::shared_ptr<BoxMesh> pBoxMesh,
 void ShapeMeshes::LoadBoxMesh()
 {
 	m_pBoxMesh->CreateBoxMesh();
+	UploadQuantizedSolid(ShapeType::Box, GetBoxGeometry());
+	m_bCullBackFaces[ShapeType::Box] = true;
+
+	// keep a CPU copy for the shared geometry pool
+	m_meshData[ShapeType::Box] = GetBoxGeometry().ToMeshData();
 }
 
 ///////////////////////////////////////////////////
@@ -84,6 +185,12 @@ void ShapeMeshes::LoadBoxMesh()
 void ShapeMeshes::LoadConeMesh()
 {
 	m_pConeMesh->CreateConeMesh();
+	m_meshData[ShapeType::Cone] = m_pConeMesh->GetMeshData();
+	m_bCullBackFaces[ShapeType::Cone] = true;
+	m_submeshes[ShapeType::Cone] = {
+		BuildSubmeshRange("bottom", m_pConeMesh->GetMeshData(), m_pConeMesh->GetParts(), 0),
+		BuildSubmeshRange("sides", m_pConeMesh->GetMeshData(), m_pConeMesh->GetParts(), 1)
+	};
 };
 
 ///////////////////////////////////////////////////
@@ -93,7 +200,8 @@ void ShapeMeshes::LoadConeMesh()
 //  store it in a VAO/VBO.  The normals and texture
 //  coordinates are also set.
 //
-//  Correct triangle drawing commands:
+//  The vertices are laid out for these draw commands,
+//  which are turned into one welded triangle list:
 //
 //	glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
 //	glDrawArrays(GL_TRIANGLE_FAN, 36, 36);		//top
@@ -327,27 +435,21 @@ void ShapeMeshes::LoadCylinderMesh()
 		1.0f, 0.0f, 0.0f,		0.993150651f, 0.0f, 0.116841137f,	1.0f, 0.0f
 	};
 
-	glm::vec3 normal;
-
-	normal = CalculateTriangleNormal(glm::vec3(.98f, 1.0f, 0.17f), glm::vec3(.98f, 0.0f, 0.17f), glm::vec3(1.0f, 0.0f, 0.0f));
-
-	// store vertex and index count
-	m_CylinderMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
-	m_CylinderMesh.nIndices = 0;
-
-	// Create VAO
-	glGenVertexArrays(1, &m_CylinderMesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_CylinderMesh.vao);
-
-	// Create VBO
-	glGenBuffers(1, m_CylinderMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_CylinderMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+	// index the fans and the strip, keeping each part drawable on its own
+	std::vector<GLfloat> vertices(std::begin(verts), std::end(verts));
+	std::vector<GLuint> indices;
+	m_CylinderMesh.parts = {
+		AppendTriangleFan(indices, 0, 36),		//bottom
+		AppendTriangleFan(indices, 36, 36),		//top
+		AppendTriangleStrip(indices, 72, 146)	//sides
+	};
+	PrintWindingReport("cylinder", NormalizeWinding(vertices, indices));
+	UploadWeldedMesh(m_CylinderMesh, "cylinder", vertices, indices);
 
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetShaderMemoryLayout();
-	}
+	// keep a CPU copy for the shared geometry pool
+	m_meshData[ShapeType::Cylinder] = MeshData{ vertices, indices };
+	m_bCullBackFaces[ShapeType::Cylinder] = true;
+	m_submeshes[ShapeType::Cylinder] = BuildCylinderSubmeshes(m_meshData[ShapeType::Cylinder], m_CylinderMesh.parts);
 }
 
 ///////////////////////////////////////////////////
@@ -364,6 +466,8 @@ void ShapeMeshes::LoadCylinderMesh()
 void ShapeMeshes::LoadPlaneMesh()
 {
 	m_pPlaneMesh->CreatePlaneMesh();
+	m_meshData[ShapeType::Plane] = m_pPlaneMesh->GetMeshData();
+	m_bCullBackFaces[ShapeType::Plane] = false; // open surface, both sides are visible
 }
 
 ///////////////////////////////////////////////////
@@ -373,7 +477,8 @@ void ShapeMeshes::LoadPlaneMesh()
 //  store it in a VAO/VBO.  The normals and texture
 //  coordinates are also set.
 //
-//	Correct triangle drawing command:
+//	The vertices are laid out for this draw command,
+//	which is turned into a welded triangle list:
 //
 //	glDrawArrays(GL_TRIANGLE_STRIP, 0, meshes.gPrismMesh.nVertices);
 ///////////////////////////////////////////////////
@@ -428,20 +533,16 @@ void ShapeMeshes::LoadPrismMesh()
 
 	};
 
-	m_PrismMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
-
-	glGenVertexArrays(1, &m_PrismMesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_PrismMesh.vao);
-
-	// Create 2 buffers: first one for the vertex data; second one for the indices
-	glGenBuffers(1, m_PrismMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_PrismMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+	// the vertices form one triangle strip
+	std::vector<GLfloat> vertices(std::begin(verts), std::end(verts));
+	std::vector<GLuint> indices;
+	AppendTriangleStrip(indices, 0, static_cast<GLuint>(vertices.size() / MeshData::FloatsPerVertex));
+	PrintWindingReport("prism", NormalizeWinding(vertices, indices));
+	UploadWeldedMesh(m_PrismMesh, "prism", vertices, indices);
 
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetShaderMemoryLayout();
-	}
+	// keep a CPU copy for the shared geometry pool
+	m_meshData[ShapeType::Prism] = MeshData{ vertices, indices };
+	m_bCullBackFaces[ShapeType::Prism] = true;
 }
 
 ///////////////////////////////////////////////////
@@ -452,6 +553,11 @@ void ShapeMeshes::LoadPrismMesh()
 void ShapeMeshes::LoadTetrahedronMesh()
 {
 	m_pTetrahedronMesh->CreateTetrahedronMesh();
+	UploadQuantizedSolid(ShapeType::Tetrahedron, GetTetrahedronGeometry());
+	m_bCullBackFaces[ShapeType::Tetrahedron] = true;
+
+	// keep a CPU copy for the shared geometry pool
+	m_meshData[ShapeType::Tetrahedron] = GetTetrahedronGeometry().ToMeshData();
 }
 
 ///////////////////////////////////////////////////
@@ -461,7 +567,8 @@ void ShapeMeshes::LoadTetrahedronMesh()
 //  vertices and store it in a VAO/VBO.  The normals 
 //  and texture coordinates are also set.
 //
-//  Correct triangle drawing command:
+//  The vertices are laid out for this draw command,
+//  which is turned into a welded triangle list:
 //
 //	glDrawArrays(GL_TRIANGLE_STRIP, 0, meshes.gPyramid4Mesh.nVertices);
 ///////////////////////////////////////////////////
@@ -501,27 +608,24 @@ void ShapeMeshes::LoadPyramid4Mesh()
 		0.0f, 0.5f, 0.0f,		0.0f, 0.0f, 1.0f,	0.5f, 1.0f,		//top point
 	};
 
-	// Calculate total defined vertices
-	m_Pyramid4Mesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
+	// the vertices form one triangle strip
+	std::vector<GLfloat> vertices(std::begin(verts), std::end(verts));
+	std::vector<GLuint> indices;
+	AppendTriangleStrip(indices, 0, static_cast<GLuint>(vertices.size() / MeshData::FloatsPerVertex));
+	PrintWindingReport("pyramid4", NormalizeWinding(vertices, indices));
+	UploadWeldedMesh(m_Pyramid4Mesh, "pyramid4", vertices, indices);
 
-	glGenVertexArrays(1, &m_Pyramid4Mesh.vao);				// Creates 1 VAO
-	glGenBuffers(1, m_Pyramid4Mesh.vbos);					// Creates 1 VBO
-	glBindVertexArray(m_Pyramid4Mesh.vao);					// Activates the VAO
-	glBindBuffer(GL_ARRAY_BUFFER, m_Pyramid4Mesh.vbos[0]);	// Activates the VBO
-	// Sends vertex or coordinate data to the GPU
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW);
-
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetShaderMemoryLayout();
-	}
+	// keep a CPU copy for the shared geometry pool
+	m_meshData[ShapeType::Pyramid4] = MeshData{ vertices, indices };
+	m_bCullBackFaces[ShapeType::Pyramid4] = true;
 }
 
 ///////////////////////////////////////////////////
 //	LoadSphereMesh()
 //
 //	Create a sphere mesh by calculating the vertices and indices from given radius, stack count, slice count, and store it in a VAO/VBO.
-//  The normals and texture coordinates are also set.
+//  The normals and texture coordinates are also set. The rows of the
+//  grid are generated in parallel by the parametric surface engine.
 //
 //  Correct triangle drawing command:
 //
@@ -529,114 +633,84 @@ void ShapeMeshes::LoadPyramid4Mesh()
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadSphereMesh(float radius, int stacks, int slices)
 {
-	// Initialize vertex & index variables from passed parameters
-	int vertexCount = (stacks + 1) * (slices + 1);
-	int indexCount = stacks * slices * 6; // 6 indices per quad
-
-	// Vectors to store vertices & indices
-	std::vector<glm::vec3> vertices(vertexCount);
-	std::vector<GLuint> indices(indexCount);
-
-	// Generate vertices
-	int index = 0;
-	// Outer Stack Loop (Latteral lines)
-	for (int i = 0; i <= stacks; ++i) {
-		float Theta = i * pi / stacks; // Calculate vertical angle in radians from Z-axis
-		float sinTheta = sin(Theta); // sin of angle Theta
-		float cosTheta = cos(Theta); // cosine of angle Theta
-
-		// Inner Slice Loop (Longitudinal lines)
-		for (int j = 0; j <= slices; ++j) {
-			float Phi = j * 2 * pi / slices; // Calculate horizontal angle in radians around Z-axis
-			float sinPhi = sin(Phi); // Sin of angle Phi
-			float cosPhi = cos(Phi); // cosine of angle Phi
-
-			glm::vec3 vertex{};
-			vertex.x = radius * cosPhi * sinTheta; // Determine x position of vertex
-			vertex.y = radius * cosTheta; // Determine y position of vertex
-			vertex.z = radius * sinPhi * sinTheta; // Determine z position of vertex
-
-			vertices[index++] = vertex; // Store vertices in vector
-		}
-	}
+	std::string key = MeshCache::MakeKey("sphere",
+		{ radius, static_cast<float>(stacks), static_cast<float>(slices) });
+	LoadCachedMesh(m_SphereMesh, ShapeType::Sphere, "sphere", key,
+		[&](MeshData& sphereData, std::vector<IndexRange>& parts)
+	{
+		// stacks run from the top pole down, slices around the y axis
+		GenerateParametricSurface(SphereSurface{ radius }, SphereSurface::Grid(stacks, slices), sphereData);
+		std::vector<GLuint>& indices = sphereData.indices;
+
+		PrintWindingReport("sphere", NormalizeWinding(sphereData.vertices, indices));
+
+		// the upper and lower halves are kept apart for the "upper half" and "lower half" submeshes,
+		// welding drops the triangles that collapse at the poles
+		parts = {
+			{ 0, static_cast<GLuint>(indices.size() / 2) },
+			{ static_cast<GLuint>(indices.size() / 2), static_cast<GLuint>(indices.size() - indices.size() / 2) }
+		};
+	});
+
+	// the winding is made consistent, but the sphere is also viewed
+	// from the inside as the sky dome, so its back faces are kept
+	m_bCullBackFaces[ShapeType::Sphere] = false;
+	m_submeshes[ShapeType::Sphere] = BuildHalfSubmeshes(m_meshData[ShapeType::Sphere], m_SphereMesh.parts, "upper half", "lower half");
+
+	// coarser levels for spheres that cover few pixels
+	m_lodMeshData[ShapeType::Sphere] = BuildSurfaceLods("sphere", SphereSurface{ radius }, SphereSurface::Grid(stacks, slices), true);
+	m_surfaces[ShapeType::Sphere] = { SurfaceComputeManager::SURFACE_TYPE::Sphere, glm::vec2(radius, 0.0f),
+		static_cast<GLuint>(slices), static_cast<GLuint>(stacks) };
+
+	// clusters for culling parts of large spheres such as the sky dome
+	BuildMeshletMesh(ShapeType::Sphere, m_SphereMesh.vbos[0], m_meshData[ShapeType::Sphere]);
+}
 
-	// Generate Traingles for sphere mesh.
-	// Generate indices
-	index = 0;
-	// Outer foor loop (Latteral lines)
-	for (int i = 0; i < stacks; ++i) {
-		// Inner for loop (Longitudinal lines)
-		for (int j = 0; j < slices; ++j) {
-			int current = i * (slices + 1) + j; // Current vertex in the vector array
-			int next = current + slices + 1; // Next vertex is directly below current vertex in the next stack
-
-			// Form First Triangle from current stack & slice
-			indices[index++] = current; // Current vertex
-			indices[index++] = next; // Adjacent vertex
-			indices[index++] = current + 1; // Corresponding vertex in next stack
-
-			// Form Second Triangle from current stack & slice
-			indices[index++] = next; // Next vertex in the next stack
-			indices[index++] = next + 1; // Adjacent vertex in next stack
-			indices[index++] = current + 1; // Corresponding vertex in current stack
-		}
-	}
 
-	// Store vertex and index count
-	m_SphereMesh.nVertices = vertices.size();
-	m_SphereMesh.nIndices = indices.size();
+///////////////////////////////////////////////////
+//	LoadIcosphereMesh()
+//
+//	Create the sphere mesh as a subdivided icosahedron,
+//  in place of LoadSphereMesh(). Its triangles are
+//  nearly even in size, so it reaches the accuracy of
+//  the UV sphere with fewer of them, see
+//  RunIcosphereBenchmark(). The normals, texture coords
+//  and upper and lower halves match the UV sphere.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadIcosphereMesh(float radius, int subdivisions)
+{
+	std::string key = MeshCache::MakeKey("icosphere", { radius, static_cast<float>(subdivisions) });
+	LoadCachedMesh(m_SphereMesh, ShapeType::Sphere, "icosphere", key,
+		[&](MeshData& sphereData, std::vector<IndexRange>& parts)
+	{
+		GenerateIcosphere(radius, subdivisions, sphereData, &parts);
+		PrintWindingReport("icosphere", NormalizeWinding(sphereData.vertices, sphereData.indices));
+	});
 
-	glm::vec3 normal;
-	glm::vec3 center(0.0f, 0.0f, 0.0f);
-	std::vector<GLfloat> combined_values;
-	combined_values.reserve(vertices.size() * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV)); // Reserve space for combined values (this avoids multiple reallocations during the push_back operation)
+	// viewed from the inside as the sky dome too
+	m_bCullBackFaces[ShapeType::Sphere] = false;
+	m_submeshes[ShapeType::Sphere] = BuildHalfSubmeshes(m_meshData[ShapeType::Sphere], m_SphereMesh.parts, "upper half", "lower half");
 
-	// Combine interleaved vertices, normals, and texture coords
-	for (const auto& vert : vertices)
+	// coarser levels are the lower subdivisions, down to the first
+	std::vector<MeshData> levels;
+	for (int level = subdivisions - 1; level >= 1 && levels.size() + 1 < g_MaxLodLevels; --level)
 	{
-		normal = glm::normalize(vert - center);
-
-		// Calculate UV coordinates based on spherical coordinates
-		float u = atan2(normal.z, normal.x) / (2 * pi) + 0.5f;
-		float v = normal.y * 0.5f + 0.5f;
-
-		combined_values.push_back(vert.x);
-		combined_values.push_back(vert.y);
-		combined_values.push_back(vert.z);
-		combined_values.push_back(normal.x);
-		combined_values.push_back(normal.y);
-		combined_values.push_back(normal.z);
-		combined_values.push_back(u);
-		combined_values.push_back(v);
+		MeshData lod;
+		GenerateIcosphere(radius, level, lod);
+		NormalizeWinding(lod.vertices, lod.indices);
+		WeldVertices(lod);
+		OptimizeMesh(lod);
+
+		std::cout << "INFO: icosphere LOD " << levels.size() + 1 << ": "
+			<< lod.IndexCount() / 3 << " triangles" << std::endl;
+		levels.push_back(std::move(lod));
 	}
+	m_lodMeshData[ShapeType::Sphere] = std::move(levels);
 
-	// Create VAO
-	glGenVertexArrays(1, &m_SphereMesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_SphereMesh.vao);
+	// the compute shader only writes grids, so the icosphere stays a CPU mesh
+	m_surfaces.erase(ShapeType::Sphere);
 
-	// Create VBOs
-	glGenBuffers(2, m_SphereMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_SphereMesh.vbos[0]); // Activates the vertex buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_SphereMesh.vbos[1]); // Activates the index buffer
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
-
-	// Specify vertex attribute pointers
-	glVertexAttribPointer(0, g_FloatsPerVertex, GL_FLOAT, GL_FALSE, (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV) * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0); // Vertex position
-	glVertexAttribPointer(1, g_FloatsPerNormal, GL_FLOAT, GL_FALSE, (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV) * sizeof(GLfloat), (GLvoid*)(g_FloatsPerVertex * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1); // Normal
-	glVertexAttribPointer(2, g_FloatsPerUV, GL_FLOAT, GL_FALSE, (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV) * sizeof(GLfloat), (GLvoid*)((g_FloatsPerVertex + g_FloatsPerNormal) * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2); // Texture coordinates
-
-	// Unbind VAO
-	glBindVertexArray(0);
-
-	if (!m_bMemoryLayoutDone)
-	{
-		SetShaderMemoryLayout();
-	}
+	BuildMeshletMesh(ShapeType::Sphere, m_SphereMesh.vbos[0], m_meshData[ShapeType::Sphere]);
 }
 
 
@@ -647,10 +721,11 @@ void ShapeMeshes::LoadSphereMesh(float radius, int stacks, int slices)
 //  vertices and store it in a VAO/VBO.  The normals 
 //  and texture coordinates are also set.
 //
-//  Correct triangle drawing commands:
+//  The vertices are laid out for these draw commands,
+//  which are turned into one welded triangle list:
 //
 //	glDrawArrays(GL_TRIANGLE_FAN, 0, 36);		//bottom
-//	glDrawArrays(GL_TRIANGLE_FAN, 36, 72);		//top
+//	glDrawArrays(GL_TRIANGLE_FAN, 36, 36);		//top
 //	glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadTaperedCylinderMesh()
@@ -881,23 +956,21 @@ void ShapeMeshes::LoadTaperedCylinderMesh()
 		1.0f, 0.0f, 0.0f,		0.993150651f, 0.5f, 0.116841137f,	1.0, 0.0
 	};
 
-	// store vertex and index count
-	m_TaperedCylinderMesh.nVertices = sizeof(verts) / (sizeof(verts[0]) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV));
-	m_TaperedCylinderMesh.nIndices = 0;
-
-	// Create VAO
-	glGenVertexArrays(1, &m_TaperedCylinderMesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_TaperedCylinderMesh.vao);
-
-	// Create VBO
-	glGenBuffers(1, m_TaperedCylinderMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_TaperedCylinderMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(verts), verts, GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
+	// index the fans and the strip, keeping each part drawable on its own
+	std::vector<GLfloat> vertices(std::begin(verts), std::end(verts));
+	std::vector<GLuint> indices;
+	m_TaperedCylinderMesh.parts = {
+		AppendTriangleFan(indices, 0, 36),		//bottom
+		AppendTriangleFan(indices, 36, 36),		//top
+		AppendTriangleStrip(indices, 72, 146)	//sides
+	};
+	PrintWindingReport("tapered cylinder", NormalizeWinding(vertices, indices));
+	UploadWeldedMesh(m_TaperedCylinderMesh, "tapered cylinder", vertices, indices);
 
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetShaderMemoryLayout();
-	}
+	// keep a CPU copy for the shared geometry pool
+	m_meshData[ShapeType::TaperedCylinder] = MeshData{ vertices, indices };
+	m_bCullBackFaces[ShapeType::TaperedCylinder] = true;
+	m_submeshes[ShapeType::TaperedCylinder] = BuildCylinderSubmeshes(m_meshData[ShapeType::TaperedCylinder], m_TaperedCylinderMesh.parts);
 }
 
 ///////////////////////////////////////////////////
@@ -907,9 +980,8 @@ void ShapeMeshes::LoadTaperedCylinderMesh()
 //  store it in a VAO/VBO.  The normals and texture
 //  coordinates are also set.
 //
-//	Correct triangle drawing command:
-//
-//	glDrawArrays(GL_TRIANGLES, 0, meshes.gTorusMesh.nVertices);
+//	The grid is generated in parallel by the parametric
+//	surface engine, two triangles per quad, and then welded.
 ///////////////////////////////////////////////////
 void ShapeMeshes::LoadTorusMesh(float thickness)
 {
@@ -923,386 +995,393 @@ void ShapeMeshes::LoadTorusMesh(float thickness)
 		_tubeRadius = thickness;
 	}
 
-	auto mainSegmentAngleStep = glm::radians(360.0f / float(_mainSegments));
-	auto tubeSegmentAngleStep = glm::radians(360.0f / float(_tubeSegments));
+	std::string key = MeshCache::MakeKey("torus", { _mainRadius, _tubeRadius,
+		static_cast<float>(_mainSegments), static_cast<float>(_tubeSegments) });
+	LoadCachedMesh(m_TorusMesh, ShapeType::Torus, "torus", key,
+		[&](MeshData& torusData, std::vector<IndexRange>& parts)
+	{
+		// the main segments run along u, so the first half of the
+		// indices is the "first half" submesh of the ring
+		GenerateParametricSurface(TorusSurface{ _mainRadius, _tubeRadius }, TorusSurface::Grid(_mainSegments, _tubeSegments), torusData);
+
+		// the torus is not star-shaped, its normals tell the outside
+		PrintWindingReport("torus", NormalizeWinding(torusData.vertices, torusData.indices, WindingReference::Normals));
+
+		GLuint halfIndexCount = torusData.IndexCount() / 2;
+		halfIndexCount -= halfIndexCount % 3;
+		parts = {
+			{ 0, halfIndexCount },
+			{ halfIndexCount, torusData.IndexCount() - halfIndexCount }
+		};
+	});
+
+	m_bCullBackFaces[ShapeType::Torus] = true;
+	m_submeshes[ShapeType::Torus] = BuildHalfSubmeshes(m_meshData[ShapeType::Torus], m_TorusMesh.parts, "first half", "second half");
+
+	// coarser levels for tori that cover few pixels
+	m_lodMeshData[ShapeType::Torus] = BuildSurfaceLods("torus", TorusSurface{ _mainRadius, _tubeRadius },
+		TorusSurface::Grid(_mainSegments, _tubeSegments), true, WindingReference::Normals);
+	m_surfaces[ShapeType::Torus] = { SurfaceComputeManager::SURFACE_TYPE::Torus, glm::vec2(_mainRadius, _tubeRadius),
+		static_cast<GLuint>(_mainSegments), static_cast<GLuint>(_tubeSegments) };
+}
 
-	std::vector<glm::vec3> vertex_list;
-	std::vector<std::vector<glm::vec3>> segments_list;
-	std::vector<glm::vec2> texture_coords;
-	glm::vec3 center(0.0f, 0.0f, 0.0f);
-	glm::vec3 normal;
-	glm::vec3 vertex;
-	glm::vec2 text_coord;
+///////////////////////////////////////////////////
+//	LoadOctahedronMesh()
+//
+//	Upload the octahedron from its compile-time table,
+//	its six vertices are shared between the faces.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadOctahedronMesh()
+{
+	LoadSolidMesh(m_OctahedronMesh, ShapeType::Octahedron, GetOctahedronGeometry());
+}
 
-	// generate the torus vertices
-	auto currentMainSegmentAngle = 0.0f;
-	for (auto i = 0; i < _mainSegments; i++)
-	{
-		// Calculate sine and cosine of main segment angle
-		auto sinMainSegment = sin(currentMainSegmentAngle);
-		auto cosMainSegment = cos(currentMainSegmentAngle);
-		auto currentTubeSegmentAngle = 0.0f;
-		std::vector<glm::vec3> segment_points;
-		for (auto j = 0; j < _tubeSegments; j++)
-		{
-			// Calculate sine and cosine of tube segment angle
-			auto sinTubeSegment = sin(currentTubeSegmentAngle);
-			auto cosTubeSegment = cos(currentTubeSegmentAngle);
+///////////////////////////////////////////////////
+//	LoadDecahedronMesh()
+//
+//	Upload the pentagonal bipyramid from its compile-time table.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadDecahedronMesh()
+{
+	LoadSolidMesh(m_DecahedronMesh, ShapeType::Decahedron, GetDecahedronGeometry());
+}
 
-			// Calculate vertex position on the surface of torus
-			auto surfacePosition = glm::vec3(
-				(_mainRadius + _tubeRadius * cosTubeSegment) * cosMainSegment,
-				(_mainRadius + _tubeRadius * cosTubeSegment) * sinMainSegment,
-				_tubeRadius * sinTubeSegment);
+///////////////////////////////////////////////////
+//	LoadDodecahedronMesh()
+//
+//	Upload the dodecahedron from its compile-time table,
+//	twelve flat pentagons around a sphere of radius 1.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadDodecahedronMesh()
+{
+	LoadSolidMesh(m_DodecahedronMesh, ShapeType::Dodecahedron, GetDodecahedronGeometry());
+}
 
-			//vertex_list.push_back(surfacePosition);
-			segment_points.push_back(surfacePosition);
+///////////////////////////////////////////////////
+//	LoadIcosahedronMesh()
+//
+//	Upload the icosahedron from its compile-time table,
+//	twenty flat triangles around a sphere of radius 1.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadIcosahedronMesh()
+{
+	LoadSolidMesh(m_IcosahedronMesh, ShapeType::Icosahedron, GetIcosahedronGeometry());
+}
 
-			// Update current tube angle
-			currentTubeSegmentAngle += tubeSegmentAngleStep;
-		}
-		segments_list.push_back(segment_points);
-		segment_points.clear();
+///////////////////////////////////////////////////
+//	LoadImportedMesh()
+//
+//	Import a mesh file and fit it into the unit sphere, so
+//	that it can be placed like the other shapes. The winding
+//	of an imported file is not known, so its back faces are
+//	kept. Simplified levels of detail and meshlets are built
+//	as for the large generated meshes.
+///////////////////////////////////////////////////
+bool ShapeMeshes::LoadImportedMesh(const std::string& path)
+{
+	MeshData meshData;
+	ImportReport report;
+	if (!ImportMesh(path, meshData, &report))
+	{
+		return false;
+	}
+	PrintImportReport(path.c_str(), report);
+	if (meshData.indices.empty())
+	{
+		std::cerr << "Failed to import mesh " << path << ": no triangles" << std::endl;
+		return false;
+	}
 
-		// Update main segment angle
-		currentMainSegmentAngle += mainSegmentAngleStep;
+	// center the bounding box on the origin and scale the farthest vertex to 1
+	glm::vec3 minimum(std::numeric_limits<float>::max());
+	glm::vec3 maximum(-std::numeric_limits<float>::max());
+	for (size_t i = 0; i < meshData.vertices.size(); i += MeshData::FloatsPerVertex)
+	{
+		glm::vec3 position(meshData.vertices[i], meshData.vertices[i + 1], meshData.vertices[i + 2]);
+		minimum = glm::min(minimum, position);
+		maximum = glm::max(maximum, position);
+	}
+	glm::vec3 center = (minimum + maximum) * 0.5f;
+	float radius = 0.0f;
+	for (size_t i = 0; i < meshData.vertices.size(); i += MeshData::FloatsPerVertex)
+	{
+		glm::vec3 position(meshData.vertices[i], meshData.vertices[i + 1], meshData.vertices[i + 2]);
+		radius = std::max(radius, glm::length(position - center));
+	}
+	float scale = radius > 0.0f ? 1.0f / radius : 1.0f;
+	for (size_t i = 0; i < meshData.vertices.size(); i += MeshData::FloatsPerVertex)
+	{
+		meshData.vertices[i] = (meshData.vertices[i] - center.x) * scale;
+		meshData.vertices[i + 1] = (meshData.vertices[i + 1] - center.y) * scale;
+		meshData.vertices[i + 2] = (meshData.vertices[i + 2] - center.z) * scale;
 	}
 
-	float horizontalStep = 1.0f / _mainSegments;
-	float verticalStep = 1.0f / _tubeSegments;
-	float u = 0.0;
-	float v = 0.0;
+	m_ImportedMesh.parts.clear();
+	UploadWeldedMesh(m_ImportedMesh, "imported mesh", meshData.vertices, meshData.indices);
+	m_bCullBackFaces[ShapeType::Imported] = false;
 
-	// connect the various segments together, forming triangles
-	for (int i = 0; i < _mainSegments; i++)
-	{
-		for (int j = 0; j < _tubeSegments; j++)
-		{
-			if (((i + 1) < _mainSegments) && ((j + 1) < _tubeSegments))
-			{
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i][j + 1]);
-				texture_coords.push_back(glm::vec2(u, v + verticalStep));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v + verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-				vertex_list.push_back(segments_list[i + 1][j]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-				vertex_list.push_back(segments_list[i + 1][j + 1]);
-				texture_coords.push_back(glm::vec2(u + horizontalStep, v - verticalStep));
-				vertex_list.push_back(segments_list[i][j]);
-				texture_coords.push_back(glm::vec2(u, v));
-			}
-			else
-			{
-				if (((i + 1) == _mainSegments) && ((j + 1) == _tubeSegments))
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][0]);
-					texture_coords.push_back(glm::vec2(0, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((i + 1) == _mainSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][j + 1]);
-					texture_coords.push_back(glm::vec2(u, v + verticalStep));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[0][j]);
-					texture_coords.push_back(glm::vec2(0, v));
-					vertex_list.push_back(segments_list[0][j + 1]);
-					texture_coords.push_back(glm::vec2(0, v + verticalStep));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
-				else if ((j + 1) == _tubeSegments)
-				{
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i][0]);
-					texture_coords.push_back(glm::vec2(u, 0));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-					vertex_list.push_back(segments_list[i + 1][j]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, v));
-					vertex_list.push_back(segments_list[i + 1][0]);
-					texture_coords.push_back(glm::vec2(u + horizontalStep, 0));
-					vertex_list.push_back(segments_list[i][j]);
-					texture_coords.push_back(glm::vec2(u, v));
-				}
+	// keep a CPU copy for the shared geometry pool
+	m_meshData[ShapeType::Imported] = std::move(meshData);
 
-			}
-			v += verticalStep;
-		}
-		v = 0.0;
-		u += horizontalStep;
+	// the simplified levels are cached under a hash of the fitted buffers
+	LoadSimplifiedLods(ShapeType::Imported, "imported mesh", "imported_lod");
+
+	BuildMeshletMesh(ShapeType::Imported, m_ImportedMesh.vbos[0], m_meshData[ShapeType::Imported]);
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	RequireMesh()
+//
+//	Marks the mesh of the shape as used in this frame,
+//	loading it first when it is not resident. A shape
+//	whose mesh fails to load is not tried again, so its
+//	draws are skipped instead of using empty buffers.
+///////////////////////////////////////////////////
+bool ShapeMeshes::RequireMesh(ShapeType shapeType)
+{
+	auto resident = m_residentMeshes.find(shapeType);
+	if (resident != m_residentMeshes.end())
+	{
+		resident->second.lastUsedFrame = m_meshFrame;
+		return true;
+	}
+	if (m_failedMeshes.count(shapeType) != 0 || !LoadShapeMesh(shapeType))
+	{
+		m_failedMeshes.insert(shapeType);
+		return false;
 	}
 
-	std::vector<GLfloat> combined_values;
+	size_t gpuBytes = MeasureMeshBytes(shapeType);
+	m_residentMeshes[shapeType] = { gpuBytes, m_meshFrame };
+	m_residentMeshBytes += gpuBytes;
+	return true;
+}
 
-	// combine interleaved vertices, normals, and texture coords
-	for (int i = 0; i < vertex_list.size(); i++)
+///////////////////////////////////////////////////
+//	LoadShapeMesh()
+//
+//	The box, plane, tetrahedron, sphere and polyhedra are
+//	drawn from quantized vertices, the solids from the
+//	copies in their tables and the plane and sphere
+//	quantized here. The cone, cylinders, prism, pyramid,
+//	torus and imported mesh keep their float vertices.
+///////////////////////////////////////////////////
+bool ShapeMeshes::LoadShapeMesh(ShapeType shapeType)
+{
+	switch (shapeType)
 	{
-		vertex = vertex_list[i];
-		normal = normalize(vertex);
-		if (vertex.x < 0)
-		{
-			if (normal.x > 0)
-				normal.x *= -1;
-		}
-		else if (vertex.x > 0)
-		{
-			if (normal.x < 0)
-				normal.x *= -1;
-		}
-		if (vertex.y < 0)
+	case ShapeType::Box:
+		LoadBoxMesh();
+		return true;
+	case ShapeType::Cone:
+		LoadConeMesh();
+		return true;
+	case ShapeType::Cylinder:
+		LoadCylinderMesh();
+		return true;
+	case ShapeType::Plane:
+		LoadPlaneMesh();
+		break;
+	case ShapeType::Prism:
+		LoadPrismMesh();
+		return true;
+	case ShapeType::Tetrahedron:
+		LoadTetrahedronMesh();
+		return true;
+	case ShapeType::Pyramid4:
+		LoadPyramid4Mesh();
+		return true;
+	case ShapeType::Sphere:
+		if (m_icosphereSubdivisions > 0)
 		{
-			if (normal.y > 0)
-				normal.y *= -1;
+			LoadIcosphereMesh(1, m_icosphereSubdivisions);
 		}
-		else if (vertex.y > 0)
+		else
 		{
-			if (normal.y < 0)
-				normal.y *= -1;
+			LoadSphereMesh(1, g_UVSphereStacks, g_UVSphereStacks * 2);
 		}
-		if (vertex.z < 0)
-		{
-			if (normal.z > 0)
-				normal.z *= -1;
-		}
-		else if (vertex.z > 0)
-		{
-			if (normal.z < 0)
-				normal.z *= -1;
-		}
-		text_coord = texture_coords[i];
-		combined_values.push_back(vertex.x);
-		combined_values.push_back(vertex.y);
-		combined_values.push_back(vertex.z);
-		combined_values.push_back(normal.x);
-		combined_values.push_back(normal.y);
-		combined_values.push_back(normal.z);
-		combined_values.push_back(text_coord.x);
-		combined_values.push_back(text_coord.y);
-	}
-
-	// store vertex and index count
-	m_TorusMesh.nVertices = vertex_list.size();
-	m_TorusMesh.nIndices = 0;
-
-	// Create VAO
-	glGenVertexArrays(1, &m_TorusMesh.vao); // we can also generate multiple VAOs or buffers at the same time
-	glBindVertexArray(m_TorusMesh.vao);
-
-	// Create VBOs
-	glGenBuffers(1, m_TorusMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_TorusMesh.vbos[0]); // Activates the buffer
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW); // Sends vertex or coordinate data to the GPU
-
-	if (m_bMemoryLayoutDone == false)
-	{
-		SetShaderMemoryLayout();
+		break;
+	case ShapeType::TaperedCylinder:
+		LoadTaperedCylinderMesh();
+		return true;
+	case ShapeType::Torus:
+		LoadTorusMesh();
+		return true;
+	case ShapeType::Octahedron:
+		LoadOctahedronMesh();
+		return true;
+	case ShapeType::Decahedron:
+		LoadDecahedronMesh();
+		return true;
+	case ShapeType::Dodecahedron:
+		LoadDodecahedronMesh();
+		return true;
+	case ShapeType::Icosahedron:
+		LoadIcosahedronMesh();
+		return true;
+	case ShapeType::Imported:
+		return !m_importedMeshPath.empty() && LoadImportedMesh(m_importedMeshPath);
+	default:
+		return false;
 	}
+	return QuantizeMesh(shapeType, GetShapeMeshName(shapeType));
 }
 
-void ShapeMeshes::LoadOctahedronMesh()
+///////////////////////////////////////////////////
+//	ReleaseMesh()
+//
+//	Deletes the buffers and CPU copies of a loaded mesh,
+//	it is loaded again, mostly from the mesh cache, when
+//	its shape is next required. The geometry pool keeps
+//	its own copy, so pooled draws are not affected.
+///////////////////////////////////////////////////
+void ShapeMeshes::ReleaseMesh(ShapeType shapeType)
 {
-	// Define the vertices for the Octahedron
-	std::vector<glm::vec3> vertices = {
-		glm::vec3(0.0f, 1.0f, 0.0f), // Top vertex
-		glm::vec3(1.0f, 0.0f, 0.0f), // Front vertex
-		glm::vec3(0.0f, 0.0f, 1.0f), // Right vertex
-		glm::vec3(-1.0f, 0.0f, 0.0f), // Back vertex
-		glm::vec3(0.0f, 0.0f, -1.0f), // Left vertex
-		glm::vec3(0.0f, -1.0f, 0.0f) // Bottom vertex
-	};
-
-	std::vector<GLuint> indices = {
-		0, 1, 2, 0, 2, 3, 0, 3, 4, 0, 4, 1, // Top pyramid
-		5, 1, 2, 5, 2, 3, 5, 3, 4, 5, 4, 1  // Bottom pyramid
-	};
-
-	// Define UV coordinates for each vertex
-	std::vector<glm::vec2> uvs = {
-		glm::vec2(0.5f, 1.0f), // Top vertex
-		glm::vec2(1.0f, 0.5f), // Front vertex
-		glm::vec2(0.5f, 0.0f), // Right vertex
-		glm::vec2(0.0f, 0.5f), // Back vertex
-		glm::vec2(0.5f, 0.5f), // Left vertex
-		glm::vec2(0.5f, 0.5f)  // Bottom vertex
-	};
+	auto resident = m_residentMeshes.find(shapeType);
+	if (resident == m_residentMeshes.end())
+	{
+		return;
+	}
 
-	std::vector<GLfloat> combined_values;
-	for (GLuint index : indices)
+	GLMesh* pMesh = GetGLMesh(shapeType);
+	if (pMesh)
 	{
-		glm::vec3 vertex = vertices[index];
-		glm::vec3 normal = glm::normalize(vertex);
-		glm::vec2 uv = uvs[index];
-
-		combined_values.push_back(vertex.x);
-		combined_values.push_back(vertex.y);
-		combined_values.push_back(vertex.z);
-		combined_values.push_back(normal.x);
-		combined_values.push_back(normal.y);
-		combined_values.push_back(normal.z);
-		combined_values.push_back(uv.x);
-		combined_values.push_back(uv.y);
+		glDeleteBuffers(2, pMesh->vbos);
+		*pMesh = GLMesh();
 	}
 
-	m_OctahedronMesh.nVertices = combined_values.size() / 8;
-	m_OctahedronMesh.nIndices = indices.size();
+	// the box, cone, plane and tetrahedron keep their buffers in their own classes
+	switch (shapeType)
+	{
+	case ShapeType::Box:
+		m_pBoxMesh->ReleaseBoxMesh();
+		break;
+	case ShapeType::Cone:
+		m_pConeMesh->ReleaseConeMesh();
+		break;
+	case ShapeType::Plane:
+		m_pPlaneMesh->ReleasePlaneMesh();
+		break;
+	case ShapeType::Tetrahedron:
+		m_pTetrahedronMesh->ReleaseTetrahedronMesh();
+		break;
+	default:
+		break;
+	}
 
-	glGenVertexArrays(1, &m_OctahedronMesh.vao);
-	glBindVertexArray(m_OctahedronMesh.vao);
+	auto quantizedMesh = m_quantizedMeshes.find(shapeType);
+	if (quantizedMesh != m_quantizedMeshes.end())
+	{
+		glDeleteBuffers(2, quantizedMesh->second.vbos);
+		m_quantizedMeshes.erase(quantizedMesh);
+	}
+	auto meshletMesh = m_meshletMeshes.find(shapeType);
+	if (meshletMesh != m_meshletMeshes.end())
+	{
+		glDeleteBuffers(1, &meshletMesh->second.ebo);
+		m_meshletMeshes.erase(meshletMesh);
+	}
 
-	glGenBuffers(1, m_OctahedronMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_OctahedronMesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * combined_values.size(), combined_values.data(), GL_STATIC_DRAW);
+	m_meshData.erase(shapeType);
+	m_lodMeshData.erase(shapeType);
+	m_surfaces.erase(shapeType);
+	m_submeshes.erase(shapeType);
 
-	glEnableVertexAttribArray(0); // Position
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
+	m_residentMeshBytes -= resident->second.gpuBytes;
+	m_residentMeshes.erase(resident);
+}
 
-	glEnableVertexAttribArray(1); // Normal
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
+///////////////////////////////////////////////////
+//	BeginMeshFrame()
+//
+//	Starts a new frame of the registry. While the loaded
+//	meshes take more than the memory budget, the one used
+//	longest ago is released, as long as it has been idle
+//	for g_MeshIdleFrames so that no mesh is reloaded on
+//	every other frame.
+///////////////////////////////////////////////////
+void ShapeMeshes::BeginMeshFrame()
+{
+	m_meshFrame++;
+	while (m_meshMemoryBudget > 0 && m_residentMeshBytes > m_meshMemoryBudget)
+	{
+		auto idlest = m_residentMeshes.end();
+		for (auto resident = m_residentMeshes.begin(); resident != m_residentMeshes.end(); ++resident)
+		{
+			if (m_meshFrame - resident->second.lastUsedFrame < g_MeshIdleFrames)
+			{
+				continue;
+			}
+			if (idlest == m_residentMeshes.end() || resident->second.lastUsedFrame < idlest->second.lastUsedFrame)
+			{
+				idlest = resident;
+			}
+		}
+		if (idlest == m_residentMeshes.end())
+		{
+			break;
+		}
 
-	glEnableVertexAttribArray(2); // Texture Coordinate
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
+		std::cout << "INFO: released the " << GetShapeMeshName(idlest->first) << ", "
+			<< idlest->second.gpuBytes << " bytes, unused for " << m_meshFrame - idlest->second.lastUsedFrame
+			<< " frames" << std::endl;
+		ReleaseMesh(idlest->first);
+	}
+}
 
-	if (!m_bMemoryLayoutDone)
+///////////////////////////////////////////////////
+//	GetGLMesh()
+///////////////////////////////////////////////////
+ShapeMeshes::GLMesh* ShapeMeshes::GetGLMesh(ShapeType shapeType)
+{
+	switch (shapeType)
 	{
-		SetShaderMemoryLayout();
+	case ShapeType::Cylinder: return &m_CylinderMesh;
+	case ShapeType::Prism: return &m_PrismMesh;
+	case ShapeType::Pyramid4: return &m_Pyramid4Mesh;
+	case ShapeType::Sphere: return &m_SphereMesh;
+	case ShapeType::TaperedCylinder: return &m_TaperedCylinderMesh;
+	case ShapeType::Torus: return &m_TorusMesh;
+	case ShapeType::Octahedron: return &m_OctahedronMesh;
+	case ShapeType::Decahedron: return &m_DecahedronMesh;
+	case ShapeType::Dodecahedron: return &m_DodecahedronMesh;
+	case ShapeType::Icosahedron: return &m_IcosahedronMesh;
+	case ShapeType::Imported: return &m_ImportedMesh;
+	default: return nullptr;
 	}
-
-	glBindVertexArray(0);
 }
 
-void ShapeMeshes::LoadDecahedronMesh()
+const ShapeMeshes::GLMesh* ShapeMeshes::GetGLMesh(ShapeType shapeType) const
 {
-	// Define the vertices for the Decahedron
-	float radius = 1.0f;
-	constexpr float angle = 2 * pi / 5.0f;
-	float height = sqrt(radius * radius - (2 * radius * sin(pi / 5.0f) / 2) * (2 * radius * sin(pi / 5.0f) / 2));
+	return const_cast<ShapeMeshes*>(this)->GetGLMesh(shapeType);
+}
 
-	std::vector<glm::vec3> baseVertices;
-	for (int i = 0; i < 5; ++i)
+///////////////////////////////////////////////////
+//	MeasureMeshBytes()
+///////////////////////////////////////////////////
+size_t ShapeMeshes::MeasureMeshBytes(ShapeType shapeType) const
+{
+	auto entry = m_meshData.find(shapeType);
+	if (entry == m_meshData.end())
 	{
-		float theta = i * angle;
-		float x = radius * cos(theta);
-		float y = radius * sin(theta);
-		baseVertices.push_back(glm::vec3(x, 0.0f, y));
+		return 0;
 	}
+	const MeshData& meshData = entry->second;
+	size_t indexBytes = sizeof(GLuint) * meshData.indices.size();
+	size_t bytes = sizeof(GLfloat) * meshData.vertices.size() + indexBytes;
 
-	glm::vec3 topVertex = glm::vec3(0.0f, height, 0.0f);
-	glm::vec3 bottomVertex = glm::vec3(0.0f, -height, 0.0f);
-
-	std::vector<glm::vec3> verts = { topVertex };
-	verts.insert(verts.end(), baseVertices.begin(), baseVertices.end());
-	verts.push_back(bottomVertex);
-
-	std::vector<GLuint> indices = {
-		// Top Pyramid
-		0, 1, 2,
-		0, 2, 3, 
-		0, 3, 4, 
-		0, 4, 5,
-		0, 5, 1,
-		1, 5, 6,
-		1, 6, 2,
-		2, 6, 3,
-		3, 6, 4,
-		4, 6, 5
-	};
-
-	// Define UV coordinates for each vertex
-	std::vector<glm::vec2> uvs = {
-		glm::vec2(0.0f, 1.0f), // Top vertex //
-		glm::vec2(0.9f, 0.7f), // Front vertex
-		glm::vec2(0.7f, 0.9f), // Right vertex
-		glm::vec2(0.3f, 0.7f), // Back vertex //
-		glm::vec2(0.1f, 0.7f), // Left vertex
-		glm::vec2(1.0f, 0.0f), // Bottom center vertex //
-		glm::vec2(0.3f, 0.9f), // Bottom Left vertex //
-		glm::vec2(0.1f, 0.3f), // Bottom Back vertex
-		glm::vec2(0.3f, 0.7f), // Bottom Right vertex
-		glm::vec2(0.3f, 0.9f)  // Bottom Front vertex
-	};
-
-	std::vector<GLfloat> combined_values;
-	combined_values.reserve(verts.size() * (3 + 3 + 2)); // 3 for position, 3 for normal, 2 for UV
-
-	for (GLuint index : indices)
+	if (m_quantizedMeshes.count(shapeType) != 0)
 	{
-		if (index < verts.size() && index < uvs.size())
-		{
-			glm::vec3 vertex = verts[index];
-			glm::vec3 normal = glm::normalize(vertex);
-			glm::vec2 uv = uvs[index];
-
-			combined_values.push_back(vertex.x);
-			combined_values.push_back(vertex.y);
-			combined_values.push_back(vertex.z);
-			combined_values.push_back(normal.x);
-			combined_values.push_back(normal.y);
-			combined_values.push_back(normal.z);
-			combined_values.push_back(uv.x);
-			combined_values.push_back(uv.y);
-		}
+		bytes += sizeof(QuantizedVertex) * meshData.VertexCount() + indexBytes;
 	}
-
-	m_DecahedronMesh.nVertices = combined_values.size() / 8;
-	m_DecahedronMesh.nIndices = indices.size();
-
-	glGenVertexArrays(1, &m_DecahedronMesh.vao);
-	glBindVertexArray(m_DecahedronMesh.vao);
-
-	glGenBuffers(1, m_DecahedronMesh.vbos);
-	glBindBuffer(GL_ARRAY_BUFFER, m_DecahedronMesh.vbos[0]);
-	glBufferData(GL_ARRAY_BUFFER, combined_values.size() * sizeof(GLfloat), combined_values.data(), GL_STATIC_DRAW);
-
-	glGenBuffers(1, &m_DecahedronMesh.vbos[1]);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_DecahedronMesh.vbos[1]);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * indices.size(), indices.data(), GL_STATIC_DRAW);
-
-	// Specify vertex attribute pointers
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)0);
-	glEnableVertexAttribArray(0); // Vertex position
-
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(3 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(1); // Normal
-
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(GLfloat), (GLvoid*)(6 * sizeof(GLfloat)));
-	glEnableVertexAttribArray(2); // Texture coordinates
-
-	if (!m_bMemoryLayoutDone)
+	if (m_meshletMeshes.count(shapeType) != 0)
 	{
-		SetShaderMemoryLayout();
+		bytes += indexBytes;
 	}
-
-	glBindVertexArray(0);
+	return bytes;
 }
 
-
-
-//void ShapeMeshes::LoadDodecahedronMesh() {}
-
 ///////////////////////////////////////////////////
 //	DrawConeMesh()
 //	Transform and draw the box mesh to the window.
@@ -1318,9 +1397,9 @@ void ShapeMeshes::DrawBoxMesh() const
 //	Transform and draw the plane mesh to the window.
 // 
 ///////////////////////////////////////////////////
-void ShapeMeshes::DrawConeMesh(bool bDrawBottom) const
+void ShapeMeshes::DrawConeMesh() const
 {
-	m_pConeMesh->DrawConeMesh(bDrawBottom);
+	m_pConeMesh->DrawConeMesh();
 }
 
 ///////////////////////////////////////////////////
@@ -1329,27 +1408,10 @@ void ShapeMeshes::DrawConeMesh(bool bDrawBottom) const
 //	Transform and draw the plane mesh to the window.
 // 
 ///////////////////////////////////////////////////
-void ShapeMeshes::DrawCylinderMesh(
-	bool bDrawTop,
-	bool bDrawBottom,
-	bool bDrawSides) const
+void ShapeMeshes::DrawCylinderMesh() const
 {
-	glBindVertexArray(m_CylinderMesh.vao);
-
-	if (bDrawBottom == true)
-	{
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 36);	//bottom
-	}
-	if (bDrawTop == true)
-	{
-		glDrawArrays(GL_TRIANGLE_FAN, 36, 36);	//top
-	}
-	if (bDrawSides == true)
-	{
-		glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
-	}
-
-	glBindVertexArray(0);
+	MeshData::Layout::Bind(m_CylinderMesh.vbos[0], m_CylinderMesh.vbos[1]);
+	glDrawElements(GL_TRIANGLES, m_CylinderMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
 }
 
 ///////////////////////////////////////////////////
@@ -1369,11 +1431,9 @@ void ShapeMeshes::DrawPlaneMesh() const
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPrismMesh() const
 {
-	glBindVertexArray(m_PrismMesh.vao);
+	MeshData::Layout::Bind(m_PrismMesh.vbos[0], m_PrismMesh.vbos[1]);
 
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_PrismMesh.nVertices);
-
-	glBindVertexArray(0);
+	glDrawElements(GL_TRIANGLES, m_PrismMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
 }
 
 ///////////////////////////////////////////////////
@@ -1395,11 +1455,9 @@ void ShapeMeshes::DrawTetrahedronMesh() const
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawPyramid4Mesh() const
 {
-	glBindVertexArray(m_Pyramid4Mesh.vao);
-
-	glDrawArrays(GL_TRIANGLE_STRIP, 0, m_Pyramid4Mesh.nVertices);
+	MeshData::Layout::Bind(m_Pyramid4Mesh.vbos[0], m_Pyramid4Mesh.vbos[1]);
 
-	glBindVertexArray(0);
+	glDrawElements(GL_TRIANGLES, m_Pyramid4Mesh.nIndices, GL_UNSIGNED_INT, (void*)0);
 }
 
 ///////////////////////////////////////////////////
@@ -1410,182 +1468,645 @@ void ShapeMeshes::DrawPyramid4Mesh() const
 ///////////////////////////////////////////////////
 void ShapeMeshes::DrawSphereMesh() const
 {
-	glBindVertexArray(m_SphereMesh.vao);
+	MeshData::Layout::Bind(m_SphereMesh.vbos[0], m_SphereMesh.vbos[1]);
 	glDrawElements(GL_TRIANGLES, m_SphereMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
-	glBindVertexArray(0);
 }
 
 ///////////////////////////////////////////////////
-//	DrawHalfSphereMesh()
+//	DrawTaperedCylinderMesh()
 //
 //	Transform and draw the plane mesh to the window.
 // 
 ///////////////////////////////////////////////////
-void ShapeMeshes::DrawHalfSphereMesh() const
+void ShapeMeshes::DrawTaperedCylinderMesh() const
 {
-	glBindVertexArray(m_SphereMesh.vao);
+	MeshData::Layout::Bind(m_TaperedCylinderMesh.vbos[0], m_TaperedCylinderMesh.vbos[1]);
+	glDrawElements(GL_TRIANGLES, m_TaperedCylinderMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+}
 
-	glDrawElements(GL_TRIANGLES, m_SphereMesh.nIndices/2, GL_UNSIGNED_INT, (void*)0);
+///////////////////////////////////////////////////
+//	DrawTorusMesh()
+//
+//	Transform and draw the plane mesh to the window.
+// 
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawTorusMesh() const
+{
+	MeshData::Layout::Bind(m_TorusMesh.vbos[0], m_TorusMesh.vbos[1]);
 
-	glBindVertexArray(0);
+	glDrawElements(GL_TRIANGLES, m_TorusMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
 }
 
 ///////////////////////////////////////////////////
-//	DrawTaperedCylinderMesh()
+//	DrawOctahedronMesh()
+//
+//	Transform and draw the plane mesh to the window.
+// 
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawOctahedronMesh() const
+{
+	MeshData::Layout::Bind(m_OctahedronMesh.vbos[0], m_OctahedronMesh.vbos[1]);
+	glDrawElements(GL_TRIANGLES, m_OctahedronMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+}
+
+///////////////////////////////////////////////////
+//	DrawDecahedronMesh()
 //
 //	Transform and draw the plane mesh to the window.
 // 
 ///////////////////////////////////////////////////
-void ShapeMeshes::DrawTaperedCylinderMesh(
-	bool bDrawTop,
-	bool bDrawBottom,
-	bool bDrawSides) const
+void ShapeMeshes::DrawDecahedronMesh() const
 {
-	glBindVertexArray(m_TaperedCylinderMesh.vao);
+	MeshData::Layout::Bind(m_DecahedronMesh.vbos[0], m_DecahedronMesh.vbos[1]);
+	glDrawElements(GL_TRIANGLES, m_DecahedronMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+}
+
+///////////////////////////////////////////////////
+//	DrawDodecahedronMesh()
+//
+//	Transform and draw the dodecahedron mesh to the window.
+//
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawDodecahedronMesh() const
+{
+	MeshData::Layout::Bind(m_DodecahedronMesh.vbos[0], m_DodecahedronMesh.vbos[1]);
+	glDrawElements(GL_TRIANGLES, m_DodecahedronMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+}
 
-	if (bDrawBottom == true)
+///////////////////////////////////////////////////
+// DrawIcosahedronMesh()
+//
+//	Transform and draw the icosahedron mesh to the window.
+//
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawIcosahedronMesh() const
+{
+	MeshData::Layout::Bind(m_IcosahedronMesh.vbos[0], m_IcosahedronMesh.vbos[1]);
+	glDrawElements(GL_TRIANGLES, m_IcosahedronMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+}
+
+///////////////////////////////////////////////////
+// DrawImportedMesh()
+//
+//	Transform and draw the imported mesh to the window,
+//	nothing is drawn when no mesh was imported.
+//
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawImportedMesh() const
+{
+	if (!IsMeshLoaded(ShapeType::Imported))
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 36);	//bottom
+		return;
 	}
-	if (bDrawTop == true)
+	MeshData::Layout::Bind(m_ImportedMesh.vbos[0], m_ImportedMesh.vbos[1]);
+	glDrawElements(GL_TRIANGLES, m_ImportedMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
+}
+
+
+
+///////////////////////////////////////////////////
+//	UploadWeldedMesh()
+//
+//	Welds the duplicate vertices of a mesh, reorders it for
+//	the vertex cache, overdraw and vertex fetch, prints both
+//	reports and uploads the vertex and index buffers. Meshes
+//	with no parts get one part covering every index.
+///////////////////////////////////////////////////
+void ShapeMeshes::UploadWeldedMesh(GLMesh& mesh,
+	const char* meshName,
+	std::vector<GLfloat>& vertices,
+	std::vector<GLuint>& indices)
+{
+	if (mesh.parts.empty())
 	{
-		glDrawArrays(GL_TRIANGLE_FAN, 36, 72);	//top
+		mesh.parts.push_back({ 0, static_cast<GLuint>(indices.size()) });
 	}
-	if (bDrawSides == true)
+	PrintWeldReport(meshName, WeldVertices(vertices, indices, mesh.parts));
+	PrintVertexCacheReport(meshName, OptimizeMesh(vertices, indices, mesh.parts));
+
+	UploadMesh(mesh,
+		vertices.data(),
+		static_cast<GLuint>(vertices.size() / MeshData::FloatsPerVertex),
+		indices.data(),
+		static_cast<GLuint>(indices.size()));
+}
+
+///////////////////////////////////////////////////
+//	UploadMesh()
+///////////////////////////////////////////////////
+void ShapeMeshes::UploadMesh(GLMesh& mesh,
+	const GLfloat* vertices,
+	GLuint vertexCount,
+	const GLuint* indices,
+	GLuint indexCount)
+{
+	// store vertex and index count
+	mesh.nVertices = vertexCount;
+	mesh.nIndices = indexCount;
+
+	// Create 2 buffers: first one for the vertex data; second one for the indices
+	mesh.vbos[0] = CreateBufferData(sizeof(GLfloat) * MeshData::FloatsPerVertex * vertexCount, vertices);
+	mesh.vbos[1] = CreateBufferData(sizeof(GLuint) * indexCount, indices);
+}
+
+///////////////////////////////////////////////////
+//	LoadSolidMesh()
+//
+//	The solid tables are built at compile time already
+//	welded, wound outward and quantized, so only the
+//	uploads are left.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadSolidMesh(GLMesh& mesh, ShapeType shapeType, const SolidGeometry& geometry)
+{
+	UploadMesh(mesh, geometry.vertices, geometry.vertexCount, geometry.indices, geometry.indexCount);
+	UploadQuantizedSolid(shapeType, geometry);
+	m_bCullBackFaces[shapeType] = true;
+
+	// keep a CPU copy for the shared geometry pool
+	m_meshData[shapeType] = geometry.ToMeshData();
+}
+
+///////////////////////////////////////////////////
+//	LoadCachedMesh()
+//
+//	On a cache hit the mesh is decoded from the memory-mapped
+//	file into a MeshData, which is uploaded and then kept as
+//	is. The buffers are not uploaded straight from the mapping:
+//	the encoded file is smaller to read, and the geometry pool
+//	needs the decoded CPU copy anyway, so the decode is the one
+//	copy a hit makes. Otherwise the generator fills in the mesh
+//	and its parts, which are welded, optimized, uploaded and
+//	written to the cache for the next start.
+//	Either way the final mesh is kept as the CPU copy.
+///////////////////////////////////////////////////
+void ShapeMeshes::LoadCachedMesh(GLMesh& mesh,
+	ShapeType shapeType,
+	const char* meshName,
+	const std::string& key,
+	const std::function<void(MeshData& meshData, std::vector<IndexRange>& parts)>& generate)
+{
+	CachedMesh cached;
+	if (m_meshCache.Load(key, cached))
 	{
-		glDrawArrays(GL_TRIANGLE_STRIP, 72, 146);	//sides
+		const MeshData& decoded = cached.meshData;
+		std::cout << "INFO: " << meshName << " loaded from the mesh cache, " << decoded.VertexCount()
+			<< " vertices, " << decoded.IndexCount() / 3 << " triangles" << std::endl;
+
+		mesh.parts = std::move(cached.parts);
+		UploadMesh(mesh, decoded.vertices.data(), decoded.VertexCount(), decoded.indices.data(), decoded.IndexCount());
+
+		// keep the decoded buffers as the CPU copy for the shared geometry pool
+		m_meshData[shapeType] = std::move(cached.meshData);
+		return;
 	}
 
-	glBindVertexArray(0);
+	MeshData meshData;
+	mesh.parts.clear();
+	generate(meshData, mesh.parts);
+	UploadWeldedMesh(mesh, meshName, meshData.vertices, meshData.indices);
+	m_meshCache.Store(key, meshData.vertices, meshData.indices, mesh.parts);
+
+	// keep a CPU copy for the shared geometry pool
+	m_meshData[shapeType] = std::move(meshData);
 }
 
 ///////////////////////////////////////////////////
-//	DrawTorusMesh()
+//	LoadSimplifiedLods()
 //
-//	Transform and draw the plane mesh to the window.
-// 
+//	Each level keeps a quarter of the triangles of the one
+//	before, within the error bound. The cache key holds a
+//	hash of the source buffers and the level settings, so a
+//	changed mesh is simplified again. Levels that would save
+//	little over the one before are left out.
 ///////////////////////////////////////////////////
-void ShapeMeshes::DrawTorusMesh() const
+void ShapeMeshes::LoadSimplifiedLods(ShapeType shapeType, const char* meshName, const char* keyName)
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	const MeshData& source = m_meshData[shapeType];
+	std::vector<SimplifyTarget> targets;
+	float triangleCount = static_cast<float>(source.IndexCount() / 3);
+	while (targets.size() + 1 < g_MaxLodLevels)
+	{
+		triangleCount *= g_SimplifiedLodRatio;
+		if (triangleCount < g_MinLodTriangles)
+		{
+			break;
+		}
+		targets.push_back({ static_cast<GLuint>(triangleCount), g_SimplifiedLodMaxError });
+	}
+	if (targets.empty())
+	{
+		m_lodMeshData.erase(shapeType);
+		return;
+	}
 
-	glDrawArrays(GL_TRIANGLES, 0, m_TorusMesh.nVertices);
+	std::vector<std::string> keys;
+	std::vector<MeshData> levels;
+	for (GLuint level = 0; level < targets.size(); ++level)
+	{
+		// the target counts follow from the source count, the level number stays exact as a float
+		keys.push_back(MeshCache::MakeKey(keyName, source, { g_SimplifiedLodRatio, targets[level].maxError, static_cast<float>(level) }));
 
-	glBindVertexArray(0);
+		CachedMesh cached;
+		if (levels.size() == level && m_meshCache.Load(keys.back(), cached))
+		{
+			levels.push_back(std::move(cached.meshData));
+		}
+	}
+
+	if (levels.size() == targets.size())
+	{
+		std::cout << "INFO: " << meshName << " LODs loaded from the mesh cache" << std::endl;
+	}
+	else
+	{
+		std::vector<SimplifyReport> reports;
+		levels = BuildSimplifiedLods(source, targets, &reports);
+		for (GLuint level = 0; level < levels.size(); ++level)
+		{
+			PrintSimplifyReport(meshName, level + 1, reports[level]);
+			m_meshCache.Store(keys[level], levels[level].vertices, levels[level].indices, { { 0, levels[level].IndexCount() } });
+		}
+	}
+
+	// a level that stopped at the error bound is no coarser than the one before
+	GLuint previousCount = source.IndexCount();
+	std::vector<MeshData>& lods = m_lodMeshData[shapeType];
+	lods.clear();
+	for (MeshData& level : levels)
+	{
+		if (level.IndexCount() * 4 > previousCount * 3)
+		{
+			break;
+		}
+		previousCount = level.IndexCount();
+		lods.push_back(std::move(level));
+	}
 }
 
 ///////////////////////////////////////////////////
-//	DrawHalfTorusMesh()
+//	BuildGeometryPool()
 //
-//	Transform and draw the plane mesh to the window.
-// 
+//	Pack every loaded triangle mesh, and the coarser
+//	levels of detail of the parametric ones, into the
+//	shared geometry pool so that they can be drawn with
+//	indirect multi-draw commands from a single VAO.
+//
+//	With a ready surface compute manager the parametric
+//	meshes and their levels only get a range that the GPU
+//	writes after the upload. They are then the plain grids
+//	of the generator, not welded or reordered.
 ///////////////////////////////////////////////////
-void ShapeMeshes::DrawHalfTorusMesh() const
+void ShapeMeshes::BuildGeometryPool(SurfaceComputeManager* pSurfaceCompute)
 {
-	glBindVertexArray(m_TorusMesh.vao);
+	bool bGpuSurfaces = pSurfaceCompute && pSurfaceCompute->IsReady();
 
-	glDrawArrays(GL_TRIANGLES, 0, m_TorusMesh.nVertices/2);
+	m_poolMeshIDs.clear();
+	m_poolSubmeshIDs.clear();
+	for (const auto& meshData : m_meshData)
+	{
+		auto surface = m_surfaces.find(meshData.first);
+		if (bGpuSurfaces && surface != m_surfaces.end())
+		{
+			m_poolMeshIDs[meshData.first] = pSurfaceCompute->ReserveSurface(surface->second);
+			continue;
+		}
+		m_poolMeshIDs[meshData.first] = m_pGeometryPool->AddMesh(meshData.second);
 
-	glBindVertexArray(0);
+		// the named ranges point into the pooled mesh; those of a GPU written
+		// grid differ from the CPU mesh, so its parts are drawn unpooled
+		auto submeshes = m_submeshes.find(meshData.first);
+		if (submeshes == m_submeshes.end())
+		{
+			continue;
+		}
+		for (const SubmeshRange& submesh : submeshes->second)
+		{
+			m_poolSubmeshIDs[{ meshData.first, submesh.name }] =
+				m_pGeometryPool->AddSubmesh(m_poolMeshIDs[meshData.first], submesh);
+		}
+	}
+
+	// the coarser levels are pooled meshes of their own, chained to the full mesh
+	for (const auto& lodMeshData : m_lodMeshData)
+	{
+		auto meshID = m_poolMeshIDs.find(lodMeshData.first);
+		if (meshID == m_poolMeshIDs.end())
+		{
+			continue;
+		}
+
+		// each parametric level halves the grid of the one before
+		auto surface = m_surfaces.find(lodMeshData.first);
+		std::vector<GLuint> lodMeshIDs;
+		for (const MeshData& level : lodMeshData.second)
+		{
+			if (bGpuSurfaces && surface != m_surfaces.end())
+			{
+				SurfaceComputeManager::SURFACE levelSurface = surface->second;
+				levelSurface.columns >>= lodMeshIDs.size() + 1;
+				levelSurface.rows >>= lodMeshIDs.size() + 1;
+				lodMeshIDs.push_back(pSurfaceCompute->ReserveSurface(levelSurface));
+				continue;
+			}
+			lodMeshIDs.push_back(m_pGeometryPool->AddMesh(level));
+		}
+		m_pGeometryPool->SetLodChain(meshID->second, lodMeshIDs);
+	}
+	m_pGeometryPool->Upload();
+
+	if (bGpuSurfaces)
+	{
+		pSurfaceCompute->GenerateSurfaces();
+	}
 }
 
 ///////////////////////////////////////////////////
-//	DrawOctahedronMesh()
-//
-//	Transform and draw the plane mesh to the window.
-// 
+//	GetPoolMeshID()
+//	Look up the geometry pool mesh ID of a shape type.
 ///////////////////////////////////////////////////
-void ShapeMeshes::DrawOctahedronMesh() const
+bool ShapeMeshes::GetPoolMeshID(ShapeType shapeType, GLuint& meshID) const
 {
-	glBindVertexArray(m_OctahedronMesh.vao);
-	glDrawArrays(GL_TRIANGLES, 0, m_OctahedronMesh.nVertices);
-	glBindVertexArray(0);
+	auto it = m_poolMeshIDs.find(shapeType);
+	if (it != m_poolMeshIDs.end())
+	{
+		meshID = it->second;
+		return true;
+	}
+	return false;
 }
 
 ///////////////////////////////////////////////////
-//	DrawDecahedronMesh()
-//
-//	Transform and draw the plane mesh to the window.
-// 
+//	GetPoolMeshID()
+//	Look up the geometry pool mesh ID of a named range of a shape,
+//	an empty name is the whole mesh.
 ///////////////////////////////////////////////////
-void ShapeMeshes::DrawDecahedronMesh() const
+bool ShapeMeshes::GetPoolMeshID(ShapeType shapeType, const std::string& submesh, GLuint& meshID) const
 {
-	glBindVertexArray(m_DecahedronMesh.vao);
-	glDrawArrays(GL_TRIANGLES, 0, m_DecahedronMesh.nVertices);
-	glBindVertexArray(0);
+	if (submesh.empty())
+	{
+		return GetPoolMeshID(shapeType, meshID);
+	}
+
+	auto it = m_poolSubmeshIDs.find({ shapeType, submesh });
+	if (it != m_poolSubmeshIDs.end())
+	{
+		meshID = it->second;
+		return true;
+	}
+	return false;
 }
 
-/*
 ///////////////////////////////////////////////////
-//	DrawDodecahedronMesh()
-//
-//	Transform and draw the plane mesh to the window.
-//
+//	DrawPoolLod()
+//	Draws a level of a pooled mesh, level 0 is the mesh itself,
+//	for the immediate draws that pick their level on the CPU.
 ///////////////////////////////////////////////////
-void ShapeMeshes::DrawDodecahedronMesh() const
+void ShapeMeshes::DrawPoolLod(GLuint meshID, GLuint level) const
 {
-	glBindVertexArray(m_DodecahedronMesh.vao);
-	glDrawElements(GL_TRIANGLES, m_DodecahedronMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
-	glBindVertexArray(0);
+	const GeometryPool::MeshRange& range = m_pGeometryPool->GetMeshRange(m_pGeometryPool->GetLodMesh(meshID, level));
+
+	m_pGeometryPool->Bind();
+	glDrawElementsBaseVertex(GL_TRIANGLES, range.indexCount, GL_UNSIGNED_INT,
+		IndexRange{ range.firstIndex, range.indexCount }.Offset(), range.baseVertex);
 }
 
 ///////////////////////////////////////////////////
-// DrawIcosahedronMesh()
-//
-//	Transform and draw the plane mesh to the window.
+//	GetMeshData()
+//	Look up the CPU copy of a loaded mesh, nullptr when it is not loaded.
+///////////////////////////////////////////////////
+const MeshData* ShapeMeshes::GetMeshData(ShapeType shapeType) const
+{
+	auto entry = m_meshData.find(shapeType);
+	return entry != m_meshData.end() ? &entry->second : nullptr;
+}
+
+///////////////////////////////////////////////////
+//	FindSubmesh()
+//	Look up a named range of a loaded mesh, nullptr when it has none by that name.
+///////////////////////////////////////////////////
+const SubmeshRange* ShapeMeshes::FindSubmesh(ShapeType shapeType, const std::string& name) const
+{
+	auto submeshes = m_submeshes.find(shapeType);
+	if (submeshes == m_submeshes.end())
+	{
+		return nullptr;
+	}
+	for (const SubmeshRange& submesh : submeshes->second)
+	{
+		if (submesh.name == name)
+		{
+			return &submesh;
+		}
+	}
+	return nullptr;
+}
+
+///////////////////////////////////////////////////
+//	DrawSubmesh()
 //
+//	Draws a named range from the buffers the whole mesh
+//	is drawn from, quantized ones included, as the index
+//	order of every copy is that of the CPU mesh.
 ///////////////////////////////////////////////////
-void ShapeMeshes::DrawIcosahedronMesh() const
+void ShapeMeshes::DrawSubmesh(ShapeType shapeType, const SubmeshRange& submesh) const
 {
-	glBindVertexArray(m_IcosahedronMesh.vao);
-	glDrawElements(GL_TRIANGLES, m_IcosahedronMesh.nIndices, GL_UNSIGNED_INT, (void*)0);
-	glBindVertexArray(0);
+	auto quantizedMesh = m_quantizedMeshes.find(shapeType);
+	if (quantizedMesh != m_quantizedMeshes.end())
+	{
+		QuantizedVertexLayout::Bind(quantizedMesh->second.vbos[0], quantizedMesh->second.vbos[1]);
+		submesh.Draw();
+		return;
+	}
+
+	if (shapeType == ShapeType::Cone)
+	{
+		m_pConeMesh->DrawConeRange(submesh);
+		return;
+	}
+
+	const GLMesh* pMesh = GetGLMesh(shapeType);
+	if (pMesh)
+	{
+		MeshData::Layout::Bind(pMesh->vbos[0], pMesh->vbos[1]);
+		submesh.Draw();
+	}
+}
+
+///////////////////////////////////////////////////
+//	CanCullBackFaces()
+//	True for closed meshes whose winding was normalized at load time.
+//	Open surfaces and meshes not loaded keep both sides, as do the
+//	named ranges, through which the inside can be seen.
+///////////////////////////////////////////////////
+bool ShapeMeshes::CanCullBackFaces(ShapeType shapeType, const std::string& submesh) const
+{
+	auto entry = m_bCullBackFaces.find(shapeType);
+	return submesh.empty() && entry != m_bCullBackFaces.end() && entry->second;
+}
+
+///////////////////////////////////////////////////
+//	IsHeavyMesh()
+//	True for pooled meshes with at least g_HeavyMeshIndexCount indices.
+//	The pool bounds are used for the occlusion query box.
+///////////////////////////////////////////////////
+bool ShapeMeshes::IsHeavyMesh(ShapeType shapeType) const
+{
+	auto entry = m_poolMeshIDs.find(shapeType);
+	return entry != m_poolMeshIDs.end() &&
+		m_pGeometryPool->GetMeshRange(entry->second).indexCount >= g_HeavyMeshIndexCount;
 }
-*/
 
-glm::vec3 ShapeMeshes::CalculateTriangleNormal(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2)
+///////////////////////////////////////////////////
+//	QuantizeMesh()
+//
+//	Uploads a QuantizedVertex copy of a loaded triangle
+//	mesh, halving its vertex memory and bandwidth, and
+//	reports the error against the float vertices. The
+//	meshlets of the mesh are moved to the quantized
+//	buffer. The geometry pool keeps the float layout.
+///////////////////////////////////////////////////
+bool ShapeMeshes::QuantizeMesh(ShapeType shapeType, const char* meshName)
 {
-	glm::vec3 Normal(0, 0, 0);
-	float v1x = p1.x - p0.x;
-	float v1y = p1.y - p0.y;
-	float v1z = p1.z - p0.z;
-	float v2x = p2.x - p1.x;
-	float v2y = p2.y - p1.y;
-	float v2z = p2.z - p1.z;
-	Normal.x = v1y * v2z - v1z * v2y;
-	Normal.y = v1z * v2x - v1x * v2z;
-	Normal.z = v1x * v2y - v1y * v2x;
-	float len = (float)sqrt(Normal.x * Normal.x + Normal.y * Normal.y + Normal.z * Normal.z);
-	if (len == 0)
+	auto entry = m_meshData.find(shapeType);
+	if (entry == m_meshData.end())
 	{
-		//throw Exception();
+		return false;
 	}
-	else
+	const MeshData& meshData = entry->second;
+
+	QuantizedMesh quantizedMesh;
+	QuantizationReport report;
+	std::vector<QuantizedVertex> vertices = QuantizeVertices(meshData.vertices, quantizedMesh.decoding, report);
+	quantizedMesh.nIndices = meshData.IndexCount();
+	PrintQuantizationReport(meshName, report);
+
+	quantizedMesh.vbos[0] = CreateBufferData(sizeof(QuantizedVertex) * vertices.size(), vertices.data());
+	quantizedMesh.vbos[1] = CreateBufferData(sizeof(GLuint) * meshData.indices.size(), meshData.indices.data());
+
+	// the meshlet indices refer to the same vertices
+	auto meshletMesh = m_meshletMeshes.find(shapeType);
+	if (meshletMesh != m_meshletMeshes.end())
+	{
+		meshletMesh->second.vbo = quantizedMesh.vbos[0];
+		meshletMesh->second.bQuantized = true;
+	}
+
+	m_quantizedMeshes[shapeType] = quantizedMesh;
+	return true;
+}
+
+///////////////////////////////////////////////////
+//	UploadQuantizedSolid()
+///////////////////////////////////////////////////
+void ShapeMeshes::UploadQuantizedSolid(ShapeType shapeType, const SolidGeometry& geometry)
+{
+	QuantizedMesh quantizedMesh;
+	quantizedMesh.decoding = geometry.GetVertexDecoding();
+	quantizedMesh.nIndices = geometry.indexCount;
+	quantizedMesh.vbos[0] = CreateBufferData(sizeof(QuantizedVertex) * geometry.vertexCount, geometry.quantizedVertices);
+	quantizedMesh.vbos[1] = CreateBufferData(sizeof(GLuint) * geometry.indexCount, geometry.indices);
+	m_quantizedMeshes[shapeType] = quantizedMesh;
+}
+
+///////////////////////////////////////////////////
+//	GetVertexDecoding()
+//	The decoding ranges of a quantized mesh, nullptr for float meshes.
+///////////////////////////////////////////////////
+const VertexDecoding* ShapeMeshes::GetVertexDecoding(ShapeType shapeType) const
+{
+	auto entry = m_quantizedMeshes.find(shapeType);
+	return entry != m_quantizedMeshes.end() ? &entry->second.decoding : nullptr;
+}
+
+///////////////////////////////////////////////////
+//	DrawQuantizedMesh()
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawQuantizedMesh(ShapeType shapeType) const
+{
+	auto entry = m_quantizedMeshes.find(shapeType);
+	if (entry == m_quantizedMeshes.end())
 	{
-		Normal.x /= len;
-		Normal.y /= len;
-		Normal.z /= len;
+		return;
 	}
-	return Normal;
+
+	QuantizedVertexLayout::Bind(entry->second.vbos[0], entry->second.vbos[1]);
+	glDrawElements(GL_TRIANGLES, entry->second.nIndices, GL_UNSIGNED_INT, (void*)0);
 }
 
+///////////////////////////////////////////////////
+//	BuildMeshletMesh()
+//
+//	Splits an indexed mesh into meshlets and uploads the
+//	meshlet ordered indices into their own index buffer,
+//	so the regular draw order of the mesh is unchanged.
+///////////////////////////////////////////////////
+void ShapeMeshes::BuildMeshletMesh(ShapeType shapeType, GLuint vertexBuffer, const MeshData& meshData)
+{
+	MeshletMesh meshletMesh;
+	std::vector<GLuint> indices = meshData.indices;
+	meshletMesh.meshlets = BuildMeshlets(meshData.vertices, indices);
+	meshletMesh.vbo = vertexBuffer;
+	meshletMesh.bQuantized = false;
+
+	meshletMesh.ebo = CreateBufferData(sizeof(GLuint) * indices.size(), indices.data());
 
+	m_meshletMeshes[shapeType] = std::move(meshletMesh);
+}
 
-void ShapeMeshes::SetShaderMemoryLayout()
+///////////////////////////////////////////////////
+//	DrawMeshlets()
+//
+//	Culls the meshlets of one object and draws the surviving
+//	index ranges with a single multi-draw call.
+///////////////////////////////////////////////////
+void ShapeMeshes::DrawMeshlets(ShapeType shapeType,
+	const glm::mat4& model,
+	const Frustum& frustum,
+	const glm::vec3& cameraPosition) const
 {
-	// The following code defines the layout of the mesh data in memory - each mesh needs
-	// to have the same memory layout so that the data is retrieved properly by the shaders
+	auto entry = m_meshletMeshes.find(shapeType);
+	if (entry == m_meshletMeshes.end())
+	{
+		return;
+	}
 
-	// Strides between vertex coordinates is 6 (x, y, z, r, g, b, a). A tightly packed stride is 0.
-	GLint stride = sizeof(float) * (g_FloatsPerVertex + g_FloatsPerNormal + g_FloatsPerUV);// The number of floats before each
+	const MeshletMesh& meshletMesh = entry->second;
+	bool bCullBackFaces = CanCullBackFaces(shapeType);
 
-	// Create Vertex Attribute Pointers
-	glVertexAttribPointer(0, g_FloatsPerVertex, GL_FLOAT, GL_FALSE, stride, 0);
-	glEnableVertexAttribArray(0);
+	std::vector<GLsizei> counts;
+	std::vector<const void*> offsets;
+	for (const Meshlet& meshlet : meshletMesh.meshlets)
+	{
+		if (!IsMeshletVisible(meshlet, model, frustum, cameraPosition, bCullBackFaces))
+		{
+			continue;
+		}
 
-	glVertexAttribPointer(1, g_FloatsPerNormal, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * g_FloatsPerVertex));
-	glEnableVertexAttribArray(1);
+		// neighboring ranges are merged into one draw
+		const void* offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(meshlet.firstIndex * sizeof(GLuint)));
+		if (!counts.empty() && static_cast<const char*>(offsets.back()) + counts.back() * sizeof(GLuint) == offset)
+		{
+			counts.back() += meshlet.indexCount;
+		}
+		else
+		{
+			counts.push_back(meshlet.indexCount);
+			offsets.push_back(offset);
+		}
+	}
+
+	if (counts.empty())
+	{
+		return;
+	}
 
-	glVertexAttribPointer(2, g_FloatsPerUV, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(float) * (g_FloatsPerVertex + g_FloatsPerNormal)));
-	glEnableVertexAttribArray(2);
-}
\ No newline at end of file
+	if (meshletMesh.bQuantized)
+	{
+		QuantizedVertexLayout::Bind(meshletMesh.vbo, meshletMesh.ebo);
+	}
+	else
+	{
+		MeshData::Layout::Bind(meshletMesh.vbo, meshletMesh.ebo);
+	}
+	glMultiDrawElements(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(), static_cast<GLsizei>(counts.size()));
+}
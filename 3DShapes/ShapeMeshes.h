@@ -13,12 +13,30 @@
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <functional>
+#include <map>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 #include "BoxMesh.h"
 #include "ConeMesh.h"
 #include "PlaneMesh.h"
 #include "TetrahedronMesh.h"
+#include "GeometryPool.h"
+#include "MeshCache.h"
+#include "MeshImporter.h"
+#include "SolidTables.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshWelding.h"
+#include "Meshlet.h"
+#include "SubmeshRange.h"
+#include "VertexQuantization.h"
+#include "ShapeGenerator.h"
+#include "SurfaceComputeManager.h"
 /***********************************************************
  *  ShapeMeshes
  *
@@ -49,13 +67,14 @@ public:
 
 private:
 
-	// stores the GL data relative to a given mesh
+	// stores the GL data relative to a given mesh, drawn
+	// through the shared VAO of the mesh vertex layout
 	struct GLMesh
 	{
-		GLuint vao;         // Handle for the vertex array object
 		GLuint vbos[2];     // Handles for the vertex buffer objects
 		GLuint nVertices;	// Number of vertices for the mesh
 		GLuint nIndices;    // Number of indices for the mesh
+		std::vector<IndexRange> parts;	// Index runs of the parts that are drawn separately
 	};
 
 	GLMesh m_CylinderMesh;
@@ -66,8 +85,9 @@ private:
 	GLMesh m_TorusMesh;
 	GLMesh m_OctahedronMesh;
 	GLMesh m_DecahedronMesh;
-
-	bool m_bMemoryLayoutDone;
+	GLMesh m_DodecahedronMesh;
+	GLMesh m_IcosahedronMesh;
+	GLMesh m_ImportedMesh;
 
 public:
 	// methods for loading the shape mesh data 
@@ -80,41 +100,90 @@ public:
 	void LoadTetrahedronMesh();
 	void LoadPyramid4Mesh();
 	void LoadSphereMesh(float radius, int stacks, int slices);
+	void LoadIcosphereMesh(float radius, int subdivisions);
 	void LoadTaperedCylinderMesh();
 	void LoadTorusMesh(float thickness = 0.2);
 	void LoadOctahedronMesh();
 	void LoadDecahedronMesh();
-	//void LoadDodecahedronMesh();
-	//void LoadIcosahedronMesh();
+	void LoadDodecahedronMesh();
+	void LoadIcosahedronMesh();
+
+	// imports an OBJ, PLY or glTF file as the Imported shape,
+	// centered and scaled to fit the unit sphere
+	bool LoadImportedMesh(const std::string& path);
+	bool IsMeshLoaded(ShapeType shapeType) const { return m_meshData.count(shapeType) != 0; }
+
+	// registry of the shape meshes: a mesh is loaded the first time its
+	// shape is required, by the scene manifest or a draw, and the meshes
+	// left unused are released again while over the memory budget
+	bool RequireMesh(ShapeType shapeType);
+	void ReleaseMesh(ShapeType shapeType);
+	void BeginMeshFrame();
+	size_t GetResidentMeshBytes() const { return m_residentMeshBytes; }
+	void SetMeshMemoryBudget(size_t memoryBudget) { m_meshMemoryBudget = memoryBudget; }
+
+	// the sphere is loaded as an icosphere of this many subdivisions, 0 for the UV sphere
+	void SetIcosphereSubdivisions(int subdivisions) { m_icosphereSubdivisions = subdivisions; }
+	// mesh file of the Imported shape, empty for none
+	void SetImportedMeshPath(const std::string& path) { m_importedMeshPath = path; }
 
 	// methods for drawing the shape mesh in the display window
 	void DrawBoxMesh() const;
-	void DrawConeMesh(
-		bool bDrawBottom=true) const;
-	void DrawCylinderMesh(
-		bool bDrawTop=true,
-		bool bDrawBottom=true,
-		bool bDrawSides = true) const;
+	void DrawConeMesh() const;
+	void DrawCylinderMesh() const;
 	void DrawPlaneMesh() const;
 	void DrawPrismMesh() const;
 	void DrawTetrahedronMesh() const;
 	void DrawPyramid4Mesh() const;
 	void DrawSphereMesh() const;
-	void DrawHalfSphereMesh() const;
-	void DrawTaperedCylinderMesh(
-		bool bDrawTop = true,
-		bool bDrawBottom = true,
-		bool bDrawSides = true) const;
+	void DrawTaperedCylinderMesh() const;
 	void DrawTorusMesh() const;
-	void DrawHalfTorusMesh() const;
 	void DrawOctahedronMesh() const;
 	void DrawDecahedronMesh() const;
-	//void DrawDodecahedronMesh() const;
-	//void DrawIcosahedronMesh() const;
+	void DrawDodecahedronMesh() const;
+	void DrawIcosahedronMesh() const;
+	void DrawImportedMesh() const;
+
+	// packs the loaded triangle meshes into the shared 
+	// geometry pool used for GPU-driven drawing; with a
+	// surface compute manager the parametric ones are
+	// written into it on the GPU instead of uploaded
+	void BuildGeometryPool(SurfaceComputeManager* pSurfaceCompute = nullptr);
+	std::shared_ptr<GeometryPool> GetGeometryPool() const { return m_pGeometryPool; }
+	bool GetPoolMeshID(ShapeType shapeType, GLuint& meshID) const;
+	bool GetPoolMeshID(ShapeType shapeType, const std::string& submesh, GLuint& meshID) const;
+	// draws one level of detail of a pooled mesh from the float vertices of the pool
+	void DrawPoolLod(GLuint meshID, GLuint level) const;
+
+	// named index ranges of the loaded meshes, such as the caps of a
+	// cylinder or the halves of a sphere, drawn like meshes of their own
+	const SubmeshRange* FindSubmesh(ShapeType shapeType, const std::string& name) const;
+
+	// CPU copy of a loaded mesh in object space, nullptr when it is not loaded
+	const MeshData* GetMeshData(ShapeType shapeType) const;
+	void DrawSubmesh(ShapeType shapeType, const SubmeshRange& submesh) const;
+
+	// true when back faces of the shape, or of one of its named
+	// ranges, can be culled; a part of a closed mesh is open
+	bool CanCullBackFaces(ShapeType shapeType, const std::string& submesh = "") const;
 
-		// called to set the memory layout 
-	// template for shader data
-	void SetShaderMemoryLayout();
+	// true for pooled meshes with enough triangles to be worth
+	// an occlusion query of their bounding box
+	bool IsHeavyMesh(ShapeType shapeType) const;
+
+	// switches a loaded triangle mesh to the compact QuantizedVertex
+	// format; its draws then need the decoding ranges in the shader
+	bool QuantizeMesh(ShapeType shapeType, const char* meshName);
+	const VertexDecoding* GetVertexDecoding(ShapeType shapeType) const;
+	void DrawQuantizedMesh(ShapeType shapeType) const;
+
+	// draws only the meshlets of the shape that pass the frustum
+	// and, for closed meshes, the normal cone test
+	bool HasMeshlets(ShapeType shapeType) const { return m_meshletMeshes.count(shapeType) != 0; }
+	void DrawMeshlets(ShapeType shapeType,
+		const glm::mat4& model,
+		const Frustum& frustum,
+		const glm::vec3& cameraPosition) const;
 
 
 private:
@@ -123,6 +192,96 @@ private:
 	std::shared_ptr<ConeMesh> m_pConeMesh; // smart pointer to the ConeMesh object
 	std::shared_ptr<PlaneMesh> m_pPlaneMesh; // smart pointer to the PlaneMesh object
 	std::shared_ptr<TetrahedronMesh> m_pTetrahedronMesh; // smart pointer to the TetrahedronMesh object
+	std::shared_ptr<GeometryPool> m_pGeometryPool; // smart pointer to the shared GeometryPool object
+	MeshCache m_meshCache; // on-disk copies of the generated meshes
+
+	std::unordered_map<ShapeType, MeshData> m_meshData; // CPU copies of the loaded triangle meshes
+	std::unordered_map<ShapeType, std::vector<MeshData>> m_lodMeshData; // coarser levels of the pooled meshes
+	std::unordered_map<ShapeType, GLuint> m_poolMeshIDs; // geometry pool mesh ID of each shape
+	std::unordered_map<ShapeType, bool> m_bCullBackFaces; // closed meshes with normalized winding
+	std::unordered_map<ShapeType, SurfaceComputeManager::SURFACE> m_surfaces; // parameters of the parametric meshes
+	std::unordered_map<ShapeType, std::vector<SubmeshRange>> m_submeshes; // named ranges of the loaded meshes
+	std::map<std::pair<ShapeType, std::string>, GLuint> m_poolSubmeshIDs; // geometry pool mesh ID of each named range
+
+	// meshlet ordered copy of a mesh, sharing the mesh's vertex buffer
+	struct MeshletMesh
+	{
+		GLuint vbo;         // Handle for the vertex buffer of the mesh
+		GLuint ebo;         // Handle for the meshlet ordered index buffer
+		bool bQuantized;    // The vertex buffer holds QuantizedVertex data
+		std::vector<Meshlet> meshlets;
+	};
+	std::unordered_map<ShapeType, MeshletMesh> m_meshletMeshes;
+
+	// quantized copy of a mesh with its own vertex and index buffers
+	struct QuantizedMesh
+	{
+		GLuint vbos[2];     // Handles for the quantized vertex and index buffers
+		GLuint nIndices;    // Number of indices of the mesh
+		VertexDecoding decoding;
+	};
+	std::unordered_map<ShapeType, QuantizedMesh> m_quantizedMeshes;
+
+	// a loaded mesh of the registry
+	struct ResidentMesh
+	{
+		size_t gpuBytes;		// Bytes of its buffers outside the geometry pool
+		GLuint lastUsedFrame;	// Frame in which it was last required
+	};
+	std::unordered_map<ShapeType, ResidentMesh> m_residentMeshes;
+	std::unordered_set<ShapeType> m_failedMeshes; // shapes whose mesh could not be loaded
+	size_t m_residentMeshBytes;
+	size_t m_meshMemoryBudget; // 0 keeps every loaded mesh
+	GLuint m_meshFrame;
+	int m_icosphereSubdivisions;
+	std::string m_importedMeshPath;
+
+	// runs the loader of the shape, false when it has no mesh
+	bool LoadShapeMesh(ShapeType shapeType);
+
+	// the buffers of a mesh this class uploads itself, nullptr for the
+	// box, cone, plane and tetrahedron, whose classes own their buffers
+	GLMesh* GetGLMesh(ShapeType shapeType);
+	const GLMesh* GetGLMesh(ShapeType shapeType) const;
+
+	// bytes of the vertex, quantized and meshlet buffers of a loaded mesh
+	size_t MeasureMeshBytes(ShapeType shapeType) const;
+
+	// welds and optimizes a mesh given as triangle list indices
+	// over its vertices, reports the results and uploads it indexed
+	void UploadWeldedMesh(GLMesh& mesh,
+		const char* meshName,
+		std::vector<GLfloat>& vertices,
+		std::vector<GLuint>& indices);
+
+	// creates the vertex and index buffers of a mesh from final data
+	void UploadMesh(GLMesh& mesh,
+		const GLfloat* vertices,
+		GLuint vertexCount,
+		const GLuint* indices,
+		GLuint indexCount);
+
+	// uploads one of the compile-time solid tables
+	void LoadSolidMesh(GLMesh& mesh, ShapeType shapeType, const SolidGeometry& geometry);
+	// uploads the quantized copy that a solid table carries, in place of QuantizeMesh()
+	void UploadQuantizedSolid(ShapeType shapeType, const SolidGeometry& geometry);
+
+	// uploads a generated mesh from the mesh cache, or generates,
+	// welds, optimizes and stores it when the cache has no valid copy
+	void LoadCachedMesh(GLMesh& mesh,
+		ShapeType shapeType,
+		const char* meshName,
+		const std::string& key,
+		const std::function<void(MeshData& meshData, std::vector<IndexRange>& parts)>& generate);
+
+	// coarser levels of a loaded mesh made by the simplifier on worker
+	// threads, read from the mesh cache when it holds every level; the
+	// faceted generated shapes have a seam at every vertex and keep
+	// their full detail, the smooth ones use their parametric levels
+	void LoadSimplifiedLods(ShapeType shapeType, const char* meshName, const char* keyName);
+
+	// splits an indexed mesh into meshlets for cluster culling
+	void BuildMeshletMesh(ShapeType shapeType, GLuint vertexBuffer, const MeshData& meshData);
 	/*
 	std::shared_ptr<CylinderMesh> m_pCylinderMesh; // smart pointer to the CylinderMesh object
 	std::shared_ptr<PlaneMesh> m_pPlaneMesh; // smart pointer to the PlaneMesh object
@@ -135,9 +294,4 @@ private:
 	std::shared_ptr<OctahedronMesh> m_pOctahedronMesh; // smart pointer to the OctahedronMesh object
 	std::shared_ptr<DecahedronMesh> m_pDecahedronMesh; // smart pointer to the DecahedronMesh object
 	*/
-
-	// called to calculate the normal for 
-	// the passed in coordinates
-	glm::vec3 CalculateTriangleNormal(
-		glm::vec3 px, glm::vec3 py, glm::vec3 pz);
 };
\ No newline at end of file
@@ -0,0 +1,360 @@
+#include "SolidTables.h"
+
+using namespace SolidMath;
+
+namespace
+{
+	constexpr Vec3 g_Origin = { 0.0, 0.0, 0.0 };
+	constexpr double g_GoldenRatio = 1.61803398874989484820;
+
+	// texture coords of the corners of a quad face
+	constexpr Vec2 g_QuadUVs[4] = { { 0.0, 0.0 }, { 1.0, 0.0 }, { 1.0, 1.0 }, { 0.0, 1.0 } };
+
+	///////////////////////////////////////////////////
+	//	MakeBox()
+	//
+	//	Unit cube, each face has its own four vertices. The
+	//	u and v axes of every face keep the texture mapping
+	//	the box had, and u x v is the face normal.
+	///////////////////////////////////////////////////
+	constexpr SolidTable<24, 36> MakeBox()
+	{
+		struct BoxFace
+		{
+			Vec3 normal, uAxis, vAxis;
+		};
+		const BoxFace faces[6] = {
+			{ { 0.0, 0.0, -1.0 }, { -1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 } },	// Back
+			{ { 0.0, -1.0, 0.0 }, { 1.0, 0.0, 0.0 }, { 0.0, 0.0, 1.0 } },	// Bottom
+			{ { -1.0, 0.0, 0.0 }, { 0.0, 0.0, 1.0 }, { 0.0, 1.0, 0.0 } },	// Left
+			{ { 1.0, 0.0, 0.0 }, { 0.0, 0.0, -1.0 }, { 0.0, 1.0, 0.0 } },	// Right
+			{ { 0.0, 1.0, 0.0 }, { 1.0, 0.0, 0.0 }, { 0.0, 0.0, -1.0 } },	// Top
+			{ { 0.0, 0.0, 1.0 }, { 1.0, 0.0, 0.0 }, { 0.0, 1.0, 0.0 } }		// Front
+		};
+
+		SolidTable<24, 36> table{};
+		for (const BoxFace& face : faces)
+		{
+			Vec3 corners[4] = {};
+			for (GLuint k = 0; k < 4; ++k)
+			{
+				corners[k] = 0.5 * face.normal + (g_QuadUVs[k].x - 0.5) * face.uAxis + (g_QuadUVs[k].y - 0.5) * face.vAxis;
+			}
+			table.AddFace(corners, g_QuadUVs, 4, g_Origin);
+		}
+		return table;
+	}
+
+	///////////////////////////////////////////////////
+	//	MakeTetrahedron()
+	//
+	//	The 3-sided pyramid on a unit triangle in the xz plane,
+	//	with flat faces and one texture coord per corner.
+	///////////////////////////////////////////////////
+	constexpr SolidTable<12, 12> MakeTetrahedron()
+	{
+		const double h = Sqrt(3.0) / 2.0;	// Height of the base triangle
+		const double y = Sqrt(3.0) / 6.0;	// Distance of the base center from its edge
+		const Vec3 positions[4] = {
+			{ 0.0, 0.0, 0.0 },	// Origin
+			{ 1.0, 0.0, 0.0 },	// X-axis
+			{ 0.5, 0.0, h },	// Z-axis
+			{ 0.5, h, y }		// Zenith-Apex
+		};
+		const Vec2 uvs[4] = { { 0.5, 0.0 }, { 1.0, 0.0 }, { y, y }, { h, h } };
+		const GLuint faces[4][3] = { { 0, 1, 2 }, { 0, 1, 3 }, { 0, 2, 3 }, { 2, 1, 3 } };
+
+		Vec3 center = g_Origin;
+		for (const Vec3& position : positions)
+		{
+			center = center + 0.25 * position;
+		}
+
+		SolidTable<12, 12> table{};
+		for (const auto& face : faces)
+		{
+			Vec3 corners[3] = { positions[face[0]], positions[face[1]], positions[face[2]] };
+			Vec2 cornerUVs[3] = { uvs[face[0]], uvs[face[1]], uvs[face[2]] };
+			table.AddFace(corners, cornerUVs, 3, center);
+		}
+		return table;
+	}
+
+	///////////////////////////////////////////////////
+	//	MakeOctahedron()
+	//
+	//	Shares its six vertices between the faces, with the
+	//	normals pointing away from the center.
+	///////////////////////////////////////////////////
+	constexpr SolidTable<6, 24> MakeOctahedron()
+	{
+		const Vec3 positions[6] = {
+			{ 0.0, 1.0, 0.0 },	// Top vertex
+			{ 1.0, 0.0, 0.0 },	// Front vertex
+			{ 0.0, 0.0, 1.0 },	// Right vertex
+			{ -1.0, 0.0, 0.0 },	// Back vertex
+			{ 0.0, 0.0, -1.0 },	// Left vertex
+			{ 0.0, -1.0, 0.0 }	// Bottom vertex
+		};
+		const Vec2 uvs[6] = { { 0.5, 1.0 }, { 1.0, 0.5 }, { 0.5, 0.0 }, { 0.0, 0.5 }, { 0.5, 0.5 }, { 0.5, 0.5 } };
+		const GLuint faces[8][3] = {
+			{ 0, 1, 2 }, { 0, 2, 3 }, { 0, 3, 4 }, { 0, 4, 1 },	// Top pyramid
+			{ 5, 1, 2 }, { 5, 2, 3 }, { 5, 3, 4 }, { 5, 4, 1 }	// Bottom pyramid
+		};
+
+		SolidTable<6, 24> table{};
+		for (GLuint i = 0; i < 6; ++i)
+		{
+			table.AddVertex(positions[i], Normalize(positions[i]), uvs[i]);
+		}
+		for (const auto& face : faces)
+		{
+			table.AddTriangle(face[0], face[1], face[2], g_Origin);
+		}
+		return table;
+	}
+
+	///////////////////////////////////////////////////
+	//	MakeDecahedron()
+	//
+	//	Pentagonal bipyramid of radius 1, a ring of five
+	//	vertices in the xz plane and a top and bottom apex.
+	///////////////////////////////////////////////////
+	constexpr SolidTable<7, 30> MakeDecahedron()
+	{
+		const double height = Cos(Pi / 5.0);
+		const Vec2 uvs[7] = {
+			{ 0.0, 1.0 },	// Top vertex
+			{ 0.9, 0.7 },
+			{ 0.7, 0.9 },
+			{ 0.3, 0.7 },
+			{ 0.1, 0.7 },
+			{ 1.0, 0.0 },
+			{ 0.3, 0.9 }	// Bottom vertex
+		};
+		const GLuint faces[10][3] = {
+			{ 0, 1, 2 }, { 0, 2, 3 }, { 0, 3, 4 }, { 0, 4, 5 }, { 0, 5, 1 },
+			{ 1, 5, 6 }, { 1, 6, 2 }, { 2, 6, 3 }, { 3, 6, 4 }, { 4, 6, 5 }
+		};
+
+		SolidTable<7, 30> table{};
+		const Vec3 top = { 0.0, height, 0.0 };
+		table.AddVertex(top, Normalize(top), uvs[0]);
+		for (GLuint i = 0; i < 5; ++i)
+		{
+			double theta = 2.0 * Pi * i / 5.0;
+			Vec3 ring = { Cos(theta), 0.0, Sin(theta) };
+			table.AddVertex(ring, ring, uvs[1 + i]);
+		}
+		const Vec3 bottom = { 0.0, -height, 0.0 };
+		table.AddVertex(bottom, Normalize(bottom), uvs[6]);
+
+		for (const auto& face : faces)
+		{
+			table.AddTriangle(face[0], face[1], face[2], g_Origin);
+		}
+		return table;
+	}
+
+	// squared length of the shortest edge between any two points
+	constexpr double ShortestDistanceSquared(const Vec3* points, GLuint count)
+	{
+		double shortest = Dot(points[1] - points[0], points[1] - points[0]);
+		for (GLuint i = 0; i < count; ++i)
+		{
+			for (GLuint j = i + 1; j < count; ++j)
+			{
+				double distance = Dot(points[j] - points[i], points[j] - points[i]);
+				shortest = distance < shortest ? distance : shortest;
+			}
+		}
+		return shortest;
+	}
+
+	constexpr bool IsEdge(const Vec3& a, const Vec3& b, double edgeSquared)
+	{
+		double distance = Dot(b - a, b - a);
+		return distance < edgeSquared * (1.0 + 1e-9);
+	}
+
+	// reverses the corners of a polygon that winds clockwise from
+	// outside, so texture coords given per corner are not mirrored
+	constexpr void WindOutward(Vec3* corners, GLuint cornerCount)
+	{
+		if (Dot(Cross(corners[1] - corners[0], corners[2] - corners[0]), corners[0]) < 0.0)
+		{
+			for (GLuint k = 0; k < cornerCount / 2; ++k)
+			{
+				Vec3 corner = corners[k];
+				corners[k] = corners[cornerCount - 1 - k];
+				corners[cornerCount - 1 - k] = corner;
+			}
+		}
+	}
+
+	// the 12 icosahedron vertices (0, +-1, +-phi) and their cyclic
+	// permutations, scaled to radius 1
+	struct IcosahedronVertices
+	{
+		Vec3 positions[12];
+	};
+
+	constexpr IcosahedronVertices MakeIcosahedronVertices()
+	{
+		IcosahedronVertices result{};
+		const double scale = 1.0 / Sqrt(1.0 + g_GoldenRatio * g_GoldenRatio);
+		GLuint count = 0;
+		for (int a = -1; a <= 1; a += 2)
+		{
+			for (int b = -1; b <= 1; b += 2)
+			{
+				result.positions[count++] = scale * Vec3{ 0.0, 1.0 * a, g_GoldenRatio * b };
+				result.positions[count++] = scale * Vec3{ 1.0 * a, g_GoldenRatio * b, 0.0 };
+				result.positions[count++] = scale * Vec3{ g_GoldenRatio * b, 0.0, 1.0 * a };
+			}
+		}
+		return result;
+	}
+
+	///////////////////////////////////////////////////
+	//	MakeIcosahedron()
+	//
+	//	Radius 1 with flat faces. The 20 faces are the
+	//	triples of vertices that are all one edge apart.
+	///////////////////////////////////////////////////
+	constexpr SolidTable<60, 60> MakeIcosahedron()
+	{
+		const IcosahedronVertices icosahedron = MakeIcosahedronVertices();
+		const Vec3* positions = icosahedron.positions;
+		const double edgeSquared = ShortestDistanceSquared(positions, 12);
+		const Vec2 uvs[3] = { PolygonUV(0, 3), PolygonUV(1, 3), PolygonUV(2, 3) };
+
+		SolidTable<60, 60> table{};
+		for (GLuint i = 0; i < 12; ++i)
+		{
+			for (GLuint j = i + 1; j < 12; ++j)
+			{
+				for (GLuint k = j + 1; k < 12; ++k)
+				{
+					if (IsEdge(positions[i], positions[j], edgeSquared) &&
+						IsEdge(positions[j], positions[k], edgeSquared) &&
+						IsEdge(positions[i], positions[k], edgeSquared))
+					{
+						Vec3 corners[3] = { positions[i], positions[j], positions[k] };
+						WindOutward(corners, 3);
+						table.AddFace(corners, uvs, 3, g_Origin);
+					}
+				}
+			}
+		}
+		return table;
+	}
+
+	///////////////////////////////////////////////////
+	//	MakeDodecahedron()
+	//
+	//	Radius 1 with flat pentagons. The dodecahedron is the
+	//	dual of the icosahedron, so each icosahedron vertex
+	//	picks the five dodecahedron vertices closest to it as
+	//	a face, which are then put in order around its edges.
+	///////////////////////////////////////////////////
+	constexpr SolidTable<60, 108> MakeDodecahedron()
+	{
+		// (+-1, +-1, +-1) and the cyclic permutations of
+		// (0, +-phi, +-1/phi), scaled to radius 1; this is the
+		// orientation whose face centers are the icosahedron vertices
+		Vec3 positions[20] = {};
+		const double scale = 1.0 / Sqrt(3.0);
+		GLuint count = 0;
+		for (int a = -1; a <= 1; a += 2)
+		{
+			for (int b = -1; b <= 1; b += 2)
+			{
+				for (int c = -1; c <= 1; c += 2)
+				{
+					positions[count++] = scale * Vec3{ 1.0 * a, 1.0 * b, 1.0 * c };
+				}
+				positions[count++] = scale * Vec3{ 0.0, g_GoldenRatio * a, b / g_GoldenRatio };
+				positions[count++] = scale * Vec3{ g_GoldenRatio * a, b / g_GoldenRatio, 0.0 };
+				positions[count++] = scale * Vec3{ b / g_GoldenRatio, 0.0, g_GoldenRatio * a };
+			}
+		}
+		const double edgeSquared = ShortestDistanceSquared(positions, 20);
+		const Vec2 uvs[5] = { PolygonUV(0, 5), PolygonUV(1, 5), PolygonUV(2, 5), PolygonUV(3, 5), PolygonUV(4, 5) };
+
+		const IcosahedronVertices icosahedron = MakeIcosahedronVertices();
+		SolidTable<60, 108> table{};
+		for (const Vec3& direction : icosahedron.positions)
+		{
+			double nearest = -1.0;
+			for (const Vec3& position : positions)
+			{
+				nearest = Dot(position, direction) > nearest ? Dot(position, direction) : nearest;
+			}
+
+			GLuint face[5] = {};
+			GLuint faceCount = 0;
+			for (GLuint i = 0; i < 20 && faceCount < 5; ++i)
+			{
+				if (Dot(positions[i], direction) > nearest - 1e-9)
+				{
+					face[faceCount++] = i;
+				}
+			}
+
+			// walk the edges so consecutive corners share one
+			Vec3 corners[5] = { positions[face[0]] };
+			bool bUsed[5] = { true };
+			for (GLuint k = 1; k < 5; ++k)
+			{
+				for (GLuint candidate = 1; candidate < 5; ++candidate)
+				{
+					if (!bUsed[candidate] && IsEdge(corners[k - 1], positions[face[candidate]], edgeSquared))
+					{
+						corners[k] = positions[face[candidate]];
+						bUsed[candidate] = true;
+						break;
+					}
+				}
+			}
+			WindOutward(corners, 5);
+			table.AddFace(corners, uvs, 5, g_Origin);
+		}
+		return table;
+	}
+
+	template <GLuint VertexCount, GLuint IndexCount>
+	constexpr SolidTable<VertexCount, IndexCount> Quantized(SolidTable<VertexCount, IndexCount> table)
+	{
+		table.Quantize();
+		return table;
+	}
+
+	constexpr SolidTable<24, 36> g_BoxTable = Quantized(MakeBox());
+	constexpr SolidTable<12, 12> g_TetrahedronTable = Quantized(MakeTetrahedron());
+	constexpr SolidTable<6, 24> g_OctahedronTable = Quantized(MakeOctahedron());
+	constexpr SolidTable<7, 30> g_DecahedronTable = Quantized(MakeDecahedron());
+	constexpr SolidTable<60, 108> g_DodecahedronTable = Quantized(MakeDodecahedron());
+	constexpr SolidTable<60, 60> g_IcosahedronTable = Quantized(MakeIcosahedron());
+
+	static_assert(g_BoxTable.IsComplete(), "box table must be full and wound outward");
+	static_assert(g_TetrahedronTable.IsComplete(), "tetrahedron table must be full and wound outward");
+	static_assert(g_OctahedronTable.IsComplete(), "octahedron table must be full and wound outward");
+	static_assert(g_DecahedronTable.IsComplete(), "decahedron table must be full and wound outward");
+	static_assert(g_DodecahedronTable.IsComplete(), "dodecahedron table must be full and wound outward");
+	static_assert(g_IcosahedronTable.IsComplete(), "icosahedron table must be full and wound outward");
+
+	constexpr SolidGeometry g_BoxGeometry = g_BoxTable.GetGeometry();
+	constexpr SolidGeometry g_TetrahedronGeometry = g_TetrahedronTable.GetGeometry();
+	constexpr SolidGeometry g_OctahedronGeometry = g_OctahedronTable.GetGeometry();
+	constexpr SolidGeometry g_DecahedronGeometry = g_DecahedronTable.GetGeometry();
+	constexpr SolidGeometry g_DodecahedronGeometry = g_DodecahedronTable.GetGeometry();
+	constexpr SolidGeometry g_IcosahedronGeometry = g_IcosahedronTable.GetGeometry();
+}
+
+const SolidGeometry& GetBoxGeometry() { return g_BoxGeometry; }
+const SolidGeometry& GetTetrahedronGeometry() { return g_TetrahedronGeometry; }
+const SolidGeometry& GetOctahedronGeometry() { return g_OctahedronGeometry; }
+const SolidGeometry& GetDecahedronGeometry() { return g_DecahedronGeometry; }
+const SolidGeometry& GetDodecahedronGeometry() { return g_DodecahedronGeometry; }
+const SolidGeometry& GetIcosahedronGeometry() { return g_IcosahedronGeometry; }
@@ -0,0 +1,335 @@
+#ifndef SOLID_TABLES_H
+#define SOLID_TABLES_H
+#pragma once
+
+#include <GL/glew.h>
+
+#include "MeshData.h"
+#include "VertexQuantization.h"
+
+// Final vertex and index data of a fixed-topology solid, already
+// welded and wound counter-clockwise from outside, ready to upload
+struct SolidGeometry
+{
+	const GLfloat* vertices;	// Interleaved vertex data in the MeshData layout
+	GLuint vertexCount;
+	const GLuint* indices;		// Triangle list indices
+	GLuint indexCount;
+	const QuantizedVertex* quantizedVertices;	// The vertices as QuantizeVertices() writes them
+	const GLfloat* decoding;	// Position center and extent, UV minimum and size of the quantized vertices
+
+	VertexDecoding GetVertexDecoding() const
+	{
+		return VertexDecoding{ glm::vec3(decoding[0], decoding[1], decoding[2]),
+			glm::vec3(decoding[3], decoding[4], decoding[5]),
+			glm::vec4(decoding[6], decoding[7], decoding[8], decoding[9]) };
+	}
+
+	MeshData ToMeshData() const	// CPU copy of the tables
+	{
+		return MeshData{
+			std::vector<GLfloat>(vertices, vertices + vertexCount * MeshData::FloatsPerVertex),
+			std::vector<GLuint>(indices, indices + indexCount) };
+	}
+};
+
+// tables generated at compile time, see SolidTables.cpp
+const SolidGeometry& GetBoxGeometry();
+const SolidGeometry& GetTetrahedronGeometry();
+const SolidGeometry& GetOctahedronGeometry();
+const SolidGeometry& GetDecahedronGeometry();
+const SolidGeometry& GetDodecahedronGeometry();
+const SolidGeometry& GetIcosahedronGeometry();
+
+namespace SolidMath
+{
+	// double precision vector math usable in constant expressions,
+	// the results are rounded to float only when they are stored
+	struct Vec2
+	{
+		double x, y;
+	};
+
+	struct Vec3
+	{
+		double x, y, z;
+	};
+
+	constexpr Vec3 operator+(const Vec3& a, const Vec3& b) { return { a.x + b.x, a.y + b.y, a.z + b.z }; }
+	constexpr Vec3 operator-(const Vec3& a, const Vec3& b) { return { a.x - b.x, a.y - b.y, a.z - b.z }; }
+	constexpr Vec3 operator*(double s, const Vec3& a) { return { s * a.x, s * a.y, s * a.z }; }
+	constexpr double Dot(const Vec3& a, const Vec3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+	constexpr Vec3 Cross(const Vec3& a, const Vec3& b)
+	{
+		return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+	}
+
+	// Newton iterations from above converge for every positive value
+	constexpr double Sqrt(double value)
+	{
+		if (value <= 0.0)
+		{
+			return 0.0;
+		}
+		double root = value > 1.0 ? value : 1.0;
+		for (int i = 0; i < 64; ++i)
+		{
+			root = 0.5 * (root + value / root);
+		}
+		return root;
+	}
+
+	constexpr Vec3 Normalize(const Vec3& a)
+	{
+		return (1.0 / Sqrt(Dot(a, a))) * a;
+	}
+
+	constexpr float Abs(float value)
+	{
+		return value < 0.0f ? -value : value;
+	}
+
+	constexpr float Clamp(float value, float minimum, float maximum)
+	{
+		return value < minimum ? minimum : (value > maximum ? maximum : value);
+	}
+
+	// rounds half away from zero like std::round(), in double so the 0.5 adds exactly
+	constexpr long Round(float value)
+	{
+		return value < 0.0f ? -static_cast<long>(0.5 - value) : static_cast<long>(value + 0.5);
+	}
+
+	// the encodings of QuantizeVertices(), in the same float steps
+	constexpr GLshort EncodeSnorm(float value)
+	{
+		return static_cast<GLshort>(Round(Clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	constexpr GLushort EncodeUnorm(float value)
+	{
+		return static_cast<GLushort>(Round(Clamp(value, 0.0f, 1.0f) * 65535.0f));
+	}
+
+	constexpr double Pi = 3.14159265358979323846;
+
+	// Taylor series after reducing the angle to [-pi, pi]
+	constexpr double Sin(double angle)
+	{
+		while (angle > Pi)
+		{
+			angle -= 2.0 * Pi;
+		}
+		while (angle < -Pi)
+		{
+			angle += 2.0 * Pi;
+		}
+		double term = angle;
+		double sum = angle;
+		for (int n = 1; n < 20; ++n)
+		{
+			term *= -angle * angle / ((2 * n) * (2 * n + 1));
+			sum += term;
+		}
+		return sum;
+	}
+
+	constexpr double Cos(double angle)
+	{
+		return Sin(angle + 0.5 * Pi);
+	}
+
+	// corner of a regular polygon inscribed in the unit texture square,
+	// the first corner at the top and the others counter-clockwise
+	constexpr Vec2 PolygonUV(GLuint corner, GLuint cornerCount)
+	{
+		double angle = 0.5 * Pi + 2.0 * Pi * corner / cornerCount;
+		return { 0.5 + 0.5 * Cos(angle), 0.5 + 0.5 * Sin(angle) };
+	}
+}
+
+/***********************************************************
+ *  SolidTable
+ *
+ *  Fixed size vertex and index arrays that constexpr
+ *  functions fill in, so the finished solid is a constant
+ *  and nothing about it is computed at startup.
+ ***********************************************************/
+template <GLuint VertexCount, GLuint IndexCount>
+struct SolidTable
+{
+	GLfloat vertices[VertexCount * MeshData::FloatsPerVertex];
+	GLuint indices[IndexCount];
+	GLuint vertexCount;		// Vertices added so far
+	GLuint indexCount;		// Indices added so far
+	QuantizedVertex quantizedVertices[VertexCount];	// Filled in by Quantize()
+	GLfloat decoding[10];	// Position center and extent, UV minimum and size
+
+	constexpr GLuint AddVertex(const SolidMath::Vec3& position, const SolidMath::Vec3& normal, const SolidMath::Vec2& uv)
+	{
+		GLfloat* vertex = vertices + vertexCount * MeshData::FloatsPerVertex;
+		vertex[0] = static_cast<GLfloat>(position.x);
+		vertex[1] = static_cast<GLfloat>(position.y);
+		vertex[2] = static_cast<GLfloat>(position.z);
+		vertex[3] = static_cast<GLfloat>(normal.x);
+		vertex[4] = static_cast<GLfloat>(normal.y);
+		vertex[5] = static_cast<GLfloat>(normal.z);
+		vertex[6] = static_cast<GLfloat>(uv.x);
+		vertex[7] = static_cast<GLfloat>(uv.y);
+		return vertexCount++;
+	}
+
+	constexpr SolidMath::Vec3 Position(GLuint vertex) const
+	{
+		const GLfloat* p = vertices + vertex * MeshData::FloatsPerVertex;
+		return { p[0], p[1], p[2] };
+	}
+
+	constexpr SolidMath::Vec3 Normal(GLuint vertex) const
+	{
+		const GLfloat* n = vertices + vertex * MeshData::FloatsPerVertex + 3;
+		return { n[0], n[1], n[2] };
+	}
+
+	// adds the triangle wound counter-clockwise when seen from
+	// outside, which for a convex solid is away from its center
+	constexpr void AddTriangle(GLuint a, GLuint b, GLuint c, const SolidMath::Vec3& center)
+	{
+		using namespace SolidMath;
+		Vec3 normal = Cross(Position(b) - Position(a), Position(c) - Position(a));
+		bool bOutward = Dot(normal, Position(a) - center) > 0.0;
+		indices[indexCount++] = a;
+		indices[indexCount++] = bOutward ? b : c;
+		indices[indexCount++] = bOutward ? c : b;
+	}
+
+	// adds a flat convex polygon with its own vertices and face
+	// normal, triangulated as a fan in counter-clockwise order
+	constexpr void AddFace(const SolidMath::Vec3* corners, const SolidMath::Vec2* uvs, GLuint cornerCount, const SolidMath::Vec3& center)
+	{
+		using namespace SolidMath;
+		Vec3 normal = Normalize(Cross(corners[1] - corners[0], corners[2] - corners[0]));
+		bool bOutward = Dot(normal, corners[0] - center) > 0.0;
+		if (!bOutward)
+		{
+			normal = -1.0 * normal;
+		}
+
+		GLuint first = vertexCount;
+		for (GLuint k = 0; k < cornerCount; ++k)
+		{
+			GLuint corner = bOutward ? k : cornerCount - 1 - k;
+			AddVertex(corners[corner], normal, uvs[corner]);
+		}
+		for (GLuint k = 1; k + 1 < cornerCount; ++k)
+		{
+			indices[indexCount++] = first;
+			indices[indexCount++] = first + k;
+			indices[indexCount++] = first + k + 1;
+		}
+	}
+
+	// true when the table is full and every triangle faces the
+	// same way as the normals of its vertices
+	constexpr bool IsComplete() const
+	{
+		if (vertexCount != VertexCount || indexCount != IndexCount)
+		{
+			return false;
+		}
+		for (GLuint i = 0; i < IndexCount; i += 3)
+		{
+			using namespace SolidMath;
+			Vec3 a = Position(indices[i]);
+			Vec3 normal = Cross(Position(indices[i + 1]) - a, Position(indices[i + 2]) - a);
+			for (GLuint k = 0; k < 3; ++k)
+			{
+				if (Dot(normal, Normal(indices[i + k])) <= 0.0)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	// the QuantizedVertex copy of the finished table, so that the
+	// solid is uploaded quantized without converting it at startup
+	constexpr void Quantize()
+	{
+		using namespace SolidMath;
+		const GLfloat minimumExtent = 1e-6f;
+
+		GLfloat minimum[5] = { vertices[0], vertices[1], vertices[2], vertices[6], vertices[7] };
+		GLfloat maximum[5] = { vertices[0], vertices[1], vertices[2], vertices[6], vertices[7] };
+		for (GLuint v = 0; v < VertexCount; ++v)
+		{
+			const GLfloat* vertex = vertices + v * MeshData::FloatsPerVertex;
+			const GLfloat values[5] = { vertex[0], vertex[1], vertex[2], vertex[6], vertex[7] };
+			for (GLuint i = 0; i < 5; ++i)
+			{
+				minimum[i] = values[i] < minimum[i] ? values[i] : minimum[i];
+				maximum[i] = values[i] > maximum[i] ? values[i] : maximum[i];
+			}
+		}
+		for (GLuint i = 0; i < 3; ++i)
+		{
+			decoding[i] = (minimum[i] + maximum[i]) * 0.5f;
+			GLfloat extent = (maximum[i] - minimum[i]) * 0.5f;
+			decoding[3 + i] = extent > minimumExtent ? extent : minimumExtent;
+		}
+		for (GLuint i = 0; i < 2; ++i)
+		{
+			GLfloat size = maximum[3 + i] - minimum[3 + i];
+			decoding[6 + i] = minimum[3 + i];
+			decoding[8 + i] = size > minimumExtent ? size : minimumExtent;
+		}
+
+		for (GLuint v = 0; v < VertexCount; ++v)
+		{
+			const GLfloat* vertex = vertices + v * MeshData::FloatsPerVertex;
+			QuantizedVertex& out = quantizedVertices[v];
+			for (GLuint i = 0; i < 3; ++i)
+			{
+				out.position[i] = EncodeSnorm((vertex[i] - decoding[i]) / decoding[3 + i]);
+			}
+			out.position[3] = 0;
+
+			// octahedron encoding of the unit normal, zero length normals are stored as +Z
+			GLfloat normal[3] = { vertex[3], vertex[4], vertex[5] };
+			GLfloat length = static_cast<GLfloat>(Sqrt(static_cast<double>(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2])));
+			GLfloat encoded[2] = { 0.0f, 0.0f };
+			if (length > 0.0f)
+			{
+				for (GLfloat& value : normal)
+				{
+					value /= length;
+				}
+				GLfloat sum = Abs(normal[0]) + Abs(normal[1]) + Abs(normal[2]);
+				for (GLfloat& value : normal)
+				{
+					value /= sum;
+				}
+				encoded[0] = normal[0];
+				encoded[1] = normal[1];
+				if (normal[2] < 0.0f)
+				{
+					encoded[0] = (1.0f - Abs(normal[1])) * (normal[0] >= 0.0f ? 1.0f : -1.0f);
+					encoded[1] = (1.0f - Abs(normal[0])) * (normal[1] >= 0.0f ? 1.0f : -1.0f);
+				}
+			}
+			out.normal[0] = EncodeSnorm(encoded[0]);
+			out.normal[1] = EncodeSnorm(encoded[1]);
+
+			out.uv[0] = EncodeUnorm((vertex[6] - decoding[6]) / decoding[8]);
+			out.uv[1] = EncodeUnorm((vertex[7] - decoding[7]) / decoding[9]);
+		}
+	}
+
+	constexpr SolidGeometry GetGeometry() const
+	{
+		return { vertices, VertexCount, indices, IndexCount, quantizedVertices, decoding };
+	}
+};
+
+#endif // SOLID_TABLES_H
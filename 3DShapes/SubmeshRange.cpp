@@ -0,0 +1,45 @@
+#include "SubmeshRange.h"
+#include <algorithm>
+
+///////////////////////////////////////////////////
+//	BuildSubmeshRange()
+///////////////////////////////////////////////////
+SubmeshRange BuildSubmeshRange(const std::string& name,
+	const MeshData& meshData,
+	const std::vector<IndexRange>& parts,
+	size_t firstPart,
+	size_t partCount)
+{
+	const IndexRange& first = parts[firstPart];
+	const IndexRange& last = parts[firstPart + partCount - 1];
+
+	SubmeshRange submesh;
+	submesh.name = name;
+	submesh.firstIndex = first.firstIndex;
+	submesh.indexCount = last.firstIndex + last.indexCount - first.firstIndex;
+	submesh.baseVertex = 0;
+
+	// bounding sphere centered on the bounding box of the positions the range uses
+	auto position = [&](GLuint index)
+	{
+		const GLfloat* vertex = &meshData.vertices[static_cast<size_t>(meshData.indices[index]) * MeshData::FloatsPerVertex];
+		return glm::vec3(vertex[0], vertex[1], vertex[2]);
+	};
+	GLuint endIndex = submesh.firstIndex + submesh.indexCount;
+	glm::vec3 minCorner(0.0f);
+	glm::vec3 maxCorner(0.0f);
+	for (GLuint i = submesh.firstIndex; i < endIndex; ++i)
+	{
+		minCorner = (i == submesh.firstIndex) ? position(i) : glm::min(minCorner, position(i));
+		maxCorner = (i == submesh.firstIndex) ? position(i) : glm::max(maxCorner, position(i));
+	}
+
+	glm::vec3 center = (minCorner + maxCorner) * 0.5f;
+	float radius = 0.0f;
+	for (GLuint i = submesh.firstIndex; i < endIndex; ++i)
+	{
+		radius = std::max(radius, glm::length(position(i) - center));
+	}
+	submesh.bounds = glm::vec4(center, radius);
+	return submesh;
+}
@@ -0,0 +1,46 @@
+#ifndef SUBMESH_RANGE_H
+#define SUBMESH_RANGE_H
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <string>
+#include <vector>
+
+#include "MeshData.h"
+
+// A named index range of a mesh that is drawn like a mesh of its own,
+// such as the top of a cylinder or the upper half of a sphere
+struct SubmeshRange
+{
+	std::string name;	// Name the scene refers to the range by
+	GLuint firstIndex;	// First index of the range in the index buffer of the mesh
+	GLuint indexCount;	// Number of indices of the range
+	GLint baseVertex;	// Offset added to every index of the range
+	glm::vec4 bounds;	// Object-space bounding sphere of the vertices it uses (xyz center, w radius)
+
+	IndexRange Indices() const { return { firstIndex, indexCount }; }
+
+	// draws the range from the bound vertex and element buffers
+	void Draw() const
+	{
+		glDrawElementsBaseVertex(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, Indices().Offset(), baseVertex);
+	}
+};
+
+///////////////////////////////////////////////////
+//	BuildSubmeshRange()
+//
+//	Joins partCount parts of a mesh, starting at firstPart,
+//	into one named range. The parts have to follow each
+//	other in the index buffer, as the parts of the welded
+//	and optimized meshes do. The bounding sphere is found
+//	the way the geometry pool finds that of a whole mesh.
+///////////////////////////////////////////////////
+SubmeshRange BuildSubmeshRange(const std::string& name,
+	const MeshData& meshData,
+	const std::vector<IndexRange>& parts,
+	size_t firstPart,
+	size_t partCount = 1);
+
+#endif // SUBMESH_RANGE_H
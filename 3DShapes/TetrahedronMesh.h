@@ -4,6 +4,8 @@
 
 #include <GL/glew.h>
 
+#include "MeshData.h"
+
 class TetrahedronMesh
 {
 public:
@@ -13,21 +15,17 @@ public:
 	~TetrahedronMesh();
 
 	void CreateTetrahedronMesh();// method for loading the shape mesh data into memory
+	void ReleaseTetrahedronMesh(); // deletes the buffers until the next CreateTetrahedronMesh()
 	void DrawTetrahedronMesh() const;
 
 private:
 	struct GLMesh
 	{
-		GLuint vao;         // Handle for the vertex array object
 		GLuint vbos[2];     // Handles for the vertex buffer objects
 		GLuint nVertices;	// Number of vertices for the mesh
 		GLuint nIndices;    // Number of indices for the mesh
 	};
 
 	GLMesh m_TetrahedronMesh;
-
-	void SetTetrahedronMeshMemoryLayout();
-
-	bool m_bMemoryLayoutDone;
 };
 #endif // TETRAHEDRON_MESH_H
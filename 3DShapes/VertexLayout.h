@@ -0,0 +1,206 @@
+#ifndef VERTEX_LAYOUT_H
+#define VERTEX_LAYOUT_H
+#pragma once
+
+#include <GL/glew.h>
+#include <cstddef>
+
+// Size in bytes of one attribute, packed formats hold every component in 4 bytes
+constexpr GLuint GetAttribSize(GLint components, GLenum type)
+{
+	return (type == GL_INT_2_10_10_10_REV || type == GL_UNSIGNED_INT_2_10_10_10_REV) ? 4 :
+		components * ((type == GL_BYTE || type == GL_UNSIGNED_BYTE) ? 1 :
+		(type == GL_SHORT || type == GL_UNSIGNED_SHORT || type == GL_HALF_FLOAT) ? 2 : 4);
+}
+
+// True when the context has direct state access (core in OpenGL 4.5), checked once
+inline bool HasDirectStateAccess()
+{
+	static const bool bSupported = GLEW_VERSION_4_5 || GLEW_ARB_direct_state_access;
+	return bSupported;
+}
+
+///////////////////////////////////////////////////
+//	SetBufferData() / CreateBufferData()
+//
+//	Fills a buffer object with the bytes, creating it
+//	first for CreateBufferData(). Without direct state
+//	access the buffer is filled through the copy-write
+//	target, which no VAO records, so the bound VAO and
+//	array buffer are left alone.
+///////////////////////////////////////////////////
+inline void SetBufferData(GLuint buffer, GLsizeiptr byteSize, const void* data, GLenum usage = GL_STATIC_DRAW)
+{
+	if (HasDirectStateAccess())
+	{
+		glNamedBufferData(buffer, byteSize, data, usage);
+	}
+	else
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferData(GL_COPY_WRITE_BUFFER, byteSize, data, usage);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+}
+
+inline GLuint CreateBufferData(GLsizeiptr byteSize, const void* data, GLenum usage = GL_STATIC_DRAW)
+{
+	GLuint buffer = 0;
+	if (HasDirectStateAccess())
+	{
+		glCreateBuffers(1, &buffer);
+	}
+	else
+	{
+		glGenBuffers(1, &buffer);
+	}
+	SetBufferData(buffer, byteSize, data, usage);
+	return buffer;
+}
+
+// Writes a range of a buffer made by CreateBufferData()
+inline void SetBufferSubData(GLuint buffer, GLintptr offset, GLsizeiptr byteSize, const void* data)
+{
+	if (HasDirectStateAccess())
+	{
+		glNamedBufferSubData(buffer, offset, byteSize, data);
+	}
+	else
+	{
+		glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, offset, byteSize, data);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+	}
+}
+
+// One vertex attribute read by the shader at the given location
+template <GLuint location, GLint components, GLenum type, GLboolean normalized = GL_FALSE>
+struct Attr
+{
+	static constexpr GLuint Location = location;
+	static constexpr GLint Components = components;
+	static constexpr GLenum Type = type;
+	static constexpr GLboolean Normalized = normalized;
+	static constexpr GLuint Size = GetAttribSize(components, type);
+};
+
+///////////////////////////////////////////////////
+//	VertexLayout
+//
+//	An interleaved vertex format made of Attr entries in
+//	memory order. The stride and offsets are computed at
+//	compile time and the formats are set with direct state
+//	access on buffer binding 0. Every mesh of a layout
+//	shares one VAO and only swaps the bound buffers.
+//	Without direct state access the VAO is bound to be
+//	edited and the attribute pointers are set again each
+//	time its buffers change.
+///////////////////////////////////////////////////
+template <typename... Attribs>
+class VertexLayout
+{
+public:
+	static constexpr GLuint AttribCount = sizeof...(Attribs);
+	static constexpr GLuint VertexBinding = 0;
+
+	// byte offset of the attribute at the index inside a vertex
+	static constexpr GLuint Offset(GLuint index)
+	{
+		const GLuint sizes[] = { Attribs::Size..., 0 };
+		GLuint offset = 0;
+		for (GLuint i = 0; i < index && i < AttribCount; ++i)
+		{
+			offset += sizes[i];
+		}
+		return offset;
+	}
+
+	// byte size of one vertex
+	static constexpr GLuint Stride()
+	{
+		return Offset(AttribCount);
+	}
+
+	// creates a VAO with the attribute formats of the layout
+	static GLuint CreateVertexArray()
+	{
+		GLuint vao = 0;
+		if (!HasDirectStateAccess())
+		{
+			// the pointers need a bound array buffer, they are set by SetBuffers()
+			glGenVertexArrays(1, &vao);
+			return vao;
+		}
+		glCreateVertexArrays(1, &vao);
+
+		GLuint index = 0;
+		int expand[] = { 0, (SetAttribFormat<Attribs>(vao, Offset(index++)), 0)... };
+		(void)expand;
+		return vao;
+	}
+
+	// attaches the vertex and index buffers of a mesh to a VAO of this layout
+	static void SetBuffers(GLuint vao, GLuint vertexBuffer, GLuint indexBuffer = 0)
+	{
+		if (!HasDirectStateAccess())
+		{
+			BindBuffers(vao, vertexBuffer, indexBuffer);
+			glBindVertexArray(0);
+			return;
+		}
+		glVertexArrayVertexBuffer(vao, VertexBinding, vertexBuffer, 0, Stride());
+		glVertexArrayElementBuffer(vao, indexBuffer);
+	}
+
+	// the VAO shared by every mesh of this layout
+	static GLuint GetSharedVertexArray()
+	{
+		static const GLuint vao = CreateVertexArray();
+		return vao;
+	}
+
+	// points the shared VAO at the buffers of a mesh and binds it for drawing;
+	// mesh buffers are created with DSA, so it can stay bound between draws
+	static void Bind(GLuint vertexBuffer, GLuint indexBuffer = 0)
+	{
+		GLuint vao = GetSharedVertexArray();
+		if (!HasDirectStateAccess())
+		{
+			BindBuffers(vao, vertexBuffer, indexBuffer);
+			return;
+		}
+		SetBuffers(vao, vertexBuffer, indexBuffer);
+		glBindVertexArray(vao);
+	}
+
+private:
+	// binds the VAO and records the buffers and attribute pointers in it,
+	// the VAO is left bound
+	static void BindBuffers(GLuint vao, GLuint vertexBuffer, GLuint indexBuffer)
+	{
+		glBindVertexArray(vao);
+		glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+		GLuint index = 0;
+		int expand[] = { 0, (SetAttribPointer<Attribs>(Offset(index++)), 0)... };
+		(void)expand;
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	}
+
+	template <typename Attrib>
+	static void SetAttribPointer(GLuint offset)
+	{
+		glEnableVertexAttribArray(Attrib::Location);
+		glVertexAttribPointer(Attrib::Location, Attrib::Components, Attrib::Type, Attrib::Normalized,
+			Stride(), reinterpret_cast<const void*>(static_cast<size_t>(offset)));
+	}
+
+	template <typename Attrib>
+	static void SetAttribFormat(GLuint vao, GLuint offset)
+	{
+		glEnableVertexArrayAttrib(vao, Attrib::Location);
+		glVertexArrayAttribFormat(vao, Attrib::Location, Attrib::Components, Attrib::Type, Attrib::Normalized, offset);
+		glVertexArrayAttribBinding(vao, Attrib::Location, VertexBinding);
+	}
+};
+
+#endif // VERTEX_LAYOUT_H
@@ -0,0 +1,148 @@
+#include "VertexQuantization.h"
+#include "MeshData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace
+{
+	const float g_SnormScale = 32767.0f;	// Largest snorm16 value
+	const float g_UnormScale = 65535.0f;	// Largest unorm16 value
+	const float g_MinExtent = 1e-6f;		// Keeps flat bounds from dividing by zero
+
+	GLshort EncodeSnorm(float value)
+	{
+		return static_cast<GLshort>(std::round(std::max(-1.0f, std::min(1.0f, value)) * g_SnormScale));
+	}
+
+	GLushort EncodeUnorm(float value)
+	{
+		return static_cast<GLushort>(std::round(std::max(0.0f, std::min(1.0f, value)) * g_UnormScale));
+	}
+
+	// snorm16 to float as OpenGL converts normalized attributes
+	float DecodeSnorm(GLshort value)
+	{
+		return std::max(value / g_SnormScale, -1.0f);
+	}
+
+	float DecodeUnorm(GLushort value)
+	{
+		return value / g_UnormScale;
+	}
+
+	// projects the normal onto an octahedron and unfolds it into the -1..1 square
+	glm::vec2 EncodeOctahedron(glm::vec3 normal)
+	{
+		normal /= std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+		glm::vec2 encoded(normal.x, normal.y);
+		if (normal.z < 0.0f)
+		{
+			encoded.x = (1.0f - std::abs(normal.y)) * (normal.x >= 0.0f ? 1.0f : -1.0f);
+			encoded.y = (1.0f - std::abs(normal.x)) * (normal.y >= 0.0f ? 1.0f : -1.0f);
+		}
+		return encoded;
+	}
+
+	// must match OctahedronDecode() in the vertex shader
+	glm::vec3 DecodeOctahedron(glm::vec2 encoded)
+	{
+		glm::vec3 normal(encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y));
+		float t = std::max(-normal.z, 0.0f);
+		normal.x += normal.x >= 0.0f ? -t : t;
+		normal.y += normal.y >= 0.0f ? -t : t;
+		return glm::normalize(normal);
+	}
+}
+
+///////////////////////////////////////////////////
+//	QuantizeVertices()
+///////////////////////////////////////////////////
+std::vector<QuantizedVertex> QuantizeVertices(const std::vector<GLfloat>& vertices,
+	VertexDecoding& decoding,
+	QuantizationReport& report)
+{
+	const GLuint vertexCount = static_cast<GLuint>(vertices.size() / MeshData::FloatsPerVertex);
+	std::vector<QuantizedVertex> quantized(vertexCount);
+
+	report = QuantizationReport{};
+	report.vertexCount = vertexCount;
+	report.floatBytes = static_cast<GLuint>(vertices.size() * sizeof(GLfloat));
+	report.quantizedBytes = static_cast<GLuint>(quantized.size() * sizeof(QuantizedVertex));
+	if (vertexCount == 0)
+	{
+		decoding = VertexDecoding{ glm::vec3(0.0f), glm::vec3(1.0f), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f) };
+		return quantized;
+	}
+
+	// bounds of the positions and texture coords
+	glm::vec3 positionMin(vertices[0], vertices[1], vertices[2]);
+	glm::vec3 positionMax = positionMin;
+	glm::vec2 uvMin(vertices[6], vertices[7]);
+	glm::vec2 uvMax = uvMin;
+	for (GLuint v = 0; v < vertexCount; ++v)
+	{
+		const GLfloat* vertex = &vertices[v * MeshData::FloatsPerVertex];
+		positionMin = glm::min(positionMin, glm::vec3(vertex[0], vertex[1], vertex[2]));
+		positionMax = glm::max(positionMax, glm::vec3(vertex[0], vertex[1], vertex[2]));
+		uvMin = glm::min(uvMin, glm::vec2(vertex[6], vertex[7]));
+		uvMax = glm::max(uvMax, glm::vec2(vertex[6], vertex[7]));
+	}
+
+	decoding.positionCenter = (positionMin + positionMax) * 0.5f;
+	decoding.positionExtent = glm::max((positionMax - positionMin) * 0.5f, glm::vec3(g_MinExtent));
+	glm::vec2 uvSize = glm::max(uvMax - uvMin, glm::vec2(g_MinExtent));
+	decoding.uvRange = glm::vec4(uvMin, uvSize);
+
+	for (GLuint v = 0; v < vertexCount; ++v)
+	{
+		const GLfloat* vertex = &vertices[v * MeshData::FloatsPerVertex];
+		glm::vec3 position(vertex[0], vertex[1], vertex[2]);
+		glm::vec3 normal(vertex[3], vertex[4], vertex[5]);
+		glm::vec2 uv(vertex[6], vertex[7]);
+		QuantizedVertex& out = quantized[v];
+
+		glm::vec3 scaledPosition = (position - decoding.positionCenter) / decoding.positionExtent;
+		out.position[0] = EncodeSnorm(scaledPosition.x);
+		out.position[1] = EncodeSnorm(scaledPosition.y);
+		out.position[2] = EncodeSnorm(scaledPosition.z);
+		out.position[3] = 0;
+
+		glm::vec3 decodedPosition = decoding.positionCenter + decoding.positionExtent *
+			glm::vec3(DecodeSnorm(out.position[0]), DecodeSnorm(out.position[1]), DecodeSnorm(out.position[2]));
+		report.maxPositionError = std::max(report.maxPositionError, glm::length(decodedPosition - position));
+
+		// zero length normals are stored as +Z and not measured
+		float normalLength = glm::length(normal);
+		glm::vec2 octahedron = normalLength > 0.0f ? EncodeOctahedron(normal / normalLength) : glm::vec2(0.0f);
+		out.normal[0] = EncodeSnorm(octahedron.x);
+		out.normal[1] = EncodeSnorm(octahedron.y);
+		if (normalLength > 0.0f)
+		{
+			glm::vec3 decodedNormal = DecodeOctahedron(glm::vec2(DecodeSnorm(out.normal[0]), DecodeSnorm(out.normal[1])));
+			float cosine = std::max(-1.0f, std::min(1.0f, glm::dot(decodedNormal, normal / normalLength)));
+			report.maxNormalError = std::max(report.maxNormalError, glm::degrees(std::acos(cosine)));
+		}
+
+		glm::vec2 scaledUV = (uv - uvMin) / uvSize;
+		out.uv[0] = EncodeUnorm(scaledUV.x);
+		out.uv[1] = EncodeUnorm(scaledUV.y);
+
+		glm::vec2 decodedUV = uvMin + uvSize * glm::vec2(DecodeUnorm(out.uv[0]), DecodeUnorm(out.uv[1]));
+		report.maxUVError = std::max(report.maxUVError, std::max(std::abs(decodedUV.x - uv.x), std::abs(decodedUV.y - uv.y)));
+	}
+
+	return quantized;
+}
+
+///////////////////////////////////////////////////
+//	PrintQuantizationReport()
+///////////////////////////////////////////////////
+void PrintQuantizationReport(const char* meshName, const QuantizationReport& report)
+{
+	std::cout << "INFO: quantized " << meshName << ": " << report.vertexCount << " vertices, "
+		<< report.floatBytes << " -> " << report.quantizedBytes << " bytes, max error position "
+		<< report.maxPositionError << ", normal " << report.maxNormalError << " deg, uv "
+		<< report.maxUVError << std::endl;
+}
@@ -0,0 +1,63 @@
+#ifndef VERTEX_QUANTIZATION_H
+#define VERTEX_QUANTIZATION_H
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+#include "VertexLayout.h"
+
+// Compact vertex: snorm16 position, octahedron encoded snorm16
+// normal, and unorm16 texture coords, 16 bytes instead of 32
+struct QuantizedVertex
+{
+	GLshort position[4];	// Position in the mesh bounds, the fourth value pads to 8 bytes
+	GLshort normal[2];		// Octahedron encoded unit normal
+	GLushort uv[2];			// Texture coords in the mesh UV range
+};
+
+// the QuantizedVertex format, normalized so the shader reads -1..1 and 0..1
+typedef VertexLayout<
+	Attr<0, 4, GL_SHORT, GL_TRUE>,			// Position
+	Attr<1, 2, GL_SHORT, GL_TRUE>,			// Octahedron normal
+	Attr<2, 2, GL_UNSIGNED_SHORT, GL_TRUE>	// Texture coords
+> QuantizedVertexLayout;
+
+static_assert(QuantizedVertexLayout::Stride() == sizeof(QuantizedVertex), "QuantizedVertexLayout must match QuantizedVertex");
+
+// Ranges the vertex shader uses to decode a quantized mesh
+struct VertexDecoding
+{
+	glm::vec3 positionCenter;	// Center of the position bounds
+	glm::vec3 positionExtent;	// Half size of the position bounds
+	glm::vec4 uvRange;			// UV minimum (xy) and size (zw)
+};
+
+// Quantization error measured against the float originals
+struct QuantizationReport
+{
+	GLuint vertexCount;			// Number of vertices quantized
+	float maxPositionError;		// Largest position error in object units
+	float maxNormalError;		// Largest normal error in degrees
+	float maxUVError;			// Largest texture coordinate error
+	GLuint floatBytes;			// Size of the float vertex data
+	GLuint quantizedBytes;		// Size of the quantized vertex data
+};
+
+///////////////////////////////////////////////////
+//	QuantizeVertices()
+//
+//	Converts vertices in the interleaved layout of MeshData
+//	into QuantizedVertex and fills the decoding ranges. The
+//	error of every vertex is measured after decoding it
+//	the same way the vertex shader does.
+///////////////////////////////////////////////////
+std::vector<QuantizedVertex> QuantizeVertices(const std::vector<GLfloat>& vertices,
+	VertexDecoding& decoding,
+	QuantizationReport& report);
+
+// Writes a one line summary of the report
+void PrintQuantizationReport(const char* meshName, const QuantizationReport& report);
+
+#endif // VERTEX_QUANTIZATION_H
@@ -0,0 +1,592 @@
+///////////////////////////////////////////////////////////////////////////////
+// CullingManager.cpp
+// ============
+// GPU-driven frustum and occlusion culling with indirect draw generation
+//
+//  Objects are uploaded once; every frame a compute pass culls them and
+//  writes compacted instance lists and draw commands, so the CPU work per
+//  frame does not depend on the number of objects.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CullingManager.h"
+#include "ShaderManager.h"
+#include "GeometryPool.h"
+#include "Frustum.h"
+#include "LodSelection.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <glm/gtc/type_ptr.hpp>
+
+// declaration of the global variables and defines
+namespace
+{
+    const GLuint CULL_GROUP_SIZE = 64;          // local_size_x of the culling and compaction shaders
+    const GLuint PYRAMID_GROUP_SIZE = 8;        // local_size_x/y of the depth pyramid shader
+    const GLuint OBJECT_INDEX_ATTRIBUTE = 3;    // inObjectIndex in the vertex shader
+    const GLuint OBJECT_INDEX_BINDING = 1;      // vertex buffer binding after the mesh vertices
+    const GLuint DEPTH_PYRAMID_TEXTURE_UNIT = 15;  // kept clear of the scene texture slots
+    const GLuint STATS_INTERVAL = 120;          // frames between stats read backs, each one stalls the pipeline
+
+    // shader storage binding points shared with the compute shaders
+    const GLuint OBJECT_BINDING = 0;
+    const GLuint COMMAND_BINDING = 1;
+    const GLuint VISIBLE_OBJECT_BINDING = 2;
+    const GLuint COMMAND_BUCKET_BINDING = 3;
+    const GLuint DRAW_COMMAND_BINDING = 4;
+    const GLuint DRAW_COUNT_BINDING = 5;
+    const GLuint CULL_STATS_BINDING = 6;
+    const GLuint OBJECT_LOD_BINDING = 7;
+
+    const char* g_UseObjectBufferName = "bUseObjectBuffer";
+    const char* g_QuantizedVerticesName = "bQuantizedVertices";    // the pool keeps float vertices
+
+    GLuint GroupCount(GLuint count, GLuint groupSize)
+    {
+        return (count + groupSize - 1) / groupSize;
+    }
+}
+
+/***********************************************************
+ *  CullingManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CullingManager::CullingManager(std::shared_ptr<ShaderManager> pShaderManager, std::shared_ptr<GeometryPool> pGeometryPool)
+    : m_pShaderManager(std::move(pShaderManager)),
+    m_pGeometryPool(std::move(pGeometryPool)),
+    m_bReady(false),
+    m_bIndirectCount(false),
+    m_cullProgram(0),
+    m_compactProgram(0),
+    m_depthPyramidProgram(0),
+    m_objectBuffer(0),
+    m_commandTemplateBuffer(0),
+    m_commandBuffer(0),
+    m_visibleObjectBuffer(0),
+    m_commandBucketBuffer(0),
+    m_drawCommandBuffer(0),
+    m_drawCountBuffer(0),
+    m_statsBuffer(0),
+    m_objectLodBuffer(0),
+    m_objectCount(0),
+    m_commandCount(0),
+    m_minScreenSize(0.0f),
+    m_bLod(true),
+    m_frameStats(),
+    m_statsFrame(0),
+    m_depthTexture(0),
+    m_depthPyramid(0),
+    m_depthPyramidWidth(0),
+    m_depthPyramidHeight(0),
+    m_depthPyramidLevels(0),
+    m_bDepthPyramidValid(false),
+    m_depthPyramidViewProjection(1.0f)
+{}
+
+/***********************************************************
+ *  ~CullingManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+CullingManager::~CullingManager()
+{
+    DestroyBuffers();
+    DestroyDepthPyramid();
+
+    if (m_cullProgram != 0) glDeleteProgram(m_cullProgram);
+    if (m_compactProgram != 0) glDeleteProgram(m_compactProgram);
+    if (m_depthPyramidProgram != 0) glDeleteProgram(m_depthPyramidProgram);
+}
+
+/***********************************************************
+ *  IsSupported()
+ *
+ *  Compute shaders, shader storage buffers and multi-draw
+ *  indirect are all core in OpenGL 4.3. The buffers are
+ *  also set up with direct state access.
+ ***********************************************************/
+bool CullingManager::IsSupported()
+{
+    return GLEW_VERSION_4_3 != 0 && HasDirectStateAccess();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method loads the culling compute shaders. When it
+ *  returns false the scene keeps drawing one shape at a time.
+ ***********************************************************/
+bool CullingManager::Initialize(const char* cullShaderPath, const char* compactShaderPath, const char* depthPyramidShaderPath)
+{
+    m_bReady = false;
+
+    if (!IsSupported())
+    {
+        std::cout << "INFO: OpenGL 4.3 or direct state access is not available, GPU culling is disabled" << std::endl;
+        return false;
+    }
+
+    m_cullProgram = m_pShaderManager->LoadComputeShader(cullShaderPath);
+    m_compactProgram = m_pShaderManager->LoadComputeShader(compactShaderPath);
+    m_depthPyramidProgram = m_pShaderManager->LoadComputeShader(depthPyramidShaderPath);
+    if (m_cullProgram == 0 || m_compactProgram == 0 || m_depthPyramidProgram == 0)
+    {
+        std::cerr << "Failed to load the GPU culling shaders" << std::endl;
+        return false;
+    }
+
+    // the draw count can only be read from a buffer with ARB_indirect_parameters,
+    // otherwise every command is submitted and empty ones draw nothing
+    m_bIndirectCount = GLEW_ARB_indirect_parameters != 0;
+    std::cout << "INFO: GPU culling enabled, draw count "
+        << (m_bIndirectCount ? "read from GPU buffer" : "fixed per bucket") << std::endl;
+
+    m_bReady = true;
+    return true;
+}
+
+/***********************************************************
+ *  SetObjects()
+ *
+ *  This method uploads the object data and builds one draw
+ *  command per (bucket, mesh, level) triple. The commands are
+ *  grouped by bucket so each bucket is one range of commands,
+ *  and the levels of a mesh follow each other.
+ ***********************************************************/
+void CullingManager::SetObjects(const std::vector<CULL_OBJECT>& objects, GLuint bucketCount)
+{
+    DestroyBuffers();
+
+    m_objectCount = static_cast<GLuint>(objects.size());
+    m_bucketFirstCommand.assign(bucketCount, 0);
+    m_bucketCommandCount.assign(bucketCount, 0);
+
+    // count the objects of every (bucket, mesh) pair, ordered by bucket
+    std::map<std::pair<GLuint, GLuint>, GLuint> instanceCounts;
+    for (const CULL_OBJECT& object : objects)
+    {
+        instanceCounts[{ object.bucket, object.meshID }]++;
+    }
+
+    // lay out the commands and reserve an instance range for each,
+    // every level has room for all objects of the pair
+    std::vector<DRAW_COMMAND> commands;
+    std::vector<GLuint> commandBuckets;
+    std::map<std::pair<GLuint, GLuint>, GLuint> commandIndices;
+    GLuint baseInstance = 0;
+    for (const auto& entry : instanceCounts)
+    {
+        GLuint bucket = entry.first.first;
+        GLuint meshID = entry.first.second;
+
+        if (m_bucketCommandCount[bucket] == 0)
+        {
+            m_bucketFirstCommand[bucket] = static_cast<GLuint>(commands.size());
+        }
+        commandIndices[entry.first] = static_cast<GLuint>(commands.size());
+
+        for (GLuint level = 0; level < m_pGeometryPool->GetLodCount(meshID); level++)
+        {
+            const GeometryPool::MeshRange& range = m_pGeometryPool->GetMeshRange(m_pGeometryPool->GetLodMesh(meshID, level));
+            commands.push_back({ range.indexCount, 0, range.firstIndex, range.baseVertex, baseInstance });
+            commandBuckets.push_back(bucket);
+            commandBuckets.push_back(m_bucketFirstCommand[bucket]);
+            m_bucketCommandCount[bucket]++;
+            baseInstance += entry.second;
+        }
+    }
+    m_commandCount = static_cast<GLuint>(commands.size());
+
+    // object data with world-space bounding spheres
+    std::vector<OBJECT_DATA> objectData(objects.size());
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        const CULL_OBJECT& object = objects[i];
+        glm::vec4 bounds = m_pGeometryPool->GetMeshRange(object.meshID).bounds;
+        float scale = std::max(glm::length(glm::vec3(object.model[0])),
+            std::max(glm::length(glm::vec3(object.model[1])), glm::length(glm::vec3(object.model[2]))));
+
+        objectData[i].model = object.model;
+        objectData[i].color = object.color;
+        objectData[i].bounds = glm::vec4(glm::vec3(object.model * glm::vec4(glm::vec3(bounds), 1.0f)), bounds.w * scale);
+        objectData[i].commandIndex = commandIndices[{ object.bucket, object.meshID }];
+        objectData[i].lodCount = m_pGeometryPool->GetLodCount(object.meshID);
+    }
+
+    if (m_objectCount == 0)
+    {
+        return;
+    }
+
+    GLuint buffers[9];
+    glGenBuffers(9, buffers);
+    m_objectBuffer = buffers[0];
+    m_commandTemplateBuffer = buffers[1];
+    m_commandBuffer = buffers[2];
+    m_visibleObjectBuffer = buffers[3];
+    m_commandBucketBuffer = buffers[4];
+    m_drawCommandBuffer = buffers[5];
+    m_drawCountBuffer = buffers[6];
+    m_statsBuffer = buffers[7];
+    m_objectLodBuffer = buffers[8];
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, objectData.size() * sizeof(OBJECT_DATA), objectData.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandTemplateBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, commands.size() * sizeof(DRAW_COMMAND), commands.data(), GL_STATIC_COPY);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, commands.size() * sizeof(DRAW_COMMAND), commands.data(), GL_DYNAMIC_COPY);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_visibleObjectBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, baseInstance * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBucketBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, commandBuckets.size() * sizeof(GLuint), commandBuckets.data(), GL_STATIC_DRAW);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawCommandBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, commands.size() * sizeof(DRAW_COMMAND), nullptr, GL_DYNAMIC_COPY);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_drawCountBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, std::max<GLuint>(bucketCount, 1) * sizeof(GLuint), nullptr, GL_DYNAMIC_COPY);
+
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_statsBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, sizeof(CULL_STATS), nullptr, GL_DYNAMIC_READ);
+
+    std::vector<GLuint> objectLods(m_objectCount, NO_LOD);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_objectLodBuffer);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, objectLods.size() * sizeof(GLuint), objectLods.data(), GL_DYNAMIC_COPY);
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+    // the visible object list is read per instance; baseInstance
+    // of each command selects that command's range of the list
+    GLuint vao = m_pGeometryPool->GetVertexArray();
+    glVertexArrayVertexBuffer(vao, OBJECT_INDEX_BINDING, m_visibleObjectBuffer, 0, sizeof(GLuint));
+    glVertexArrayBindingDivisor(vao, OBJECT_INDEX_BINDING, 1);
+    glVertexArrayAttribIFormat(vao, OBJECT_INDEX_ATTRIBUTE, 1, GL_UNSIGNED_INT, 0);
+    glVertexArrayAttribBinding(vao, OBJECT_INDEX_ATTRIBUTE, OBJECT_INDEX_BINDING);
+    glEnableVertexArrayAttrib(vao, OBJECT_INDEX_ATTRIBUTE);
+
+    std::cout << "INFO: GPU culling " << m_objectCount << " objects with "
+        << m_commandCount << " draw commands in " << bucketCount << " buckets" << std::endl;
+}
+
+/***********************************************************
+ *  CullObjects()
+ *
+ *  This method resets the draw commands, tests every object
+ *  against the view frustum (and the depth pyramid of the
+ *  previous frame) and packs the non-empty draw commands.
+ ***********************************************************/
+void CullingManager::CullObjects(const glm::mat4& view, const glm::mat4& projection, bool bUseDepthPyramid)
+{
+    if (!m_bReady || m_objectCount == 0)
+    {
+        return;
+    }
+
+    // the counters still hold the previous frame
+    if (++m_statsFrame >= STATS_INTERVAL)
+    {
+        ReadFrameStats();
+        m_statsFrame = 0;
+    }
+
+    Frustum frustum = Frustum::FromMatrix(projection * view);
+
+    // start from empty commands and counts
+    glBindBuffer(GL_COPY_READ_BUFFER, m_commandTemplateBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_commandBuffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, m_commandCount * sizeof(DRAW_COMMAND));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_drawCountBuffer);
+    glClearBufferData(GL_COPY_WRITE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, m_statsBuffer);
+    glClearBufferData(GL_COPY_WRITE_BUFFER, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BINDING, m_objectBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BINDING, m_commandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VISIBLE_OBJECT_BINDING, m_visibleObjectBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BUCKET_BINDING, m_commandBucketBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_COMMAND_BINDING, m_drawCommandBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, DRAW_COUNT_BINDING, m_drawCountBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, CULL_STATS_BINDING, m_statsBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_LOD_BINDING, m_objectLodBuffer);
+
+    // projected diameter in pixels = 2 * radius * projectionScale / distance,
+    // an orthographic projection has no perspective divide
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    bool bPerspective = projection[3][3] == 0.0f;
+    float projectionScale = projection[1][1] * 0.5f * static_cast<float>(viewport[3]);
+    glm::vec3 cameraPosition = glm::vec3(glm::inverse(view)[3]);
+
+    // culling pass, one invocation per object
+    bool bOcclusion = bUseDepthPyramid && m_bDepthPyramidValid;
+    glUseProgram(m_cullProgram);
+    glUniform1ui(glGetUniformLocation(m_cullProgram, "objectCount"), m_objectCount);
+    glUniform4fv(glGetUniformLocation(m_cullProgram, "frustumPlanes"), 6, glm::value_ptr(frustum.planes[0]));
+    glUniform1f(glGetUniformLocation(m_cullProgram, "minScreenSize"), m_minScreenSize);
+    glUniform1f(glGetUniformLocation(m_cullProgram, "projectionScale"), projectionScale);
+    glUniform1i(glGetUniformLocation(m_cullProgram, "bPerspective"), bPerspective);
+    glUniform3fv(glGetUniformLocation(m_cullProgram, "cameraPosition"), 1, glm::value_ptr(cameraPosition));
+    glUniform1i(glGetUniformLocation(m_cullProgram, "bUseLod"), m_bLod);
+    glUniform1f(glGetUniformLocation(m_cullProgram, "lodBaseSize"), LOD_BASE_SIZE);
+    glUniform1f(glGetUniformLocation(m_cullProgram, "lodHysteresis"), LOD_HYSTERESIS);
+    glUniform1i(glGetUniformLocation(m_cullProgram, "bUseDepthPyramid"), bOcclusion);
+    if (bOcclusion)
+    {
+        glActiveTexture(GL_TEXTURE0 + DEPTH_PYRAMID_TEXTURE_UNIT);
+        glBindTexture(GL_TEXTURE_2D, m_depthPyramid);
+        glActiveTexture(GL_TEXTURE0);
+        glUniform1i(glGetUniformLocation(m_cullProgram, "depthPyramid"), DEPTH_PYRAMID_TEXTURE_UNIT);
+        glUniform2f(glGetUniformLocation(m_cullProgram, "depthPyramidSize"),
+            static_cast<float>(m_depthPyramidWidth), static_cast<float>(m_depthPyramidHeight));
+        glUniform1f(glGetUniformLocation(m_cullProgram, "depthPyramidMaxLevel"), static_cast<float>(m_depthPyramidLevels - 1));
+        glUniformMatrix4fv(glGetUniformLocation(m_cullProgram, "previousViewProjection"), 1, GL_FALSE, glm::value_ptr(m_depthPyramidViewProjection));
+    }
+    glDispatchCompute(GroupCount(m_objectCount, CULL_GROUP_SIZE), 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // compaction pass, one invocation per command
+    glUseProgram(m_compactProgram);
+    glUniform1ui(glGetUniformLocation(m_compactProgram, "commandCount"), m_commandCount);
+    glDispatchCompute(GroupCount(m_commandCount, CULL_GROUP_SIZE), 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    // back to the scene shader
+    m_pShaderManager->use();
+}
+
+/***********************************************************
+ *  ReadFrameStats()
+ *
+ *  This method reads back the culling counters of the last
+ *  frame and reports how many draws each test removed.
+ ***********************************************************/
+void CullingManager::ReadFrameStats()
+{
+    glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBuffer(GL_COPY_READ_BUFFER, m_statsBuffer);
+    glGetBufferSubData(GL_COPY_READ_BUFFER, 0, sizeof(CULL_STATS), &m_frameStats);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+
+    std::cout << "INFO: frame stats - " << m_frameStats.visibleCount << " of " << m_objectCount << " objects drawn, removed: "
+        << m_frameStats.frustumCulled << " frustum, "
+        << m_frameStats.contributionCulled << " contribution (< " << m_minScreenSize << " px), "
+        << m_frameStats.occlusionCulled << " occlusion" << std::endl;
+    std::cout << "INFO: frame stats - " << m_frameStats.drawnTriangles << " triangles drawn with LOD "
+        << (m_bLod ? "on" : "off") << ", " << m_frameStats.fullDetailTriangles << " at full detail" << std::endl;
+}
+
+/***********************************************************
+ *  BeginDraw()
+ *
+ *  This method binds the geometry pool and the indirect
+ *  buffers written by CullObjects().
+ ***********************************************************/
+void CullingManager::BeginDraw() const
+{
+    m_pGeometryPool->Bind();
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BINDING, m_objectBuffer);
+    if (m_bIndirectCount)
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_drawCommandBuffer);
+        glBindBuffer(GL_PARAMETER_BUFFER_ARB, m_drawCountBuffer);
+    }
+    else
+    {
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_commandBuffer);
+    }
+    m_pShaderManager->setBoolValue(g_UseObjectBufferName, true);
+    m_pShaderManager->setBoolValue(g_QuantizedVerticesName, false);
+}
+
+/***********************************************************
+ *  DrawBucket()
+ *
+ *  This method draws every visible object of a bucket with
+ *  a single multi-draw call. The shader state for the bucket
+ *  must already be set.
+ ***********************************************************/
+void CullingManager::DrawBucket(GLuint bucket) const
+{
+    if (bucket >= m_bucketCommandCount.size() || m_bucketCommandCount[bucket] == 0)
+    {
+        return;
+    }
+
+    const void* firstCommand = reinterpret_cast<const void*>(
+        static_cast<uintptr_t>(m_bucketFirstCommand[bucket] * sizeof(DRAW_COMMAND)));
+    if (m_bIndirectCount)
+    {
+        glMultiDrawElementsIndirectCountARB(GL_TRIANGLES, GL_UNSIGNED_INT, firstCommand,
+            static_cast<GLintptr>(bucket * sizeof(GLuint)), m_bucketCommandCount[bucket], sizeof(DRAW_COMMAND));
+    }
+    else
+    {
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, firstCommand,
+            m_bucketCommandCount[bucket], sizeof(DRAW_COMMAND));
+    }
+}
+
+/***********************************************************
+ *  EndDraw()
+ *
+ *  This method restores the state used for drawing one
+ *  shape at a time.
+ ***********************************************************/
+void CullingManager::EndDraw() const
+{
+    m_pShaderManager->setBoolValue(g_UseObjectBufferName, false);
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+    if (m_bIndirectCount)
+    {
+        glBindBuffer(GL_PARAMETER_BUFFER_ARB, 0);
+    }
+    glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  UpdateDepthPyramid()
+ *
+ *  This method copies the depth buffer of the frame that was
+ *  just rendered and reduces it into a mip chain that keeps
+ *  the farthest depth. The next frame tests against it.
+ ***********************************************************/
+void CullingManager::UpdateDepthPyramid(const glm::mat4& view, const glm::mat4& projection)
+{
+    if (!m_bReady)
+    {
+        return;
+    }
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    if (viewport[2] <= 0 || viewport[3] <= 0)
+    {
+        return;
+    }
+    if (viewport[2] != m_depthPyramidWidth || viewport[3] != m_depthPyramidHeight)
+    {
+        CreateDepthPyramid(viewport[2], viewport[3]);
+    }
+
+    glActiveTexture(GL_TEXTURE0 + DEPTH_PYRAMID_TEXTURE_UNIT);
+    glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+    glCopyTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    glUseProgram(m_depthPyramidProgram);
+    glUniform1i(glGetUniformLocation(m_depthPyramidProgram, "sourceDepth"), DEPTH_PYRAMID_TEXTURE_UNIT);
+
+    GLint width = m_depthPyramidWidth;
+    GLint height = m_depthPyramidHeight;
+    for (GLint level = 0; level < m_depthPyramidLevels; level++)
+    {
+        // level 0 copies the depth texture, the rest reduce the level above
+        if (level == 0)
+        {
+            glUniform1i(glGetUniformLocation(m_depthPyramidProgram, "bCopyLevel"), true);
+            glUniform1i(glGetUniformLocation(m_depthPyramidProgram, "sourceLevel"), 0);
+        }
+        else
+        {
+            glBindTexture(GL_TEXTURE_2D, m_depthPyramid);
+            glUniform1i(glGetUniformLocation(m_depthPyramidProgram, "bCopyLevel"), false);
+            glUniform1i(glGetUniformLocation(m_depthPyramidProgram, "sourceLevel"), level - 1);
+        }
+
+        glBindImageTexture(0, m_depthPyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+        glDispatchCompute(GroupCount(width, PYRAMID_GROUP_SIZE), GroupCount(height, PYRAMID_GROUP_SIZE), 1);
+        glMemoryBarrier(GL_SHADER_IMAGE_ACCESS_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+        width = std::max(1, width / 2);
+        height = std::max(1, height / 2);
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    m_pShaderManager->use();
+
+    m_depthPyramidViewProjection = projection * view;
+    m_bDepthPyramidValid = true;
+}
+
+/***********************************************************
+ *  CreateDepthPyramid()
+ *
+ *  This method creates the depth copy and the R32F pyramid
+ *  for the current viewport size.
+ ***********************************************************/
+void CullingManager::CreateDepthPyramid(GLint width, GLint height)
+{
+    DestroyDepthPyramid();
+
+    m_depthPyramidWidth = width;
+    m_depthPyramidHeight = height;
+    m_depthPyramidLevels = 1 + static_cast<GLint>(std::floor(std::log2(static_cast<float>(std::max(width, height)))));
+
+    glGenTextures(1, &m_depthTexture);
+    glBindTexture(GL_TEXTURE_2D, m_depthTexture);
+    glTexStorage2D(GL_TEXTURE_2D, 1, GL_DEPTH_COMPONENT24, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    glGenTextures(1, &m_depthPyramid);
+    glBindTexture(GL_TEXTURE_2D, m_depthPyramid);
+    glTexStorage2D(GL_TEXTURE_2D, m_depthPyramidLevels, GL_R32F, width, height);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+/***********************************************************
+ *  DestroyBuffers()
+ *
+ *  This method frees the object and draw command buffers.
+ ***********************************************************/
+void CullingManager::DestroyBuffers()
+{
+    GLuint buffers[9] = { m_objectBuffer, m_commandTemplateBuffer, m_commandBuffer,
+        m_visibleObjectBuffer, m_commandBucketBuffer, m_drawCommandBuffer, m_drawCountBuffer, m_statsBuffer,
+        m_objectLodBuffer };
+    if (m_objectBuffer != 0)
+    {
+        glDeleteBuffers(9, buffers);
+    }
+
+    m_objectBuffer = m_commandTemplateBuffer = m_commandBuffer = 0;
+    m_visibleObjectBuffer = m_commandBucketBuffer = m_drawCommandBuffer = m_drawCountBuffer = 0;
+    m_statsBuffer = 0;
+    m_objectLodBuffer = 0;
+    m_statsFrame = 0;
+    m_objectCount = 0;
+    m_commandCount = 0;
+}
+
+/***********************************************************
+ *  DestroyDepthPyramid()
+ *
+ *  This method frees the depth copy and pyramid textures.
+ ***********************************************************/
+void CullingManager::DestroyDepthPyramid()
+{
+    if (m_depthTexture != 0) glDeleteTextures(1, &m_depthTexture);
+    if (m_depthPyramid != 0) glDeleteTextures(1, &m_depthPyramid);
+
+    m_depthTexture = 0;
+    m_depthPyramid = 0;
+    m_depthPyramidWidth = 0;
+    m_depthPyramidHeight = 0;
+    m_depthPyramidLevels = 0;
+    m_bDepthPyramidValid = false;
+}
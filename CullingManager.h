@@ -0,0 +1,127 @@
+///////////////////////////////////////////////////////////////////////////////
+// CullingManager.h
+// ============
+// GPU-driven frustum and occlusion culling with indirect draw generation
+//
+//  Objects are uploaded once; every frame a compute pass culls them and
+//  writes compacted instance lists and draw commands, so the CPU work per
+//  frame does not depend on the number of objects.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef CULLINGMANAGER_H
+#define CULLINGMANAGER_H
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class ShaderManager; // Forward Declaration
+class GeometryPool; // Forward Declaration
+
+class CullingManager {
+public:
+    // Per-object data, matches ObjectData in the vertex and culling shaders (std430)
+    struct OBJECT_DATA {
+        glm::mat4 model;
+        glm::vec4 color;
+        glm::vec4 bounds;       // World-space bounding sphere (xyz center, w radius)
+        GLuint commandIndex;    // Draw command that renders the object's mesh at level 0
+        GLuint lodCount;        // Levels of the mesh, their commands follow commandIndex
+        GLuint padding[2];
+    };
+
+    // Matches DrawElementsIndirectCommand
+    struct DRAW_COMMAND {
+        GLuint count;
+        GLuint instanceCount;
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+
+    // Number of objects removed by each culling test in one frame
+    struct CULL_STATS {
+        GLuint frustumCulled;
+        GLuint occlusionCulled;
+        GLuint contributionCulled;  // Projected size below the minimum screen size
+        GLuint visibleCount;
+        GLuint drawnTriangles;      // Triangles of the selected levels of the visible objects
+        GLuint fullDetailTriangles; // Triangles the visible objects have at level 0
+    };
+
+    // An object drawn from the geometry pool
+    struct CULL_OBJECT {
+        GLuint meshID;      // Geometry pool mesh of the object
+        GLuint bucket;      // Shader state bucket (texture, material) the object is drawn with
+        glm::mat4 model;
+        glm::vec4 color;
+    };
+
+    CullingManager(std::shared_ptr<ShaderManager> pShaderManager, std::shared_ptr<GeometryPool> pGeometryPool); // Constructor
+    ~CullingManager(); // Destructor
+
+    static bool IsSupported();  // Compute shaders, SSBOs and indirect draws are available
+
+    // Load the culling compute shaders, returns false if the GPU path cannot be used
+    bool Initialize(const char* cullShaderPath, const char* compactShaderPath, const char* depthPyramidShaderPath);
+    bool IsReady() const { return m_bReady; }
+
+    void SetObjects(const std::vector<CULL_OBJECT>& objects, GLuint bucketCount);  // Upload the objects and build the draw commands
+    void CullObjects(const glm::mat4& view, const glm::mat4& projection, bool bUseDepthPyramid);  // Run the culling passes for this frame
+
+    void SetMinScreenSize(float pixels) { m_minScreenSize = pixels; }   // Objects with a smaller projected diameter are not drawn
+    void SetLodEnabled(bool bEnabled) { m_bLod = bEnabled; }   // Pick a mesh level per object from its projected size
+    const CULL_STATS& GetFrameStats() const { return m_frameStats; }   // Stats of the last frame that was read back
+
+    void BeginDraw() const;     // Bind the geometry pool and indirect buffers
+    void DrawBucket(GLuint bucket) const;   // Draw the visible objects of one bucket with one multi-draw call
+    void EndDraw() const;       // Restore the regular per-object drawing state
+
+    void UpdateDepthPyramid(const glm::mat4& view, const glm::mat4& projection);  // Build the depth pyramid from the rendered frame
+
+private:
+    std::shared_ptr<ShaderManager> m_pShaderManager;  // Smart Pointer to the ShaderManager Object
+    std::shared_ptr<GeometryPool> m_pGeometryPool;    // Smart Pointer to the GeometryPool Object
+
+    bool m_bReady;
+    bool m_bIndirectCount;  // glMultiDrawElementsIndirectCount is available
+
+    GLuint m_cullProgram;
+    GLuint m_compactProgram;
+    GLuint m_depthPyramidProgram;
+
+    GLuint m_objectBuffer;          // OBJECT_DATA per object
+    GLuint m_commandTemplateBuffer; // Draw commands with zero instances, copied in every frame
+    GLuint m_commandBuffer;         // Draw commands filled by the culling pass
+    GLuint m_visibleObjectBuffer;   // Compacted visible object indices, read as an instanced attribute
+    GLuint m_commandBucketBuffer;   // Bucket and first bucket command of every draw command
+    GLuint m_drawCommandBuffer;     // Non-empty draw commands packed per bucket
+    GLuint m_drawCountBuffer;       // Number of packed draw commands per bucket
+    GLuint m_statsBuffer;           // CULL_STATS written by the culling pass
+    GLuint m_objectLodBuffer;       // Level each object was drawn with, kept across frames for the hysteresis
+
+    GLuint m_objectCount;
+    GLuint m_commandCount;
+    std::vector<GLuint> m_bucketFirstCommand;   // First draw command of each bucket
+    std::vector<GLuint> m_bucketCommandCount;   // Number of draw commands of each bucket
+
+    float m_minScreenSize;      // Contribution culling threshold in pixels
+    bool m_bLod;                // Level of detail selection is on
+    CULL_STATS m_frameStats;
+    GLuint m_statsFrame;        // Frames since the stats were last read back
+
+    GLuint m_depthTexture;      // Copy of the scene depth buffer
+    GLuint m_depthPyramid;      // Farthest-depth mip chain of the copy
+    GLint m_depthPyramidWidth;
+    GLint m_depthPyramidHeight;
+    GLint m_depthPyramidLevels;
+    bool m_bDepthPyramidValid;
+    glm::mat4 m_depthPyramidViewProjection; // Matrices the depth pyramid was rendered with
+
+    void ReadFrameStats();
+    void CreateDepthPyramid(GLint width, GLint height);
+    void DestroyBuffers();
+    void DestroyDepthPyramid();
+};
+#endif // CULLINGMANAGER_H
@@ -1,5 +1,6 @@
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -15,6 +16,14 @@
 #include "ResourceManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "ParametricSurface.h"
+#include "MeshSimplifier.h"
+#include "MeshImporter.h"
+#include "MeshWelding.h"
+#include "PagedMesh.h"
+#include "Icosphere.h"
+#include "MeshCodec.h"
+#include "MeshNormals.h"
 
 // Namespace for declaring global variables
 namespace
@@ -63,6 +72,110 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// time the parametric mesh generators across thread counts, the mesh
+	// simplifier, the mesh importer, the mesh codec or the normal and tangent
+	// kernels and quit, compare the icosphere with the UV sphere and quit,
+	// convert a mesh file into a paged mesh and quit,
+	// add an N x N field of spheres to the scene, load the sphere as an
+	// icosphere, import a mesh file into the scene, stream a paged mesh into
+	// it, set the memory the shape meshes may take before unused ones are
+	// released, write the parametric meshes of the geometry pool on the GPU,
+	// or bake the static scene into merged buffers
+	GLuint sphereFieldSize = 0;
+	int icosphereSubdivisions = 0;
+	size_t meshBudgetMB = 64;
+	bool bGPUSurfaces = false;
+	bool bStaticBatching = false;
+	std::string importedMeshPath;
+	std::string streamedMeshPath;
+	size_t streamingBudgetMB = 256;
+	for (int arg = 1; arg < argc; ++arg)
+	{
+		if (std::strcmp(argv[arg], "--benchmark-surfaces") == 0)
+		{
+			RunParametricSurfaceBenchmark();
+			return(EXIT_SUCCESS);
+		}
+		if (std::strcmp(argv[arg], "--benchmark-simplify") == 0)
+		{
+			RunMeshSimplifierBenchmark();
+			return(EXIT_SUCCESS);
+		}
+		if (std::strcmp(argv[arg], "--benchmark-import") == 0)
+		{
+			RunMeshImportBenchmark(arg + 1 < argc ? argv[arg + 1] : nullptr);
+			return(EXIT_SUCCESS);
+		}
+		if (std::strcmp(argv[arg], "--benchmark-codec") == 0)
+		{
+			RunMeshCodecBenchmark(arg + 1 < argc ? argv[arg + 1] : nullptr);
+			return(EXIT_SUCCESS);
+		}
+		if (std::strcmp(argv[arg], "--benchmark-normals") == 0)
+		{
+			RunMeshNormalsBenchmark();
+			return(EXIT_SUCCESS);
+		}
+		if (std::strcmp(argv[arg], "--benchmark-icosphere") == 0)
+		{
+			RunIcosphereBenchmark();
+			return(EXIT_SUCCESS);
+		}
+		if (std::strcmp(argv[arg], "--build-paged-mesh") == 0 && arg + 2 < argc)
+		{
+			MeshData meshData;
+			if (!ImportMesh(argv[arg + 1], meshData))
+			{
+				return(EXIT_FAILURE);
+			}
+			PrintWeldReport("paged mesh source", WeldVertices(meshData));
+			PagedMeshReport report;
+			if (!WritePagedMesh(meshData, argv[arg + 2], 65536, &report))
+			{
+				return(EXIT_FAILURE);
+			}
+			PrintPagedMeshReport(argv[arg + 2], report);
+			return(EXIT_SUCCESS);
+		}
+		if (std::strcmp(argv[arg], "--stream") == 0 && arg + 1 < argc)
+		{
+			streamedMeshPath = argv[++arg];
+		}
+		if (std::strcmp(argv[arg], "--stream-budget") == 0 && arg + 1 < argc)
+		{
+			streamingBudgetMB = std::strtoul(argv[++arg], nullptr, 10);
+		}
+		if (std::strcmp(argv[arg], "--mesh-budget") == 0 && arg + 1 < argc)
+		{
+			meshBudgetMB = std::strtoul(argv[++arg], nullptr, 10);
+		}
+		if (std::strcmp(argv[arg], "--import") == 0 && arg + 1 < argc)
+		{
+			importedMeshPath = argv[++arg];
+		}
+		if (std::strcmp(argv[arg], "--icosphere") == 0)
+		{
+			// four subdivisions, 5120 triangles, unless a level follows
+			icosphereSubdivisions = 4;
+			if (arg + 1 < argc && argv[arg + 1][0] != '-')
+			{
+				icosphereSubdivisions = std::atoi(argv[++arg]);
+			}
+		}
+		if (std::strcmp(argv[arg], "--gpu-surfaces") == 0)
+		{
+			bGPUSurfaces = true;
+		}
+		if (std::strcmp(argv[arg], "--bake-static") == 0)
+		{
+			bStaticBatching = true;
+		}
+		if (std::strcmp(argv[arg], "--sphere-field") == 0 && arg + 1 < argc)
+		{
+			sphereFieldSize = static_cast<GLuint>(std::strtoul(argv[++arg], nullptr, 10));
+		}
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
@@ -86,6 +199,8 @@ int main(int argc, char* argv[])
 
 	// try to create a new Shape Meshes object
 	auto g_basicMeshes = std::make_shared<ShapeMeshes>(g_BoxMesh, g_ConeMesh, g_PlaneMesh, g_TetrahedronMesh);
+	g_basicMeshes->SetIcosphereSubdivisions(icosphereSubdivisions);
+	g_basicMeshes->SetMeshMemoryBudget(meshBudgetMB << 20);
 
 	// try to create a new shape generator object
 	auto g_ShapeGenerator = std::make_shared<ShapeGenerator>(g_ShaderManager, g_basicMeshes, g_ResourceManager);
@@ -99,14 +214,21 @@ int main(int argc, char* argv[])
 		return(EXIT_FAILURE);
 	}
 
-	// load the shader code from the external GLSL files
+	// load the shader code from the external GLSL files; the object buffer
+	// of the GPU-driven draws needs OpenGL 4.3, older contexts such as the
+	// 3.3 one on macOS only draw one shape at a time
 	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
+		GLEW_VERSION_4_3 ? "../../Utilities/shaders/vertexShader.glsl" : "../../Utilities/shaders/vertexShader330.glsl",
 		"../../Utilities/shaders/fragmentShader.glsl");
 	g_ShaderManager->use();
 
 	// try to create a new scene manager object and prepare the 3D scene
-	auto g_SceneManager = std::make_unique<SceneManager>(g_ShaderManager, g_ShapeGenerator, g_ResourceManager);
+	auto g_SceneManager = std::make_unique<SceneManager>(g_ShaderManager, g_ShapeGenerator, g_ResourceManager, g_ViewManager);
+	g_SceneManager->SetSphereFieldSize(sphereFieldSize);
+	g_SceneManager->SetImportedMeshPath(importedMeshPath);
+	g_SceneManager->SetStreamedMesh(streamedMeshPath, streamingBudgetMB << 20);
+	g_SceneManager->SetGPUSurfaceGeneration(bGPUSurfaces);
+	g_SceneManager->SetStaticBatching(bStaticBatching);
 	g_SceneManager->PrepareScene();
 
 	// loop will keep running until the application is closed 
@@ -0,0 +1,439 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshStreamingManager.cpp
+// ============
+// Out-of-core streaming of paged meshes within a fixed memory budget
+//
+//  Only the chunk table of a paged mesh stays in memory. Every frame the
+//  chunks in and near the view are requested nearest first from a loader
+//  thread, finished loads are uploaded a few at a time, and the chunks that
+//  were out of view the longest are evicted to keep within the budget.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshStreamingManager.h"
+#include "Frustum.h"
+
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+// declaration of the global variables and defines
+namespace
+{
+    const GLuint STATS_INTERVAL = 120;                  // frames between stats reports
+    const size_t MAX_UPLOAD_BYTES_PER_FRAME = 8 << 20;  // keeps the upload time of one frame bounded
+    const GLuint MAX_QUEUED_LOADS = 8;                  // requests waiting for the loader at a time
+    const float PREFETCH_MARGIN = 0.25f;                // frustum growth for prefetching, in mesh radii
+}
+
+/***********************************************************
+ *  MeshStreamingManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshStreamingManager::MeshStreamingManager(size_t memoryBudget)
+    : m_memoryBudget(memoryBudget),
+    m_queuedBytes(0),
+    m_bStopLoader(false),
+    m_stats(),
+    m_totalLoadMs(0.0),
+    m_statsFrames(0),
+    m_intervalLoads(0),
+    m_intervalEvictions(0),
+    m_intervalHits(0),
+    m_intervalMisses(0),
+    m_intervalLoadMs(0.0),
+    m_intervalMaxLoadMs(0.0)
+{}
+
+/***********************************************************
+ *  ~MeshStreamingManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshStreamingManager::~MeshStreamingManager()
+{
+    if (m_loader.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_bStopLoader = true;
+        }
+        m_wakeLoader.notify_one();
+        m_loader.join();
+    }
+
+    for (CHUNK& chunk : m_chunkStates)
+    {
+        if (chunk.state == CHUNK_STATE::Resident)
+        {
+            glDeleteBuffers(2, chunk.vbos);
+        }
+    }
+}
+
+/***********************************************************
+ *  Open()
+ *
+ *  This method reads the chunk table of a paged mesh and
+ *  starts the loader thread. A manager streams one mesh, so
+ *  it can only be opened once.
+ ***********************************************************/
+bool MeshStreamingManager::Open(const std::string& path)
+{
+    if (IsOpen() || !m_file.Open(path))
+    {
+        return false;
+    }
+
+    m_chunks = m_file.GetChunks();
+    CHUNK chunk = {};
+    chunk.state = CHUNK_STATE::Unloaded;
+    m_chunkStates.assign(m_chunks.size(), chunk);
+
+    size_t totalBytes = 0;
+    for (const PagedChunk& pagedChunk : m_chunks)
+    {
+        totalBytes += pagedChunk.GetByteSize();
+    }
+    std::cout << "INFO: streaming " << path << ", " << m_chunks.size() << " chunks, "
+        << totalBytes / (1024.0 * 1024.0) << " MB in a budget of " << m_memoryBudget / (1024.0 * 1024.0) << " MB" << std::endl;
+
+    m_loader = std::thread(&MeshStreamingManager::LoaderThread, this);
+    return true;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method marks the chunks whose bounding spheres are
+ *  in the frustum as visible, and the ones in a slightly
+ *  larger frustum as wanted. Finished loads are uploaded
+ *  next, so that chunks that arrive in time are drawn this
+ *  frame, and the missing wanted chunks are requested. A
+ *  missing chunk leaves a hole for a few frames instead of
+ *  stalling the frame.
+ ***********************************************************/
+void MeshStreamingManager::Update(const glm::mat4& model, const Frustum& frustum, const glm::vec3& cameraPosition)
+{
+    if (!IsOpen())
+    {
+        return;
+    }
+
+    // the loads finished since the last frame wait for their upload
+    std::vector<LOADED_CHUNK> loaded;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        loaded.swap(m_loaded);
+    }
+    for (LOADED_CHUNK& chunk : loaded)
+    {
+        if (!chunk.bValid)
+        {
+            std::cerr << "Failed to read chunk " << chunk.chunk << " of the streamed mesh" << std::endl;
+            m_chunkStates[chunk.chunk].state = CHUNK_STATE::Failed;
+            m_queuedBytes -= m_chunks[chunk.chunk].GetByteSize();
+            continue;
+        }
+        m_chunkStates[chunk.chunk].state = CHUNK_STATE::Loaded;
+        m_pendingUploads.push_back(std::move(chunk));
+    }
+
+    // bounding spheres in world space, the radius grows with the largest scale
+    const float scale = std::max(glm::length(glm::vec3(model[0])), std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+    const float meshRadius = 0.5f * glm::length(m_file.GetBoundsMax() - m_file.GetBoundsMin()) * scale;
+    std::vector<std::pair<std::pair<bool, float>, GLuint>> wanted;
+    std::vector<bool> bWanted(m_chunks.size(), false);
+    for (GLuint chunk = 0; chunk < m_chunks.size(); chunk++)
+    {
+        glm::vec3 center = glm::vec3(model * glm::vec4(glm::vec3(m_chunks[chunk].sphere), 1.0f));
+        float radius = m_chunks[chunk].sphere.w * scale;
+        CHUNK& state = m_chunkStates[chunk];
+        state.bVisible = frustum.IntersectsSphere(center, radius);
+        bWanted[chunk] = state.bVisible || frustum.IntersectsSphere(center, radius + PREFETCH_MARGIN * meshRadius);
+        if (!bWanted[chunk])
+        {
+            continue;
+        }
+
+        // visible chunks come before the prefetched ones, each nearest first
+        float distance = std::max(glm::length(center - cameraPosition) - radius, 0.0f);
+        wanted.push_back({ { !state.bVisible, distance }, chunk });
+        if (state.bVisible && state.state == CHUNK_STATE::Resident)
+        {
+            m_lru.splice(m_lru.begin(), m_lru, state.lruEntry);
+        }
+    }
+
+    UploadLoadedChunks();
+
+    // visible chunks may evict everything else, prefetched ones only the unwanted chunks
+    size_t visibleBytes = 0;
+    size_t keptBytes = 0;
+    m_drawChunks.clear();
+    for (GLuint chunk = 0; chunk < m_chunks.size(); chunk++)
+    {
+        const CHUNK& state = m_chunkStates[chunk];
+        if (state.state == CHUNK_STATE::Resident && bWanted[chunk])
+        {
+            keptBytes += m_chunks[chunk].GetByteSize();
+        }
+        if (!state.bVisible)
+        {
+            continue;
+        }
+        if (state.state == CHUNK_STATE::Resident)
+        {
+            visibleBytes += m_chunks[chunk].GetByteSize();
+            m_drawChunks.push_back(chunk);
+            m_intervalHits++;
+            m_stats.hitCount++;
+        }
+        else
+        {
+            m_intervalMisses++;
+            m_stats.missCount++;
+        }
+    }
+
+    std::sort(wanted.begin(), wanted.end());
+    std::vector<GLuint> candidates;
+    for (const auto& entry : wanted)
+    {
+        candidates.push_back(entry.second);
+    }
+    RequestChunks(candidates, visibleBytes, keptBytes);
+
+    if (++m_statsFrames >= STATS_INTERVAL)
+    {
+        ReportStats();
+    }
+}
+
+/***********************************************************
+ *  Draw()
+ ***********************************************************/
+void MeshStreamingManager::Draw() const
+{
+    for (GLuint chunk : m_drawChunks)
+    {
+        MeshData::Layout::Bind(m_chunkStates[chunk].vbos[0], m_chunkStates[chunk].vbos[1]);
+        glDrawElements(GL_TRIANGLES, m_chunks[chunk].indexCount, GL_UNSIGNED_INT, (void*)0);
+    }
+}
+
+/***********************************************************
+ *  LoaderThread()
+ *
+ *  This method reads the requested chunks one after the
+ *  other, the nearest first, until the manager is destroyed.
+ ***********************************************************/
+void MeshStreamingManager::LoaderThread()
+{
+    for (;;)
+    {
+        LOADED_CHUNK loaded;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeLoader.wait(lock, [this] { return m_bStopLoader || !m_requests.empty(); });
+            if (m_bStopLoader)
+            {
+                return;
+            }
+            loaded.chunk = m_requests.front();
+            m_requests.pop_front();
+        }
+
+        loaded.bValid = m_file.ReadChunk(loaded.chunk, loaded.meshData);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_loaded.push_back(std::move(loaded));
+    }
+}
+
+/***********************************************************
+ *  UploadLoadedChunks()
+ *
+ *  This method uploads the waiting loads until the bytes of
+ *  this frame are used up, at least one per frame so that
+ *  a chunk larger than the limit still gets through.
+ ***********************************************************/
+void MeshStreamingManager::UploadLoadedChunks()
+{
+    size_t uploadedBytes = 0;
+    while (!m_pendingUploads.empty() && (uploadedBytes == 0 || uploadedBytes < MAX_UPLOAD_BYTES_PER_FRAME))
+    {
+        LOADED_CHUNK loaded = std::move(m_pendingUploads.front());
+        m_pendingUploads.pop_front();
+
+        size_t bytes = m_chunks[loaded.chunk].GetByteSize();
+        m_queuedBytes -= bytes;
+        if (UploadChunk(loaded))
+        {
+            uploadedBytes += bytes;
+        }
+    }
+}
+
+/***********************************************************
+ *  UploadChunk()
+ *
+ *  This method evicts the chunks that were out of view the
+ *  longest until the new one fits into the budget. When it
+ *  does not fit without evicting visible chunks it is
+ *  dropped, and requested again once there is room.
+ ***********************************************************/
+bool MeshStreamingManager::UploadChunk(LOADED_CHUNK& loaded)
+{
+    CHUNK& state = m_chunkStates[loaded.chunk];
+    size_t bytes = m_chunks[loaded.chunk].GetByteSize();
+
+    // pick the victims first, EvictChunk() erases their list entries
+    std::vector<GLuint> victims;
+    size_t freedBytes = 0;
+    for (auto entry = m_lru.rbegin(); entry != m_lru.rend() && m_stats.residentBytes - freedBytes + bytes > m_memoryBudget; ++entry)
+    {
+        if (!m_chunkStates[*entry].bVisible)
+        {
+            victims.push_back(*entry);
+            freedBytes += m_chunks[*entry].GetByteSize();
+        }
+    }
+    for (GLuint chunk : victims)
+    {
+        EvictChunk(chunk);
+    }
+    if (m_stats.residentBytes + bytes > m_memoryBudget)
+    {
+        state.state = CHUNK_STATE::Unloaded;
+        state.requestTime = std::chrono::steady_clock::time_point();
+        return false;
+    }
+
+    state.vbos[0] = CreateBufferData(loaded.meshData.vertices.size() * sizeof(GLfloat), loaded.meshData.vertices.data());
+    state.vbos[1] = CreateBufferData(loaded.meshData.indices.size() * sizeof(GLuint), loaded.meshData.indices.data());
+    state.state = CHUNK_STATE::Resident;
+    m_lru.push_front(loaded.chunk);
+    state.lruEntry = m_lru.begin();
+
+    std::chrono::duration<double, std::milli> latency = std::chrono::steady_clock::now() - state.requestTime;
+    m_totalLoadMs += latency.count();
+    m_intervalLoadMs += latency.count();
+    m_intervalMaxLoadMs = std::max(m_intervalMaxLoadMs, latency.count());
+    m_intervalLoads++;
+    state.requestTime = std::chrono::steady_clock::time_point();
+
+    m_stats.residentBytes += bytes;
+    m_stats.peakResidentBytes = std::max(m_stats.peakResidentBytes, m_stats.residentBytes);
+    m_stats.residentChunks++;
+    m_stats.loadCount++;
+    m_stats.averageLoadMs = m_totalLoadMs / m_stats.loadCount;
+    m_stats.maxLoadMs = std::max(m_stats.maxLoadMs, latency.count());
+    return true;
+}
+
+/***********************************************************
+ *  EvictChunk()
+ ***********************************************************/
+void MeshStreamingManager::EvictChunk(GLuint chunk)
+{
+    CHUNK& state = m_chunkStates[chunk];
+    glDeleteBuffers(2, state.vbos);
+    m_lru.erase(state.lruEntry);
+    state.state = CHUNK_STATE::Unloaded;
+
+    m_stats.residentBytes -= m_chunks[chunk].GetByteSize();
+    m_stats.residentChunks--;
+    m_stats.evictionCount++;
+    m_intervalEvictions++;
+}
+
+/***********************************************************
+ *  RequestChunks()
+ *
+ *  This method replaces the requests the loader has not
+ *  started yet with the wanted chunks that are missing, in
+ *  the order given, as long as they fit into the budget
+ *  next to the loads under way and the resident chunks
+ *  they cannot evict: the visible ones for a visible chunk,
+ *  and every wanted one for a prefetched chunk, so that
+ *  prefetching never evicts what it prefetched before.
+ ***********************************************************/
+void MeshStreamingManager::RequestChunks(const std::vector<GLuint>& wanted, size_t visibleBytes, size_t keptBytes)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::deque<GLuint> withdrawn;
+    withdrawn.swap(m_requests);
+    for (GLuint chunk : withdrawn)
+    {
+        m_chunkStates[chunk].state = CHUNK_STATE::Unloaded;
+        m_queuedBytes -= m_chunks[chunk].GetByteSize();
+    }
+
+    for (GLuint chunk : wanted)
+    {
+        CHUNK& state = m_chunkStates[chunk];
+        size_t bytes = m_chunks[chunk].GetByteSize();
+        if (state.state != CHUNK_STATE::Unloaded)
+        {
+            continue;
+        }
+        size_t committedBytes = state.bVisible ? visibleBytes : keptBytes;
+        if (m_requests.size() >= MAX_QUEUED_LOADS || committedBytes + m_queuedBytes + bytes > m_memoryBudget)
+        {
+            break;
+        }
+
+        // a chunk keeps the time of its first request while it stays wanted
+        if (state.requestTime == std::chrono::steady_clock::time_point())
+        {
+            state.requestTime = std::chrono::steady_clock::now();
+        }
+        state.state = CHUNK_STATE::Queued;
+        m_queuedBytes += bytes;
+        m_requests.push_back(chunk);
+    }
+
+    // the latency of a chunk that is no longer wanted starts again
+    for (GLuint chunk : withdrawn)
+    {
+        if (m_chunkStates[chunk].state == CHUNK_STATE::Unloaded)
+        {
+            m_chunkStates[chunk].requestTime = std::chrono::steady_clock::time_point();
+        }
+    }
+
+    if (!m_requests.empty())
+    {
+        m_wakeLoader.notify_one();
+    }
+}
+
+/***********************************************************
+ *  ReportStats()
+ *
+ *  This method prints the resident bytes, the loads and
+ *  evictions with their latency, and the rate of visible
+ *  chunks that were resident since the last report.
+ ***********************************************************/
+void MeshStreamingManager::ReportStats()
+{
+    GLuint lookups = m_intervalHits + m_intervalMisses;
+    std::cout << "INFO: mesh streaming - resident " << m_stats.residentBytes / (1024.0 * 1024.0) << " of "
+        << m_memoryBudget / (1024.0 * 1024.0) << " MB in " << m_stats.residentChunks << " chunks, "
+        << m_intervalLoads << " loads";
+    if (m_intervalLoads > 0)
+    {
+        std::cout << " (latency " << m_intervalLoadMs / m_intervalLoads << " ms average, " << m_intervalMaxLoadMs << " ms max)";
+    }
+    std::cout << ", " << m_intervalEvictions << " evictions, hit rate "
+        << (lookups > 0 ? 100.0f * m_intervalHits / lookups : 100.0f) << "%" << std::endl;
+
+    m_statsFrames = 0;
+    m_intervalLoads = 0;
+    m_intervalEvictions = 0;
+    m_intervalHits = 0;
+    m_intervalMisses = 0;
+    m_intervalLoadMs = 0.0;
+    m_intervalMaxLoadMs = 0.0;
+}
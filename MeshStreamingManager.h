@@ -0,0 +1,119 @@
+///////////////////////////////////////////////////////////////////////////////
+// MeshStreamingManager.h
+// ============
+// Out-of-core streaming of paged meshes within a fixed memory budget
+//
+//  Only the chunk table of a paged mesh stays in memory. Every frame the
+//  chunks in and near the view are requested nearest first from a loader
+//  thread, finished loads are uploaded a few at a time, and the chunks that
+//  were out of view the longest are evicted to keep within the budget.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef MESHSTREAMINGMANAGER_H
+#define MESHSTREAMINGMANAGER_H
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "PagedMesh.h"
+
+struct Frustum; // Forward Declaration
+
+class MeshStreamingManager {
+public:
+    // Streaming metrics, totals since the mesh was opened
+    struct STREAMING_STATS {
+        size_t residentBytes;       // Bytes of the chunks on the GPU
+        size_t peakResidentBytes;
+        GLuint residentChunks;
+        GLuint loadCount;           // Chunks read and uploaded
+        GLuint evictionCount;
+        double averageLoadMs;       // Time from the request of a chunk to its upload
+        double maxLoadMs;
+        GLuint hitCount;            // Visible chunks that were resident when drawn
+        GLuint missCount;           // Visible chunks that were not
+    };
+
+    explicit MeshStreamingManager(size_t memoryBudget); // Constructor
+    ~MeshStreamingManager(); // Destructor, stops the loader and frees the chunks
+
+    bool Open(const std::string& path);     // Read the chunk table and start the loader thread
+    bool IsOpen() const { return !m_chunks.empty(); }
+    const PagedMeshFile& GetFile() const { return m_file; }
+
+    void SetMemoryBudget(size_t bytes) { m_memoryBudget = bytes; }  // GPU bytes the resident chunks may take
+
+    // Upload finished loads, pick the visible chunks and request the missing ones nearest first
+    void Update(const glm::mat4& model, const Frustum& frustum, const glm::vec3& cameraPosition);
+    void Draw() const;  // Draw the visible resident chunks with the current shader state
+
+    const STREAMING_STATS& GetStats() const { return m_stats; }
+
+private:
+    enum class CHUNK_STATE {
+        Unloaded,
+        Queued,     // Requested, waiting for or being read by the loader
+        Loaded,     // Read, waiting for its upload
+        Resident,   // On the GPU
+        Failed      // Could not be read, never requested again
+    };
+
+    struct CHUNK {
+        CHUNK_STATE state;
+        GLuint vbos[2];     // Vertex and index buffer while resident
+        bool bVisible;      // Inside the frustum this frame
+        std::chrono::steady_clock::time_point requestTime;
+        std::list<GLuint>::iterator lruEntry;   // Place in m_lru while resident
+    };
+
+    // a chunk read by the loader thread
+    struct LOADED_CHUNK {
+        GLuint chunk;
+        bool bValid;
+        MeshData meshData;
+    };
+
+    PagedMeshFile m_file;   // Read only by the loader thread after Open()
+    std::vector<PagedChunk> m_chunks;
+    std::vector<CHUNK> m_chunkStates;
+    std::list<GLuint> m_lru;    // Resident chunks, the most recently visible first
+    std::vector<GLuint> m_drawChunks;   // Visible resident chunks of this frame
+    std::deque<LOADED_CHUNK> m_pendingUploads;  // Loads waiting for an upload slot
+    size_t m_memoryBudget;
+    size_t m_queuedBytes;   // Bytes of the chunks requested, read or waiting for upload
+
+    // shared with the loader thread
+    std::thread m_loader;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeLoader;
+    std::deque<GLuint> m_requests;      // Chunks to read, nearest first
+    std::vector<LOADED_CHUNK> m_loaded; // Chunks read since the last Update()
+    bool m_bStopLoader;
+
+    // stats, totals and since the last report
+    STREAMING_STATS m_stats;
+    double m_totalLoadMs;
+    GLuint m_statsFrames;
+    GLuint m_intervalLoads;
+    GLuint m_intervalEvictions;
+    GLuint m_intervalHits;
+    GLuint m_intervalMisses;
+    double m_intervalLoadMs;
+    double m_intervalMaxLoadMs;
+
+    void LoaderThread();
+    void UploadLoadedChunks();
+    bool UploadChunk(LOADED_CHUNK& loaded);
+    void EvictChunk(GLuint chunk);
+    void RequestChunks(const std::vector<GLuint>& wanted, size_t visibleBytes, size_t keptBytes);
+    void ReportStats();
+};
+#endif // MESHSTREAMINGMANAGER_H
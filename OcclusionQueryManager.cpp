@@ -0,0 +1,210 @@
+///////////////////////////////////////////////////////////////////////////////
+// OcclusionQueryManager.cpp
+// ============
+// Hardware occlusion queries with conditional rendering for heavy objects
+//
+//  The bounding box of every heavy object is tested against the depth buffer
+//  at the end of a frame, and the next frame draws the object under a
+//  conditional render on that result without waiting for it.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "OcclusionQueryManager.h"
+
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+    const GLuint STATS_INTERVAL = 120;  // frames between stats reports
+}
+
+/***********************************************************
+ *  OcclusionQueryManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+OcclusionQueryManager::OcclusionQueryManager()
+    : m_frame(0),
+    m_slotCount(0),
+    m_bConditionalDraw(false),
+    m_queryTarget(GL_ANY_SAMPLES_PASSED),
+    m_statsFrames(0),
+    m_resultCount(0),
+    m_hiddenCount(0)
+{}
+
+/***********************************************************
+ *  ~OcclusionQueryManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+OcclusionQueryManager::~OcclusionQueryManager()
+{
+    for (std::vector<GLuint>& queries : m_queries)
+    {
+        if (!queries.empty())
+        {
+            glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+        }
+    }
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  The query set of this frame was last used two frames
+ *  ago, so its results are normally available and can be
+ *  read for the stats without stalling.
+ ***********************************************************/
+void OcclusionQueryManager::BeginFrame()
+{
+    // conservative queries may be cheaper where they are supported (GL 4.3)
+    m_queryTarget = GLEW_VERSION_4_3 ? GL_ANY_SAMPLES_PASSED_CONSERVATIVE : GL_ANY_SAMPLES_PASSED;
+
+    m_frame++;
+    m_slotCount = 0;
+    m_boundingBoxes.clear();
+
+    CollectResults(m_frame % 2);
+    if (++m_statsFrames >= STATS_INTERVAL)
+    {
+        ReportStats();
+    }
+}
+
+/***********************************************************
+ *  BeginConditionalDraw()
+ *
+ *  This method starts drawing the next heavy object. When its
+ *  box was queried last frame the draw is conditional on that
+ *  query; GL_QUERY_NO_WAIT draws anyway if it is not done.
+ *  Every heavy object takes a slot, so the slots stay stable
+ *  while some of them are drawn unconditionally.
+ ***********************************************************/
+GLuint OcclusionQueryManager::BeginConditionalDraw(bool bConditional)
+{
+    GLuint slot = m_slotCount++;
+    GLuint previous = (m_frame + 1) % 2;
+
+    m_bConditionalDraw = bConditional && slot < m_bIssued[previous].size() && m_bIssued[previous][slot];
+    if (m_bConditionalDraw)
+    {
+        glBeginConditionalRender(m_queries[previous][slot], GL_QUERY_NO_WAIT);
+    }
+    return slot;
+}
+
+/***********************************************************
+ *  EndConditionalDraw()
+ ***********************************************************/
+void OcclusionQueryManager::EndConditionalDraw()
+{
+    if (m_bConditionalDraw)
+    {
+        glEndConditionalRender();
+        m_bConditionalDraw = false;
+    }
+}
+
+/***********************************************************
+ *  AddBoundingBox()
+ *
+ *  The boxes are drawn after the whole scene so that they
+ *  are tested against every occluder.
+ ***********************************************************/
+void OcclusionQueryManager::AddBoundingBox(GLuint slot, const glm::mat4& boxModel)
+{
+    m_boundingBoxes.push_back({ slot, boxModel });
+}
+
+/***********************************************************
+ *  BeginQuery()
+ ***********************************************************/
+void OcclusionQueryManager::BeginQuery(GLuint box)
+{
+    GLuint current = m_frame % 2;
+    GLuint slot = m_boundingBoxes[box].slot;
+
+    if (slot >= m_queries[current].size())
+    {
+        GLuint first = static_cast<GLuint>(m_queries[current].size());
+        m_queries[current].resize(slot + 1);
+        m_bIssued[current].resize(slot + 1, false);
+        glGenQueries(slot + 1 - first, &m_queries[current][first]);
+    }
+
+    glBeginQuery(m_queryTarget, m_queries[current][slot]);
+    m_bIssued[current][slot] = true;
+}
+
+/***********************************************************
+ *  EndQuery()
+ ***********************************************************/
+void OcclusionQueryManager::EndQuery()
+{
+    glEndQuery(m_queryTarget);
+}
+
+/***********************************************************
+ *  CollectResults()
+ *
+ *  This method reads the finished queries of a set. A hidden
+ *  result means the matching conditional draw was skipped.
+ ***********************************************************/
+void OcclusionQueryManager::CollectResults(GLuint set)
+{
+    if (m_hiddenFrames.size() < m_queries[set].size())
+    {
+        m_hiddenFrames.resize(m_queries[set].size(), 0);
+    }
+
+    for (size_t slot = 0; slot < m_queries[set].size(); slot++)
+    {
+        if (!m_bIssued[set][slot])
+        {
+            continue;
+        }
+        m_bIssued[set][slot] = false;
+
+        GLuint available = 0;
+        glGetQueryObjectuiv(m_queries[set][slot], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+        {
+            continue;
+        }
+
+        GLuint passed = 0;
+        glGetQueryObjectuiv(m_queries[set][slot], GL_QUERY_RESULT, &passed);
+        m_resultCount++;
+        if (!passed)
+        {
+            m_hiddenCount++;
+            m_hiddenFrames[slot]++;
+        }
+    }
+}
+
+/***********************************************************
+ *  ReportStats()
+ *
+ *  This method prints the rate of skipped draws and how
+ *  often each heavy object was hidden since the last report.
+ ***********************************************************/
+void OcclusionQueryManager::ReportStats()
+{
+    if (m_resultCount > 0)
+    {
+        std::cout << "INFO: occlusion queries - " << m_hiddenCount << " of " << m_resultCount
+            << " heavy draws skipped (" << (100.0f * m_hiddenCount / m_resultCount) << "%), hidden frames per object:";
+        for (size_t slot = 0; slot < m_hiddenFrames.size(); slot++)
+        {
+            std::cout << " [" << slot << "] " << m_hiddenFrames[slot];
+        }
+        std::cout << std::endl;
+    }
+
+    m_hiddenFrames.assign(m_hiddenFrames.size(), 0);
+    m_statsFrames = 0;
+    m_resultCount = 0;
+    m_hiddenCount = 0;
+}
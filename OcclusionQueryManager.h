@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// OcclusionQueryManager.h
+// ============
+// Hardware occlusion queries with conditional rendering for heavy objects
+//
+//  The bounding box of every heavy object is tested against the depth buffer
+//  at the end of a frame, and the next frame draws the object under a
+//  conditional render on that result without waiting for it.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef OCCLUSIONQUERYMANAGER_H
+#define OCCLUSIONQUERYMANAGER_H
+#pragma once
+
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class OcclusionQueryManager {
+public:
+    OcclusionQueryManager(); // Constructor
+    ~OcclusionQueryManager(); // Destructor
+
+    void BeginFrame();  // Start a new frame of queries and collect the stats of older ones
+
+    GLuint BeginConditionalDraw(bool bConditional);  // Draw the next heavy object only if last frame's query passed, returns its slot
+    void EndConditionalDraw();
+
+    void AddBoundingBox(GLuint slot, const glm::mat4& boxModel);   // Queue the bounding box of a slot for this frame's query
+    GLuint GetBoundingBoxCount() const { return static_cast<GLuint>(m_boundingBoxes.size()); }
+    const glm::mat4& GetBoundingBoxModel(GLuint box) const { return m_boundingBoxes[box].model; }
+
+    void BeginQuery(GLuint box);    // Wrap the draw of a queued bounding box in its slot's query
+    void EndQuery();
+
+private:
+    // a queued bounding box of one heavy object
+    struct BOUNDING_BOX {
+        GLuint slot;
+        glm::mat4 model;
+    };
+
+    std::vector<GLuint> m_queries[2];   // Query objects of the current and the previous frame
+    std::vector<bool> m_bIssued[2];     // Slots whose query was issued in that frame
+    std::vector<BOUNDING_BOX> m_boundingBoxes;
+    GLuint m_frame;
+    GLuint m_slotCount;     // Heavy objects drawn so far this frame
+    bool m_bConditionalDraw;    // A conditional render is active
+    GLenum m_queryTarget;
+
+    // stats gathered between reports
+    std::vector<GLuint> m_hiddenFrames;     // Frames each slot's query reported hidden
+    GLuint m_statsFrames;
+    GLuint m_resultCount;
+    GLuint m_hiddenCount;
+
+    void CollectResults(GLuint set);
+    void ReportStats();
+};
+#endif // OCCLUSIONQUERYMANAGER_H
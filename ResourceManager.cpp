@@ -1,14 +1,46 @@
 #include "ResourceManager.h"
 #include "ShaderManager.h"
 #include "stb_image.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
 #include <iostream>
+#include <mutex>
 #include <stdexcept>
+#include <thread>
 
 namespace {
     const char* g_ColorValueName = "objectColor";
     const char* g_TextureValueName = "objectTexture";
     const char* g_UseTextureName = "bUseTexture";
     const char* g_FaceColorsName = "faceColors";
+
+    // The texture files of the scene and their tags, in texture slot order
+    const char* g_TextureFiles[][2] = {
+        { "Textures/Baby_blue_aqua_mosaic_texture.jpg", "baby_blue_mosaic" },
+        { "Textures/Green_mosaic_texture.jpg", "green_mosaic" },
+        { "Textures/Pink_Marble_texture.jpg", "pink_marble" },
+        { "Textures/stone_rock_texture.jpg", "stone_rock" },
+        { "Textures/very_rough_cement_texture.jpg", "very_rough_cement" },
+        { "Textures/wood_brown_texture.jpg", "wood_brown" },
+        { "Textures/wood_dark.jpg", "wood_dark" },
+        { "Textures/clouds_wispy.jpg", "clouds_wispy" },
+        { "Textures/abstract_texture.jpg", "abstract" },
+        { "Textures/glitch_texture.jpg", "glitch" },
+        { "Textures/Ice_texture.jpg", "ice" }
+    };
+
+    double MillisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    // Bytes of a file, 0 when it cannot be opened
+    std::streamoff GetFileSize(const std::string& filename) {
+        std::ifstream file(filename, std::ios::binary | std::ios::ate);
+        return file ? static_cast<std::streamoff>(file.tellg()) : 0;
+    }
 }
 
 ResourceManager::ResourceManager(std::shared_ptr<ShaderManager> pShaderManager)
@@ -34,26 +66,45 @@ void ResourceManager::SetShaderColor(const glm::vec4& color) const {
 }
 
 /***********************************************************
- *  CreateGLTexture()
+ *  DecodeTextureImage()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  This method is used for reading and decoding an image file
+ *  into memory. It does not touch OpenGL, so the texture
+ *  workers call it in parallel.
  ***********************************************************/
-bool ResourceManager::CreateGLTexture(const char* filename, const std::string textureTag) {
+bool ResourceManager::DecodeTextureImage(TEXTURE_IMAGE& image) {
+    auto start = std::chrono::steady_clock::now();
 
-    int width, height, colorChannels;
-
-    // Indicate to always flip images vertically when loaded
-    stbi_set_flip_vertically_on_load(true);
+    // Indicate to always flip images vertically when loaded, set per
+    // thread so that the workers do not share the setting
+    stbi_set_flip_vertically_on_load_thread(true);
 
     // Try to parse the image data from the specified image file
-    unsigned char* image = stbi_load(filename, &width, &height, &colorChannels, 0);
+    image.pixels = stbi_load(image.filename.c_str(), &image.width, &image.height, &image.colorChannels, 0);
+    image.decodeMs = MillisecondsSince(start);
+    return image.pixels != nullptr;
+}
+
+/***********************************************************
+ *  UploadGLTexture()
+ *
+ *  This method is used for converting a decoded image into an
+ *  OpenGL texture, configuring the texture mapping parameters
+ *  and generating the mipmaps. The image memory is freed and
+ *  the new texture ID returned, 0 when the image could not be used.
+ ***********************************************************/
+GLuint ResourceManager::UploadGLTexture(TEXTURE_IMAGE& image) const {
+    auto start = std::chrono::steady_clock::now();
 
-    if (!image) {
-        std::cerr << "Failed to load texture: " << filename << std::endl;
-        return false;
+    if (!image.pixels) {
+        std::cerr << "Failed to load texture: " << image.filename << std::endl;
+        return 0;
+    }
+    if (image.colorChannels != 3 && image.colorChannels != 4) {
+        std::cout << "Not implemented to handle image with " << image.colorChannels << " channels" << std::endl;
+        stbi_image_free(image.pixels);
+        image.pixels = nullptr;
+        return 0;
     }
 
     GLuint textureID;
@@ -68,30 +119,24 @@ bool ResourceManager::CreateGLTexture(const char* filename, const std::string te
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
     // If the loaded image is in RGB format
-    if (colorChannels == 3)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
+    if (image.colorChannels == 3)
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, image.width, image.height, 0, GL_RGB, GL_UNSIGNED_BYTE, image.pixels);
     // If the loaded image is in RGBA format - it supports transparency
-    else if (colorChannels == 4)
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
     else
-    {
-        std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-        return false;
-    }
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image.width, image.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image.pixels);
 
     // Generate the texture mipmaps for mapping textures to lower resolutions
     glGenerateMipmap(GL_TEXTURE_2D);
 
     // Free the image data from local memory
-    stbi_image_free(image);
+    stbi_image_free(image.pixels);
+    image.pixels = nullptr;
     glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
 
-    // Register the loaded texture and associate it with tag string
-    m_textures.push_back({ textureID, textureTag });
-    std::cout << "Texture loaded with tag: " << textureTag << std::endl;
-
-    // Image loaded successfully
-    return true;
+    image.uploadMs = MillisecondsSince(start);
+    std::cout << "Texture loaded with tag: " << image.tag << " (" << image.width << "x" << image.height
+        << ", decoded in " << image.decodeMs << " ms, uploaded in " << image.uploadMs << " ms)" << std::endl;
+    return textureID;
 }
 
 /***********************************************************
@@ -113,21 +158,85 @@ void ResourceManager::BindGLTextures() const {
 
 /***********************************************************
  *  LoadTextures()
- *  This method calls CreateGLTexture() to load the texture files and BindGLTextures() to bind them to memory
+ *
+ *  This method decodes the texture files on a pool of worker
+ *  threads while the calling GL thread uploads each texture
+ *  as soon as its decode finishes, then calls BindGLTextures()
+ *  to bind them to memory. The textures are registered in
+ *  file order, so their slots do not depend on which decode
+ *  finished first.
  ***********************************************************/
-void ResourceManager::LoadTextures() {
-    CreateGLTexture("Textures/Baby_blue_aqua_mosaic_texture.jpg", "baby_blue_mosaic");
-    CreateGLTexture("Textures/Green_mosaic_texture.jpg", "green_mosaic");
-    CreateGLTexture("Textures/Pink_Marble_texture.jpg", "pink_marble");
-    CreateGLTexture("Textures/stone_rock_texture.jpg", "stone_rock");
-    CreateGLTexture("Textures/very_rough_cement_texture.jpg", "very_rough_cement");
-    CreateGLTexture("Textures/wood_brown_texture.jpg", "wood_brown");
-    CreateGLTexture("Textures/wood_dark.jpg", "wood_dark");
-    CreateGLTexture("Textures/clouds_wispy.jpg", "clouds_wispy");
-    CreateGLTexture("Textures/abstract_texture.jpg", "abstract");
-    CreateGLTexture("Textures/glitch_texture.jpg", "glitch");
-    CreateGLTexture("Textures/Ice_texture.jpg", "ice");
+void ResourceManager::LoadTextures(unsigned threadCount) {
+    auto start = std::chrono::steady_clock::now();
+
+    std::vector<TEXTURE_IMAGE> images;
+    for (const auto& file : g_TextureFiles) {
+        images.push_back({ file[0], file[1], nullptr, 0, 0, 0, 0.0, 0.0 });
+    }
+
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threadCount = static_cast<unsigned>(std::min<size_t>(threadCount, images.size()));
+
+    // The largest files are decoded first, so that one of them
+    // does not start last and hold up the others
+    std::vector<size_t> decodeOrder(images.size());
+    std::vector<std::streamoff> fileSizes(images.size());
+    for (size_t i = 0; i < images.size(); ++i) {
+        decodeOrder[i] = i;
+        fileSizes[i] = GetFileSize(images[i].filename);
+    }
+    std::stable_sort(decodeOrder.begin(), decodeOrder.end(),
+        [&](size_t a, size_t b) { return fileSizes[a] > fileSizes[b]; });
+
+    // Each worker takes the next file and reports it as decoded
+    std::mutex mutex;
+    std::condition_variable decodedSignal;
+    std::vector<size_t> decoded;    // Images in the order their decode finished
+    std::atomic<size_t> nextImage(0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threadCount; ++t) {
+        workers.emplace_back([&]() {
+            for (size_t next = nextImage++; next < images.size(); next = nextImage++) {
+                size_t i = decodeOrder[next];
+                DecodeTextureImage(images[i]);
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    decoded.push_back(i);
+                }
+                decodedSignal.notify_one();
+            }
+        });
+    }
+
+    // Upload each image as soon as it is decoded, OpenGL calls stay on this thread
+    std::vector<GLuint> textureIDs(images.size(), 0);
+    double decodeMs = 0.0;
+    for (size_t uploaded = 0; uploaded < images.size(); ++uploaded) {
+        size_t i;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            decodedSignal.wait(lock, [&]() { return decoded.size() > uploaded; });
+            i = decoded[uploaded];
+        }
+        textureIDs[i] = UploadGLTexture(images[i]);
+        decodeMs += images[i].decodeMs;
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // Register the loaded textures and associate them with their tag strings
+    for (size_t i = 0; i < images.size(); ++i) {
+        if (textureIDs[i] != 0) {
+            m_textures.push_back({ textureIDs[i], images[i].tag });
+        }
+    }
     BindGLTextures();
+
+    std::cout << "INFO: " << m_textures.size() << " textures loaded in " << MillisecondsSince(start)
+        << " ms on " << threadCount << " decode threads, " << decodeMs << " ms of decoding in total" << std::endl;
 }
 
 /***********************************************************
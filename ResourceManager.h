@@ -42,20 +42,33 @@ public:
 
     void SetShaderColor(const glm::vec4& color) const;    // Set the color for the shader using the provided color vector
 
-    void LoadTextures();    // Call CreateGLTexture() to load the texture files and BindGLTextures() to bind to memory
+    void LoadTextures(unsigned threadCount = 0);    // Decode the texture files on threadCount workers (0 for every core), upload them and bind them to memory
     void SetShaderTexture(const std::string& textureTag) const;   // Set the texture data into the shader
     void SetTextureUVScale(float u, float v) const;   // Set the UV scale for the texture mapping
 
     void SetShaderMaterial(const std::string& materialTag) const; // Set the object material into the shader
 
 private:
+    // An image file decoded into memory, waiting to be uploaded
+    struct TEXTURE_IMAGE {
+        std::string filename;
+        std::string tag;
+        unsigned char* pixels;  // Decoded image, null when the file could not be read
+        int width;
+        int height;
+        int colorChannels;
+        double decodeMs;        // Time spent reading and decoding the file
+        double uploadMs;        // Time spent creating the texture and its mipmaps
+    };
+
     std::shared_ptr<ShaderManager> m_pShaderManager;  // Smart Pointer to the ShaderManager Object
     std::unordered_map<std::string, glm::vec4> m_colors;    // Map to store Colors
     std::vector<TEXTURE_INFO> m_textures;    // Vector to store textures
     std::unordered_map<std::string, OBJECT_MATERIAL> m_objectMaterials;    // Map to store Materials
 
     // Load texture images and convert to OpenGL texture data
-    bool CreateGLTexture(const char* filename, const std::string textureTag);   // Load texture images and convert to OpenGL texture data
+    static bool DecodeTextureImage(TEXTURE_IMAGE& image);  // Decode an image file, safe to call from any thread
+    GLuint UploadGLTexture(TEXTURE_IMAGE& image) const;     // Convert a decoded image to an OpenGL texture and free it
     void BindGLTextures() const;     // Bind loaded OpenGL textures to slots in memory
     int GetTextureSlot(const std::string& textureTag) const;    // Get a texture memory slot by tag
     void DestroyGLTextures();     // Free the loaded OpenGL texture memory slots
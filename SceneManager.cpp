@@ -15,13 +15,30 @@
 #include "ShapeGenerator.h"
 #include "ResourceManager.h"
 #include "ShaderManager.h"
+#include "ViewManager.h"
+#include "CullingManager.h"
+#include "MeshStreamingManager.h"
+#include "SurfaceComputeManager.h"
+#include "StaticBatchManager.h"
 #include "stb_image.h"
 #include <glm/gtx/transform.hpp>
+#include <map>
 
 // Declaration of global variables
 namespace
 {
     const char* g_UseLightingName = "bUseLighting";
+
+    // compute shaders for the GPU-driven culling path
+    const char* g_CullShaderPath = "../../Utilities/shaders/cullComputeShader.glsl";
+    const char* g_CompactShaderPath = "../../Utilities/shaders/compactComputeShader.glsl";
+    const char* g_DepthPyramidShaderPath = "../../Utilities/shaders/depthPyramidComputeShader.glsl";
+
+    // compute shader writing the parametric meshes into the geometry pool
+    const char* g_SurfaceShaderPath = "../../Utilities/shaders/surfaceComputeShader.glsl";
+
+    // distance the B key moves a baked object, one cell of the bake so it changes cells
+    const float BAKED_OBJECT_STEP = 8.0f;
 }
 
 /***********************************************************
@@ -31,10 +48,18 @@ namespace
  ***********************************************************/
 SceneManager::SceneManager(std::shared_ptr<ShaderManager> pShaderManager,
     std::shared_ptr<ShapeGenerator> pShapeGenerator,
-    std::shared_ptr<ResourceManager> pResourceManager)
+    std::shared_ptr<ResourceManager> pResourceManager,
+    std::shared_ptr<ViewManager> pViewManager)
     : m_pShaderManager(std::move(pShaderManager)),
     m_pShapeGenerator(std::move(pShapeGenerator)),
-    m_pResourceManager(std::move(pResourceManager))
+    m_pResourceManager(std::move(pResourceManager)),
+    m_pViewManager(std::move(pViewManager)),
+    m_sphereFieldSize(0),
+    m_streamingBudget(0),
+    m_streamedModel(1.0f),
+    m_bGPUSurfaces(false),
+    m_bStaticBatching(false),
+    m_bBakedObjectMoved(false)
 {}
 
 /***********************************************************
@@ -81,11 +106,157 @@ void SceneManager::SetupSceneLights()
  ***********************************************************/
 void SceneManager::PrepareScene()
 {
-    glDisable(GL_CULL_FACE);
+    // closed meshes are wound counter-clockwise, culling is switched per shape
+    glCullFace(GL_BACK);
+    glFrontFace(GL_CCW);
     SetupSceneLights();
     // Load textures and meshes into memory
     m_pResourceManager->LoadTextures();
-    m_pShapeGenerator->LoadMeshes();
+    PrepareGPUSurfaces();
+
+    // the captured scene is the manifest of the meshes to load
+    m_pShapeGenerator->BeginCapture();
+    GenerateSceneObjects();
+    std::vector<SceneObject> sceneObjects = m_pShapeGenerator->EndCapture();
+    m_pShapeGenerator->LoadMeshes(sceneObjects, m_importedMeshPath, m_pSurfaceCompute.get());
+    if (m_pSurfaceCompute)
+    {
+        m_pSurfaceCompute->VerifySurfaces();
+    }
+    PrepareGPUCulling(sceneObjects);
+    PrepareStaticBatches(sceneObjects);
+    PrepareStreamedMesh();
+}
+
+/***********************************************************
+ *  PrepareGPUSurfaces()
+ *
+ *  This method loads the surface compute shader when the
+ *  GPU generation is enabled. Without it the parametric
+ *  meshes are added to the geometry pool from the CPU.
+ ***********************************************************/
+void SceneManager::PrepareGPUSurfaces()
+{
+    if (!m_bGPUSurfaces)
+    {
+        return;
+    }
+
+    m_pSurfaceCompute = std::make_shared<SurfaceComputeManager>(m_pShaderManager,
+        m_pShapeGenerator->GetShapeMeshes()->GetGeometryPool());
+    if (!m_pSurfaceCompute->Initialize(g_SurfaceShaderPath))
+    {
+        m_pSurfaceCompute.reset();
+    }
+}
+
+/***********************************************************
+ *  PrepareStaticBatches()
+ *
+ *  This method bakes the captured scene, which does not move
+ *  after it is prepared, into merged buffers when the static
+ *  batching is enabled. The objects that cannot be baked are
+ *  drawn one at a time after the baked ones. The baked
+ *  objects read their colors from a shader storage buffer,
+ *  so it needs the same OpenGL version as the GPU culling.
+ ***********************************************************/
+void SceneManager::PrepareStaticBatches(const std::vector<SceneObject>& sceneObjects)
+{
+    if (!m_bStaticBatching)
+    {
+        return;
+    }
+    if (!CullingManager::IsSupported())
+    {
+        std::cout << "INFO: OpenGL 4.3 or direct state access is not available, static batching is disabled" << std::endl;
+        return;
+    }
+
+    m_pStaticBatches = std::make_shared<StaticBatchManager>(m_pShaderManager, m_pShapeGenerator->GetShapeMeshes());
+    m_unbakedObjects = m_pStaticBatches->SetObjects(sceneObjects);
+    if (!m_pStaticBatches->IsReady())
+    {
+        m_pStaticBatches.reset();
+    }
+}
+
+/***********************************************************
+ *  PrepareStreamedMesh()
+ *
+ *  This method opens the paged mesh and fits its bounds
+ *  into a sphere of radius 3 behind the scene. Its chunks
+ *  are only loaded once they come into view.
+ ***********************************************************/
+void SceneManager::PrepareStreamedMesh()
+{
+    if (m_streamedMeshPath.empty())
+    {
+        return;
+    }
+
+    m_pStreamingManager = std::make_shared<MeshStreamingManager>(m_streamingBudget);
+    if (!m_pStreamingManager->Open(m_streamedMeshPath))
+    {
+        m_pStreamingManager.reset();
+        return;
+    }
+
+    const PagedMeshFile& file = m_pStreamingManager->GetFile();
+    glm::vec3 center = (file.GetBoundsMin() + file.GetBoundsMax()) * 0.5f;
+    float radius = 0.5f * glm::length(file.GetBoundsMax() - file.GetBoundsMin());
+    float fitScale = radius > 0.0f ? 3.0f / radius : 1.0f;
+    m_streamedModel = glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, 3.0f, -12.0f)) *
+        glm::scale(glm::mat4(1.0f), glm::vec3(fitScale)) *
+        glm::translate(glm::mat4(1.0f), -center);
+}
+
+/***********************************************************
+ *  PrepareGPUCulling()
+ *
+ *  This method groups the captured scene objects into buckets
+ *  that share the same texture and material, and uploads them
+ *  for culling and drawing on the GPU. Shapes that are not in
+ *  the geometry pool are drawn one at a time.
+ ***********************************************************/
+void SceneManager::PrepareGPUCulling(const std::vector<SceneObject>& sceneObjects)
+{
+    std::shared_ptr<ShapeMeshes> pShapeMeshes = m_pShapeGenerator->GetShapeMeshes();
+    m_pCullingManager = std::make_shared<CullingManager>(m_pShaderManager, pShapeMeshes->GetGeometryPool());
+    if (!m_pCullingManager->Initialize(g_CullShaderPath, g_CompactShaderPath, g_DepthPyramidShaderPath))
+    {
+        return;
+    }
+
+    // objects with a solid color share one bucket per material and culling mode,
+    // the color itself is read per object on the GPU
+    std::map<std::string, GLuint> bucketIndices;
+    std::vector<CullingManager::CULL_OBJECT> cullObjects;
+    m_bucketStates.clear();
+    m_unpooledObjects.clear();
+    for (const SceneObject& sceneObject : sceneObjects)
+    {
+        GLuint meshID = 0;
+        if (!pShapeMeshes->GetPoolMeshID(sceneObject.shapeType, sceneObject.submesh, meshID))
+        {
+            m_unpooledObjects.push_back(sceneObject);
+            continue;
+        }
+
+        bool bSolidColor = sceneObject.color != glm::vec4(1.0f);
+        bool bCullBackFaces = pShapeMeshes->CanCullBackFaces(sceneObject.shapeType, sceneObject.submesh);
+        std::string bucketKey = std::string(bSolidColor ? "color|" : "texture|") + (bCullBackFaces ? "cull|" : "both|") +
+            sceneObject.textureTag + "|" + sceneObject.materialTag;
+        auto bucket = bucketIndices.find(bucketKey);
+        if (bucket == bucketIndices.end())
+        {
+            bucket = bucketIndices.emplace(bucketKey, static_cast<GLuint>(m_bucketStates.size())).first;
+            m_bucketStates.push_back(sceneObject);
+        }
+
+        cullObjects.push_back({ meshID, bucket->second, sceneObject.model, sceneObject.color });
+    }
+
+    m_pCullingManager->SetObjects(cullObjects, static_cast<GLuint>(m_bucketStates.size()));
 }
 
 /***********************************************************
@@ -95,6 +266,144 @@ void SceneManager::PrepareScene()
  *  transforming and drawing the basic 3D shapes
  ***********************************************************/
 void SceneManager::RenderScene()
+{
+    if (m_pViewManager)
+    {
+        m_pShapeGenerator->SetViewState(m_pViewManager->GetViewMatrix(),
+            m_pViewManager->GetProjectionMatrix(),
+            m_pViewManager->GetViewportHeight(),
+            m_pViewManager->GetMinScreenSize(),
+            m_pViewManager->IsMeshletCullingEnabled(),
+            m_pViewManager->IsOcclusionQueryEnabled(),
+            m_pViewManager->IsLodEnabled());
+    }
+
+    if (m_pViewManager && m_pViewManager->IsGPUCullingEnabled() &&
+        m_pCullingManager && m_pCullingManager->IsReady())
+    {
+        RenderSceneGPUCulled();
+    }
+    else if (m_pViewManager && m_pStaticBatches)
+    {
+        RenderSceneBaked();
+    }
+    else
+    {
+        GenerateSceneObjects();
+    }
+
+    if (m_pStreamingManager)
+    {
+        m_pShapeGenerator->DrawStreamedMesh(*m_pStreamingManager, m_streamedModel, glm::vec4(0.8f, 0.8f, 0.8f, 1.0f), "", "smoothStone");
+    }
+
+    // the heavy meshes drawn above are tested against the finished depth buffer
+    m_pShapeGenerator->DrawOcclusionQueries();
+}
+
+/***********************************************************
+ *  RenderSceneGPUCulled()
+ *
+ *  This method culls the captured scene on the GPU and draws
+ *  each bucket with one indirect multi-draw call. The depth
+ *  pyramid for the next frame is built afterwards.
+ ***********************************************************/
+void SceneManager::RenderSceneGPUCulled()
+{
+    const glm::mat4& view = m_pViewManager->GetViewMatrix();
+    const glm::mat4& projection = m_pViewManager->GetProjectionMatrix();
+    bool bOcclusionCulling = m_pViewManager->IsOcclusionCullingEnabled();
+
+    m_pCullingManager->SetMinScreenSize(m_pViewManager->GetMinScreenSize());
+    m_pCullingManager->SetLodEnabled(m_pViewManager->IsLodEnabled());
+    m_pCullingManager->CullObjects(view, projection, bOcclusionCulling);
+
+    m_pCullingManager->BeginDraw();
+    for (GLuint bucket = 0; bucket < m_bucketStates.size(); bucket++)
+    {
+        const SceneObject& state = m_bucketStates[bucket];
+        m_pShapeGenerator->SetShaderState(state.color, state.textureTag, state.materialTag);
+        m_pShapeGenerator->SetFaceCulling(state.shapeType, state.submesh);
+        m_pCullingManager->DrawBucket(bucket);
+    }
+    m_pCullingManager->EndDraw();
+
+    for (const SceneObject& sceneObject : m_unpooledObjects)
+    {
+        m_pShapeGenerator->DrawSceneObject(sceneObject);
+    }
+
+    if (bOcclusionCulling)
+    {
+        m_pCullingManager->UpdateDepthPyramid(view, projection);
+    }
+}
+
+/***********************************************************
+ *  RenderSceneBaked()
+ *
+ *  This method draws the baked cells in view with one
+ *  multi-draw call per bucket, then the objects that could
+ *  not be baked one at a time.
+ ***********************************************************/
+void SceneManager::RenderSceneBaked()
+{
+    bool bMoved = m_pViewManager->TakeBakedObjectMove() && MoveBakedObject();
+    GLuint rebakedCells = m_pStaticBatches->GetStats().rebakedCells;
+    m_pStaticBatches->CullCells(m_pViewManager->GetViewMatrix(), m_pViewManager->GetProjectionMatrix());
+    if (bMoved)
+    {
+        std::cout << "INFO: moved a baked object, rebaked " << (m_pStaticBatches->GetStats().rebakedCells - rebakedCells)
+            << " of " << m_pStaticBatches->GetStats().cellCount << " cells" << std::endl;
+    }
+
+    m_pStaticBatches->BeginDraw();
+    for (GLuint bucket = 0; bucket < m_pStaticBatches->GetBucketCount(); bucket++)
+    {
+        const SceneObject& state = m_pStaticBatches->GetBucketState(bucket);
+        m_pShapeGenerator->SetShaderState(state.color, state.textureTag, state.materialTag);
+        m_pShapeGenerator->SetFaceCulling(state.shapeType, state.submesh);
+        m_pStaticBatches->DrawBucket(bucket);
+    }
+    m_pStaticBatches->EndDraw();
+
+    for (const SceneObject& sceneObject : m_unbakedObjects)
+    {
+        m_pShapeGenerator->DrawSceneObject(sceneObject);
+    }
+}
+
+/***********************************************************
+ *  MoveBakedObject()
+ *
+ *  This method moves the last baked object one cell along
+ *  the x axis, or back on the next call, as an editor would.
+ *  Only the cell it left and the one it entered are baked
+ *  and uploaded again, which the next CullCells() does.
+ *  False when the moved object could not be baked.
+ ***********************************************************/
+bool SceneManager::MoveBakedObject()
+{
+    GLuint object = m_pStaticBatches->GetObjectCount() - 1;
+    SceneObject sceneObject = m_pStaticBatches->GetObject(object);
+    float step = m_bBakedObjectMoved ? -BAKED_OBJECT_STEP : BAKED_OBJECT_STEP;
+    sceneObject.model = glm::translate(glm::mat4(1.0f), glm::vec3(step, 0.0f, 0.0f)) * sceneObject.model;
+    if (!m_pStaticBatches->UpdateObject(object, sceneObject))
+    {
+        return false;
+    }
+    m_bBakedObjectMoved = !m_bBakedObjectMoved;
+    return true;
+}
+
+/***********************************************************
+ *  GenerateSceneObjects()
+ *
+ *  This method generates every shape of the scene. It draws
+ *  them directly, or records them while the ShapeGenerator
+ *  is capturing.
+ ***********************************************************/
+void SceneManager::GenerateSceneObjects()
 {
     // Generate First Plane
     m_pShapeGenerator->GenerateShape(
@@ -162,6 +471,18 @@ void SceneManager::RenderScene()
         "ice"                                 // Material
     );
 
+    // Generate Igloo, the upper half of the sphere resting on the floor
+    m_pShapeGenerator->GenerateShape(
+        ShapeType::Sphere,                      // Shape Type
+        glm::vec3(1.25f, 1.25f, 1.25f),         // Scale
+        glm::vec3(0.0f, 0.0f, 0.0f),            // Rotation
+        glm::vec3(-4.0f, 0.0f, 3.0f),           // Position
+        glm::vec4(1.0f),                        // Color
+        "ice",                                  // Texture
+        "ice",                                  // Material
+        "upper half"                            // Submesh
+    );
+
     m_pShapeGenerator->GenerateRubiksCube(
 		glm::vec3(1.0f, 1.0f, 1.0f),            // Scale
 		glm::vec3(0.0f, 0.0f, 0.0f),              // Rotation
@@ -170,5 +491,126 @@ void SceneManager::RenderScene()
 		"",                         // Texture
 		"backdrop"                                 // Material
 	);
+
+    GenerateSphereField();
+    GenerateImportedMesh();
+}
+
+/***********************************************************
+ *  SetSphereFieldSize()
+ *
+ *  This method sets the number of rows and columns of the
+ *  sphere field, 0 leaves it out of the scene. It has to be
+ *  called before PrepareScene().
+ ***********************************************************/
+void SceneManager::SetSphereFieldSize(GLuint size)
+{
+    m_sphereFieldSize = size;
+}
+
+/***********************************************************
+ *  SetImportedMeshPath()
+ *
+ *  This method sets the OBJ, PLY or glTF file that is loaded
+ *  with the other meshes and shown in the scene. It has to
+ *  be called before PrepareScene().
+ ***********************************************************/
+void SceneManager::SetImportedMeshPath(const std::string& path)
+{
+    m_importedMeshPath = path;
+}
+
+/***********************************************************
+ *  SetStreamedMesh()
+ *
+ *  This method sets the paged mesh file that is streamed
+ *  into the scene and the GPU bytes its resident chunks may
+ *  take. It has to be called before PrepareScene().
+ ***********************************************************/
+void SceneManager::SetStreamedMesh(const std::string& path, size_t memoryBudget)
+{
+    m_streamedMeshPath = path;
+    m_streamingBudget = memoryBudget;
+}
+
+/***********************************************************
+ *  SetGPUSurfaceGeneration()
+ *
+ *  This method makes the sphere and torus of the geometry
+ *  pool, with their levels of detail, be written by a
+ *  compute shader and checked against the CPU generator.
+ *  It has to be called before PrepareScene().
+ ***********************************************************/
+void SceneManager::SetGPUSurfaceGeneration(bool bEnabled)
+{
+    m_bGPUSurfaces = bEnabled;
+}
+
+/***********************************************************
+ *  SetStaticBatching()
+ *
+ *  This method makes the captured scene be baked into merged
+ *  world-space buffers, drawn in a few calls per frame when
+ *  the GPU culling is off. It has to be called before
+ *  PrepareScene().
+ ***********************************************************/
+void SceneManager::SetStaticBatching(bool bEnabled)
+{
+    m_bStaticBatching = bEnabled;
+}
+
+/***********************************************************
+ *  GenerateSphereField()
+ *
+ *  This method generates a square grid of spheres that
+ *  recedes from the scene into the distance, a stress scene
+ *  for comparing the triangle throughput with the level of
+ *  detail selection on and off.
+ ***********************************************************/
+void SceneManager::GenerateSphereField()
+{
+    const float spacing = 1.5f;
+    for (GLuint row = 0; row < m_sphereFieldSize; row++)
+    {
+        for (GLuint column = 0; column < m_sphereFieldSize; column++)
+        {
+            float x = (column - 0.5f * (m_sphereFieldSize - 1)) * spacing;
+            float z = -6.0f - row * spacing;
+            m_pShapeGenerator->GenerateShape(
+                ShapeType::Sphere,                      // Shape Type
+                glm::vec3(0.5f, 0.5f, 0.5f),            // Scale
+                glm::vec3(0.0f, 0.0f, 0.0f),            // Rotation
+                glm::vec3(x, 0.5f, z),                  // Position
+                glm::vec4(0.2f + 0.6f * column / m_sphereFieldSize, 0.4f, 0.8f - 0.6f * row / m_sphereFieldSize, 1.0f), // Color
+                "",                                     // Texture
+                "smoothStone"                           // Material
+            );
+        }
+    }
+}
+
+/***********************************************************
+ *  GenerateImportedMesh()
+ *
+ *  This method places the imported mesh, which is fitted
+ *  into the unit sphere, on the floor in front of the scene.
+ *  A file that fails to import is skipped when drawn.
+ ***********************************************************/
+void SceneManager::GenerateImportedMesh()
+{
+    if (m_importedMeshPath.empty())
+    {
+        return;
+    }
+
+    m_pShapeGenerator->GenerateShape(
+        ShapeType::Imported,                    // Shape Type
+        glm::vec3(1.0f, 1.0f, 1.0f),            // Scale
+        glm::vec3(0.0f, 0.0f, 0.0f),            // Rotation
+        glm::vec3(2.5f, 1.0f, 2.0f),            // Position
+        glm::vec4(0.8f, 0.8f, 0.8f, 1.0f),      // Color
+        "",                                     // Texture
+        "smoothStone"                           // Material
+    );
 }
 #endif // SCENEMANAGER_CPP
@@ -10,12 +10,20 @@
 #define SCENEMANAGER_H
 #pragma once
 
+#include <GL/glew.h>
 #include <memory>
 #include <string>
+#include <vector>
+
+#include "ShapeGenerator.h"
 
 class ShaderManager; // Forward Declaration
-class ShapeGenerator; // Forward Declaration
 class ResourceManager; // Forward Declaration
+class ViewManager; // Forward Declaration
+class CullingManager; // Forward Declaration
+class MeshStreamingManager; // Forward Declaration
+class SurfaceComputeManager; // Forward Declaration
+class StaticBatchManager; // Forward Declaration
 
 /***********************************************************
  *  SceneManager
@@ -29,7 +37,8 @@ public:
     // constructor
     SceneManager(std::shared_ptr<ShaderManager> pShaderManager,
         std::shared_ptr<ShapeGenerator> pShapeGenerator,
-        std::shared_ptr<ResourceManager> pResourceManager);
+        std::shared_ptr<ResourceManager> pResourceManager,
+        std::shared_ptr<ViewManager> pViewManager);
 
     // destructor
     ~SceneManager();
@@ -39,10 +48,68 @@ public:
     void PrepareScene();
     void RenderScene();
 
+    // rows and columns of the sphere field stress scene, 0 for none
+    void SetSphereFieldSize(GLuint size);
+    // mesh file shown in the scene as the Imported shape, empty for none
+    void SetImportedMeshPath(const std::string& path);
+    // paged mesh streamed into the scene within the memory budget, empty for none
+    void SetStreamedMesh(const std::string& path, size_t memoryBudget);
+    // write the parametric meshes of the geometry pool with a compute shader
+    void SetGPUSurfaceGeneration(bool bEnabled);
+    // bake the static scene objects into merged world-space buffers
+    void SetStaticBatching(bool bEnabled);
+
 private:
     // shared pointers to managed objects
     std::shared_ptr<ShaderManager> m_pShaderManager;
     std::shared_ptr<ShapeGenerator> m_pShapeGenerator;
     std::shared_ptr<ResourceManager> m_pResourceManager;
+    std::shared_ptr<ViewManager> m_pViewManager;
+    std::shared_ptr<CullingManager> m_pCullingManager;
+    std::shared_ptr<MeshStreamingManager> m_pStreamingManager;
+    std::shared_ptr<SurfaceComputeManager> m_pSurfaceCompute;
+    std::shared_ptr<StaticBatchManager> m_pStaticBatches;
+
+    // shader state shared by the objects of each GPU culling bucket
+    std::vector<SceneObject> m_bucketStates;
+    // captured objects that are not in the geometry pool
+    std::vector<SceneObject> m_unpooledObjects;
+    // captured objects that could not be baked
+    std::vector<SceneObject> m_unbakedObjects;
+    // rows and columns of the sphere field
+    GLuint m_sphereFieldSize;
+    // mesh file of the Imported shape
+    std::string m_importedMeshPath;
+    // paged mesh file of the streamed mesh, its budget and placement
+    std::string m_streamedMeshPath;
+    size_t m_streamingBudget;
+    glm::mat4 m_streamedModel;
+    // parametric pool meshes are generated on the GPU
+    bool m_bGPUSurfaces;
+    // static objects are drawn from baked buffers
+    bool m_bStaticBatching;
+    // the baked object moved with the B key is away from its place
+    bool m_bBakedObjectMoved;
+
+    // generate the shapes of the scene
+    void GenerateSceneObjects();
+    // generate the grid of spheres used to measure the level of detail
+    void GenerateSphereField();
+    // generate the imported mesh when one was loaded
+    void GenerateImportedMesh();
+    // load the compute shader for the parametric pool meshes
+    void PrepareGPUSurfaces();
+    // upload the captured scene for GPU-driven culling
+    void PrepareGPUCulling(const std::vector<SceneObject>& sceneObjects);
+    // bake the captured scene into merged buffers per cell
+    void PrepareStaticBatches(const std::vector<SceneObject>& sceneObjects);
+    // open the streamed mesh and place it behind the scene
+    void PrepareStreamedMesh();
+    // draw the scene through the GPU culling path
+    void RenderSceneGPUCulled();
+    // draw the scene from the baked buffers
+    void RenderSceneBaked();
+    // move the last baked object one cell over and back, rebaking only its cells
+    bool MoveBakedObject();
 };
 #endif // SCENEMANAGER_H
\ No newline at end of file
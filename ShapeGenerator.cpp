@@ -12,8 +12,14 @@
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
 #include "ResourceManager.h"
+#include "OcclusionQueryManager.h"
+#include "MeshStreamingManager.h"
+#include "LodSelection.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
 
 
 // Constructor: Initializes ShapeGenerator with provided ShaderManager, ShapeMeshes, and ResourceManager pointers
@@ -23,7 +29,22 @@ ShapeGenerator::ShapeGenerator(
     std::shared_ptr<ResourceManager> pResourceManager)
     : m_pShaderManager(std::move(pShaderManager)),
     m_basicMeshes(std::move(basicMeshes)),
-    m_pResourceManager(std::move(pResourceManager)) {}
+    m_pResourceManager(std::move(pResourceManager)),
+    m_bCapturing(false),
+    m_model(1.0f),
+    m_frustum(),
+    m_cameraPosition(0.0f),
+    m_bMeshletCulling(false),
+    m_bLod(false),
+    m_bPerspective(true),
+    m_projectionScale(0.0f),
+    m_lodObject(0),
+    m_minScreenSize(0.0f),
+    m_drawnObjects(0),
+    m_contributionCulled(0),
+    m_statsFrames(0),
+    m_pOcclusionQueries(std::make_shared<OcclusionQueryManager>()),
+    m_bOcclusionQueries(false) {}
 
 // Destructor
 ShapeGenerator::~ShapeGenerator() {}
@@ -36,16 +57,54 @@ namespace
     const char* g_TextureValueName = "objectTexture";   // Name for texture value in shader
     const char* g_UseTextureName = "bUseTexture";       // Name for texture usage flag in shader
     const char* g_UVScaleName = "UVscale";              // Name for UVscale usage for texture
+    const char* g_QuantizedName = "bQuantizedVertices"; // Name for quantized vertex flag in shader
+    const char* g_PositionCenterName = "quantizedPositionCenter";   // Name for quantized position center in shader
+    const char* g_PositionExtentName = "quantizedPositionExtent";   // Name for quantized position extent in shader
+    const char* g_UVRangeName = "quantizedUVRange";     // Name for quantized UV range in shader
+
+    const float g_OcclusionNearMargin = 0.5f;           // Camera distance to a query box below which it is not queried
+
+    const GLuint g_StatsInterval = 120;                 // frames between stats reports
+}
+
+/***********************************************************
+ *  LoadMeshes()
+ *  The scene objects are the manifest of the meshes loaded up front. Only those
+ *  meshes are pooled for GPU-driven drawing, startup pays for nothing else.
+ ***********************************************************/
+void ShapeGenerator::LoadMeshes(const std::vector<SceneObject>& sceneObjects,
+    const std::string& importedMeshPath,
+    SurfaceComputeManager* pSurfaceCompute)
+{
+    m_basicMeshes->SetImportedMeshPath(importedMeshPath);
+    for (const SceneObject& sceneObject : sceneObjects)
+    {
+        m_basicMeshes->RequireMesh(sceneObject.shapeType);
+    }
+    std::cout << "INFO: scene meshes loaded, " << m_basicMeshes->GetResidentMeshBytes() << " bytes" << std::endl;
+
+    // Pack the loaded meshes for GPU-driven drawing
+    m_basicMeshes->BuildGeometryPool(pSurfaceCompute);
 }
 
-void ShapeGenerator::LoadMeshes()
+/***********************************************************
+ *  BeginCapture()
+ *  Starts recording GenerateShape() calls as SceneObjects instead of drawing them.
+ ***********************************************************/
+void ShapeGenerator::BeginCapture()
 {
-    m_basicMeshes->LoadBoxMesh();
-    m_basicMeshes->LoadPlaneMesh();
-    m_basicMeshes->LoadSphereMesh(1, 32, 64);
-    m_basicMeshes->LoadTetrahedronMesh();
-    m_basicMeshes->LoadOctahedronMesh();
-    m_basicMeshes->LoadDecahedronMesh();
+    m_capturedObjects.clear();
+    m_bCapturing = true;
+}
+
+/***********************************************************
+ *  EndCapture()
+ *  Stops recording and returns the captured SceneObjects.
+ ***********************************************************/
+std::vector<SceneObject> ShapeGenerator::EndCapture()
+{
+    m_bCapturing = false;
+    return std::move(m_capturedObjects);
 }
 
 void ShapeGenerator::GenerateShape(ShapeType shapeType,
@@ -54,30 +113,152 @@ void ShapeGenerator::GenerateShape(ShapeType shapeType,
     const glm::vec3& position,
     const glm::vec4& color,
     const std::string& textureTag,
-    const std::string& materialTag)
+    const std::string& materialTag,
+    const std::string& submesh)
 {
+    if (m_bCapturing)
+    {
+        m_capturedObjects.push_back({ shapeType, BuildModelMatrix(scale, rotation, position), color, textureTag, materialTag, submesh });
+        return;
+    }
+
     SetTransformations(scale, rotation, position);
+    SetShaderState(color, textureTag, materialTag);
+    DrawShapeMesh(shapeType, submesh);
+}
 
-    if (color != glm::vec4(1.0f)) {
-        SetShaderColor(color);
-        if (materialTag.empty())
-        {
-            SetShaderMaterial("default");
-        }
+/***********************************************************
+ *  DrawSceneObject()
+ *  Draws a captured SceneObject with its own model matrix and shader state.
+ ***********************************************************/
+void ShapeGenerator::DrawSceneObject(const SceneObject& sceneObject)
+{
+    m_model = sceneObject.model;
+    if (m_pShaderManager)
+    {
+        m_pShaderManager->setMat4Value(g_ModelName, m_model);
     }
-    else if (!textureTag.empty() && !materialTag.empty())
+    SetShaderState(sceneObject.color, sceneObject.textureTag, sceneObject.materialTag);
+    DrawShapeMesh(sceneObject.shapeType, sceneObject.submesh);
+}
+
+/***********************************************************
+ *  DrawStreamedMesh()
+ *  Draws a streamed mesh with its own model matrix and shader state. The winding
+ *  of a streamed mesh is not known, so both sides are drawn.
+ ***********************************************************/
+void ShapeGenerator::DrawStreamedMesh(MeshStreamingManager& streamingManager,
+    const glm::mat4& model,
+    const glm::vec4& color,
+    const std::string& textureTag,
+    const std::string& materialTag)
+{
+    m_model = model;
+    if (m_pShaderManager)
     {
-        SetShaderTexture(textureTag);
-        SetShaderMaterial(materialTag);
+        m_pShaderManager->setMat4Value(g_ModelName, m_model);
     }
-    else if (textureTag.empty() || materialTag.empty())
+    SetShaderState(color, textureTag, materialTag);
+    SetVertexDecoding(nullptr);
+    glDisable(GL_CULL_FACE);
+
+    streamingManager.Update(m_model, m_frustum, m_cameraPosition);
+    streamingManager.Draw();
+}
+
+/***********************************************************
+ *  DrawShapeMesh()
+ *  Draws the mesh of the shape type with the current shader state.
+ *  Heavy meshes are skipped when last frame's query found their bounding box hidden,
+ *  pooled meshes when they project smaller than the minimum screen size.
+ *  A named range of the mesh is drawn alone, an unknown name draws nothing.
+ ***********************************************************/
+void ShapeGenerator::DrawShapeMesh(ShapeType shapeType, const std::string& submesh)
+{
+    // the mesh is loaded on its first draw, a shape without one is skipped
+    if (!m_basicMeshes->RequireMesh(shapeType))
     {
-        if (!textureTag.empty()) {
-            SetShaderTexture(textureTag);
+        return;
+    }
+
+    const SubmeshRange* pSubmesh = nullptr;
+    if (!submesh.empty())
+    {
+        pSubmesh = m_basicMeshes->FindSubmesh(shapeType, submesh);
+        if (!pSubmesh)
+        {
+            return;
         }
-        else if (!materialTag.empty()) {
-            SetShaderMaterial(materialTag);
+    }
+
+    // the bounds of the whole mesh hold any of its ranges, so a range is never removed while visible
+    GLuint meshID = 0;
+    if (m_minScreenSize > 0.0f && m_basicMeshes->GetPoolMeshID(shapeType, meshID) &&
+        GetProjectedSize(meshID) < m_minScreenSize)
+    {
+        // the removed object keeps its place in the draw order the levels are kept by
+        if (!pSubmesh && m_bLod && m_basicMeshes->GetGeometryPool()->GetLodCount(meshID) > 1)
+        {
+            m_lodObject++;
         }
+        m_contributionCulled++;
+        return;
+    }
+    m_drawnObjects++;
+
+    SetFaceCulling(shapeType, submesh);
+    SetVertexDecoding(m_basicMeshes->GetVertexDecoding(shapeType));
+
+    if (!m_bOcclusionQueries || !m_basicMeshes->IsHeavyMesh(shapeType))
+    {
+        DrawShapeGeometry(shapeType, pSubmesh);
+        return;
+    }
+
+    glm::mat4 boxModel;
+    bool bQueryBox = GetOcclusionBox(shapeType, boxModel);
+    GLuint slot = m_pOcclusionQueries->BeginConditionalDraw(bQueryBox);
+    DrawShapeGeometry(shapeType, pSubmesh);
+    m_pOcclusionQueries->EndConditionalDraw();
+
+    if (bQueryBox)
+    {
+        m_pOcclusionQueries->AddBoundingBox(slot, boxModel);
+    }
+}
+
+/***********************************************************
+ *  DrawShapeGeometry()
+ *  Draws a named range, the meshlets or the whole mesh of the shape type.
+ ***********************************************************/
+void ShapeGenerator::DrawShapeGeometry(ShapeType shapeType, const SubmeshRange* pSubmesh)
+{
+    if (pSubmesh)
+    {
+        m_basicMeshes->DrawSubmesh(shapeType, *pSubmesh);
+        return;
+    }
+
+    // a coarser level is drawn from the float vertices of the geometry pool
+    GLuint meshID = 0;
+    GLuint level = SelectLod(shapeType, meshID);
+    if (level > 0)
+    {
+        SetVertexDecoding(nullptr);
+        m_basicMeshes->DrawPoolLod(meshID, level);
+        return;
+    }
+
+    if (m_bMeshletCulling && m_basicMeshes->HasMeshlets(shapeType))
+    {
+        m_basicMeshes->DrawMeshlets(shapeType, m_model, m_frustum, m_cameraPosition);
+        return;
+    }
+
+    if (m_basicMeshes->GetVertexDecoding(shapeType))
+    {
+        m_basicMeshes->DrawQuantizedMesh(shapeType);
+        return;
     }
 
     switch (shapeType) {
@@ -117,11 +298,258 @@ void ShapeGenerator::GenerateShape(ShapeType shapeType,
     case ShapeType::Decahedron:
         m_basicMeshes->DrawDecahedronMesh();
 		break;
+    case ShapeType::Dodecahedron:
+        m_basicMeshes->DrawDodecahedronMesh();
+        break;
+    case ShapeType::Icosahedron:
+        m_basicMeshes->DrawIcosahedronMesh();
+        break;
+    case ShapeType::Imported:
+        m_basicMeshes->DrawImportedMesh();
+        break;
     default:
         break;
     }
 }
 
+/***********************************************************
+ *  SetViewState()
+ *  Stores the frustum and camera position that meshlet culling, contribution
+ *  culling and the level of detail selection test against, and starts a new
+ *  frame of occlusion queries and of the mesh registry.
+ ***********************************************************/
+void ShapeGenerator::SetViewState(const glm::mat4& view,
+    const glm::mat4& projection,
+    float viewportHeight,
+    float minScreenSize,
+    bool bMeshletCulling,
+    bool bOcclusionQueries,
+    bool bLod)
+{
+    m_frustum = Frustum::FromMatrix(projection * view);
+    m_cameraPosition = glm::vec3(glm::inverse(view)[3]);
+    m_bMeshletCulling = bMeshletCulling;
+
+    // projected diameter in pixels = 2 * radius * projectionScale / distance,
+    // an orthographic projection has no perspective divide
+    m_bLod = bLod;
+    m_bPerspective = projection[3][3] == 0.0f;
+    m_projectionScale = projection[1][1] * 0.5f * viewportHeight;
+    m_lodObject = 0;
+
+    if (++m_statsFrames >= g_StatsInterval)
+    {
+        ReportStats();
+    }
+    m_minScreenSize = minScreenSize;
+    m_drawnObjects = 0;
+    m_contributionCulled = 0;
+
+    // a new frame runs even while the queries are off, so stale results expire
+    m_bOcclusionQueries = bOcclusionQueries;
+    m_pOcclusionQueries->BeginFrame();
+
+    // meshes left unused are released while over the memory budget
+    m_basicMeshes->BeginMeshFrame();
+}
+
+/***********************************************************
+ *  SelectLod()
+ *  Picks the level of the pooled mesh from the projected diameter of its bounding
+ *  sphere, the same way as the culling pass. The scene draws its objects in the
+ *  same order every frame, so the draw order keeps each object's last level, which
+ *  it only leaves once it is LOD_HYSTERESIS levels past it.
+ ***********************************************************/
+GLuint ShapeGenerator::SelectLod(ShapeType shapeType, GLuint& meshID)
+{
+    if (!m_bLod || !m_basicMeshes->GetPoolMeshID(shapeType, meshID))
+    {
+        return 0;
+    }
+    std::shared_ptr<GeometryPool> pGeometryPool = m_basicMeshes->GetGeometryPool();
+    GLuint lodCount = pGeometryPool->GetLodCount(meshID);
+    if (lodCount <= 1)
+    {
+        return 0;
+    }
+
+    float projectedSize = GetProjectedSize(meshID);
+    float lod = glm::clamp(std::log2(LOD_BASE_SIZE / std::max(projectedSize, 1e-3f)), 0.0f, static_cast<float>(lodCount - 1));
+
+    if (m_lodObject >= m_objectLods.size())
+    {
+        m_objectLods.push_back(NO_LOD);
+    }
+    GLuint& level = m_objectLods[m_lodObject++];
+    if (level >= lodCount || lod < level - LOD_HYSTERESIS || lod > level + 1.0f + LOD_HYSTERESIS)
+    {
+        level = std::min(static_cast<GLuint>(lod), lodCount - 1);
+    }
+    return level;
+}
+
+/***********************************************************
+ *  GetProjectedSize()
+ *  The diameter in pixels of the bounding sphere of the pooled mesh under the
+ *  current model matrix. A camera inside the sphere sees it as unbounded.
+ ***********************************************************/
+float ShapeGenerator::GetProjectedSize(GLuint meshID) const
+{
+    const glm::vec4& bounds = m_basicMeshes->GetGeometryPool()->GetMeshRange(meshID).bounds;
+    float scale = std::max(glm::length(glm::vec3(m_model[0])),
+        std::max(glm::length(glm::vec3(m_model[1])), glm::length(glm::vec3(m_model[2]))));
+    glm::vec3 center = glm::vec3(m_model * glm::vec4(glm::vec3(bounds), 1.0f));
+    float radius = bounds.w * scale;
+
+    float distance = m_bPerspective ? glm::length(center - m_cameraPosition) : 1.0f;
+    if (m_bPerspective && distance <= radius)
+    {
+        return 1e30f;
+    }
+    return 2.0f * radius * m_projectionScale / distance;
+}
+
+/***********************************************************
+ *  ReportStats()
+ *  Prints how many objects the last frame drew one at a time and how many of them
+ *  contribution culling removed, the counterpart of the culling pass's frame stats.
+ ***********************************************************/
+void ShapeGenerator::ReportStats()
+{
+    GLuint objectCount = m_drawnObjects + m_contributionCulled;
+    if (objectCount > 0)
+    {
+        std::cout << "INFO: immediate frame stats - " << m_drawnObjects << " of " << objectCount
+            << " objects drawn, removed: " << m_contributionCulled << " contribution (< " << m_minScreenSize << " px)" << std::endl;
+    }
+    m_statsFrames = 0;
+}
+
+/***********************************************************
+ *  GetOcclusionBox()
+ *  Builds the box around the bounding sphere of a heavy mesh. A camera inside or
+ *  near the box would clip it, so those meshes are drawn without a query.
+ ***********************************************************/
+bool ShapeGenerator::GetOcclusionBox(ShapeType shapeType, glm::mat4& boxModel) const
+{
+    GLuint meshID = 0;
+    if (!m_basicMeshes->GetPoolMeshID(shapeType, meshID))
+    {
+        return false;
+    }
+    const glm::vec4& bounds = m_basicMeshes->GetGeometryPool()->GetMeshRange(meshID).bounds;
+
+    boxModel = m_model * glm::translate(glm::mat4(1.0f), glm::vec3(bounds));
+    boxModel = glm::scale(boxModel, glm::vec3(2.0f * bounds.w));
+
+    // the sphere around the box corners, grown by the near plane margin
+    float maxScale = std::max(glm::length(glm::vec3(boxModel[0])),
+        std::max(glm::length(glm::vec3(boxModel[1])), glm::length(glm::vec3(boxModel[2]))));
+    float boxRadius = 0.5f * std::sqrt(3.0f) * maxScale;
+    return glm::length(m_cameraPosition - glm::vec3(boxModel[3])) > boxRadius + g_OcclusionNearMargin;
+}
+
+/***********************************************************
+ *  DrawOcclusionQueries()
+ *  Draws the queued bounding boxes without writing color or depth, each inside
+ *  its occlusion query, once every occluder of the frame is in the depth buffer.
+ ***********************************************************/
+void ShapeGenerator::DrawOcclusionQueries()
+{
+    GLuint boxCount = m_pOcclusionQueries->GetBoundingBoxCount();
+    if (boxCount == 0)
+    {
+        return;
+    }
+
+    glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    glDepthMask(GL_FALSE);
+    glDisable(GL_CULL_FACE);
+    SetVertexDecoding(nullptr);
+    m_basicMeshes->RequireMesh(ShapeType::Box);
+
+    for (GLuint box = 0; box < boxCount; box++)
+    {
+        if (m_pShaderManager)
+        {
+            m_pShaderManager->setMat4Value(g_ModelName, m_pOcclusionQueries->GetBoundingBoxModel(box));
+        }
+        m_pOcclusionQueries->BeginQuery(box);
+        m_basicMeshes->DrawBoxMesh();
+        m_pOcclusionQueries->EndQuery();
+    }
+
+    glDepthMask(GL_TRUE);
+    glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+/***********************************************************
+ *  SetVertexDecoding()
+ *  Passes the ranges that turn quantized vertices back into positions and UVs.
+ ***********************************************************/
+void ShapeGenerator::SetVertexDecoding(const VertexDecoding* decoding)
+{
+    if (!m_pShaderManager)
+    {
+        return;
+    }
+
+    m_pShaderManager->setBoolValue(g_QuantizedName, decoding != nullptr);
+    if (decoding)
+    {
+        m_pShaderManager->setVec3Value(g_PositionCenterName, decoding->positionCenter);
+        m_pShaderManager->setVec3Value(g_PositionExtentName, decoding->positionExtent);
+        m_pShaderManager->setVec4Value(g_UVRangeName, decoding->uvRange);
+    }
+}
+
+/***********************************************************
+ *  SetFaceCulling()
+ *  Culls back faces only for whole meshes whose winding was normalized when loaded.
+ ***********************************************************/
+void ShapeGenerator::SetFaceCulling(ShapeType shapeType, const std::string& submesh) const
+{
+    if (m_basicMeshes->CanCullBackFaces(shapeType, submesh))
+    {
+        glEnable(GL_CULL_FACE);
+    }
+    else
+    {
+        glDisable(GL_CULL_FACE);
+    }
+}
+
+/***********************************************************
+ *  SetShaderState()
+ *  Selects the shader color, texture, and material for a shape from its color, texture tag, and material tag.
+ ***********************************************************/
+void ShapeGenerator::SetShaderState(const glm::vec4& color,
+    const std::string& textureTag,
+    const std::string& materialTag)
+{
+    if (color != glm::vec4(1.0f)) {
+        SetShaderColor(color);
+        if (materialTag.empty())
+        {
+            SetShaderMaterial("default");
+        }
+    }
+    else if (!textureTag.empty() && !materialTag.empty())
+    {
+        SetShaderTexture(textureTag);
+        SetShaderMaterial(materialTag);
+    }
+    else if (textureTag.empty() || materialTag.empty())
+    {
+        if (!textureTag.empty()) {
+            SetShaderTexture(textureTag);
+        }
+        else if (!materialTag.empty()) {
+            SetShaderMaterial(materialTag);
+        }
+    }
+}
+
 // Generates a Rubiks Cube with specified transformations and color.
 void ShapeGenerator::GenerateRubiksCube(const glm::vec3& scale, const glm::vec3& rotation, const glm::vec3& position, const glm::vec4& color, const std::string& textureTag, const std:: string& materialTag)
 {
@@ -180,6 +608,19 @@ void ShapeGenerator::GenerateRubiksCube(const glm::vec3& scale, const glm::vec3&
     }
 }
 
+/***********************************************************
+ *  BuildModelMatrix()
+ *  This method combines scaling, rotation, and translation into the model matrix of a shape.
+ ***********************************************************/
+glm::mat4 ShapeGenerator::BuildModelMatrix(const glm::vec3& scale, const glm::vec3& rotation, const glm::vec3& position) const
+{
+    return glm::translate(glm::mat4(1.0f), position) *
+        glm::rotate(glm::mat4(1.0f), glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f)) *
+        glm::rotate(glm::mat4(1.0f), glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f)) *
+        glm::rotate(glm::mat4(1.0f), glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f)) *
+        glm::scale(glm::mat4(1.0f), scale);
+}
+
 /***********************************************************
  *  SetTransformations()
  *  This method applies transformations (scaling, rotation, translation) to the shape and updates the shader with the resulting model matrix.
@@ -187,16 +628,12 @@ void ShapeGenerator::GenerateRubiksCube(const glm::vec3& scale, const glm::vec3&
 void ShapeGenerator::SetTransformations(const glm::vec3& scale, const glm::vec3& rotation, const glm::vec3& position)
 {
     // Create modelView from translation, rotation, and scale
-    glm::mat4 modelView = glm::translate(glm::mat4(1.0f), position) *
-        glm::rotate(glm::mat4(1.0f), glm::radians(rotation.x), glm::vec3(1.0f, 0.0f, 0.0f)) *
-        glm::rotate(glm::mat4(1.0f), glm::radians(rotation.y), glm::vec3(0.0f, 1.0f, 0.0f)) * 
-        glm::rotate(glm::mat4(1.0f), glm::radians(rotation.z), glm::vec3(0.0f, 0.0f, 1.0f)) * 
-        glm::scale(glm::mat4(1.0f), scale);
+    m_model = BuildModelMatrix(scale, rotation, position);
 
     // Update the shader with the model matrix
     if (m_pShaderManager)
     {
-        m_pShaderManager->setMat4Value(g_ModelName, modelView);
+        m_pShaderManager->setMat4Value(g_ModelName, m_model);
     }
 }
 
@@ -11,13 +11,21 @@
 #define SHAPEGENERATOR_H
 #pragma once
 
+#include <GL/glew.h>
 #include <memory>
 #include <glm/glm.hpp>
+#include "Frustum.h"
 #include <string>
+#include <vector>
 
 class ShaderManager; // Forward declaration
+class OcclusionQueryManager; // Forward declaration
+struct VertexDecoding; // Forward declaration
+struct SubmeshRange; // Forward declaration
 class ShapeMeshes; // Forward declaration
 class ResourceManager; // Forward declaration
+class MeshStreamingManager; // Forward declaration
+class SurfaceComputeManager; // Forward declaration
 
 enum class ShapeType {
     Box,
@@ -33,7 +41,18 @@ enum class ShapeType {
     Octahedron,
     Decahedron,
     Dodecahedron,
-    Icosahedron
+    Icosahedron,
+    Imported
+};
+
+// A shape request recorded while capturing the scene instead of being drawn
+struct SceneObject {
+    ShapeType shapeType;
+    glm::mat4 model;
+    glm::vec4 color;
+    std::string textureTag;
+    std::string materialTag;
+    std::string submesh;    // named range of the mesh, empty for the whole mesh
 };
 
 // Class for generating various shapes for use in Scenes
@@ -46,7 +65,12 @@ public:
         std::shared_ptr<ResourceManager> pResourceManager);
     ~ShapeGenerator();
 
-    void LoadMeshes();
+    // loads and pools the meshes of the captured scene objects, the other shapes are loaded on their
+    // first draw; the mesh file is the Imported shape unless the path is empty; with a surface
+    // compute manager the parametric meshes of the geometry pool are written on the GPU
+    void LoadMeshes(const std::vector<SceneObject>& sceneObjects,
+        const std::string& importedMeshPath = "",
+        SurfaceComputeManager* pSurfaceCompute = nullptr);
 
     void GenerateShape(ShapeType shapeType,
         const glm::vec3& scale,
@@ -54,7 +78,8 @@ public:
         const glm::vec3& position,
         const glm::vec4& color = glm::vec4(1.0f),
         const std::string& textureTag = "",
-        const std::string& materialTag = "");
+        const std::string& materialTag = "",
+        const std::string& submesh = "");
 
     void GenerateRubiksCube(const glm::vec3& scale,
         const glm::vec3& rotation,
@@ -63,6 +88,43 @@ public:
         const std::string& textureTag = "",
         const std::string& materialTag = "");
 
+    // While capturing, GenerateShape() records SceneObjects instead of drawing them
+    void BeginCapture();
+    std::vector<SceneObject> EndCapture();
+
+    // Draws a captured SceneObject immediately
+    void DrawSceneObject(const SceneObject& sceneObject);
+
+    // Streams in the chunks of a paged mesh that the camera sees and draws the resident ones
+    void DrawStreamedMesh(MeshStreamingManager& streamingManager,
+        const glm::mat4& model,
+        const glm::vec4& color,
+        const std::string& textureTag = "",
+        const std::string& materialTag = "");
+
+    // Applies the color, texture, and material selection used by GenerateShape()
+    void SetShaderState(const glm::vec4& color,
+        const std::string& textureTag,
+        const std::string& materialTag);
+
+    // Sets the camera used to cull the meshlets of large meshes, to query heavy meshes,
+    // to remove pooled meshes smaller than minScreenSize pixels and to pick their level of detail this frame
+    void SetViewState(const glm::mat4& view,
+        const glm::mat4& projection,
+        float viewportHeight,
+        float minScreenSize,
+        bool bMeshletCulling,
+        bool bOcclusionQueries,
+        bool bLod);
+
+    // Queries the bounding boxes of the heavy meshes drawn this frame, after the rest of the scene
+    void DrawOcclusionQueries();
+
+    // Enables back-face culling for closed meshes and disables it for open ones and their parts
+    void SetFaceCulling(ShapeType shapeType, const std::string& submesh = "") const;
+
+    std::shared_ptr<ShapeMeshes> GetShapeMeshes() const { return m_basicMeshes; }
+
 private:
 
     // Pointer to the ShaderManager object
@@ -74,6 +136,56 @@ private:
     // Pointer to the ResourceManager object
     std::shared_ptr<ResourceManager> m_pResourceManager;
 
+    // Scene objects recorded while capturing
+    bool m_bCapturing;
+    std::vector<SceneObject> m_capturedObjects;
+
+    // Model matrix of the shape being drawn and the camera for meshlet culling
+    glm::mat4 m_model;
+    Frustum m_frustum;
+    glm::vec3 m_cameraPosition;
+    bool m_bMeshletCulling;
+
+    // Level of detail of the pooled meshes drawn immediately, picked from the projected size
+    // like the culling pass does; objects are told apart by their draw order within the frame
+    bool m_bLod;
+    bool m_bPerspective;
+    float m_projectionScale;            // Pixels per unit at distance 1, or per unit when orthographic
+    std::vector<GLuint> m_objectLods;   // Level each object was drawn with, kept across frames for the hysteresis
+    GLuint m_lodObject;                 // Draw order of the next object with levels this frame
+
+    // Contribution culling of the pooled meshes drawn immediately, like the culling pass
+    float m_minScreenSize;              // Objects with a smaller projected diameter in pixels are not drawn
+    GLuint m_drawnObjects;              // Objects drawn this frame
+    GLuint m_contributionCulled;        // Objects removed by contribution culling this frame
+    GLuint m_statsFrames;               // Frames since the last stats report
+
+    // Bounding box queries that skip hidden heavy meshes in the next frame
+    std::shared_ptr<OcclusionQueryManager> m_pOcclusionQueries;
+    bool m_bOcclusionQueries;
+
+    // Builds the model matrix from scale, rotation, and position
+    glm::mat4 BuildModelMatrix(const glm::vec3& scale, const glm::vec3& rotation, const glm::vec3& position) const;
+
+    // Draws the mesh of the shape type, or one of its named ranges, with the current shader state
+    void DrawShapeMesh(ShapeType shapeType, const std::string& submesh = "");
+    void DrawShapeGeometry(ShapeType shapeType, const SubmeshRange* pSubmesh);
+
+    // Picks the level of detail of the pooled mesh of the shape type for the current model matrix, 0 for full detail
+    GLuint SelectLod(ShapeType shapeType, GLuint& meshID);
+
+    // Projected diameter in pixels of the bounding sphere of a pooled mesh for the current model matrix
+    float GetProjectedSize(GLuint meshID) const;
+
+    // Reports the immediate draws of the last frame and the ones contribution culling removed
+    void ReportStats();
+
+    // Selects float vertices, or the decoding ranges of a quantized mesh, in the shader
+    void SetVertexDecoding(const VertexDecoding* decoding);
+
+    // Builds the box around the bounding sphere of a heavy mesh, false when the camera is too close to query it
+    bool GetOcclusionBox(ShapeType shapeType, glm::mat4& boxModel) const;
+
     // Sets the transformation matrices (scale, rotation, and position) for the shape
     void SetTransformations(const glm::vec3& scale, const glm::vec3& rotation, const glm::vec3& position);
 
@@ -0,0 +1,644 @@
+///////////////////////////////////////////////////////////////////////////////
+// StaticBatchManager.cpp
+// ============
+// Baking of static scene objects into merged world-space buffers
+//
+//  Objects that never move after PrepareScene() are transformed once on the
+//  CPU and merged per spatial cell and shader state bucket. A frame of static
+//  content then takes one multi-draw call per bucket over the visible cells,
+//  with no model matrix uploads, and an edited object only rebakes the cells
+//  it left and entered.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StaticBatchManager.h"
+#include "ShaderManager.h"
+#include "ShapeMeshes.h"
+#include "CullingManager.h"
+#include "Frustum.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+    const GLuint OBJECT_INDEX_ATTRIBUTE = 3;    // inObjectIndex in the vertex shader
+    const GLuint OBJECT_INDEX_BINDING = 1;      // vertex buffer binding after the mesh vertices
+    const GLuint OBJECT_BINDING = 0;            // ObjectBuffer in the vertex shader
+
+    // a heavy mesh gains little from merging and its copies fill memory quickly,
+    // the geometry pool draws it better; the bake as a whole is capped as well
+    const GLuint MAX_OBJECT_VERTICES = 16384;
+    const GLuint MAX_BAKED_VERTICES = 1u << 22;
+
+    // every cell gets room to grow by half before an edit moves it
+    // to the end of the buffers, which grow by half once full
+    const float CELL_GROWTH = 1.5f;
+    const GLuint NO_VERTEX = 0xFFFFFFFFu;
+
+    const char* g_UseObjectBufferName = "bUseObjectBuffer";
+    const char* g_QuantizedVerticesName = "bQuantizedVertices";    // the baked vertices are floats
+
+    GLuint WithGrowth(GLuint count)
+    {
+        return static_cast<GLuint>(std::ceil(count * CELL_GROWTH));
+    }
+
+    // the mesh of an object and the run of its indices, false when it has none
+    bool FindObjectMesh(ShapeMeshes& shapeMeshes,
+        const SceneObject& sceneObject,
+        const MeshData*& pMeshData,
+        IndexRange& range,
+        GLint& baseVertex)
+    {
+        if (!shapeMeshes.RequireMesh(sceneObject.shapeType))
+        {
+            return false;
+        }
+        pMeshData = shapeMeshes.GetMeshData(sceneObject.shapeType);
+        if (!pMeshData)
+        {
+            return false;
+        }
+
+        range = { 0, pMeshData->IndexCount() };
+        baseVertex = 0;
+        if (!sceneObject.submesh.empty())
+        {
+            const SubmeshRange* pSubmesh = shapeMeshes.FindSubmesh(sceneObject.shapeType, sceneObject.submesh);
+            if (!pSubmesh)
+            {
+                return false;
+            }
+            range = pSubmesh->Indices();
+            baseVertex = pSubmesh->baseVertex;
+        }
+        return true;
+    }
+
+    // the most vertices an object bakes into, no more than its mesh or its indices hold
+    GLuint GetObjectVertexCount(const MeshData& meshData, const IndexRange& range)
+    {
+        return std::min(meshData.VertexCount(), range.indexCount);
+    }
+}
+
+/***********************************************************
+ *  StaticBatchManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StaticBatchManager::StaticBatchManager(std::shared_ptr<ShaderManager> pShaderManager, std::shared_ptr<ShapeMeshes> pShapeMeshes)
+    : m_pShaderManager(std::move(pShaderManager)),
+    m_pShapeMeshes(std::move(pShapeMeshes)),
+    m_cellSize(8.0f),
+    m_vao(0),
+    m_vertexBuffer(0),
+    m_objectIndexBuffer(0),
+    m_indexBuffer(0),
+    m_objectBuffer(0),
+    m_vertexCapacity(0),
+    m_indexCapacity(0),
+    m_vertexEnd(0),
+    m_indexEnd(0),
+    m_stats()
+{}
+
+/***********************************************************
+ *  ~StaticBatchManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+StaticBatchManager::~StaticBatchManager()
+{
+    DestroyBuffers();
+}
+
+/***********************************************************
+ *  SetObjects()
+ *
+ *  This method sorts the objects into the cells of a grid by
+ *  their origin and bakes every cell. The objects keep their
+ *  color in an object buffer that the vertex shader reads
+ *  through the object index of each vertex, so objects that
+ *  only differ in color share a bucket.
+ ***********************************************************/
+std::vector<SceneObject> StaticBatchManager::SetObjects(const std::vector<SceneObject>& objects, float cellSize)
+{
+    DestroyBuffers();
+    m_objects.clear();
+    m_objectBuckets.clear();
+    m_objectCells.clear();
+    m_cells.clear();
+    m_cellIndices.clear();
+    m_bucketStates.clear();
+    m_bucketIndices.clear();
+    m_visibleCells.clear();
+    m_stats = BAKE_STATS();
+    m_cellSize = cellSize;
+
+    std::vector<SceneObject> unbakedObjects;
+    GLuint bakedVertices = 0;
+    for (const SceneObject& sceneObject : objects)
+    {
+        const MeshData* pMeshData = nullptr;
+        IndexRange range;
+        GLint baseVertex;
+        if (!FindObjectMesh(*m_pShapeMeshes, sceneObject, pMeshData, range, baseVertex))
+        {
+            unbakedObjects.push_back(sceneObject);
+            continue;
+        }
+
+        GLuint vertexCount = GetObjectVertexCount(*pMeshData, range);
+        if (vertexCount > MAX_OBJECT_VERTICES || bakedVertices + vertexCount > MAX_BAKED_VERTICES)
+        {
+            unbakedObjects.push_back(sceneObject);
+            continue;
+        }
+        bakedVertices += vertexCount;
+
+        GLuint object = static_cast<GLuint>(m_objects.size());
+        m_objects.push_back(sceneObject);
+        m_objectBuckets.push_back(FindBucket(sceneObject));
+        m_objectCells.push_back(FindCell(sceneObject));
+        m_cells[m_objectCells.back()].objects.push_back(object);
+    }
+
+    if (m_objects.empty())
+    {
+        return unbakedObjects;
+    }
+
+    glCreateBuffers(1, &m_objectBuffer);
+    glNamedBufferData(m_objectBuffer, m_objects.size() * sizeof(CullingManager::OBJECT_DATA), nullptr, GL_DYNAMIC_DRAW);
+    for (GLuint object = 0; object < m_objects.size(); object++)
+    {
+        UploadObject(object);
+    }
+
+    RebakeAll();
+
+    std::cout << "INFO: baked " << m_stats.objectCount << " static objects into " << m_stats.cellCount
+        << " cells and " << m_stats.bucketCount << " buckets, " << m_stats.vertexCount << " vertices, "
+        << unbakedObjects.size() << " objects left unbaked" << std::endl;
+    return unbakedObjects;
+}
+
+/***********************************************************
+ *  UpdateObject()
+ *
+ *  This method replaces a baked object, for example after it
+ *  was moved or recolored in an editor. Only the cell it was
+ *  in and the one it moves to are baked again, on the next
+ *  CullCells(). A replacement that cannot be baked is refused.
+ ***********************************************************/
+bool StaticBatchManager::UpdateObject(GLuint object, const SceneObject& sceneObject)
+{
+    if (object >= m_objects.size())
+    {
+        return false;
+    }
+
+    const MeshData* pMeshData = nullptr;
+    IndexRange range;
+    GLint baseVertex;
+    if (!FindObjectMesh(*m_pShapeMeshes, sceneObject, pMeshData, range, baseVertex) ||
+        GetObjectVertexCount(*pMeshData, range) > MAX_OBJECT_VERTICES)
+    {
+        return false;
+    }
+
+    GLuint oldCell = m_objectCells[object];
+    m_cells[oldCell].bDirty = true;
+
+    m_objects[object] = sceneObject;
+    m_objectBuckets[object] = FindBucket(sceneObject);
+    GLuint newCell = FindCell(sceneObject);
+    if (newCell != oldCell)
+    {
+        std::vector<GLuint>& oldObjects = m_cells[oldCell].objects;
+        oldObjects.erase(std::remove(oldObjects.begin(), oldObjects.end(), object), oldObjects.end());
+        m_cells[newCell].objects.push_back(object);
+        m_objectCells[object] = newCell;
+    }
+    m_cells[newCell].bDirty = true;
+
+    UploadObject(object);
+    return true;
+}
+
+/***********************************************************
+ *  CullCells()
+ *
+ *  This method bakes the cells edited since the last frame
+ *  and keeps the cells whose bounding sphere touches the
+ *  view frustum.
+ ***********************************************************/
+void StaticBatchManager::CullCells(const glm::mat4& view, const glm::mat4& projection)
+{
+    RebakeDirtyCells();
+
+    Frustum frustum = Frustum::FromMatrix(projection * view);
+    m_visibleCells.clear();
+    for (GLuint cell = 0; cell < m_cells.size(); cell++)
+    {
+        const CELL& cellData = m_cells[cell];
+        if (!cellData.batches.empty() && frustum.IntersectsSphere(glm::vec3(cellData.bounds), cellData.bounds.w))
+        {
+            m_visibleCells.push_back(cell);
+        }
+    }
+
+    m_stats.visibleCells = static_cast<GLuint>(m_visibleCells.size());
+    m_stats.drawCalls = 0;
+}
+
+/***********************************************************
+ *  BeginDraw()
+ *
+ *  This method binds the baked buffers and the object buffer.
+ *  The baked vertices are already in world space, so the
+ *  model matrix of every object in the buffer is identity.
+ ***********************************************************/
+void StaticBatchManager::BeginDraw() const
+{
+    glBindVertexArray(m_vao);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, OBJECT_BINDING, m_objectBuffer);
+    m_pShaderManager->setBoolValue(g_UseObjectBufferName, true);
+    m_pShaderManager->setBoolValue(g_QuantizedVerticesName, false);
+}
+
+/***********************************************************
+ *  DrawBucket()
+ *
+ *  This method draws the batches of one bucket in all the
+ *  visible cells with a single multi-draw call. The shader
+ *  state for the bucket must already be set.
+ ***********************************************************/
+void StaticBatchManager::DrawBucket(GLuint bucket)
+{
+    std::vector<GLsizei> counts;
+    std::vector<const void*> offsets;
+    std::vector<GLint> baseVertices;
+    for (GLuint cell : m_visibleCells)
+    {
+        const CELL& cellData = m_cells[cell];
+        for (const BATCH& batch : cellData.batches)
+        {
+            if (batch.bucket == bucket)
+            {
+                counts.push_back(static_cast<GLsizei>(batch.indexCount));
+                offsets.push_back(IndexRange{ batch.firstIndex, batch.indexCount }.Offset());
+                baseVertices.push_back(static_cast<GLint>(cellData.firstVertex));
+            }
+        }
+    }
+
+    if (counts.empty())
+    {
+        return;
+    }
+
+    glMultiDrawElementsBaseVertex(GL_TRIANGLES, counts.data(), GL_UNSIGNED_INT, offsets.data(),
+        static_cast<GLsizei>(counts.size()), baseVertices.data());
+    m_stats.drawCalls++;
+}
+
+/***********************************************************
+ *  EndDraw()
+ *
+ *  This method restores the state used for drawing one
+ *  shape at a time.
+ ***********************************************************/
+void StaticBatchManager::EndDraw() const
+{
+    m_pShaderManager->setBoolValue(g_UseObjectBufferName, false);
+    glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  FindBucket()
+ *
+ *  This method returns the bucket of the shader state of an
+ *  object, adding one for a new state. Objects with a solid
+ *  color share one bucket per material and culling mode like
+ *  the GPU culling buckets, the color is read per object.
+ ***********************************************************/
+GLuint StaticBatchManager::FindBucket(const SceneObject& sceneObject)
+{
+    bool bSolidColor = sceneObject.color != glm::vec4(1.0f);
+    bool bCullBackFaces = m_pShapeMeshes->CanCullBackFaces(sceneObject.shapeType, sceneObject.submesh);
+    std::string bucketKey = std::string(bSolidColor ? "color|" : "texture|") + (bCullBackFaces ? "cull|" : "both|") +
+        sceneObject.textureTag + "|" + sceneObject.materialTag;
+
+    auto bucket = m_bucketIndices.find(bucketKey);
+    if (bucket == m_bucketIndices.end())
+    {
+        bucket = m_bucketIndices.emplace(bucketKey, static_cast<GLuint>(m_bucketStates.size())).first;
+        m_bucketStates.push_back(sceneObject);
+        m_stats.bucketCount = static_cast<GLuint>(m_bucketStates.size());
+    }
+    return bucket->second;
+}
+
+/***********************************************************
+ *  FindCell()
+ *
+ *  This method returns the cell of the grid that holds the
+ *  origin of an object, adding an empty one for a new cell.
+ *  A new cell has no room yet and is placed when baked.
+ ***********************************************************/
+GLuint StaticBatchManager::FindCell(const SceneObject& sceneObject)
+{
+    glm::vec3 origin = glm::vec3(sceneObject.model[3]) / m_cellSize;
+    CELL_KEY key(static_cast<int>(std::floor(origin.x)),
+        static_cast<int>(std::floor(origin.y)),
+        static_cast<int>(std::floor(origin.z)));
+
+    auto cell = m_cellIndices.find(key);
+    if (cell == m_cellIndices.end())
+    {
+        cell = m_cellIndices.emplace(key, static_cast<GLuint>(m_cells.size())).first;
+        CELL cellData = {};
+        cellData.bDirty = true;
+        m_cells.push_back(cellData);
+        m_stats.cellCount = static_cast<GLuint>(m_cells.size());
+    }
+    return cell->second;
+}
+
+/***********************************************************
+ *  BakeCell()
+ *
+ *  This method transforms the vertices of every object in a
+ *  cell into world space, grouped by bucket. Only the vertices
+ *  an object's indices use are copied. The normals are kept
+ *  as the meshes hold them, as the vertex shader does not
+ *  turn them with the model matrix either.
+ ***********************************************************/
+void StaticBatchManager::BakeCell(GLuint cell, CELL_GEOMETRY& geometry) const
+{
+    std::vector<GLuint> objects = m_cells[cell].objects;
+    std::stable_sort(objects.begin(), objects.end(), [this](GLuint a, GLuint b)
+        {
+            return m_objectBuckets[a] < m_objectBuckets[b];
+        });
+
+    std::vector<GLuint> remap;
+    for (GLuint object : objects)
+    {
+        const MeshData* pMeshData = nullptr;
+        IndexRange range;
+        GLint baseVertex;
+        if (!FindObjectMesh(*m_pShapeMeshes, m_objects[object], pMeshData, range, baseVertex))
+        {
+            continue;
+        }
+
+        GLuint bucket = m_objectBuckets[object];
+        if (geometry.batches.empty() || geometry.batches.back().bucket != bucket)
+        {
+            geometry.batches.push_back({ bucket, static_cast<GLuint>(geometry.indices.size()), 0 });
+        }
+
+        const glm::mat4& model = m_objects[object].model;
+        remap.assign(pMeshData->VertexCount(), NO_VERTEX);
+        for (GLuint i = 0; i < range.indexCount; i++)
+        {
+            GLuint source = static_cast<GLuint>(baseVertex + static_cast<GLint>(pMeshData->indices[range.firstIndex + i]));
+            if (remap[source] == NO_VERTEX)
+            {
+                remap[source] = static_cast<GLuint>(geometry.objectIndices.size());
+
+                const GLfloat* vertex = &pMeshData->vertices[source * MeshData::FloatsPerVertex];
+                glm::vec3 position = glm::vec3(model * glm::vec4(vertex[0], vertex[1], vertex[2], 1.0f));
+                geometry.vertices.insert(geometry.vertices.end(), { position.x, position.y, position.z });
+                geometry.vertices.insert(geometry.vertices.end(), vertex + 3, vertex + MeshData::FloatsPerVertex);
+                geometry.objectIndices.push_back(object);
+            }
+            geometry.indices.push_back(remap[source]);
+        }
+        geometry.batches.back().indexCount += range.indexCount;
+    }
+
+    // the bounding sphere around the center of the box of the baked vertices
+    glm::vec3 boundsMin(FLT_MAX);
+    glm::vec3 boundsMax(-FLT_MAX);
+    for (size_t i = 0; i < geometry.vertices.size(); i += MeshData::FloatsPerVertex)
+    {
+        glm::vec3 position(geometry.vertices[i], geometry.vertices[i + 1], geometry.vertices[i + 2]);
+        boundsMin = glm::min(boundsMin, position);
+        boundsMax = glm::max(boundsMax, position);
+    }
+    glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+    float radius = 0.0f;
+    for (size_t i = 0; i < geometry.vertices.size(); i += MeshData::FloatsPerVertex)
+    {
+        glm::vec3 position(geometry.vertices[i], geometry.vertices[i + 1], geometry.vertices[i + 2]);
+        radius = std::max(radius, glm::length(position - center));
+    }
+    geometry.bounds = geometry.vertices.empty() ? glm::vec4(0.0f) : glm::vec4(center, radius);
+}
+
+/***********************************************************
+ *  UploadCell()
+ *
+ *  This method writes a baked cell into its room in the
+ *  buffers, which must hold it, and points its batches at
+ *  the indices written.
+ ***********************************************************/
+void StaticBatchManager::UploadCell(GLuint cell, const CELL_GEOMETRY& geometry)
+{
+    CELL& cellData = m_cells[cell];
+    GLuint vertexCount = static_cast<GLuint>(geometry.objectIndices.size());
+    GLuint indexCount = static_cast<GLuint>(geometry.indices.size());
+    GLuint oldIndexCount = 0;
+    for (const BATCH& batch : cellData.batches)
+    {
+        oldIndexCount += batch.indexCount;
+    }
+
+    const GLsizeiptr vertexBytes = MeshData::FloatsPerVertex * sizeof(GLfloat);
+    if (vertexCount > 0)
+    {
+        glNamedBufferSubData(m_vertexBuffer, cellData.firstVertex * vertexBytes, vertexCount * vertexBytes, geometry.vertices.data());
+        glNamedBufferSubData(m_objectIndexBuffer, cellData.firstVertex * sizeof(GLuint), vertexCount * sizeof(GLuint), geometry.objectIndices.data());
+    }
+    if (indexCount > 0)
+    {
+        glNamedBufferSubData(m_indexBuffer, cellData.firstIndex * sizeof(GLuint), indexCount * sizeof(GLuint), geometry.indices.data());
+    }
+
+    cellData.batches = geometry.batches;
+    for (BATCH& batch : cellData.batches)
+    {
+        batch.firstIndex += cellData.firstIndex;
+    }
+    cellData.bounds = geometry.bounds;
+    m_stats.vertexCount = m_stats.vertexCount - cellData.vertexCount + vertexCount;
+    m_stats.indexCount = m_stats.indexCount - oldIndexCount + indexCount;
+    cellData.vertexCount = vertexCount;
+    cellData.bDirty = false;
+}
+
+/***********************************************************
+ *  UploadObject()
+ *
+ *  This method writes the color of an object into the object
+ *  buffer. Its vertices are baked in world space, so its
+ *  model matrix there is identity.
+ ***********************************************************/
+void StaticBatchManager::UploadObject(GLuint object) const
+{
+    const SceneObject& sceneObject = m_objects[object];
+    CullingManager::OBJECT_DATA data = {};
+    data.model = glm::mat4(1.0f);
+    data.color = sceneObject.color;
+    data.bounds = glm::vec4(glm::vec3(sceneObject.model[3]), 0.0f);
+    data.lodCount = 1;
+    glNamedBufferSubData(m_objectBuffer, object * sizeof(CullingManager::OBJECT_DATA), sizeof(data), &data);
+}
+
+/***********************************************************
+ *  RebakeAll()
+ *
+ *  This method bakes every cell, lays the cells out one after
+ *  another with room to grow, and uploads them into new
+ *  buffers. The buffers keep spare room at the end for the
+ *  cells that outgrow their own.
+ ***********************************************************/
+void StaticBatchManager::RebakeAll()
+{
+    std::vector<CELL_GEOMETRY> geometries(m_cells.size());
+    m_vertexEnd = 0;
+    m_indexEnd = 0;
+    for (GLuint cell = 0; cell < m_cells.size(); cell++)
+    {
+        BakeCell(cell, geometries[cell]);
+
+        CELL& cellData = m_cells[cell];
+        cellData.firstVertex = m_vertexEnd;
+        cellData.vertexCapacity = WithGrowth(static_cast<GLuint>(geometries[cell].objectIndices.size()));
+        cellData.vertexCount = 0;
+        cellData.firstIndex = m_indexEnd;
+        cellData.indexCapacity = WithGrowth(static_cast<GLuint>(geometries[cell].indices.size()));
+        cellData.batches.clear();
+        m_vertexEnd += cellData.vertexCapacity;
+        m_indexEnd += cellData.indexCapacity;
+    }
+    m_stats.vertexCount = 0;
+    m_stats.indexCount = 0;
+
+    // the old buffers are dropped, the object buffer is kept
+    if (m_vertexBuffer != 0)
+    {
+        GLuint buffers[3] = { m_vertexBuffer, m_objectIndexBuffer, m_indexBuffer };
+        glDeleteBuffers(3, buffers);
+    }
+    m_vertexCapacity = std::max(WithGrowth(m_vertexEnd), 1u);
+    m_indexCapacity = std::max(WithGrowth(m_indexEnd), 1u);
+
+    const GLsizeiptr vertexBytes = MeshData::FloatsPerVertex * sizeof(GLfloat);
+    GLuint buffers[3];
+    glCreateBuffers(3, buffers);
+    m_vertexBuffer = buffers[0];
+    m_objectIndexBuffer = buffers[1];
+    m_indexBuffer = buffers[2];
+    glNamedBufferData(m_vertexBuffer, m_vertexCapacity * vertexBytes, nullptr, GL_DYNAMIC_DRAW);
+    glNamedBufferData(m_objectIndexBuffer, m_vertexCapacity * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+    glNamedBufferData(m_indexBuffer, m_indexCapacity * sizeof(GLuint), nullptr, GL_DYNAMIC_DRAW);
+
+    // the object index of each vertex is read per vertex, not per instance
+    if (m_vao == 0)
+    {
+        m_vao = MeshData::Layout::CreateVertexArray();
+        glVertexArrayBindingDivisor(m_vao, OBJECT_INDEX_BINDING, 0);
+        glVertexArrayAttribIFormat(m_vao, OBJECT_INDEX_ATTRIBUTE, 1, GL_UNSIGNED_INT, 0);
+        glVertexArrayAttribBinding(m_vao, OBJECT_INDEX_ATTRIBUTE, OBJECT_INDEX_BINDING);
+        glEnableVertexArrayAttrib(m_vao, OBJECT_INDEX_ATTRIBUTE);
+    }
+    MeshData::Layout::SetBuffers(m_vao, m_vertexBuffer, m_indexBuffer);
+    glVertexArrayVertexBuffer(m_vao, OBJECT_INDEX_BINDING, m_objectIndexBuffer, 0, sizeof(GLuint));
+
+    for (GLuint cell = 0; cell < m_cells.size(); cell++)
+    {
+        UploadCell(cell, geometries[cell]);
+    }
+    m_stats.objectCount = static_cast<GLuint>(m_objects.size());
+}
+
+/***********************************************************
+ *  RebakeDirtyCells()
+ *
+ *  This method bakes the edited cells again. A cell that
+ *  still fits its room is written in place, one that grew
+ *  past it moves to the spare room at the end of the
+ *  buffers. Once that is used up everything is baked anew,
+ *  which also reclaims the room the moved cells left.
+ ***********************************************************/
+void StaticBatchManager::RebakeDirtyCells()
+{
+    for (GLuint cell = 0; cell < m_cells.size(); cell++)
+    {
+        CELL& cellData = m_cells[cell];
+        if (!cellData.bDirty)
+        {
+            continue;
+        }
+
+        CELL_GEOMETRY geometry;
+        BakeCell(cell, geometry);
+        GLuint vertexCount = static_cast<GLuint>(geometry.objectIndices.size());
+        GLuint indexCount = static_cast<GLuint>(geometry.indices.size());
+        if (vertexCount > cellData.vertexCapacity || indexCount > cellData.indexCapacity)
+        {
+            GLuint vertexCapacity = WithGrowth(vertexCount);
+            GLuint indexCapacity = WithGrowth(indexCount);
+            if (m_vertexEnd + vertexCapacity > m_vertexCapacity || m_indexEnd + indexCapacity > m_indexCapacity)
+            {
+                RebakeAll();
+                m_stats.rebakedCells += static_cast<GLuint>(m_cells.size());
+                return;
+            }
+
+            cellData.firstVertex = m_vertexEnd;
+            cellData.vertexCapacity = vertexCapacity;
+            cellData.firstIndex = m_indexEnd;
+            cellData.indexCapacity = indexCapacity;
+            m_vertexEnd += vertexCapacity;
+            m_indexEnd += indexCapacity;
+        }
+
+        UploadCell(cell, geometry);
+        m_stats.rebakedCells++;
+    }
+}
+
+/***********************************************************
+ *  DestroyBuffers()
+ *
+ *  This method frees the baked buffers and the object buffer.
+ ***********************************************************/
+void StaticBatchManager::DestroyBuffers()
+{
+    GLuint buffers[4] = { m_vertexBuffer, m_objectIndexBuffer, m_indexBuffer, m_objectBuffer };
+    for (GLuint buffer : buffers)
+    {
+        if (buffer != 0)
+        {
+            glDeleteBuffers(1, &buffer);
+        }
+    }
+    if (m_vao != 0)
+    {
+        glDeleteVertexArrays(1, &m_vao);
+    }
+
+    m_vertexBuffer = m_objectIndexBuffer = m_indexBuffer = m_objectBuffer = 0;
+    m_vao = 0;
+    m_vertexCapacity = m_indexCapacity = 0;
+    m_vertexEnd = m_indexEnd = 0;
+}
@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+// StaticBatchManager.h
+// ============
+// Baking of static scene objects into merged world-space buffers
+//
+//  Objects that never move after PrepareScene() are transformed once on the
+//  CPU and merged per spatial cell and shader state bucket. A frame of static
+//  content then takes one multi-draw call per bucket over the visible cells,
+//  with no model matrix uploads, and an edited object only rebakes the cells
+//  it left and entered.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef STATICBATCHMANAGER_H
+#define STATICBATCHMANAGER_H
+#pragma once
+
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "ShapeGenerator.h"
+
+class ShaderManager; // Forward Declaration
+class ShapeMeshes; // Forward Declaration
+
+class StaticBatchManager {
+public:
+    // Size of the baked scene and the work of the last frame
+    struct BAKE_STATS {
+        GLuint objectCount;     // Baked objects
+        GLuint cellCount;
+        GLuint bucketCount;
+        GLuint vertexCount;     // Baked vertices in use, without the spare room of the cells
+        GLuint indexCount;
+        GLuint rebakedCells;    // Cells baked again since SetObjects()
+        GLuint visibleCells;    // Cells that passed the frustum test last frame
+        GLuint drawCalls;       // Multi-draw calls of the last frame
+    };
+
+    StaticBatchManager(std::shared_ptr<ShaderManager> pShaderManager, std::shared_ptr<ShapeMeshes> pShapeMeshes); // Constructor
+    ~StaticBatchManager(); // Destructor
+
+    // Bake the objects into cells of cellSize world units, the objects that cannot
+    // be baked, without a mesh or with too many vertices, are returned to be drawn one at a time
+    std::vector<SceneObject> SetObjects(const std::vector<SceneObject>& objects, float cellSize = 8.0f);
+    bool IsReady() const { return !m_cells.empty(); }
+
+    // Replace a baked object, in the order SetObjects() baked them; its old and
+    // new cells are baked again before the next frame is culled
+    bool UpdateObject(GLuint object, const SceneObject& sceneObject);
+    GLuint GetObjectCount() const { return static_cast<GLuint>(m_objects.size()); }
+    const SceneObject& GetObject(GLuint object) const { return m_objects[object]; }
+
+    // Shader state of the buckets, one multi-draw call each
+    GLuint GetBucketCount() const { return static_cast<GLuint>(m_bucketStates.size()); }
+    const SceneObject& GetBucketState(GLuint bucket) const { return m_bucketStates[bucket]; }
+
+    void CullCells(const glm::mat4& view, const glm::mat4& projection);  // Rebake the edited cells and pick the visible ones
+    void BeginDraw() const;     // Bind the baked buffers
+    void DrawBucket(GLuint bucket);     // Draw the visible cells of one bucket with one multi-draw call
+    void EndDraw() const;       // Restore the regular per-object drawing state
+
+    const BAKE_STATS& GetStats() const { return m_stats; }
+
+private:
+    // The indices of one bucket in a cell, drawn together
+    struct BATCH {
+        GLuint bucket;
+        GLuint firstIndex;      // First index of the batch in the index buffer
+        GLuint indexCount;
+    };
+
+    // The baked objects of one cell of the grid and its room in the buffers
+    struct CELL {
+        std::vector<GLuint> objects;    // Baked objects whose origin lies in the cell
+        std::vector<BATCH> batches;     // One per bucket, in bucket order
+        glm::vec4 bounds;               // World-space bounding sphere of the baked vertices
+        GLuint firstVertex;             // Room of the cell in the vertex buffers, its indices are relative to it
+        GLuint vertexCapacity;
+        GLuint vertexCount;             // Baked vertices of the cell
+        GLuint firstIndex;              // Room of the cell in the index buffer
+        GLuint indexCapacity;
+        bool bDirty;                    // Baked again before the next frame is culled
+    };
+
+    // The baked vertices and indices of a cell before they are uploaded
+    struct CELL_GEOMETRY {
+        std::vector<GLfloat> vertices;      // Interleaved world-space vertices in the MeshData layout
+        std::vector<GLuint> objectIndices;  // Object of each vertex, read as inObjectIndex
+        std::vector<GLuint> indices;        // Relative to the first vertex of the cell
+        std::vector<BATCH> batches;         // First indices relative to the first index of the cell
+        glm::vec4 bounds;
+    };
+
+    typedef std::tuple<int, int, int> CELL_KEY;
+
+    std::shared_ptr<ShaderManager> m_pShaderManager;  // Smart Pointer to the ShaderManager Object
+    std::shared_ptr<ShapeMeshes> m_pShapeMeshes;      // Smart Pointer to the ShapeMeshes Object
+
+    float m_cellSize;
+    std::vector<SceneObject> m_objects;         // Baked objects
+    std::vector<GLuint> m_objectBuckets;        // Bucket of each object
+    std::vector<GLuint> m_objectCells;          // Cell of each object
+    std::vector<CELL> m_cells;
+    std::map<CELL_KEY, GLuint> m_cellIndices;   // Cell of each grid coordinate
+    std::vector<SceneObject> m_bucketStates;    // Shader state of each bucket
+    std::map<std::string, GLuint> m_bucketIndices;  // Bucket of each shader state key
+    std::vector<GLuint> m_visibleCells;         // Cells picked by the last CullCells()
+
+    GLuint m_vao;
+    GLuint m_vertexBuffer;          // Interleaved world-space vertices
+    GLuint m_objectIndexBuffer;     // Object of each vertex
+    GLuint m_indexBuffer;
+    GLuint m_objectBuffer;          // CullingManager::OBJECT_DATA per object, read by the vertex shader
+    GLuint m_vertexCapacity;        // Vertices the vertex buffers hold
+    GLuint m_indexCapacity;         // Indices the index buffer holds
+    GLuint m_vertexEnd;             // First vertex after the room of the last cell
+    GLuint m_indexEnd;              // First index after the room of the last cell
+
+    BAKE_STATS m_stats;
+
+    GLuint FindBucket(const SceneObject& sceneObject);
+    GLuint FindCell(const SceneObject& sceneObject);
+    void BakeCell(GLuint cell, CELL_GEOMETRY& geometry) const;
+    void UploadCell(GLuint cell, const CELL_GEOMETRY& geometry);
+    void UploadObject(GLuint object) const;
+    void RebakeAll();
+    void RebakeDirtyCells();
+    void DestroyBuffers();
+};
+#endif // STATICBATCHMANAGER_H
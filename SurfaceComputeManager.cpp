@@ -0,0 +1,432 @@
+///////////////////////////////////////////////////////////////////////////////
+// SurfaceComputeManager.cpp
+// ============
+// Generation of parametric primitives in the geometry pool by a compute shader
+//
+//  Spheres, tori and capped cylinders are pure functions of a few sizes and
+//  a grid resolution. Their pool ranges are reserved up front and written
+//  on the GPU, so even huge tessellations cost no CPU time or upload, and a
+//  surface can be written again at another resolution while running.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SurfaceComputeManager.h"
+#include "ShaderManager.h"
+#include "GeometryPool.h"
+#include "ParametricSurface.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// declaration of the global variables and defines
+namespace
+{
+    const GLuint SURFACE_GROUP_SIZE = 64;       // local_size_x of the surface shader
+    const GLuint MAX_GROUPS_X = 65535;          // guaranteed GL_MAX_COMPUTE_WORK_GROUP_COUNT in x
+    const float VERIFY_TOLERANCE = 1e-4f;       // largest difference from the CPU generator that passes
+
+    // shader storage binding points shared with the surface shader
+    const GLuint VERTEX_BINDING = 0;
+    const GLuint INDEX_BINDING = 1;
+
+    // grid types of the surface shader
+    const GLuint SPHERE_GRID = 0;
+    const GLuint TORUS_GRID = 1;
+    const GLuint CYLINDER_SIDE_GRID = 2;
+    const GLuint CYLINDER_CAP_GRID = 3;
+
+    GLuint GroupCount(GLuint count, GLuint groupSize)
+    {
+        return (count + groupSize - 1) / groupSize;
+    }
+
+    const char* GetSurfaceName(SurfaceComputeManager::SURFACE_TYPE type)
+    {
+        switch (type)
+        {
+        case SurfaceComputeManager::SURFACE_TYPE::Sphere: return "sphere";
+        case SurfaceComputeManager::SURFACE_TYPE::Torus: return "torus";
+        default: return "cylinder";
+        }
+    }
+
+    // the grids of the CPU generators, so both sides agree on the layout
+    SurfaceGrid GetSurfaceGrid(const SurfaceComputeManager::SURFACE& surface)
+    {
+        switch (surface.type)
+        {
+        case SurfaceComputeManager::SURFACE_TYPE::Sphere: return SphereSurface::Grid(surface.rows, surface.columns);
+        case SurfaceComputeManager::SURFACE_TYPE::Torus: return TorusSurface::Grid(surface.columns, surface.rows);
+        default: return CylinderSurface::Grid(surface.columns, surface.rows);
+        }
+    }
+
+    // bounding sphere of the surface at any resolution
+    glm::vec4 GetSurfaceBounds(const SurfaceComputeManager::SURFACE& surface)
+    {
+        switch (surface.type)
+        {
+        case SurfaceComputeManager::SURFACE_TYPE::Sphere:
+            return glm::vec4(0.0f, 0.0f, 0.0f, surface.size.x);
+        case SurfaceComputeManager::SURFACE_TYPE::Torus:
+            return glm::vec4(0.0f, 0.0f, 0.0f, surface.size.x + surface.size.y);
+        default:
+            return glm::vec4(0.0f, 0.5f * surface.size.y, 0.0f,
+                glm::length(glm::vec2(surface.size.x, 0.5f * surface.size.y)));
+        }
+    }
+
+    // the mesh the CPU generator makes of the surface
+    void GenerateCpuSurface(const SurfaceComputeManager::SURFACE& surface, MeshData& meshData)
+    {
+        switch (surface.type)
+        {
+        case SurfaceComputeManager::SURFACE_TYPE::Sphere:
+            GenerateParametricSurface(SphereSurface{ surface.size.x }, GetSurfaceGrid(surface), meshData);
+            break;
+        case SurfaceComputeManager::SURFACE_TYPE::Torus:
+            GenerateParametricSurface(TorusSurface{ surface.size.x, surface.size.y }, GetSurfaceGrid(surface), meshData);
+            break;
+        default:
+            GenerateCylinderSurface(CylinderSurface{ surface.size.x, surface.size.y }, surface.columns, surface.rows, meshData);
+            break;
+        }
+    }
+}
+
+/***********************************************************
+ *  SurfaceComputeManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SurfaceComputeManager::SurfaceComputeManager(std::shared_ptr<ShaderManager> pShaderManager, std::shared_ptr<GeometryPool> pGeometryPool)
+    : m_pShaderManager(std::move(pShaderManager)),
+    m_pGeometryPool(std::move(pGeometryPool)),
+    m_bReady(false),
+    m_surfaceProgram(0)
+{}
+
+/***********************************************************
+ *  ~SurfaceComputeManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SurfaceComputeManager::~SurfaceComputeManager()
+{
+    if (m_surfaceProgram != 0) glDeleteProgram(m_surfaceProgram);
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method loads the surface compute shader. When it
+ *  returns false no surface should be reserved, the meshes
+ *  are added to the pool from the CPU as before.
+ ***********************************************************/
+bool SurfaceComputeManager::Initialize(const char* surfaceShaderPath)
+{
+    m_bReady = false;
+
+    if (GLEW_VERSION_4_3 == 0 || !HasDirectStateAccess())
+    {
+        std::cout << "INFO: OpenGL 4.3 or direct state access is not available, surfaces are generated on the CPU" << std::endl;
+        return false;
+    }
+
+    m_surfaceProgram = m_pShaderManager->LoadComputeShader(surfaceShaderPath);
+    if (m_surfaceProgram == 0)
+    {
+        std::cerr << "Failed to load the surface compute shader" << std::endl;
+        return false;
+    }
+
+    m_bReady = true;
+    return true;
+}
+
+/***********************************************************
+ *  GetVertexCount()
+ *
+ *  A capped cylinder has a one ring grid for each cap in
+ *  front of its side grid.
+ ***********************************************************/
+GLuint SurfaceComputeManager::GetVertexCount(const SURFACE& surface)
+{
+    GLuint vertexCount = GetSurfaceGrid(surface).VertexCount();
+    if (surface.type == SURFACE_TYPE::Cylinder)
+    {
+        vertexCount += 2 * CapSurface::Grid(surface.columns).VertexCount();
+    }
+    return vertexCount;
+}
+
+GLuint SurfaceComputeManager::GetIndexCount(const SURFACE& surface)
+{
+    GLuint indexCount = GetSurfaceGrid(surface).IndexCount();
+    if (surface.type == SURFACE_TYPE::Cylinder)
+    {
+        indexCount += 2 * CapSurface::Grid(surface.columns).IndexCount();
+    }
+    return indexCount;
+}
+
+/***********************************************************
+ *  ReserveSurface()
+ *
+ *  This method makes room in the geometry pool for the
+ *  surface at its grid resolution. The range keeps that
+ *  size, so later grids may be coarser but not finer.
+ ***********************************************************/
+GLuint SurfaceComputeManager::ReserveSurface(const SURFACE& surface)
+{
+    RESERVED_SURFACE reserved;
+    reserved.surface = surface;
+    reserved.vertexCapacity = GetVertexCount(surface);
+    reserved.indexCapacity = GetIndexCount(surface);
+    reserved.bWritten = false;
+
+    GLuint meshID = m_pGeometryPool->ReserveMesh(reserved.vertexCapacity, reserved.indexCapacity, GetSurfaceBounds(surface));
+    m_surfaces[meshID] = reserved;
+    return meshID;
+}
+
+/***********************************************************
+ *  GenerateSurface()
+ *
+ *  This method writes the surface into its pool range with
+ *  one dispatch per grid. The draw commands keep the index
+ *  count of the whole range, so the indices a coarser grid
+ *  leaves over are written as empty triangles instead.
+ ***********************************************************/
+bool SurfaceComputeManager::GenerateSurface(GLuint meshID, GLuint columns, GLuint rows)
+{
+    auto entry = m_surfaces.find(meshID);
+    if (!m_bReady || entry == m_surfaces.end())
+    {
+        return false;
+    }
+
+    RESERVED_SURFACE& reserved = entry->second;
+    SURFACE surface = reserved.surface;
+    surface.columns = std::max(columns, 1u);
+    surface.rows = std::max(rows, 1u);
+    GLuint indexCount = GetIndexCount(surface);
+    if (GetVertexCount(surface) > reserved.vertexCapacity || indexCount > reserved.indexCapacity)
+    {
+        std::cerr << "Failed to generate the " << GetSurfaceName(surface.type) << " surface, a "
+            << surface.columns << " x " << surface.rows << " grid does not fit its pool range" << std::endl;
+        return false;
+    }
+
+    glUseProgram(m_surfaceProgram);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VERTEX_BINDING, m_pGeometryPool->GetVertexBuffer());
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INDEX_BINDING, m_pGeometryPool->GetIndexBuffer());
+
+    const GeometryPool::MeshRange& range = m_pGeometryPool->GetMeshRange(meshID);
+    GLuint firstVertex = static_cast<GLuint>(range.baseVertex);
+    GLuint paddingQuads = (reserved.indexCapacity - indexCount) / 6;
+    SurfaceGrid grid = GetSurfaceGrid(surface);
+    glm::vec4 angleRange(grid.uAngleStart, grid.uAngleEnd, grid.vAngleStart, grid.vAngleEnd);
+
+    if (surface.type == SURFACE_TYPE::Sphere)
+    {
+        DispatchGrid(SPHERE_GRID, glm::vec3(surface.size, 0.0f), grid.columns, grid.rows, angleRange,
+            firstVertex, range.firstIndex, 0, paddingQuads);
+    }
+    else if (surface.type == SURFACE_TYPE::Torus)
+    {
+        DispatchGrid(TORUS_GRID, glm::vec3(surface.size, 0.0f), grid.columns, grid.rows, angleRange,
+            firstVertex, range.firstIndex, 0, paddingQuads);
+    }
+    else
+    {
+        // bottom cap, top cap and side, as GenerateCylinderSurface() lays them out
+        SurfaceGrid cap = CapSurface::Grid(surface.columns);
+        glm::vec4 capAngleRange(cap.uAngleStart, cap.uAngleEnd, cap.vAngleStart, cap.vAngleEnd);
+        DispatchGrid(CYLINDER_CAP_GRID, glm::vec3(surface.size.x, 0.0f, -1.0f), cap.columns, cap.rows, capAngleRange,
+            firstVertex, range.firstIndex, 0, 0);
+        DispatchGrid(CYLINDER_CAP_GRID, glm::vec3(surface.size, 1.0f), cap.columns, cap.rows, capAngleRange,
+            firstVertex + cap.VertexCount(), range.firstIndex + cap.IndexCount(), cap.VertexCount(), 0);
+        DispatchGrid(CYLINDER_SIDE_GRID, glm::vec3(surface.size, 0.0f), grid.columns, grid.rows, angleRange,
+            firstVertex + 2 * cap.VertexCount(), range.firstIndex + 2 * cap.IndexCount(), 2 * cap.VertexCount(), paddingQuads);
+    }
+
+    // the pool is drawn from and may be read back next
+    glMemoryBarrier(GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT | GL_ELEMENT_ARRAY_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, VERTEX_BINDING, 0);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, INDEX_BINDING, 0);
+
+    // back to the scene shader
+    m_pShaderManager->use();
+
+    reserved.surface = surface;
+    reserved.bWritten = true;
+    return true;
+}
+
+/***********************************************************
+ *  GenerateSurfaces()
+ *
+ *  This method writes every reserved surface and reports
+ *  the GPU time. Waiting for the timer is only done here,
+ *  once at load time.
+ ***********************************************************/
+void SurfaceComputeManager::GenerateSurfaces()
+{
+    if (!m_bReady || m_surfaces.empty())
+    {
+        return;
+    }
+
+    GLuint timer = 0;
+    glGenQueries(1, &timer);
+    glBeginQuery(GL_TIME_ELAPSED, timer);
+
+    GLuint vertexCount = 0;
+    GLuint surfaceCount = 0;
+    for (const auto& entry : m_surfaces)
+    {
+        const SURFACE& surface = entry.second.surface;
+        if (GenerateSurface(entry.first, surface.columns, surface.rows))
+        {
+            vertexCount += GetVertexCount(surface);
+            surfaceCount++;
+        }
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    GLuint64 nanoseconds = 0;
+    glGetQueryObjectui64v(timer, GL_QUERY_RESULT, &nanoseconds);
+    glDeleteQueries(1, &timer);
+
+    std::cout << "INFO: " << surfaceCount << " surfaces with " << vertexCount << " vertices generated on the GPU in "
+        << nanoseconds / 1.0e6 << " ms" << std::endl;
+}
+
+/***********************************************************
+ *  VerifySurface()
+ *
+ *  This method reads the written range back and compares it
+ *  with the CPU generator at the same grid. Positions are
+ *  compared relative to the bounding radius, the indices
+ *  must be the same and the padding must be empty.
+ ***********************************************************/
+bool SurfaceComputeManager::VerifySurface(GLuint meshID, VERIFY_REPORT* report)
+{
+    auto entry = m_surfaces.find(meshID);
+    if (!m_bReady || entry == m_surfaces.end() || !entry->second.bWritten)
+    {
+        return false;
+    }
+
+    const RESERVED_SURFACE& reserved = entry->second;
+    const GeometryPool::MeshRange& range = m_pGeometryPool->GetMeshRange(meshID);
+    const char* surfaceName = GetSurfaceName(reserved.surface.type);
+    const size_t vertexBytes = MeshData::FloatsPerVertex * sizeof(GLfloat);
+
+    MeshData cpuMesh;
+    GenerateCpuSurface(reserved.surface, cpuMesh);
+    cpuMesh.indices.resize(reserved.indexCapacity, 0);
+
+    std::vector<GLfloat> vertices(cpuMesh.vertices.size());
+    std::vector<GLuint> indices(cpuMesh.indices.size());
+    glGetNamedBufferSubData(m_pGeometryPool->GetVertexBuffer(), range.baseVertex * vertexBytes,
+        vertices.size() * sizeof(GLfloat), vertices.data());
+    glGetNamedBufferSubData(m_pGeometryPool->GetIndexBuffer(), range.firstIndex * sizeof(GLuint),
+        indices.size() * sizeof(GLuint), indices.data());
+
+    VERIFY_REPORT result = { cpuMesh.VertexCount(), 0.0f, 0.0f, 0.0f, 0 };
+    float radius = std::max(GetSurfaceBounds(reserved.surface).w, 1e-6f);
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        float error = std::fabs(vertices[i] - cpuMesh.vertices[i]);
+        size_t component = i % MeshData::FloatsPerVertex;
+        if (component < 3)
+        {
+            result.maxPositionError = std::max(result.maxPositionError, error / radius);
+        }
+        else if (component < 6)
+        {
+            result.maxNormalError = std::max(result.maxNormalError, error);
+        }
+        else
+        {
+            result.maxUVError = std::max(result.maxUVError, error);
+        }
+    }
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        result.indexMismatches += indices[i] != cpuMesh.indices[i] ? 1 : 0;
+    }
+    if (report)
+    {
+        *report = result;
+    }
+
+    std::cout << "INFO: GPU " << surfaceName << " surface, " << result.vertexCount << " vertices, largest difference from the CPU: position "
+        << result.maxPositionError << ", normal " << result.maxNormalError << ", uv " << result.maxUVError
+        << ", " << result.indexMismatches << " indices" << std::endl;
+
+    bool bMatch = result.maxPositionError <= VERIFY_TOLERANCE && result.maxNormalError <= VERIFY_TOLERANCE &&
+        result.maxUVError <= VERIFY_TOLERANCE && result.indexMismatches == 0;
+    if (!bMatch)
+    {
+        // keep drawing the surface correctly with the CPU mesh
+        std::cerr << "Failed to match the GPU " << surfaceName << " surface with the CPU generator, uploading the CPU mesh" << std::endl;
+        glNamedBufferSubData(m_pGeometryPool->GetVertexBuffer(), range.baseVertex * vertexBytes,
+            cpuMesh.vertices.size() * sizeof(GLfloat), cpuMesh.vertices.data());
+        glNamedBufferSubData(m_pGeometryPool->GetIndexBuffer(), range.firstIndex * sizeof(GLuint),
+            cpuMesh.indices.size() * sizeof(GLuint), cpuMesh.indices.data());
+    }
+    return bMatch;
+}
+
+/***********************************************************
+ *  VerifySurfaces()
+ ***********************************************************/
+bool SurfaceComputeManager::VerifySurfaces()
+{
+    bool bMatch = true;
+    for (const auto& entry : m_surfaces)
+    {
+        if (entry.second.bWritten)
+        {
+            bMatch = VerifySurface(entry.first) && bMatch;
+        }
+    }
+    return bMatch;
+}
+
+/***********************************************************
+ *  DispatchGrid()
+ *
+ *  This method runs one invocation per vertex or quad of
+ *  the grid, whichever is more. Grids with more groups than
+ *  fit in x are dispatched as rows of groups.
+ ***********************************************************/
+void SurfaceComputeManager::DispatchGrid(GLuint gridType,
+    const glm::vec3& size,
+    GLuint columns,
+    GLuint rows,
+    const glm::vec4& angleRange,
+    GLuint firstVertex,
+    GLuint firstIndex,
+    GLuint indexBase,
+    GLuint paddingQuads)
+{
+    glUniform1ui(glGetUniformLocation(m_surfaceProgram, "gridType"), gridType);
+    glUniform3f(glGetUniformLocation(m_surfaceProgram, "gridSize"), size.x, size.y, size.z);
+    glUniform2ui(glGetUniformLocation(m_surfaceProgram, "gridQuads"), columns, rows);
+    glUniform4f(glGetUniformLocation(m_surfaceProgram, "angleRange"), angleRange.x, angleRange.y, angleRange.z, angleRange.w);
+    glUniform1ui(glGetUniformLocation(m_surfaceProgram, "firstVertex"), firstVertex);
+    glUniform1ui(glGetUniformLocation(m_surfaceProgram, "firstIndex"), firstIndex);
+    glUniform1ui(glGetUniformLocation(m_surfaceProgram, "indexBase"), indexBase);
+    glUniform1ui(glGetUniformLocation(m_surfaceProgram, "paddingQuads"), paddingQuads);
+
+    GLuint invocations = std::max((columns + 1) * (rows + 1), columns * rows + paddingQuads);
+    GLuint groups = GroupCount(invocations, SURFACE_GROUP_SIZE);
+    GLuint groupsX = std::min(groups, MAX_GROUPS_X);
+    glDispatchCompute(groupsX, GroupCount(groups, groupsX), 1);
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+// SurfaceComputeManager.h
+// ============
+// Generation of parametric primitives in the geometry pool by a compute shader
+//
+//  Spheres, tori and capped cylinders are pure functions of a few sizes and
+//  a grid resolution. Their pool ranges are reserved up front and written
+//  on the GPU, so even huge tessellations cost no CPU time or upload, and a
+//  surface can be written again at another resolution while running.
+///////////////////////////////////////////////////////////////////////////////
+#ifndef SURFACECOMPUTEMANAGER_H
+#define SURFACECOMPUTEMANAGER_H
+#pragma once
+
+#include <map>
+#include <memory>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+class ShaderManager; // Forward Declaration
+class GeometryPool; // Forward Declaration
+
+class SurfaceComputeManager {
+public:
+    enum class SURFACE_TYPE {
+        Sphere,     // SphereSurface
+        Torus,      // TorusSurface
+        Cylinder    // GenerateCylinderSurface(), caps and side
+    };
+
+    // A parametric primitive with the sizes and grid of its CPU generator
+    struct SURFACE {
+        SURFACE_TYPE type;
+        glm::vec2 size;     // Sphere radius, torus main and tube radius, or cylinder radius and height
+        GLuint columns;     // Quads along u: sphere slices, torus main segments or cylinder slices
+        GLuint rows;        // Quads along v: sphere stacks, torus tube segments or cylinder stacks
+    };
+
+    // Largest differences between a generated surface and its CPU generator
+    struct VERIFY_REPORT {
+        GLuint vertexCount;
+        float maxPositionError;     // Relative to the bounding radius of the surface
+        float maxNormalError;
+        float maxUVError;
+        GLuint indexMismatches;
+    };
+
+    SurfaceComputeManager(std::shared_ptr<ShaderManager> pShaderManager, std::shared_ptr<GeometryPool> pGeometryPool); // Constructor
+    ~SurfaceComputeManager(); // Destructor
+
+    // Load the surface compute shader, returns false if the surfaces have to come from the CPU
+    bool Initialize(const char* surfaceShaderPath);
+    bool IsReady() const { return m_bReady; }
+
+    // Reserve a pool range for the surface at up to its grid resolution; call before the pool is uploaded
+    GLuint ReserveSurface(const SURFACE& surface);
+
+    // Write a reserved surface at a grid resolution that fits its range, the rest of its indices draw nothing
+    bool GenerateSurface(GLuint meshID, GLuint columns, GLuint rows);
+    void GenerateSurfaces();    // Write every reserved surface at its full resolution
+
+    // Read a written surface back and compare it with the CPU generator, on a mismatch
+    // the CPU mesh is uploaded over it; every reserved surface for VerifySurfaces()
+    bool VerifySurface(GLuint meshID, VERIFY_REPORT* report = nullptr);
+    bool VerifySurfaces();
+
+    static GLuint GetVertexCount(const SURFACE& surface);
+    static GLuint GetIndexCount(const SURFACE& surface);
+
+private:
+    // A reserved surface, its grid is the one last written
+    struct RESERVED_SURFACE {
+        SURFACE surface;
+        GLuint vertexCapacity;  // Vertices of the pool range
+        GLuint indexCapacity;   // Indices of the pool range
+        bool bWritten;
+    };
+
+    std::shared_ptr<ShaderManager> m_pShaderManager;  // Smart Pointer to the ShaderManager Object
+    std::shared_ptr<GeometryPool> m_pGeometryPool;    // Smart Pointer to the GeometryPool Object
+
+    bool m_bReady;
+    GLuint m_surfaceProgram;
+    std::map<GLuint, RESERVED_SURFACE> m_surfaces;  // Reserved surfaces by pool mesh ID
+
+    // write one grid of a surface, followed by paddingQuads empty quads
+    void DispatchGrid(GLuint gridType,
+        const glm::vec3& size,
+        GLuint columns,
+        GLuint rows,
+        const glm::vec4& angleRange,
+        GLuint firstVertex,
+        GLuint firstIndex,
+        GLuint indexBase,
+        GLuint paddingQuads);
+};
+#endif // SURFACECOMPUTEMANAGER_H
@@ -0,0 +1,18 @@
+///////////////////////////////////////////////////////////////////////////////
+// LodSelection.h
+// ============
+// level of detail thresholds shared by the culling pass and the immediate draws
+///////////////////////////////////////////////////////////////////////////////
+#ifndef LODSELECTION_H
+#define LODSELECTION_H
+
+#include <GL/glew.h>
+
+// an object switches to the next coarser level each time its projected
+// diameter halves below LOD_BASE_SIZE pixels, and only leaves a level
+// once it is LOD_HYSTERESIS levels past its bounds so it does not pop
+const float LOD_BASE_SIZE = 256.0f;
+const float LOD_HYSTERESIS = 0.25f;
+const GLuint NO_LOD = 0xFFFFFFFFu;      // no level picked yet, the first pick skips the hysteresis
+
+#endif // LODSELECTION_H
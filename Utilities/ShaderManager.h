@@ -18,6 +18,10 @@ public:
 	
 	GLuint LoadShaders(const char* vertex_file_path, const char* fragment_file_path);
 
+	// compile and link a standalone compute shader program,
+	// the active render program is left unchanged
+	GLuint LoadComputeShader(const char* compute_file_path);
+
 	// activate the shader
 	// ------------------------------------------------------------------------
 	inline void use() const
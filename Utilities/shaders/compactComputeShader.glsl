@@ -0,0 +1,49 @@
+#version 440 core
+layout (local_size_x = 64) in;
+
+// indirect draw command read by glMultiDrawElementsIndirectCount
+struct DrawCommand
+{
+   uint count;
+   uint instanceCount;
+   uint firstIndex;
+   int baseVertex;
+   uint baseInstance;
+};
+
+layout (std430, binding = 1) readonly buffer CommandBuffer
+{
+   DrawCommand commands[];
+};
+
+// bucket of each command (x) and the bucket's first command (y)
+layout (std430, binding = 3) readonly buffer CommandBucketBuffer
+{
+   uvec2 commandBuckets[];
+};
+
+layout (std430, binding = 4) writeonly buffer DrawCommandBuffer
+{
+   DrawCommand drawCommands[];
+};
+
+layout (std430, binding = 5) buffer DrawCountBuffer
+{
+   uint drawCounts[];
+};
+
+uniform uint commandCount;
+
+void main()
+{
+   uint commandIndex = gl_GlobalInvocationID.x;
+   if (commandIndex >= commandCount || commands[commandIndex].instanceCount == 0u)
+   {
+      return;
+   }
+
+   // pack the non-empty commands to the front of their bucket
+   uvec2 bucket = commandBuckets[commandIndex];
+   uint slot = atomicAdd(drawCounts[bucket.x], 1u);
+   drawCommands[bucket.y + slot] = commands[commandIndex];
+}
@@ -0,0 +1,200 @@
+#version 440 core
+layout (local_size_x = 64) in;
+
+// indirect draw command read by glMultiDrawElementsIndirect
+struct DrawCommand
+{
+   uint count;
+   uint instanceCount;
+   uint firstIndex;
+   int baseVertex;
+   uint baseInstance;
+};
+
+// per-object data shared with the vertex shader
+struct ObjectData
+{
+   mat4 model;
+   vec4 color;
+   vec4 bounds;        // world-space bounding sphere (xyz center, w radius)
+   uint commandIndex;  // draw command that renders this object's mesh at level 0
+   uint lodCount;      // levels of the mesh, their commands follow commandIndex
+   uint padding[2];
+};
+
+layout (std430, binding = 0) readonly buffer ObjectBuffer
+{
+   ObjectData objects[];
+};
+
+layout (std430, binding = 1) buffer CommandBuffer
+{
+   DrawCommand commands[];
+};
+
+layout (std430, binding = 2) writeonly buffer VisibleObjectBuffer
+{
+   uint visibleObjects[];
+};
+
+// number of objects removed by each test, read back for the frame stats
+layout (std430, binding = 6) buffer CullStatsBuffer
+{
+   uint frustumCulled;
+   uint occlusionCulled;
+   uint contributionCulled;
+   uint visibleCount;
+   uint drawnTriangles;
+   uint fullDetailTriangles;
+};
+
+// level each object was drawn with, kept across frames
+layout (std430, binding = 7) buffer ObjectLodBuffer
+{
+   uint objectLods[];
+};
+
+uniform uint objectCount;
+uniform vec4 frustumPlanes[6];
+
+// contribution culling drops objects whose projected diameter
+// is below minScreenSize pixels
+uniform float minScreenSize = 0.0;
+uniform float projectionScale;     // pixels per unit at distance 1 (perspective) or per unit (orthographic)
+uniform bool bPerspective = true;
+uniform vec3 cameraPosition;
+
+// level of detail, one level coarser each time the projected diameter
+// halves below lodBaseSize pixels; a level is only left once the object
+// is lodHysteresis levels past it, so it does not flip every frame
+uniform bool bUseLod = false;
+uniform float lodBaseSize = 256.0;
+uniform float lodHysteresis = 0.25;
+
+// optional occlusion test against the previous frame's depth pyramid
+uniform bool bUseDepthPyramid = false;
+uniform sampler2D depthPyramid;
+uniform vec2 depthPyramidSize;
+uniform float depthPyramidMaxLevel;
+uniform mat4 previousViewProjection;
+
+bool IsInsideFrustum(vec4 sphere)
+{
+   for (int i = 0; i < 6; i++)
+   {
+      if (dot(frustumPlanes[i].xyz, sphere.xyz) + frustumPlanes[i].w < -sphere.w)
+      {
+         return false;
+      }
+   }
+   return true;
+}
+
+// projected diameter of the sphere in pixels
+float ProjectedSize(vec4 sphere)
+{
+   float distance = 1.0;
+   if (bPerspective)
+   {
+      distance = length(sphere.xyz - cameraPosition);
+
+      // the camera is inside the sphere
+      if (distance <= sphere.w)
+      {
+         return 1e30;
+      }
+   }
+   return 2.0 * sphere.w * projectionScale / distance;
+}
+
+uint SelectLod(uint objectIndex, float projectedSize, uint lodCount)
+{
+   if (!bUseLod || lodCount <= 1u)
+   {
+      return 0u;
+   }
+
+   float lod = clamp(log2(lodBaseSize / max(projectedSize, 1e-3)), 0.0, float(lodCount - 1u));
+   uint level = objectLods[objectIndex];
+   if (level >= lodCount || lod < float(level) - lodHysteresis || lod > float(level) + 1.0 + lodHysteresis)
+   {
+      level = min(uint(lod), lodCount - 1u);
+      objectLods[objectIndex] = level;
+   }
+   return level;
+}
+
+bool IsOccluded(vec4 sphere)
+{
+   // project the corners of the sphere's bounding box with the matrices
+   // that produced the depth pyramid
+   vec3 minNDC = vec3(1.0);
+   vec3 maxNDC = vec3(-1.0);
+   for (int i = 0; i < 8; i++)
+   {
+      vec3 corner = sphere.xyz + sphere.w * vec3(
+         (i & 1) != 0 ? 1.0 : -1.0,
+         (i & 2) != 0 ? 1.0 : -1.0,
+         (i & 4) != 0 ? 1.0 : -1.0);
+      vec4 clip = previousViewProjection * vec4(corner, 1.0);
+
+      // anything reaching behind the camera is never treated as hidden
+      if (clip.w <= 0.0)
+      {
+         return false;
+      }
+      vec3 ndc = clip.xyz / clip.w;
+      minNDC = min(minNDC, ndc);
+      maxNDC = max(maxNDC, ndc);
+   }
+
+   vec2 uvMin = clamp(minNDC.xy * 0.5 + 0.5, 0.0, 1.0);
+   vec2 uvMax = clamp(maxNDC.xy * 0.5 + 0.5, 0.0, 1.0);
+   float nearestDepth = minNDC.z * 0.5 + 0.5;
+
+   // pick the pyramid level where the screen rectangle covers at most 2x2 texels
+   vec2 extent = (uvMax - uvMin) * depthPyramidSize;
+   float level = clamp(ceil(log2(max(max(extent.x, extent.y), 1.0))), 0.0, depthPyramidMaxLevel);
+
+   float farthestDepth = max(
+      max(textureLod(depthPyramid, vec2(uvMin.x, uvMin.y), level).r, textureLod(depthPyramid, vec2(uvMax.x, uvMin.y), level).r),
+      max(textureLod(depthPyramid, vec2(uvMin.x, uvMax.y), level).r, textureLod(depthPyramid, vec2(uvMax.x, uvMax.y), level).r));
+
+   return nearestDepth > farthestDepth;
+}
+
+void main()
+{
+   uint objectIndex = gl_GlobalInvocationID.x;
+   if (objectIndex >= objectCount)
+   {
+      return;
+   }
+
+   vec4 sphere = objects[objectIndex].bounds;
+   if (!IsInsideFrustum(sphere))
+   {
+      atomicAdd(frustumCulled, 1u);
+      return;
+   }
+   float projectedSize = ProjectedSize(sphere);
+   if (minScreenSize > 0.0 && projectedSize < minScreenSize)
+   {
+      atomicAdd(contributionCulled, 1u);
+      return;
+   }
+   if (bUseDepthPyramid && IsOccluded(sphere))
+   {
+      atomicAdd(occlusionCulled, 1u);
+      return;
+   }
+   atomicAdd(visibleCount, 1u);
+
+   // append the object to the instance list of the draw command of its level
+   uint firstCommand = objects[objectIndex].commandIndex;
+   uint commandIndex = firstCommand + SelectLod(objectIndex, projectedSize, objects[objectIndex].lodCount);
+   atomicAdd(drawnTriangles, commands[commandIndex].count / 3u);
+   atomicAdd(fullDetailTriangles, commands[firstCommand].count / 3u);
+   uint slot = atomicAdd(commands[commandIndex].instanceCount, 1u);
+   visibleObjects[commands[commandIndex].baseInstance + slot] = objectIndex;
+}
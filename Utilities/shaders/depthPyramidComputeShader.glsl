@@ -0,0 +1,43 @@
+#version 440 core
+layout (local_size_x = 8, local_size_y = 8) in;
+
+// level 0 is copied from the scene depth, every other level keeps
+// the farthest depth of the texels it covers in the level above
+uniform sampler2D sourceDepth;
+uniform int sourceLevel;
+uniform bool bCopyLevel = false;
+layout (r32f, binding = 0) writeonly uniform image2D destinationLevel;
+
+void main()
+{
+   ivec2 destination = ivec2(gl_GlobalInvocationID.xy);
+   ivec2 destinationSize = imageSize(destinationLevel);
+   if (any(greaterThanEqual(destination, destinationSize)))
+   {
+      return;
+   }
+
+   if (bCopyLevel)
+   {
+      imageStore(destinationLevel, destination, vec4(texelFetch(sourceDepth, destination, 0).r));
+      return;
+   }
+
+   ivec2 sourceSize = textureSize(sourceDepth, sourceLevel);
+   ivec2 source = destination * 2;
+   float farthest = 0.0;
+
+   // odd sized levels fold the extra row or column into the last texel
+   ivec2 span = ivec2(
+      (destination.x == destinationSize.x - 1 && (sourceSize.x & 1) != 0) ? 3 : 2,
+      (destination.y == destinationSize.y - 1 && (sourceSize.y & 1) != 0) ? 3 : 2);
+   for (int y = 0; y < span.y; y++)
+   {
+      for (int x = 0; x < span.x; x++)
+      {
+         ivec2 texel = min(source + ivec2(x, y), sourceSize - 1);
+         farthest = max(farthest, texelFetch(sourceDepth, texel, sourceLevel).r);
+      }
+   }
+   imageStore(destinationLevel, destination, vec4(farthest));
+}
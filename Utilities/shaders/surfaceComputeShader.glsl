@@ -0,0 +1,122 @@
+#version 440 core
+layout (local_size_x = 64) in;
+
+// the shared vertex and index buffers of the geometry pool, bound whole;
+// vertices are interleaved position (3), normal (3), texture coords (2)
+layout (std430, binding = 0) writeonly buffer VertexBuffer
+{
+   float vertices[];
+};
+
+layout (std430, binding = 1) writeonly buffer IndexBuffer
+{
+   uint indices[];
+};
+
+// grid types, the same as SurfaceComputeManager::GRID_TYPE
+const uint SPHERE_GRID = 0u;
+const uint TORUS_GRID = 1u;
+const uint CYLINDER_SIDE_GRID = 2u;
+const uint CYLINDER_CAP_GRID = 3u;
+
+uniform uint gridType;
+uniform vec3 gridSize;        // sphere: radius; torus: main and tube radius;
+                              // cylinder side: radius and height; cap: radius, height and facing
+uniform uvec2 gridQuads;      // quads along u and v
+uniform vec4 angleRange;      // angles at u = 0, u = 1, v = 0 and v = 1
+uniform uint firstVertex;     // first vertex of the grid in the vertex buffer
+uniform uint firstIndex;      // first index of the grid in the index buffer
+uniform uint indexBase;       // added to every index, the first vertex of the grid in its mesh
+uniform uint paddingQuads;    // quads of empty triangles written after the grid's own
+
+// the surfaces of ParametricSurface.h, evaluated the same way
+void EvaluateSurface(float u, float v, out vec3 position, out vec3 normal, out vec2 uv)
+{
+   float angleU = angleRange.x + (angleRange.y - angleRange.x) * u;
+   float angleV = angleRange.z + (angleRange.w - angleRange.z) * v;
+   float sinU = sin(angleU);
+   float cosU = cos(angleU);
+   float sinV = sin(angleV);
+   float cosV = cos(angleV);
+   uv = vec2(u, v);
+
+   if (gridType == SPHERE_GRID)
+   {
+      normal = vec3(cosU * sinV, cosV, sinU * sinV);
+      position = gridSize.x * normal;
+      uv = vec2(u + 0.5, cosV * 0.5 + 0.5);
+   }
+   else if (gridType == TORUS_GRID)
+   {
+      normal = vec3(cosV * cosU, cosV * sinU, sinV);
+      position = vec3(gridSize.x * cosU, gridSize.x * sinU, 0.0) + gridSize.y * normal;
+   }
+   else if (gridType == CYLINDER_SIDE_GRID)
+   {
+      normal = vec3(cosU, 0.0, sinU);
+      position = vec3(gridSize.x * cosU, gridSize.y * (1.0 - v), gridSize.x * sinU);
+      uv = vec2(u, 1.0 - v);
+   }
+   else
+   {
+      normal = vec3(0.0, gridSize.z, 0.0);
+      position = vec3(gridSize.x * v * cosU, gridSize.y, gridSize.z * gridSize.x * v * sinU);
+      uv = vec2(0.5 + 0.5 * gridSize.z * v * sinU, 0.5 + 0.5 * v * cosU);
+   }
+}
+
+void main()
+{
+   // large grids need more groups than one dispatch dimension holds
+   uint id = gl_GlobalInvocationID.y * gl_NumWorkGroups.x * gl_WorkGroupSize.x + gl_GlobalInvocationID.x;
+   uint rowVertices = gridQuads.x + 1u;
+   uint vertexCount = rowVertices * (gridQuads.y + 1u);
+   uint quadCount = gridQuads.x * gridQuads.y;
+
+   // one vertex per invocation, rows of (columns + 1) vertices
+   if (id < vertexCount)
+   {
+      uint column = id % rowVertices;
+      uint row = id / rowVertices;
+
+      vec3 position;
+      vec3 normal;
+      vec2 uv;
+      EvaluateSurface(float(column) / float(gridQuads.x), float(row) / float(gridQuads.y), position, normal, uv);
+
+      uint vertex = (firstVertex + id) * 8u;
+      vertices[vertex + 0u] = position.x;
+      vertices[vertex + 1u] = position.y;
+      vertices[vertex + 2u] = position.z;
+      vertices[vertex + 3u] = normal.x;
+      vertices[vertex + 4u] = normal.y;
+      vertices[vertex + 5u] = normal.z;
+      vertices[vertex + 6u] = uv.x;
+      vertices[vertex + 7u] = uv.y;
+   }
+
+   // two triangles per quad as BuildSurfaceIndices() winds them,
+   // the padding quads collapse onto the first vertex of the mesh
+   if (id < quadCount + paddingQuads)
+   {
+      uint index = firstIndex + id * 6u;
+      if (id < quadCount)
+      {
+         uint current = indexBase + (id / gridQuads.x) * rowVertices + id % gridQuads.x;
+         uint next = current + rowVertices;
+         indices[index + 0u] = current;
+         indices[index + 1u] = current + 1u;
+         indices[index + 2u] = next;
+         indices[index + 3u] = current + 1u;
+         indices[index + 4u] = next + 1u;
+         indices[index + 5u] = next;
+      }
+      else
+      {
+         for (uint corner = 0u; corner < 6u; corner++)
+         {
+            indices[index + corner] = 0u;
+         }
+      }
+   }
+}
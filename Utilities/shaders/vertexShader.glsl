@@ -1,20 +1,76 @@
-#version 330 core
-layout (location = 0) in vec3 inVertexPosition;
-layout (location = 1) in vec3 inVertexNormal;
-layout (location = 2) in vec2 inTextureCoordinate;
+#version 440 core
+layout (location = 0) in vec3 inVertexPosition;	// snorm16 in the mesh bounds when quantized
+layout (location = 1) in vec3 inVertexNormal;	// octahedron encoded snorm16 in xy when quantized
+layout (location = 2) in vec2 inTextureCoordinate;	// unorm16 in the mesh UV range when quantized
+layout (location = 3) in uint inObjectIndex;	// per-instance index written by the culling pass
+
+// per-object data shared with the culling compute shader
+struct ObjectData
+{
+   mat4 model;
+   vec4 color;
+   vec4 bounds;
+   uint commandIndex;
+   uint lodCount;
+   uint padding[2];
+};
+
+layout (std430, binding = 0) readonly buffer ObjectBuffer
+{
+   ObjectData objects[];
+};
 
 out vec3 fragmentPosition;
 out vec3 fragmentVertexNormal;
 out vec2 fragmentTextureCoordinate;
+out vec4 fragmentObjectColor;
 
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+uniform vec4 objectColor = vec4(1.0f);
+uniform bool bUseObjectBuffer = false;
+
+// ranges for decoding the compact vertex format of quantized meshes
+uniform bool bQuantizedVertices = false;
+uniform vec3 quantizedPositionCenter;
+uniform vec3 quantizedPositionExtent;
+uniform vec4 quantizedUVRange;
+
+// unfolds a normal stored on the octahedron into the unit sphere
+vec3 OctahedronDecode(vec2 encoded)
+{
+   vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+   float t = max(-normal.z, 0.0);
+   normal.x += normal.x >= 0.0 ? -t : t;
+   normal.y += normal.y >= 0.0 ? -t : t;
+   return normalize(normal);
+}
 
 void main()
 {
-   fragmentPosition = vec3(model * vec4(inVertexPosition, 1.0));
-   gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
-   fragmentVertexNormal = inVertexNormal;
-   fragmentTextureCoordinate = inTextureCoordinate;
-}
\ No newline at end of file
+   vec3 vertexPosition = inVertexPosition;
+   vec3 vertexNormal = inVertexNormal;
+   vec2 textureCoordinate = inTextureCoordinate;
+   if (bQuantizedVertices == true)
+   {
+      vertexPosition = quantizedPositionCenter + inVertexPosition * quantizedPositionExtent;
+      vertexNormal = OctahedronDecode(inVertexNormal.xy);
+      textureCoordinate = quantizedUVRange.xy + inTextureCoordinate * quantizedUVRange.zw;
+   }
+
+   mat4 objectModel = model;
+   fragmentObjectColor = objectColor;
+
+   // GPU-driven draws read the transform and color of the visible object
+   if (bUseObjectBuffer == true)
+   {
+      objectModel = objects[inObjectIndex].model;
+      fragmentObjectColor = objects[inObjectIndex].color;
+   }
+
+   fragmentPosition = vec3(objectModel * vec4(vertexPosition, 1.0));
+   gl_Position = projection * view * objectModel * vec4(vertexPosition, 1.0f);
+   fragmentVertexNormal = vertexNormal;
+   fragmentTextureCoordinate = textureCoordinate;
+}
@@ -0,0 +1,52 @@
+#version 330 core
+layout (location = 0) in vec3 inVertexPosition;	// snorm16 in the mesh bounds when quantized
+layout (location = 1) in vec3 inVertexNormal;	// octahedron encoded snorm16 in xy when quantized
+layout (location = 2) in vec2 inTextureCoordinate;	// unorm16 in the mesh UV range when quantized
+
+// OpenGL 3.3 variant of vertexShader.glsl for the immediate path only,
+// it has no object buffer so every draw sets the model and color
+
+out vec3 fragmentPosition;
+out vec3 fragmentVertexNormal;
+out vec2 fragmentTextureCoordinate;
+out vec4 fragmentObjectColor;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+uniform vec4 objectColor = vec4(1.0f);
+
+// ranges for decoding the compact vertex format of quantized meshes
+uniform bool bQuantizedVertices = false;
+uniform vec3 quantizedPositionCenter;
+uniform vec3 quantizedPositionExtent;
+uniform vec4 quantizedUVRange;
+
+// unfolds a normal stored on the octahedron into the unit sphere
+vec3 OctahedronDecode(vec2 encoded)
+{
+   vec3 normal = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+   float t = max(-normal.z, 0.0);
+   normal.x += normal.x >= 0.0 ? -t : t;
+   normal.y += normal.y >= 0.0 ? -t : t;
+   return normalize(normal);
+}
+
+void main()
+{
+   vec3 vertexPosition = inVertexPosition;
+   vec3 vertexNormal = inVertexNormal;
+   vec2 textureCoordinate = inTextureCoordinate;
+   if (bQuantizedVertices == true)
+   {
+      vertexPosition = quantizedPositionCenter + inVertexPosition * quantizedPositionExtent;
+      vertexNormal = OctahedronDecode(inVertexNormal.xy);
+      textureCoordinate = quantizedUVRange.xy + inTextureCoordinate * quantizedUVRange.zw;
+   }
+
+   fragmentObjectColor = objectColor;
+   fragmentPosition = vec3(model * vec4(vertexPosition, 1.0));
+   gl_Position = projection * view * model * vec4(vertexPosition, 1.0f);
+   fragmentVertexNormal = vertexNormal;
+   fragmentTextureCoordinate = textureCoordinate;
+}
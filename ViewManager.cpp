@@ -14,6 +14,7 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <memory>
+#include <algorithm>
 
 // declaration of the global variables and defines
 namespace
@@ -43,6 +44,42 @@ namespace
     // Track the state of the TAB key to handle key press events
     bool tabKeyPressed = false;
 
+    // GPU-driven culling is toggled with the G key, occlusion
+    // culling against the depth pyramid with the H key
+    bool bGPUCulling = false;
+    bool bOcclusionCulling = false;
+    bool gKeyPressed = false;
+    bool hKeyPressed = false;
+
+    // per-meshlet culling of large meshes, toggled with the M key
+    bool bMeshletCulling = true;
+    bool mKeyPressed = false;
+
+    // occlusion queries with conditional rendering, toggled with the O key
+    bool bOcclusionQueries = false;
+    bool oKeyPressed = false;
+
+    // level of detail selection for the pooled spheres and tori, toggled with the L key
+    bool bLod = true;
+    bool lKeyPressed = false;
+
+    // contribution culling threshold in pixels, adjusted with the [ and ] keys
+    float g_MinScreenSize = 2.0f;
+    bool bracketKeyPressed = false;
+    const float MIN_SCREEN_SIZE_STEP = 1.0f;
+    const float MAX_SCREEN_SIZE = 64.0f;
+
+    // one baked object is moved back and forth with the B key, to rebake its cells
+    bool bMoveBakedObject = false;
+    bool bKeyPressed = false;
+
+    // view and projection matrices of the current frame
+    glm::mat4 g_View(1.0f);
+    glm::mat4 g_Projection(1.0f);
+
+    // height in pixels of the default viewport, the framebuffer of the window
+    int g_ViewportHeight = WINDOW_HEIGHT;
+
     const float ORTHO_SCALE = 10.0f;
     const float MIN_MOVEMENT_SPEED = 0.1f;
     const float MAX_MOVEMENT_SPEED = 10.0f;
@@ -111,6 +148,11 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
+    // the default viewport covers the framebuffer, which can be larger
+    // than the window on high-DPI displays
+    int viewportWidth = 0;
+    glfwGetFramebufferSize(window, &viewportWidth, &g_ViewportHeight);
+
     m_pWindow = window;
 
     return window;
@@ -192,6 +234,113 @@ void ViewManager::ProcessKeyboardEvents()
         tabKeyPressed = false;
     }
 
+    // Toggle GPU-driven culling with the G key
+    if (glfwGetKey(m_pWindow, GLFW_KEY_G) == GLFW_PRESS)
+    {
+        if (!gKeyPressed)
+        {
+            bGPUCulling = !bGPUCulling;
+            std::cout << "INFO: GPU culling " << (bGPUCulling ? "on" : "off") << std::endl;
+            gKeyPressed = true;
+        }
+    }
+    else
+    {
+        gKeyPressed = false;
+    }
+
+    // Toggle occlusion culling with the H key
+    if (glfwGetKey(m_pWindow, GLFW_KEY_H) == GLFW_PRESS)
+    {
+        if (!hKeyPressed)
+        {
+            bOcclusionCulling = !bOcclusionCulling;
+            std::cout << "INFO: occlusion culling " << (bOcclusionCulling ? "on" : "off") << std::endl;
+            hKeyPressed = true;
+        }
+    }
+    else
+    {
+        hKeyPressed = false;
+    }
+
+    // Toggle meshlet culling with the M key
+    if (glfwGetKey(m_pWindow, GLFW_KEY_M) == GLFW_PRESS)
+    {
+        if (!mKeyPressed)
+        {
+            bMeshletCulling = !bMeshletCulling;
+            std::cout << "INFO: meshlet culling " << (bMeshletCulling ? "on" : "off") << std::endl;
+            mKeyPressed = true;
+        }
+    }
+    else
+    {
+        mKeyPressed = false;
+    }
+
+    // Toggle occlusion queries for heavy meshes with the O key
+    if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS)
+    {
+        if (!oKeyPressed)
+        {
+            bOcclusionQueries = !bOcclusionQueries;
+            std::cout << "INFO: occlusion queries " << (bOcclusionQueries ? "on" : "off") << std::endl;
+            oKeyPressed = true;
+        }
+    }
+    else
+    {
+        oKeyPressed = false;
+    }
+
+    // Toggle level of detail selection with the L key
+    if (glfwGetKey(m_pWindow, GLFW_KEY_L) == GLFW_PRESS)
+    {
+        if (!lKeyPressed)
+        {
+            bLod = !bLod;
+            std::cout << "INFO: level of detail " << (bLod ? "on" : "off") << std::endl;
+            lKeyPressed = true;
+        }
+    }
+    else
+    {
+        lKeyPressed = false;
+    }
+
+    // Lower or raise the contribution culling threshold with the [ and ] keys
+    bool bLowerKey = glfwGetKey(m_pWindow, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS;
+    bool bRaiseKey = glfwGetKey(m_pWindow, GLFW_KEY_RIGHT_BRACKET) == GLFW_PRESS;
+    if (bLowerKey || bRaiseKey)
+    {
+        if (!bracketKeyPressed)
+        {
+            g_MinScreenSize += bRaiseKey ? MIN_SCREEN_SIZE_STEP : -MIN_SCREEN_SIZE_STEP;
+            g_MinScreenSize = std::max(0.0f, std::min(g_MinScreenSize, MAX_SCREEN_SIZE));
+            std::cout << "INFO: minimum screen size " << g_MinScreenSize << " px" << std::endl;
+            bracketKeyPressed = true;
+        }
+    }
+    else
+    {
+        bracketKeyPressed = false;
+    }
+
+    // Move a baked object with the B key, taken by the scene on its next frame
+    if (glfwGetKey(m_pWindow, GLFW_KEY_B) == GLFW_PRESS)
+    {
+        if (!bKeyPressed)
+        {
+            bMoveBakedObject = true;
+            bKeyPressed = true;
+        }
+    }
+    else
+    {
+        bKeyPressed = false;
+    }
+
     // process camera zooming in and out
     if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
     {
@@ -255,6 +404,9 @@ void ViewManager::PrepareSceneView()
         projection = glm::perspective(glm::radians(g_pCamera->Zoom), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 100.0f);
     }
 
+    g_View = view;
+    g_Projection = projection;
+
     // if the shader manager object is valid
     if (m_pShaderManager)
     {
@@ -266,3 +418,100 @@ void ViewManager::PrepareSceneView()
         m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
     }
 }
+
+/***********************************************************
+ *  GetViewMatrix() / GetProjectionMatrix()
+ *
+ *  The matrices set by the last call to PrepareSceneView().
+ ***********************************************************/
+const glm::mat4& ViewManager::GetViewMatrix() const
+{
+    return g_View;
+}
+
+const glm::mat4& ViewManager::GetProjectionMatrix() const
+{
+    return g_Projection;
+}
+
+/***********************************************************
+ *  GetViewportHeight()
+ *
+ *  The height in pixels of the viewport the scene is drawn
+ *  to, read once when the window is created.
+ ***********************************************************/
+float ViewManager::GetViewportHeight() const
+{
+    return static_cast<float>(g_ViewportHeight);
+}
+
+/***********************************************************
+ *  IsGPUCullingEnabled() / IsOcclusionCullingEnabled()
+ *
+ *  The culling modes toggled with the G and H keys.
+ ***********************************************************/
+bool ViewManager::IsGPUCullingEnabled() const
+{
+    return bGPUCulling;
+}
+
+bool ViewManager::IsOcclusionCullingEnabled() const
+{
+    return bOcclusionCulling;
+}
+
+/***********************************************************
+ *  IsMeshletCullingEnabled()
+ *
+ *  Large meshes drawn one at a time cull their meshlets.
+ ***********************************************************/
+bool ViewManager::IsMeshletCullingEnabled() const
+{
+    return bMeshletCulling;
+}
+
+/***********************************************************
+ *  IsOcclusionQueryEnabled()
+ *
+ *  Heavy meshes drawn one at a time are skipped when their
+ *  bounding box was hidden in the previous frame.
+ ***********************************************************/
+bool ViewManager::IsOcclusionQueryEnabled() const
+{
+    return bOcclusionQueries;
+}
+
+/***********************************************************
+ *  IsLodEnabled()
+ *
+ *  Pooled meshes with coarser levels pick one from their
+ *  projected size when culled on the GPU.
+ ***********************************************************/
+bool ViewManager::IsLodEnabled() const
+{
+    return bLod;
+}
+
+/***********************************************************
+ *  GetMinScreenSize()
+ *
+ *  Objects with a smaller projected diameter in pixels are
+ *  removed by contribution culling.
+ ***********************************************************/
+float ViewManager::GetMinScreenSize() const
+{
+    return g_MinScreenSize;
+}
+
+/***********************************************************
+ *  TakeBakedObjectMove()
+ *
+ *  True once after the B key was pressed, when the scene
+ *  should move one of its baked objects.
+ ***********************************************************/
+bool ViewManager::TakeBakedObjectMove()
+{
+    bool bMove = bMoveBakedObject;
+    bMoveBakedObject = false;
+    return bMove;
+}
@@ -48,5 +48,22 @@ public:
 
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+
+	// view and projection matrices of the current frame
+	const glm::mat4& GetViewMatrix() const;
+	const glm::mat4& GetProjectionMatrix() const;
+	// height in pixels of the viewport, for projected sizes
+	float GetViewportHeight() const;
+
+	// culling modes selected from the keyboard
+	bool IsGPUCullingEnabled() const;
+	bool IsOcclusionCullingEnabled() const;
+	float GetMinScreenSize() const;
+	bool IsMeshletCullingEnabled() const;
+	bool IsOcclusionQueryEnabled() const;
+	bool IsLodEnabled() const;
+
+	// edit of the baked scene requested from the keyboard, cleared once taken
+	bool TakeBakedObjectMove();
 };
 #endif // VIEWMANAGER_H
\ No newline at end of file